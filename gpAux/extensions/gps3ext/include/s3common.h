@@ -32,6 +32,19 @@ struct XMLInfo {
 uint64_t XMLParserCallback(void* contents, uint64_t size, uint64_t nmemb,
                            void* userp);
 
+// number of idle curl handles kept for reuse
+#define S3_CURL_POOLSIZE 16
+
+// Curl handles are kept once done with, along with the connections they
+// hold open, so that the next request to the same host skips the TCP and
+// TLS handshakes. All of them share the DNS and TLS session caches too.
+// Thread safe.
+CURL* AcquireCurlHandle();
+
+// The handle must not be in the middle of a transfer, as it is if the
+// thread using it was cancelled, curl_easy_cleanup() it then.
+void ReleaseCurlHandle(CURL* curl);
+
 char* get_opt_s3(const char* url, const char* key);
 
 char* truncate_options(const char* url_with_options);
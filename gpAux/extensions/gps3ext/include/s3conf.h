@@ -40,6 +40,13 @@ extern string s3ext_token;
 // http or https
 extern bool s3ext_encryption;
 
+// whether to gzip the data written, and how hard
+extern bool s3ext_autocompress;
+extern int s3ext_compresslevel;
+
+// whether to split large objects for segments to read ranges of them
+extern bool s3ext_autosplit;
+
 // configuration file path
 extern string s3ext_config_path;
 
@@ -94,12 +94,33 @@ struct zstream_info {
     uint64_t done_out;
 };
 
+// number of blocks of decompressed data the inflating thread runs ahead
+#define S3_ZIP_BLOCKNUM 4
+
+// Blocks of decompressed data, filled by the inflating thread and drained by
+// get(), so that inflating the next blocks overlaps with the query
+// processing the previous ones.
+struct zstream_ring {
+    pthread_t thread;
+    bool started;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    char* blocks[S3_ZIP_BLOCKNUM];
+    uint64_t lens[S3_ZIP_BLOCKNUM];
+    uint64_t head;  // blocks drained
+    uint64_t tail;  // blocks filled
+    uint64_t done;  // bytes drained of the head block
+    bool eof;       // the file is all inflated
+    bool error;     // downloading or inflating failed
+};
+
 class Downloader {
    public:
     Downloader(uint8_t part_num);
     ~Downloader();
+    // reads the lines starting within the range of the object
     bool init(const string& url, const string& region, uint64_t size,
-              uint64_t chunksize, S3Credential* pcred);
+              uint64_t chunksize, S3Credential* pcred, const Range& range);
     bool get(char* buf, uint64_t& len);
     void destroy();
 
@@ -118,8 +139,29 @@ class Downloader {
 
     bool plain_get(char* buf, uint64_t& len);
 
+    string url;
+    string region;
+    uint64_t size;
+    S3Credential* pcred;
+    bool start_fetching(uint64_t from, uint64_t cap, uint64_t chunksize);
+    bool uncap(uint64_t from);
+
+    Range range;
+    bool ranged;     // the range is not the whole object
+    bool skipping;   // skipping the line the previous range reads
+    bool rangedone;  // read past the last line of the range
+    bool probe_gzip(const string& url, const string& region,
+                    uint64_t size, S3Credential* pcred, bool& gzip);
+    bool range_get(char* buf, uint64_t& len);
+
     struct zstream_info* z_info;
     bool zstream_get(char* buf, uint64_t& len);
+
+    struct zstream_ring* z_ring;
+    bool start_inflating();
+    bool ring_get(char* buf, uint64_t& len);
+
+    friend void* InflateThreadfunc(void* data);
 };
 
 struct Bufinfo {
@@ -143,6 +185,9 @@ class HTTPFetcher : public BlockingBuffer {
     Method method;
     HTTPHeaders headers;
     UrlParser urlparser;
+
+   private:
+    bool performing;  // in curl_easy_perform(), if the thread is cancelled
 };
 
 class S3Fetcher : public HTTPFetcher {
@@ -3,6 +3,7 @@
 
 #include <cstddef>
 #include <cstdlib>
+#include <deque>
 #include <iostream>
 #include <map>
 #include <string>
@@ -17,35 +18,138 @@
 #include <unistd.h>
 
 #include <curl/curl.h>
+#include <zlib.h>
 
 #include "s3common.h"
 #include "s3url_parser.h"
 
+using std::deque;
 using std::vector;
 
-struct Uploader {
-    Uploader();
+// S3 rejects parts smaller than 5MB, except for the last one
+#define S3_UPLOAD_MIN_PARTSIZE (5 * 1024 * 1024)
+
+// and uploads of more than 10000 parts
+#define S3_UPLOAD_MAX_PARTNUM 10000
+
+struct UploadPart {
+    char* data;
+    uint64_t len;
+    uint64_t number;  // starts from 1
+};
+
+// Uploads an object of unknown size to S3 as a multipart upload. Data
+// written is gathered into parts of chunksize bytes, which are uploaded by
+// a pool of threads while the next ones are being written. At most one
+// part more than there are threads is kept in memory, writing blocks until
+// a thread is done with its part.
+class Uploader {
+   public:
+    Uploader(uint8_t part_num);
     ~Uploader();
+    bool init(const string& schema, const string& region, const string& bucket,
+              const string& key, uint64_t chunksize, S3Credential* pcred);
+    bool write(const char* buf, uint64_t len);
+    // uploads what is left and completes the upload, or aborts it if any
+    // part failed
+    bool destroy();
+    // makes destroy() abort the upload, for data that is not complete
+    void cancel();
+
+   private:
+    const uint8_t num;
+    pthread_t* threads;
+    uint8_t threadcount;
+
+    string schema;
+    string region;
+    string bucket;
+    string key;
+    S3Credential cred;
+    string uploadid;
+
+    uint64_t partsize;
+    UploadPart* curpart;  // part being written to
+    uint64_t partcount;   // parts handed to the threads
 
-    bool init(const char *data, S3Credential *cred);
-    bool write(char *buf, uint64_t &len);
-    void destroy();
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    deque<UploadPart*> queued;    // parts waiting for a thread
+    vector<UploadPart*> freed;    // parts done with, to reuse
+    vector<string> etags;         // ETags of the uploaded parts, by number
+    uint64_t allocated;           // parts allocated
+    bool finished;                // no more parts will be queued
+    bool error;                   // a part failed to upload
+
+    bool queue(UploadPart* part);
+    UploadPart* next();
+    void done(UploadPart* part, const string& etag);
+    void stop();
+
+    friend void* UploadThreadfunc(void* data);
+};
+
+// size of the chunks data is compressed in
+#define S3_COMPRESS_CHUNKSIZE (1024 * 1024)
+
+// Compresses data written to it into a gzip stream, which it writes to an
+// Uploader. Deflating runs on a thread of its own, so that it overlaps both
+// the writing of the next chunk and the uploading of the previous parts.
+class Compressor {
+   public:
+    Compressor(Uploader* uploader);
+    ~Compressor();
+    bool init(int level);
+    bool write(const char* buf, uint64_t len);
+    // compresses what is left and ends the stream, the uploader is left to
+    // the caller
+    bool destroy();
 
    private:
-    // pthread_t* threads;
+    Uploader* uploader;
+    pthread_t thread;
+    bool started;
+
+    z_stream zstream;
+    bool zinited;
+    char* outbuf;
+
+    char* chunks[2];   // one is written to while the thread deflates the other
+    int curchunk;      // chunk being written to
+    uint64_t curlen;   // bytes in it
+
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    char* pending;        // chunk handed to the thread
+    uint64_t pendinglen;  // bytes in it
+    bool finished;        // no more chunks will be handed
+    bool error;           // compressing or uploading failed
+
+    bool hand(char* chunk, uint64_t len);
+    bool deflateChunk(const char* chunk, uint64_t len, int flush);
+
+    friend void* CompressThreadfunc(void* data);
 };
 
-const char *GetUploadId(const char *host, const char *bucket,
-                        const char *obj_name, const S3Credential &cred);
+// It returns "" if failed
+string GetUploadId(const string& schema, const string& region,
+                   const string& bucket, const string& key,
+                   const S3Credential& cred);
+
+// It returns the ETag of the part, or "" if failed
+string PartPutS3Object(const string& schema, const string& region,
+                       const string& bucket, const string& key,
+                       const S3Credential& cred, const char* data,
+                       uint64_t data_size, uint64_t part_number,
+                       const string& upload_id);
 
-const char *PartPutS3Object(const char *host, const char *bucket,
-                            const char *obj_name, const S3Credential &cred,
-                            const char *data, uint64_t data_size,
-                            uint64_t part_number, const char *upload_id);
+bool CompleteMultiPutS3(const string& schema, const string& region,
+                        const string& bucket, const string& key,
+                        const string& upload_id, const vector<string>& etags,
+                        const S3Credential& cred);
 
-bool CompleteMultiPutS3(const char *host, const char *bucket,
-                        const char *obj_name, const char *upload_id,
-                        const char **etag_array, uint64_t count,
-                        const S3Credential &cred);
+bool AbortMultiPutS3(const string& schema, const string& region,
+                     const string& bucket, const string& key,
+                     const string& upload_id, const S3Credential& cred);
 
 #endif
@@ -8,6 +8,18 @@
 
 using std::string;
 
+// objects are only split into ranges at least this large
+#define S3_SPLIT_MINSIZE ((uint64_t)1024 * 1024 * 1024)
+
+// A key, or a range of it, for a segment to read
+struct KeyRange {
+    BucketContent* content;
+    Range range;
+};
+
+vector<KeyRange> AssignKeyRanges(const ListBucketResult* keylist, int segid,
+                                 int segnum, bool split);
+
 class S3ExtBase {
    public:
     S3ExtBase(const string& url);
@@ -50,12 +62,29 @@ class S3Reader : public S3ExtBase {
     bool getNextDownloader();
 
     // private:
-    unsigned int contentindex;
+    unsigned int contentindex;  // of the key range to read next
+    vector<KeyRange> keyranges;  // assigned to this segment
     Downloader* filedownloader;
     ListBucketResult* keylist;
 };
 
-class S3Writer : public S3ExtBase {};
+class S3Writer : public S3ExtBase {
+   public:
+    S3Writer(const string& url);
+    virtual ~S3Writer();
+    virtual bool Init(int segid, int segnum, int chunksize);
+    virtual bool TransferData(char* data, uint64_t& len);
+    virtual bool Destroy();
+    // makes Destroy() abort the upload instead of completing it
+    virtual void Cancel();
+
+   protected:
+    virtual string getKeyName();
+
+    // private:
+    Uploader* fileuploader;
+    Compressor* compressor;  // NULL if data is uploaded as it is
+};
 
 extern "C" S3ExtBase* CreateExtWrapper(const char* url);
 
@@ -65,4 +94,12 @@ bool reader_transfer_data(S3Reader* reader, char* data_buf, int& data_len);
 
 bool reader_cleanup(S3Reader** reader);
 
+S3Writer* writer_init(const char* url_with_options);
+
+bool writer_transfer_data(S3Writer* writer, char* data_buf, int data_len);
+
+void writer_cancel(S3Writer* writer);
+
+bool writer_cleanup(S3Writer** writer);
+
 #endif
@@ -0,0 +1,59 @@
+-- ========
+-- PROTOCOL
+-- ========
+
+-- create the database functions
+CREATE OR REPLACE FUNCTION read_from_s3() RETURNS integer AS
+        '$libdir/gps3ext.so', 's3_import' LANGUAGE C STABLE;
+
+CREATE OR REPLACE FUNCTION write_to_s3() RETURNS integer AS
+        '$libdir/gps3ext.so', 's3_export' LANGUAGE C STABLE;
+
+-- declare the protocol name along with in/out funcs
+CREATE PROTOCOL s3 (
+        readfunc  = read_from_s3,
+        writefunc = write_to_s3
+);
+
+-- Check out the catalog table
+select * from pg_extprotocol;
+
+-- objects written are never deleted, so each run writes under a prefix of its own
+CREATE OR REPLACE FUNCTION create_s3example_tables() RETURNS void AS $$
+DECLARE
+    location text;
+BEGIN
+    location := 's3://s3-us-west-2.amazonaws.com/s3test.pivotal.io/regress/write/'
+        || to_char(now(), 'YYYYMMDDHH24MISS') || '_' || pg_backend_pid()
+        || '/ config=/home/gpadmin/s3.conf';
+
+    EXECUTE 'create WRITABLE external table s3example_write (date text, time text, '
+        || 'open float, high float, low float, volume int) location('
+        || quote_literal(location) || ') format ''csv''';
+    EXECUTE 'create READABLE external table s3example_read (date text, time text, '
+        || 'open float, high float, low float, volume int) location('
+        || quote_literal(location) || ') format ''csv''';
+END;
+$$ LANGUAGE plpgsql;
+
+drop external table s3example_write;
+drop external table s3example_read;
+SELECT create_s3example_tables();
+
+INSERT INTO s3example_write SELECT '2016-01-01', '09:30:00', i, i + 1, i - 1, i FROM generate_series(1, 100000) i;
+
+SELECT count(*) FROM s3example_read;
+
+-- the data of a failed INSERT must not make it to S3
+INSERT INTO s3example_write SELECT '2016-01-01', '09:30:00', i, i + 1, i - 1, 100 / (i - 90000) FROM generate_series(1, 100000) i;
+
+SELECT count(*) FROM s3example_read;
+
+-- =======
+-- CLEANUP
+-- =======
+DROP EXTERNAL TABLE s3example_write;
+DROP EXTERNAL TABLE s3example_read;
+DROP FUNCTION create_s3example_tables();
+
+DROP PROTOCOL s3;
@@ -54,7 +54,10 @@ void print_template() {
         "chunksize = 67108864\n"
         "low_speed_limit = 10240\n"
         "low_speed_time = 60\n"
-        "encryption = true\n");
+        "encryption = true\n"
+        "autocompress = false\n"
+        "compresslevel = 6\n"
+        "autosplit = false\n");
 }
 
 void print_usage(FILE *stream) {
@@ -10,6 +10,7 @@
 #include "postgres.h"
 
 #include "access/extprotocol.h"
+#include "access/xact.h"
 #include "catalog/pg_proc.h"
 #include "fmgr.h"
 #include "funcapi.h"
@@ -21,6 +22,7 @@
 #include "s3common.h"
 #include "s3conf.h"
 #include "s3log.h"
+#include "s3thread.h"
 #include "s3utils.h"
 #include "s3wrapper.h"
 
@@ -106,4 +108,69 @@ Datum s3_import(PG_FUNCTION_ARGS) {
  * Export data out of GPDB.
  * invoked by GPDB, be careful with C++ exceptions.
  */
-Datum s3_export(PG_FUNCTION_ARGS) { PG_RETURN_INT32(0); }
+Datum s3_export(PG_FUNCTION_ARGS) {
+    S3Writer *s3writer = NULL;
+
+    /* Must be called via the external table format manager */
+    if (!CALLED_AS_EXTPROTOCOL(fcinfo))
+        elog(ERROR,
+             "extprotocol_export: not called by external protocol manager");
+
+    /* Get our internal description of the protocol */
+    s3writer = (S3Writer *)EXTPROTOCOL_GET_USER_CTX(fcinfo);
+
+    /* last call. complete the upload and destroy writer */
+    if (EXTPROTOCOL_IS_LAST_CALL(fcinfo)) {
+        /* nothing was written by this segment */
+        if (s3writer == NULL) {
+            PG_RETURN_INT32(0);
+        }
+
+        /*
+         * The last call is also made when the transaction aborts, with only
+         * part of the data written. It must not make it to S3, and raising
+         * an error in the middle of the abort processing is not allowed.
+         */
+        bool aborting = IsAbortInProgress();
+        if (aborting) {
+            writer_cancel(s3writer);
+        }
+
+        bool result = writer_cleanup(&s3writer);
+        EXTPROTOCOL_SET_USER_CTX(fcinfo, NULL);
+
+        thread_cleanup();
+
+        if (!result && !aborting) {
+            ereport(ERROR, (0, errmsg("Failed to upload data to S3")));
+        }
+        PG_RETURN_INT32(0);
+    }
+
+    /* first call. do any desired init */
+    if (s3writer == NULL) {
+        const char *url_with_options = EXTPROTOCOL_GET_URL(fcinfo);
+
+        thread_setup();
+
+        s3writer = writer_init(url_with_options);
+        if (!s3writer) {
+            ereport(ERROR, (0, errmsg("Failed to init S3 extension, segid = "
+                                      "%d, segnum = %d, please check your "
+                                      "configurations and net connection",
+                                      s3ext_segid, s3ext_segnum)));
+        }
+
+        check_essential_config();
+
+        EXTPROTOCOL_SET_USER_CTX(fcinfo, s3writer);
+    }
+
+    char *data_buf = EXTPROTOCOL_GET_DATABUF(fcinfo);
+    int data_len = EXTPROTOCOL_GET_DATALEN(fcinfo);
+    if (!writer_transfer_data(s3writer, data_buf, data_len)) {
+        ereport(ERROR, (0, errmsg("s3_export: could not write data")));
+    }
+
+    PG_RETURN_INT32(data_len);
+}
@@ -7,6 +7,9 @@
 #include <map>
 #include <sstream>
 #include <string>
+#include <vector>
+
+#include <pthread.h>
 
 #include <openssl/err.h>
 #include <openssl/sha.h>
@@ -109,6 +112,111 @@ bool SignRequestV4(const string &method, HTTPHeaders *h,
     return true;
 }
 
+static pthread_mutex_t curl_pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static std::vector<CURL *> curl_pool;
+static CURLSH *curl_share = NULL;
+static pthread_mutex_t curl_share_mutexes[CURL_LOCK_DATA_LAST];
+
+// Downloader threads are cancelled with pthread_cancel(), a thread
+// cancelled while holding a share lock would deadlock the later requests,
+// so cancellation is deferred until the outermost lock is released.
+static __thread int curl_share_lock_depth = 0;
+static __thread int curl_share_cancel_state;
+
+static void curl_share_lock(CURL *handle, curl_lock_data data,
+                            curl_lock_access access, void *userptr) {
+    int oldstate;
+
+    pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &oldstate);
+    pthread_mutex_lock(&curl_share_mutexes[data]);
+
+    if (curl_share_lock_depth++ == 0) {
+        curl_share_cancel_state = oldstate;
+    }
+}
+
+static void curl_share_unlock(CURL *handle, curl_lock_data data,
+                              void *userptr) {
+    pthread_mutex_unlock(&curl_share_mutexes[data]);
+
+    if (--curl_share_lock_depth == 0) {
+        pthread_setcancelstate(curl_share_cancel_state, NULL);
+    }
+}
+
+// Connections are not shared, libcurl does not support sharing them
+// between threads, each handle keeps its own instead.
+static CURLSH *get_curl_share() {
+    if (!curl_share) {
+        for (int i = 0; i < CURL_LOCK_DATA_LAST; i++) {
+            pthread_mutex_init(&curl_share_mutexes[i], NULL);
+        }
+
+        curl_share = curl_share_init();
+        if (curl_share) {
+            curl_share_setopt(curl_share, CURLSHOPT_LOCKFUNC, curl_share_lock);
+            curl_share_setopt(curl_share, CURLSHOPT_UNLOCKFUNC,
+                              curl_share_unlock);
+            curl_share_setopt(curl_share, CURLSHOPT_SHARE,
+                              CURL_LOCK_DATA_DNS);
+            curl_share_setopt(curl_share, CURLSHOPT_SHARE,
+                              CURL_LOCK_DATA_SSL_SESSION);
+        } else {
+            S3WARN("Failed to create curl share, DNS and TLS sessions won't "
+                   "be cached");
+        }
+    }
+
+    return curl_share;
+}
+
+CURL *AcquireCurlHandle() {
+    CURL *curl = NULL;
+
+    pthread_mutex_lock(&curl_pool_mutex);
+    if (!curl_pool.empty()) {
+        curl = curl_pool.back();
+        curl_pool.pop_back();
+    }
+    CURLSH *share = get_curl_share();
+    pthread_mutex_unlock(&curl_pool_mutex);
+
+    if (!curl) {
+        curl = curl_easy_init();
+        if (!curl) {
+            return NULL;
+        }
+    }
+
+    // curl_easy_reset() keeps the share, but not these
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+    if (share) {
+        curl_easy_setopt(curl, CURLOPT_SHARE, share);
+    }
+
+    return curl;
+}
+
+void ReleaseCurlHandle(CURL *curl) {
+    if (!curl) {
+        return;
+    }
+
+    // options are reset, the connections and caches are kept
+    curl_easy_reset(curl);
+
+    pthread_mutex_lock(&curl_pool_mutex);
+    if (curl_pool.size() < S3_CURL_POOLSIZE) {
+        curl_pool.push_back(curl);
+        curl = NULL;
+    }
+    pthread_mutex_unlock(&curl_pool_mutex);
+
+    if (curl) {
+        curl_easy_cleanup(curl);
+    }
+}
+
 // return the number of items
 uint64_t XMLParserCallback(void *contents, uint64_t size, uint64_t nmemb,
                            void *userp) {
@@ -43,6 +43,10 @@ string s3ext_token;
 
 bool s3ext_encryption;
 
+bool s3ext_autocompress = false;
+int32_t s3ext_compresslevel = 6;
+bool s3ext_autosplit = false;
+
 // global variables
 int32_t s3ext_segid = -1;
 int32_t s3ext_segnum = -1;
@@ -145,6 +149,27 @@ bool InitConfig(const string& conf_path, const string section = "default") {
         content = s3cfg->Get(section.c_str(), "encryption", "true");
         s3ext_encryption = to_bool(content);
 
+        content = s3cfg->Get(section.c_str(), "autocompress", "false");
+        s3ext_autocompress = to_bool(content);
+
+        ret = s3cfg->Scan(section.c_str(), "compresslevel", "%d",
+                          &s3ext_compresslevel);
+        if (!ret) {
+            S3INFO("The compresslevel is set to default value 6");
+            s3ext_compresslevel = 6;
+        }
+        if (s3ext_compresslevel > 9) {
+            S3INFO("The given compresslevel is too large, use max value 9");
+            s3ext_compresslevel = 9;
+        }
+        if (s3ext_compresslevel < 1) {
+            S3INFO("The given compresslevel is too small, use min value 1");
+            s3ext_compresslevel = 1;
+        }
+
+        content = s3cfg->Get(section.c_str(), "autosplit", "false");
+        s3ext_autosplit = to_bool(content);
+
 #ifdef S3_STANDALONE
         s3ext_segid = 0;
         s3ext_segnum = 1;
@@ -85,6 +85,12 @@ bool BlockingBuffer::Init() {
     return true;
 }
 
+// Threads are cancelled while they wait for, or hold, a mutex, see
+// Downloader::destroy(). This releases it, so that the others get it.
+static void unlock_mutex(void *mutex) {
+    pthread_mutex_unlock((pthread_mutex_t *)mutex);
+}
+
 // ret < len means EMPTY
 // that's why it checks if left_data_lentgh is larger than *or equal to* len
 // below[1], provides a chance ret is 0, which is smaller than len. Otherwise,
@@ -99,15 +105,18 @@ uint64_t BlockingBuffer::Read(char *buf, uint64_t len) {
         return 0;
     }
 
+    uint64_t length_to_read = 0;
+
     // assert buf not null
     // assert len > 0, len < this->bufcap
     pthread_mutex_lock(&this->stat_mutex);
+    pthread_cleanup_push(unlock_mutex, &this->stat_mutex);
     while (this->status == BlockingBuffer::STATUS_EMPTY) {
         pthread_cond_wait(&this->stat_cond, &this->stat_mutex);
     }
 
     uint64_t left_data_length = this->realsize - this->readpos;
-    uint64_t length_to_read = std::min(len, left_data_length);
+    length_to_read = std::min(len, left_data_length);
 
     memcpy(buf, this->bufferdata + this->readpos, length_to_read);
     if (left_data_length >= len) {  // [1]
@@ -124,21 +133,23 @@ uint64_t BlockingBuffer::Read(char *buf, uint64_t len) {
             pthread_cond_signal(&this->stat_cond);
         }
     }
-    pthread_mutex_unlock(&this->stat_mutex);
+    pthread_cleanup_pop(1);
     return length_to_read;
 }
 
 // returning -1 mearns error, pls don't set chunksize to uint64_t(-1) for now
 uint64_t BlockingBuffer::Fill() {
+    uint64_t readlen = 0;
+
     // assert offset > 0, offset < this->bufcap
     pthread_mutex_lock(&this->stat_mutex);
+    pthread_cleanup_push(unlock_mutex, &this->stat_mutex);
     while (this->status == BlockingBuffer::STATUS_READY) {
         pthread_cond_wait(&this->stat_cond, &this->stat_mutex);
     }
     uint64_t offset = this->nextpos.offset;
     uint64_t leftlen = this->nextpos.len;
     // assert this->status != BlockingBuffer::STATUS_READY
-    uint64_t readlen = 0;
     this->realsize = 0;
     while (this->realsize < this->bufcap) {
         if (leftlen != 0) {
@@ -170,7 +181,7 @@ uint64_t BlockingBuffer::Fill() {
     this->status = BlockingBuffer::STATUS_READY;
     pthread_cond_signal(&this->stat_cond);
 
-    pthread_mutex_unlock(&this->stat_mutex);
+    pthread_cleanup_pop(1);
     return (readlen == (uint64_t)-1) ? -1 : this->realsize;
 }
 
@@ -227,7 +238,13 @@ Downloader::Downloader(uint8_t part_num)
       readlen(0),
       magic_bytes_num(0),
       compression(S3_ZIP_NONE),
-      z_info(NULL) {
+      size(0),
+      pcred(NULL),
+      ranged(false),
+      skipping(false),
+      rangedone(false),
+      z_info(NULL),
+      z_ring(NULL) {
     this->threads = (pthread_t *)malloc(num * sizeof(pthread_t));
     if (this->threads)
         memset((void *)this->threads, 0, num * sizeof(pthread_t));
@@ -243,18 +260,71 @@ Downloader::Downloader(uint8_t part_num)
     }
 }
 
+// A line belongs to the range its first byte is in. Unless the range starts
+// the object, reading starts with the byte before it, so that the line the
+// previous range reads, if any, is skipped up to and including its newline.
 bool Downloader::init(const string &url, const string &region, uint64_t size,
-                      uint64_t chunksize, S3Credential *pcred) {
+                      uint64_t chunksize, S3Credential *pcred,
+                      const Range &range) {
     if (!this->threads || !this->buffers) {
         return false;
     }
 
-    this->o = new OffsetMgr(size, chunksize);
+    this->range = range;
+    this->ranged = (range.offset > 0) || (range.offset + range.len < size);
+    this->skipping = (range.offset > 0);
+
+    if (this->skipping) {
+        // compressed objects can only be read as a whole, which the reader
+        // of the first range does, see get()
+        bool gzip = false;
+        if (!this->probe_gzip(url, region, size, pcred, gzip)) {
+            return false;
+        }
+        if (gzip) {
+            S3DEBUG("%s is compressed, its first range reads all of it",
+                    url.c_str());
+            this->rangedone = true;
+            return true;
+        }
+    }
+
+    this->url = url;
+    this->region = region;
+    this->size = size;
+    this->pcred = pcred;
+
+    // A ranged reader fetches one chunk past its range, for its last line.
+    // Fetching on to the end of the object would waste up to a chunk per
+    // thread. A longer last line lifts the cap, see uncap().
+    uint64_t cap = size;
+    if (this->ranged) {
+        cap = std::min(size, range.offset + range.len + chunksize);
+    }
+
+    uint64_t start = this->skipping ? range.offset - 1 : 0;
+    if (!this->start_fetching(start, cap, chunksize)) {
+        return false;
+    }
+
+    readlen = start;
+    memset(this->magic_bytes, 0, sizeof(this->magic_bytes));
+
+    return true;
+}
+
+// Starts the threads fetching the object from offset 'from' up to 'cap'
+bool Downloader::start_fetching(uint64_t from, uint64_t cap,
+                                uint64_t chunksize) {
+    this->o = new OffsetMgr(cap, chunksize);
     if (!this->o) {
         S3ERROR("Failed to create offset manager, no enough memory?");
         return false;
     }
 
+    // before the buffers take their first offsets
+    this->o->Reset(from);
+
     for (int i = 0; i < this->num; i++) {
         this->buffers[i] = BlockingBuffer::CreateBuffer(
             url, region, o, pcred);  // decide buffer according to url
@@ -266,17 +336,62 @@ bool Downloader::init(const string &url, const string &region, uint64_t size,
                        this->buffers[i]);
     }
 
-    readlen = 0;
     chunkcount = 0;
-    memset(this->magic_bytes, 0, sizeof(this->magic_bytes));
 
     return true;
 }
 
+// Fetches the object from offset 'from' on up to its end, when what comes
+// before the cap of the range does not do: the last line of the range goes
+// on past it, or the object is compressed. The inflating thread must not
+// be running yet.
+bool Downloader::uncap(uint64_t from) {
+    uint64_t chunksize = this->o->Chunksize();
+    if (this->o->Size() >= this->size) {
+        return true;
+    }
+
+    S3DEBUG("Fetching %s from %llu up to its end", this->url.c_str(), from);
+    this->destroy();
+
+    return this->start_fetching(from, this->size, chunksize);
+}
+
+// Fetches the first bytes of the object, to tell whether it is compressed
+bool Downloader::probe_gzip(const string &url, const string &region,
+                           uint64_t size, S3Credential *pcred, bool &gzip) {
+    unsigned char magic[sizeof(this->magic_bytes)];
+    OffsetMgr probe(std::min(size, (uint64_t)sizeof(magic)), sizeof(magic));
+
+    BlockingBuffer *buf =
+        BlockingBuffer::CreateBuffer(url, region, &probe, pcred);
+    if (!buf || !buf->Init()) {
+        S3ERROR("Failed to init blocking buffer");
+        delete buf;
+        return false;
+    }
+
+    bool ret = (buf->Fill() != (uint64_t)-1);
+    if (ret) {
+        uint64_t n = buf->Read((char *)magic, sizeof(magic));
+        gzip = (n > 1) && (magic[0] == 0x1f) && (magic[1] == 0x8b);
+    } else {
+        S3ERROR("Failed to fetch the first bytes of %s", url.c_str());
+    }
+
+    delete buf;
+    return ret;
+}
+
 bool Downloader::set_compression() {
     if ((this->magic_bytes[0] == 0x1f) && (this->magic_bytes[1] == 0x8b)) {
         this->compression = S3_ZIP_GZIP;
 
+        // the magic bytes are read already
+        if (!this->uncap(this->magic_bytes_num)) {
+            return false;
+        }
+
         this->z_info = new zstream_info();
         if (!this->z_info) {
             S3ERROR("Failed to allocate memory");
@@ -288,6 +403,8 @@ bool Downloader::set_compression() {
         this->z_info->out = NULL;
         this->z_info->done_out = 0;
         this->z_info->have_out = 0;
+
+        return this->start_inflating();
     } else {
         this->compression = S3_ZIP_NONE;
     }
@@ -296,7 +413,14 @@ bool Downloader::set_compression() {
 }
 
 bool Downloader::get(char *data, uint64_t &len) {
-    if (this->magic_bytes_num == 0) {
+    if (this->rangedone) {
+        len = 0;
+        return true;
+    }
+
+    // only the first range of an object may be compressed, and the whole
+    // object is read then
+    if ((this->magic_bytes_num == 0) && (this->range.offset == 0)) {
         // get first 4(at least 2) bytes to check if this file is compressed
         BlockingBuffer *buf = buffers[this->chunkcount % this->num];
 
@@ -310,13 +434,82 @@ bool Downloader::get(char *data, uint64_t &len) {
 
     switch (this->compression) {
         case S3_ZIP_GZIP:
-            return this->zstream_get(data, len);
+            return this->ring_get(data, len);
             break;
         default:
+            if (this->ranged) {
+                return this->range_get(data, len);
+            }
             return this->plain_get(data, len);
     }
 }
 
+// Cuts what plain_get() reads to the lines of the range: those before the
+// first newline are skipped, unless the range starts the object, and the
+// line ending with the first newline at or past the last byte of the range
+// is the last one.
+bool Downloader::range_get(char *data, uint64_t &len) {
+    uint64_t end = this->range.offset + this->range.len;
+    uint64_t pos = 0;
+    uint64_t from = 0;
+    uint64_t got = 0;
+
+    do {
+        pos = this->readlen;  // offset of data[0]
+        got = len;
+        if (!this->plain_get(data, got)) {
+            return false;
+        }
+        if (got == 0) {
+            // the last line goes on past the cap
+            if (!this->skipping && (this->o->Size() < this->size)) {
+                if (!this->uncap(this->readlen)) {
+                    return false;
+                }
+                continue;
+            }
+
+            this->rangedone = true;
+            len = 0;
+            return true;
+        }
+
+        from = 0;
+        if (this->skipping) {
+            char *newline = (char *)memchr(data, '\n', got);
+            if (!newline) {
+                continue;
+            }
+
+            from = newline - data + 1;
+            this->skipping = false;
+
+            // a line longer than the range
+            if (pos + from >= end) {
+                this->rangedone = true;
+                len = 0;
+                return true;
+            }
+        }
+    } while (this->skipping || (from == got));
+
+    if (pos + got >= end) {
+        uint64_t i = std::max(from, (end > pos + 1) ? end - 1 - pos : 0);
+        char *newline = (char *)memchr(data + i, '\n', got - i);
+        if (newline) {
+            got = newline - data + 1;
+            this->rangedone = true;
+        }
+    }
+
+    len = got - from;
+    if (from > 0) {
+        memmove(data, data + from, len);
+    }
+
+    return true;
+}
+
 bool Downloader::plain_get(char *data, uint64_t &len) {
     uint64_t filelen = this->o->Size();
     uint64_t tmplen = 0;
@@ -503,13 +696,142 @@ RETRY:
     return true;
 }
 
+void *InflateThreadfunc(void *data) {
+    Downloader *downloader = reinterpret_cast<Downloader *>(data);
+    zstream_ring *ring = downloader->z_ring;
+
+    S3INFO("Inflating thread starts");
+    while (true) {
+        pthread_mutex_lock(&ring->mutex);
+        pthread_cleanup_push(unlock_mutex, &ring->mutex);
+        while (ring->tail - ring->head == S3_ZIP_BLOCKNUM) {
+            pthread_cond_wait(&ring->cond, &ring->mutex);
+        }
+        pthread_cleanup_pop(1);
+
+        // get() is done with this block, it only reads blocks before tail
+        uint64_t i = ring->tail % S3_ZIP_BLOCKNUM;
+        uint64_t len = S3_ZIP_CHUNKSIZE;
+        bool ok = downloader->zstream_get(ring->blocks[i], len);
+
+        pthread_mutex_lock(&ring->mutex);
+        if (!ok) {
+            ring->error = true;
+        } else if (len == 0) {
+            ring->eof = true;
+        } else {
+            ring->lens[i] = len;
+            ring->tail++;
+        }
+        pthread_cond_broadcast(&ring->cond);
+        pthread_mutex_unlock(&ring->mutex);
+
+        if (!ok || (len == 0)) {
+            break;
+        }
+    }
+    S3INFO("Inflating thread ended");
+
+    return NULL;
+}
+
+// Hands zstream_get() over to a thread of its own, along with the
+// downloading buffers, get() only drains the ring from now on
+bool Downloader::start_inflating() {
+    this->z_ring = new zstream_ring();
+    if (!this->z_ring) {
+        S3ERROR("Failed to allocate memory");
+        return false;
+    }
+
+    zstream_ring *ring = this->z_ring;
+    ring->started = false;
+    ring->head = 0;
+    ring->tail = 0;
+    ring->done = 0;
+    ring->eof = false;
+    ring->error = false;
+    pthread_mutex_init(&ring->mutex, NULL);
+    pthread_cond_init(&ring->cond, NULL);
+
+    for (int i = 0; i < S3_ZIP_BLOCKNUM; i++) {
+        ring->blocks[i] = (char *)malloc(S3_ZIP_CHUNKSIZE);
+        ring->lens[i] = 0;
+        if (!ring->blocks[i]) {
+            S3ERROR("Failed to allocate memory");
+            return false;
+        }
+    }
+
+    if (pthread_create(&ring->thread, NULL, InflateThreadfunc, this)) {
+        S3ERROR("Failed to create inflating thread");
+        return false;
+    }
+    ring->started = true;
+
+    return true;
+}
+
+bool Downloader::ring_get(char *data, uint64_t &len) {
+    zstream_ring *ring = this->z_ring;
+
+    if (QueryCancelPending) {
+        S3INFO("Inflated data reading is interrupted by GPDB");
+        return false;
+    }
+
+    pthread_mutex_lock(&ring->mutex);
+    while ((ring->head == ring->tail) && !ring->eof && !ring->error) {
+        pthread_cond_wait(&ring->cond, &ring->mutex);
+    }
+
+    if (ring->head == ring->tail) {
+        bool failed = ring->error;
+        pthread_mutex_unlock(&ring->mutex);
+
+        len = 0;
+        return !failed;
+    }
+    pthread_mutex_unlock(&ring->mutex);
+
+    // the inflating thread leaves the block alone until head moves past it
+    uint64_t i = ring->head % S3_ZIP_BLOCKNUM;
+    uint64_t left = ring->lens[i] - ring->done;
+    if (len > left) {
+        len = left;
+    }
+    memcpy(data, ring->blocks[i] + ring->done, len);
+
+    pthread_mutex_lock(&ring->mutex);
+    ring->done += len;
+    if (ring->done == ring->lens[i]) {
+        ring->done = 0;
+        ring->head++;
+        pthread_cond_broadcast(&ring->cond);
+    }
+    pthread_mutex_unlock(&ring->mutex);
+
+    return true;
+}
+
 void Downloader::destroy() {
+    // all are cancelled before any is joined, the inflating thread may wait
+    // for a downloading thread, which holds the buffer while it fetches
+    if (this->z_ring && this->z_ring->started) {
+        pthread_cancel(this->z_ring->thread);
+    }
+
     for (int i = 0; i < this->num; i++) {
         if (this->threads && this->threads[i]) {
             pthread_cancel(this->threads[i]);
         }
     }
 
+    if (this->z_ring && this->z_ring->started) {
+        pthread_join(this->z_ring->thread, NULL);
+        this->z_ring->started = false;
+    }
+
     for (int i = 0; i < this->num; i++) {
         if (this->threads && this->threads[i]) {
             pthread_join(this->threads[i], NULL);
@@ -545,6 +867,17 @@ Downloader::~Downloader() {
         delete this->z_info;
         this->z_info = NULL;
     }
+
+    if (this->z_ring) {
+        for (int i = 0; i < S3_ZIP_BLOCKNUM; i++) {
+            free(this->z_ring->blocks[i]);
+        }
+        pthread_mutex_destroy(&this->z_ring->mutex);
+        pthread_cond_destroy(&this->z_ring->cond);
+
+        delete this->z_ring;
+        this->z_ring = NULL;
+    }
 }
 
 // return the number of items
@@ -564,16 +897,18 @@ static uint64_t WriterCallback(void *contents, uint64_t size, uint64_t nmemb,
 }
 
 HTTPFetcher::HTTPFetcher(const string &url, OffsetMgr *o)
-    : BlockingBuffer(url, o), method(GET), urlparser(url.c_str()) {
-    this->curl = curl_easy_init();
+    : BlockingBuffer(url, o),
+      method(GET),
+      urlparser(url.c_str()),
+      performing(false) {
+    // the connection is kept open for the next chunks, and objects
+    this->curl = AcquireCurlHandle();
     if (this->curl) {
 #if DEBUG_S3_CURL
         curl_easy_setopt(this->curl, CURLOPT_VERBOSE, 1L);
 #endif
         // curl_easy_setopt(curl, CURLOPT_PROXY, "127.0.0.1:8080");
-        curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
         curl_easy_setopt(this->curl, CURLOPT_WRITEFUNCTION, WriterCallback);
-        curl_easy_setopt(this->curl, CURLOPT_FORBID_REUSE, 1L);
         this->AddHeaderField(HOST, urlparser.Host());
     } else {
         S3ERROR("Failed to create curl instance, no enough memory?");
@@ -581,7 +916,14 @@ HTTPFetcher::HTTPFetcher(const string &url, OffsetMgr *o)
 }
 
 HTTPFetcher::~HTTPFetcher() {
-    if (this->curl) curl_easy_cleanup(this->curl);
+    if (!this->curl) return;
+
+    // a transfer cancelled half way leaves the handle in no state for reuse
+    if (this->performing) {
+        curl_easy_cleanup(this->curl);
+    } else {
+        ReleaseCurlHandle(this->curl);
+    }
 }
 
 bool HTTPFetcher::SetMethod(Method m) {
@@ -652,7 +994,9 @@ uint64_t HTTPFetcher::fetchdata(uint64_t offset, char *data, uint64_t len) {
         }
         curl_easy_setopt(curl, CURLOPT_HTTPHEADER, chunk);
 
+        this->performing = true;
         CURLcode res = curl_easy_perform(curl_handle);
+        this->performing = false;
 
         if (res == CURLE_WRITE_ERROR) {
             S3INFO("Curl downloading is interrupted by GPDB");
@@ -733,14 +1077,13 @@ xmlParserCtxtPtr DoGetXML(const string &region, const string &url,
     stringstream host;
     host << "s3-" << region << ".amazonaws.com";
 
-    CURL *curl = curl_easy_init();
+    CURL *curl = AcquireCurlHandle();
 
     if (curl) {
         curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
 #if DEBUG_S3_CURL
         curl_easy_setopt(curl, CURLOPT_VERBOSE, 1L);
 #endif
-        curl_easy_setopt(curl, CURLOPT_FORBID_REUSE, 1L);
     } else {
         S3ERROR("Can't create curl instance, no enough memory?");
         return NULL;
@@ -797,7 +1140,7 @@ xmlParserCtxtPtr DoGetXML(const string &region, const string &url,
         }
     }
 
-    curl_easy_cleanup(curl);
+    ReleaseCurlHandle(curl);
 
     header->FreeList();
     delete header;
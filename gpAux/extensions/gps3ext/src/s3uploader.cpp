@@ -6,9 +6,12 @@
 #define __STDC_FORMAT_MACROS
 #include <fcntl.h>
 #include <inttypes.h>
+#include <strings.h>
 #include <sys/stat.h>
 
+#include "gps3ext.h"
 #include "s3common.h"
+#include "s3conf.h"
 #include "s3downloader.h"
 #include "s3http_headers.h"
 #include "s3uploader.h"
@@ -110,7 +113,7 @@ static int trace_debug_data(CURL *handle, curl_infotype type, char *data,
 #endif
 
 struct MemoryData {
-    char *advance;
+    const char *advance;
     size_t sizeleft;
 };
 
@@ -119,12 +122,11 @@ static size_t mem_read_callback(void *ptr, size_t size, size_t nmemb,
                                 void *userp) {
     struct MemoryData *puppet = (struct MemoryData *)userp;
     size_t realsize = size * nmemb;
-    size_t nmemb2read =
-        realsize < puppet->sizeleft ? nmemb : (puppet->sizeleft / size);
-    size_t n2read = nmemb2read * size;
+    size_t n2read = std::min(realsize, puppet->sizeleft);
 
-    // printf("n2read = %d, nmemb2read = %d, realsize = %d, puppet->sizeleft =
-    // %d\n", n2read, nmemb2read, realsize, puppet->sizeleft);
+    if (QueryCancelPending) {
+        return CURL_READFUNC_ABORT;
+    }
 
     if (!n2read) return 0;
 
@@ -132,487 +134,821 @@ static size_t mem_read_callback(void *ptr, size_t size, size_t nmemb,
     puppet->advance += n2read;  /* advance pointer */
     puppet->sizeleft -= n2read; /* less data left */
 
-    return nmemb2read;
+    return n2read / size;
 }
 
 // return the number of items
 static size_t header_write_callback(void *contents, size_t size, size_t nmemb,
                                     void *userp) {
-    size_t realsize = size * nmemb;
-    struct MemoryData *puppet = (struct MemoryData *)userp;
+    string *headers = (string *)userp;
 
-    if (!puppet->advance) return 0;
-
-    // write all or fail
-    if (realsize > puppet->sizeleft) {
-        printf("not enough memory in header_data\n");
-        return 0;
-    }
-
-    memcpy(puppet->advance, contents, realsize);
-    puppet->advance += realsize;
-    puppet->sizeleft -= realsize;
+    headers->append((const char *)contents, size * nmemb);
 
     return nmemb;
 }
 
-// XXX need free
-const char *GetUploadId(const char *host, const char *bucket,
-                        const char *obj_name, const S3Credential &cred) {
-    // POST /ObjectName?uploads HTTP/1.1
-    // Host: BucketName.s3.amazonaws.com
-    // Date: date
-    // Authorization: authorization string (see Authenticating Requests (AWS
-    // Signature Version 4))
-
-    // HTTP/1.1 200 OK
-    // x-amz-id-2: Uuag1LuByRx9e6j5Onimru9pO4ZVKnJ2Qz7/C1NPcfTWAtRPfTaOFg==
-    // x-amz-request-id: 656c76696e6727732072657175657374
-    // Date:  Mon, 1 Nov 2010 20:34:56 GMT
-    // Content-Length: 197
-    // Connection: keep-alive
-    // Server: AmazonS3
-    //
-    // <?xml version="1.0" encoding="UTF-8"?>
-    // <InitiateMultipartUploadResult
-    // xmlns="http://s3.amazonaws.com/doc/2006-03-01/">
-    //   <Bucket>example-bucket</Bucket>
-    //     <Key>example-object</Key>
-    //       <UploadId>VXBsb2FkIElEIGZvciA2aWWpbmcncyBteS1tb3ZpZS5tMnRzIHVwbG9hZA</UploadId>
-    //       </InitiateMultipartUploadResult>
-    std::stringstream url;
-    std::stringstream path_with_query;
-    XMLInfo xml;
-    xml.ctxt = NULL;
-
-    if (!host || !bucket || !obj_name) return NULL;
-
-    url << "http://" << host << "/" << bucket << "/" << obj_name;
-
-    HTTPHeaders *header = new HTTPHeaders();
-    header->Add(HOST, host);
-    header->Add(CONTENTTYPE, "application/x-www-form-urlencoded");
-    UrlParser p(url.str().c_str());
-    path_with_query << p.Path() << "?uploads";
-    SignPOSTv2(header, path_with_query.str(), cred);
-
-    CURL *curl = curl_easy_init();
-    if (curl) {
-        curl_easy_setopt(curl, CURLOPT_URL, url.str().c_str());
-#if DEBUG_S3_CURL
-        curl_easy_setopt(curl, CURLOPT_VERBOSE, 1L);
-#endif
-        curl_easy_setopt(curl, CURLOPT_FORBID_REUSE, 1L);
+// Value of the given field in the response headers, or "" if missing.
+static string GetHeaderValue(const string &headers, const char *field) {
+    size_t field_len = strlen(field);
+    size_t begin = 0;
 
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)&xml);
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, XMLParserCallback);
+    // RFC 2616 states "HTTP/1.1 defines the sequence CR LF as the end-of-line
+    // marker for all protocol elements except the entity-body"
+    while (begin < headers.length()) {
+        size_t end = headers.find("\r\n", begin);
+        if (end == string::npos) {
+            end = headers.length();
+        }
 
-        curl_easy_setopt(curl, CURLOPT_POST, 1L);
+        if ((end - begin > field_len) &&
+            !strncasecmp(headers.c_str() + begin, field, field_len) &&
+            headers[begin + field_len] == ':') {
+            size_t value_begin = begin + field_len + 1;
+            while ((value_begin < end) && (headers[value_begin] == ' ')) {
+                value_begin++;
+            }
+            return headers.substr(value_begin, end - value_begin);
+        }
 
-        curl_easy_setopt(curl, CURLOPT_POSTFIELDS, "uploads");
-        curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, (long)strlen("uploads"));
-    } else {
-        return NULL;
+        begin = end + 2;
     }
 
-    header->CreateList();
-    struct curl_slist *chunk = header->GetList();
-    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, chunk);
-
-    CURLcode res = curl_easy_perform(curl);
-
-    if (res != CURLE_OK)
-        fprintf(stderr, "curl_easy_perform() failed: %s\n",
-                curl_easy_strerror(res));
+    return "";
+}
 
-    xmlParseChunk(xml.ctxt, "", 0, 1);
-    header->FreeList();
-    curl_easy_cleanup(curl);
+// Content of the first child of the root element with the given name, or ""
+// if missing.
+static string GetXMLElement(xmlDocPtr doc, const char *name) {
+    string ret;
 
-    if (!xml.ctxt) {
-        printf("xmlParseChunk failed\n");
-        return NULL;
-    }
-    xmlNode *root_element = xmlDocGetRootElement(xml.ctxt->myDoc);
-    if (!root_element) return NULL;
+    xmlNode *root_element = xmlDocGetRootElement(doc);
+    if (!root_element) return ret;
 
-    char *upload_id = NULL;
     xmlNodePtr cur = root_element->xmlChildrenNode;
     while (cur != NULL) {
-        if (!xmlStrcmp(cur->name, (const xmlChar *)"UploadId")) {
-            upload_id = (char *)xmlNodeGetContent(cur);
+        if (!xmlStrcmp(cur->name, (const xmlChar *)name)) {
+            char *content = (char *)xmlNodeGetContent(cur);
+            if (content) {
+                ret = content;
+                xmlFree(content);
+            }
             break;
         }
 
         cur = cur->next;
     }
 
-    /* always cleanup */
-    xmlDocPtr doc = xml.ctxt->myDoc;
-    xmlFreeParserCtxt(xml.ctxt);
-    xmlFreeDoc(doc);
-    delete header;
-
-    return upload_id;
+    return ret;
 }
 
-// XXX need free
-const char *PartPutS3Object(const char *host, const char *bucket,
-                            const char *obj_name, const S3Credential &cred,
+// Sends a request about the object to S3, with data as the body. Retries
+// when the request can't be sent or S3 fails internally.
+//
+// It returns the response code, or -1 if the request couldn't be sent. The
+// response headers are appended to resp_headers if not NULL, and the XML
+// body, if any, is returned in doc, which the caller must free.
+static long S3ObjectRequest(const string &method, const string &schema,
+                            const string &region, const string &bucket,
+                            const string &key, const string &query,
                             const char *data, uint64_t data_size,
-                            uint64_t part_number, const char *upload_id) {
-    std::stringstream url;
-    std::stringstream path_with_query;
-    XMLInfo xml;
-    xml.ctxt = NULL;
-
-    char *header_buf = (char *)malloc(4 * 1024);
-    if (!header_buf) {
-        printf("failed to malloc header_buf\n");
-        return NULL;
-    } else {
-        memset(header_buf, 0, 4 * 1024);
-    }
-
-    struct MemoryData header_data = {header_buf, 4 * 1024};
-    struct MemoryData read_data = {(char *)data, data_size};
+                            const S3Credential &cred, string *resp_headers,
+                            xmlDocPtr *doc) {
+#ifdef DEBUG_S3_CURL
+    struct debug_data config;
+    config.trace_ascii = 1;
+#endif
 
-    if (!host || !bucket || !obj_name) {
-        free(header_buf);
-        return NULL;
-    }
+    stringstream host;
+    host << "s3-" << region << ".amazonaws.com";
 
-    url << "http://" << host << "/" << bucket << "/" << obj_name;
+    stringstream path;
+    path << "/" << bucket << "/" << key;
 
-    // PUT /ObjectName?partNumber=PartNumber&uploadId=UploadId HTTP/1.1
-    // Host: BucketName.s3.amazonaws.com
-    // Date: date
-    // Content-Length: Size
-    // Authorization: authorization string
+    // the query is given as signed, with parameters sorted and valued
+    stringstream url;
+    url << schema << "://" << host.str() << path.str() << "?" << query;
 
-    url << "?partNumber=" << part_number << "&uploadId=" << upload_id;
+    long respcode = -1;
+    int retry_time = 3;
 
-    HTTPHeaders *header = new HTTPHeaders();
-    header->Add(HOST, host);
-    // MIME type doesn't matter actually, server wouldn't store it either
-    header->Add(CONTENTTYPE, "text/plain");
-    header->Add(CONTENTLENGTH, std::to_string(data_size));
-    UrlParser p(url.str().c_str());
-    path_with_query << p.Path() << "?partNumber=" << part_number
-                    << "&uploadId=" << upload_id;
-    SignPUTv2(header, path_with_query.str(), cred);
+    *doc = NULL;
 
-    CURL *curl = curl_easy_init();
-    if (curl) {
-        /* specify target URL, and note that this URL should include a file
-           name, not only a directory */
-        curl_easy_setopt(curl, CURLOPT_URL, url.str().c_str());
+    while (retry_time--) {
+        if (retry_time != 2)  // sleep if retry
+            usleep(3 * 1000 * 1000);
 
-        /* now specify which file/data to upload */
-        curl_easy_setopt(curl, CURLOPT_READDATA, (void *)&read_data);
+        if (QueryCancelPending) {
+            S3INFO("Uploading is interrupted by GPDB");
+            return -1;
+        }
 
-        /* we want to use our own read function */
-        curl_easy_setopt(curl, CURLOPT_READFUNCTION, mem_read_callback);
+        HTTPHeaders headers;
+        headers.Add(HOST, host.str());
+        headers.Add(X_AMZ_CONTENT_SHA256, "UNSIGNED-PAYLOAD");
+        if (!SignRequestV4(method, &headers, region, path.str(), query,
+                           cred)) {
+            S3ERROR("Failed to sign %s request of %s", method.c_str(),
+                    url.str().c_str());
+            return -1;
+        }
 
-        /* provide the size of the upload, we specicially typecast the value
-           to curl_off_t since we must be sure to use the correct data size */
-        curl_easy_setopt(curl, CURLOPT_INFILESIZE_LARGE, (curl_off_t)data_size);
+        CURL *curl = AcquireCurlHandle();
+        if (!curl) {
+            S3ERROR("Failed to create curl instance, no enough memory?");
+            return -1;
+        }
 
-        /* enable uploading */
-        curl_easy_setopt(curl, CURLOPT_UPLOAD, 1L);
+        XMLInfo xml;
+        xml.ctxt = NULL;
 
-        /* HTTP PUT please */
-        curl_easy_setopt(curl, CURLOPT_PUT, 1L);
+        string headers_in;
+        struct MemoryData read_data = {data, data_size};
 
-#if DEBUG_S3_CURL
+#ifdef DEBUG_S3_CURL
+        curl_easy_setopt(curl, CURLOPT_DEBUGFUNCTION, trace_debug_data);
+        curl_easy_setopt(curl, CURLOPT_DEBUGDATA, &config);
         curl_easy_setopt(curl, CURLOPT_VERBOSE, 1L);
 #endif
-        curl_easy_setopt(curl, CURLOPT_FORBID_REUSE, 1L);
+        curl_easy_setopt(curl, CURLOPT_URL, url.str().c_str());
+
+        // consider low speed as timeout
+        curl_easy_setopt(curl, CURLOPT_LOW_SPEED_LIMIT, s3ext_low_speed_limit);
+        curl_easy_setopt(curl, CURLOPT_LOW_SPEED_TIME, s3ext_low_speed_time);
+
+        if (method != "DELETE") {
+            // the body, even if empty, is sent the way a PUT sends it
+            curl_easy_setopt(curl, CURLOPT_UPLOAD, 1L);
+            curl_easy_setopt(curl, CURLOPT_READDATA, (void *)&read_data);
+            curl_easy_setopt(curl, CURLOPT_READFUNCTION, mem_read_callback);
+            curl_easy_setopt(curl, CURLOPT_INFILESIZE_LARGE,
+                             (curl_off_t)data_size);
+        }
+        curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, method.c_str());
 
-        curl_easy_setopt(curl, CURLOPT_HEADERDATA, (void *)&header_data);
+        curl_easy_setopt(curl, CURLOPT_HEADERDATA, (void *)&headers_in);
         curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, header_write_callback);
 
         curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)&xml);
         curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, XMLParserCallback);
-    } else {
-        free(header_buf);
-        return NULL;
-    }
 
-    header->CreateList();
-    struct curl_slist *chunk = header->GetList();
-    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, chunk);
+        headers.CreateList();
+        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers.GetList());
 
-    CURLcode res = curl_easy_perform(curl);
-    if (res != CURLE_OK)
-        fprintf(stderr, "curl_easy_perform() failed: %s\n",
-                curl_easy_strerror(res));
+        CURLcode res = curl_easy_perform(curl);
 
-    // to get the Etag from response
-    // HTTP/1.1 200 OK
-    // x-amz-id-2: Vvag1LuByRx9e6j5Onimru9pO4ZVKnJ2Qz7/C1NPcfTWAtRPfTaOFg==
-    // x-amz-request-id: 656c76696e6727732072657175657374
-    // Date:  Mon, 1 Nov 2010 20:34:56 GMT
-    // ETag: "b54357faf0632cce46e942fa68356b38"
-    // Content-Length: 0
-    // Connection: keep-alive
-    // Server: AmazonS3
-
-    std::ostringstream out;
-    out << header_buf;
+        respcode = -1;
+        if (res == CURLE_OK) {
+            curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &respcode);
+        } else {
+            S3ERROR("curl_easy_perform() failed: %s", curl_easy_strerror(res));
+        }
 
-    // std::cout << header_buf << std::endl;
+        ReleaseCurlHandle(curl);
 
-    free(header_buf);
-    header_buf = NULL;
+        if (xml.ctxt) {
+            xmlParseChunk(xml.ctxt, "", 0, 1);
+            *doc = xml.ctxt->myDoc;
+            xmlFreeParserCtxt(xml.ctxt);
+        }
 
-    // TODO general header content extracting func
-    uint64_t etag_start_pos = out.str().find("ETag: ") + 6;
-    std::string etag_to_end = out.str().substr(etag_start_pos);
-    // RFC 2616 states "HTTP/1.1 defines the sequence CR LF as the end-of-line
-    // marker for all protocol elements except the entity-body"
-    uint64_t etag_len = etag_to_end.find("\r");
+        if (res == CURLE_ABORTED_BY_CALLBACK) {
+            S3INFO("Uploading is interrupted by GPDB");
+            break;
+        }
 
-    const char *etag = etag_to_end.substr(0, etag_len).c_str();
+        // S3 asks to retry on internal errors, as it does on slow networks
+        if ((respcode == -1) || (respcode >= 500)) {
+            if (*doc) {
+                xmlFreeDoc(*doc);
+                *doc = NULL;
+            }
+            S3WARN("%s request of %s failed, response code is %ld, retry",
+                   method.c_str(), url.str().c_str(), respcode);
+            continue;
+        }
 
-    if (etag) {
-        header->FreeList();
-        delete header;
-        curl_easy_cleanup(curl);
+        if (resp_headers) {
+            resp_headers->append(headers_in);
+        }
 
-        return strdup(etag);
+        if ((respcode < 200) || (respcode >= 300)) {
+            S3ERROR("%s request of %s failed, response code is %ld, %s",
+                    method.c_str(), url.str().c_str(), respcode,
+                    *doc ? GetXMLElement(*doc, "Code").c_str() : "");
+        }
+        break;
     }
 
-    // <Error>
-    //   <Code>AccessDenied</Code>
-    //   <Message>Access Denied</Message>
-    //   <RequestId>656c76696e6727732072657175657374</RequestId>
-    //   <HostId>Uuag1LuByRx9e6j5Onimru9pO4ZVKnJ2Qz7/C1NPcfTWAtRPfTaOFg==</HostId>
-    // </Error>
-    xmlParseChunk(xml.ctxt, "", 0, 1);
-    if (!xml.ctxt) {
-        printf("xmlParseChunk failed\n");
-        return NULL;
-    }
-    xmlNode *root_element = xmlDocGetRootElement(xml.ctxt->myDoc);
-    if (!root_element) return NULL;
+    return respcode;
+}
 
-    char *response_code = NULL;
-    xmlNodePtr cur = root_element->xmlChildrenNode;
-    while (cur != NULL) {
-        if (!xmlStrcmp(cur->name, (const xmlChar *)"Code")) {
-            response_code = (char *)xmlNodeGetContent(cur);
-            break;
-        }
+// POST /ObjectName?uploads HTTP/1.1
+//
+// <InitiateMultipartUploadResult>
+//   <Bucket>example-bucket</Bucket>
+//   <Key>example-object</Key>
+//   <UploadId>VXBsb2FkIElEIGZvciA2aWWpbmcncyBteS1tb3ZpZS5tMnRzIHVwbG9hZA</UploadId>
+// </InitiateMultipartUploadResult>
+string GetUploadId(const string &schema, const string &region,
+                   const string &bucket, const string &key,
+                   const S3Credential &cred) {
+    xmlDocPtr doc = NULL;
+    string upload_id;
+
+    long respcode = S3ObjectRequest("POST", schema, region, bucket, key,
+                                    "uploads=", NULL, 0, cred, NULL, &doc);
+    if ((respcode == 200) && doc) {
+        upload_id = GetXMLElement(doc, "UploadId");
+    }
 
-        cur = cur->next;
+    if (doc) {
+        xmlFreeDoc(doc);
     }
 
-    if (response_code) {
-        std::cout << "Error: " << response_code << std::endl;
-        xmlFree(response_code);
+    if (upload_id.empty()) {
+        S3ERROR("Failed to initiate uploading of %s", key.c_str());
     }
 
-    xmlDocPtr doc = xml.ctxt->myDoc;
-    xmlFreeParserCtxt(xml.ctxt);
-    xmlFreeDoc(doc);
+    return upload_id;
+}
 
-    curl_easy_cleanup(curl);
+// PUT /ObjectName?partNumber=PartNumber&uploadId=UploadId HTTP/1.1
+//
+// HTTP/1.1 200 OK
+// ETag: "b54357faf0632cce46e942fa68356b38"
+string PartPutS3Object(const string &schema, const string &region,
+                       const string &bucket, const string &key,
+                       const S3Credential &cred, const char *data,
+                       uint64_t data_size, uint64_t part_number,
+                       const string &upload_id) {
+    xmlDocPtr doc = NULL;
+    string resp_headers;
+    string etag;
+
+    stringstream query;
+    query << "partNumber=" << part_number << "&uploadId=" << upload_id;
+
+    long respcode =
+        S3ObjectRequest("PUT", schema, region, bucket, key, query.str(), data,
+                        data_size, cred, &resp_headers, &doc);
+    if (respcode == 200) {
+        etag = GetHeaderValue(resp_headers, "ETag");
+    }
 
-    header->FreeList();
-    delete header;
+    if (doc) {
+        xmlFreeDoc(doc);
+    }
 
-    return NULL;
+    if (etag.empty()) {
+        S3ERROR("Failed to upload part %" PRIu64 " of %s", part_number,
+                key.c_str());
+    }
+
+    return etag;
 }
 
-bool CompleteMultiPutS3(const char *host, const char *bucket,
-                        const char *obj_name, const char *upload_id,
-                        const char **etag_array, uint64_t count,
+// POST /ObjectName?uploadId=UploadId HTTP/1.1
+//
+// <CompleteMultipartUpload>
+//   <Part>
+//     <PartNumber>1</PartNumber>
+//     <ETag>"a54357aff0632cce46d942af68356b38"</ETag>
+//   </Part>
+//   ...
+// </CompleteMultipartUpload>
+//
+// S3 may fail after it started to respond with 200, the body tells.
+bool CompleteMultiPutS3(const string &schema, const string &region,
+                        const string &bucket, const string &key,
+                        const string &upload_id, const vector<string> &etags,
                         const S3Credential &cred) {
-    std::stringstream url;
-    std::stringstream path_with_query;
-    XMLInfo xml;
-    xml.ctxt = NULL;
-
-#ifdef DEBUG_S3_CURL
-    struct debug_data config;
-    config.trace_ascii = 1;
-#endif
-
-    if (!host || !bucket || !obj_name) return false;
-
-    url << "http://" << host << "/" << bucket << "/" << obj_name;
-
-    url << "?uploadId=" << upload_id;
-
-    // POST
-    // /example-object?uploadId=AAAsb2FkIElEIGZvciBlbHZpbmcncyWeeS1tb3ZpZS5tMnRzIRRwbG9hZA
-    // HTTP/1.1
-    // Host: example-bucket.s3.amazonaws.com
-    // Date:  Mon, 1 Nov 2010 20:34:56 GMT
-    // Content-Length: 391
-    // Authorization: authorization string
-    //
-    // <CompleteMultipartUpload>
-    //   <Part>
-    //     <PartNumber>1</PartNumber>
-    //     <ETag>"a54357aff0632cce46d942af68356b38"</ETag>
-    //   </Part>
-    //   <Part>
-    //     <PartNumber>2</PartNumber>
-    //     <ETag>"0c78aef83f66abc1fa1e8477f296d394"</ETag>
-    //   </Part>
-    //   <Part>
-    //     <PartNumber>3</PartNumber>
-    //     <ETag>"acbd18db4cc2f85cedef654fccc4a4d8"</ETag>
-    //   </Part>
-    // </CompleteMultipartUpload>
-    std::stringstream body;
+    xmlDocPtr doc = NULL;
+    bool ret = false;
 
+    stringstream body;
     body << "<CompleteMultipartUpload>\n";
-    for (uint64_t i = 0; i < count; ++i) {
+    for (uint64_t i = 0; i < etags.size(); ++i) {
         body << "  <Part>\n    <PartNumber>" << i + 1
-             << "</PartNumber>\n    <ETag>" << etag_array[i]
+             << "</PartNumber>\n    <ETag>" << etags[i]
              << "</ETag>\n  </Part>\n";
     }
     body << "</CompleteMultipartUpload>";
 
-    // std::cout << body.str().c_str() << std::endl;
+    string body_str = body.str();
+    string query = "uploadId=" + upload_id;
+
+    long respcode = S3ObjectRequest("POST", schema, region, bucket, key, query,
+                                    body_str.c_str(), body_str.length(), cred,
+                                    NULL, &doc);
+    if ((respcode == 200) && doc) {
+        xmlNode *root_element = xmlDocGetRootElement(doc);
+        if (root_element &&
+            xmlStrcmp(root_element->name, (const xmlChar *)"Error")) {
+            ret = true;
+        } else {
+            S3ERROR("Failed to complete uploading of %s, %s", key.c_str(),
+                    GetXMLElement(doc, "Code").c_str());
+        }
+    }
 
-    uint32_t body_size = strlen(body.str().c_str());
-    char *body_data = (char *)malloc(body_size);
-    if (body_data) {
-        memcpy(body_data, body.str().c_str(), body_size);
+    if (doc) {
+        xmlFreeDoc(doc);
     }
-    struct MemoryData read_data = {body_data, body_size};
 
-    HTTPHeaders *header = new HTTPHeaders();
-    header->Add(HOST, host);
-    header->Add(CONTENTTYPE, "application/xml");
-    header->Add(CONTENTLENGTH, std::to_string(body_size));
-    UrlParser p(url.str().c_str());
-    path_with_query << p.Path() << "?uploadId=" << upload_id;
-    SignPOSTv2(header, path_with_query.str(), cred);
+    return ret;
+}
 
-    CURL *curl = curl_easy_init();
-    if (curl) {
-#ifdef DEBUG_S3_CURL
-        curl_easy_setopt(curl, CURLOPT_DEBUGFUNCTION, trace_debug_data);
-        curl_easy_setopt(curl, CURLOPT_DEBUGDATA, &config);
-#endif
-        /* specify target URL, and note that this URL should include a file
-           name, not only a directory */
-        curl_easy_setopt(curl, CURLOPT_URL, url.str().c_str());
+// DELETE /ObjectName?uploadId=UploadId HTTP/1.1
+bool AbortMultiPutS3(const string &schema, const string &region,
+                     const string &bucket, const string &key,
+                     const string &upload_id, const S3Credential &cred) {
+    xmlDocPtr doc = NULL;
+    string query = "uploadId=" + upload_id;
+
+    long respcode = S3ObjectRequest("DELETE", schema, region, bucket, key,
+                                    query, NULL, 0, cred, NULL, &doc);
+    if (doc) {
+        xmlFreeDoc(doc);
+    }
 
-        /* now specify which file/data to upload */
-        curl_easy_setopt(curl, CURLOPT_READDATA, (void *)&read_data);
+    return respcode == 204;
+}
 
-        /* we want to use our own read function */
-        curl_easy_setopt(curl, CURLOPT_READFUNCTION, mem_read_callback);
+void *UploadThreadfunc(void *data) {
+    Uploader *uploader = reinterpret_cast<Uploader *>(data);
+    UploadPart *part = NULL;
+
+    S3INFO("Uploading thread starts");
+    while ((part = uploader->next()) != NULL) {
+        string etag = PartPutS3Object(
+            uploader->schema, uploader->region, uploader->bucket,
+            uploader->key, uploader->cred, part->data, part->len, part->number,
+            uploader->uploadid);
+        S3DEBUG("Uploaded part %" PRIu64 ", %" PRIu64 " bytes", part->number,
+                part->len);
+        uploader->done(part, etag);
+    }
+    S3INFO("Uploading thread ended");
 
-        /* provide the size of the upload, we specicially typecast the value
-           to curl_off_t since we must be sure to use the correct data size
-           */
-        curl_easy_setopt(curl, CURLOPT_INFILESIZE_LARGE, (curl_off_t)body_size);
+    return NULL;
+}
 
-#ifdef DEBUG_S3_CURL
-        curl_easy_setopt(curl, CURLOPT_VERBOSE, 1L);
-#endif
-        curl_easy_setopt(curl, CURLOPT_FORBID_REUSE, 1L);
+Uploader::Uploader(uint8_t part_num)
+    : num(part_num),
+      threadcount(0),
+      partsize(0),
+      curpart(NULL),
+      partcount(0),
+      allocated(0),
+      finished(false),
+      error(false) {
+    this->threads = (pthread_t *)malloc(num * sizeof(pthread_t));
+    if (this->threads)
+        memset((void *)this->threads, 0, num * sizeof(pthread_t));
+    else {
+        S3ERROR("Failed to malloc thread, no enough memory");
+    }
 
-        curl_easy_setopt(curl, CURLOPT_POST, 1L);
+    pthread_mutex_init(&this->mutex, NULL);
+    pthread_cond_init(&this->cond, NULL);
+}
 
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)&xml);
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, XMLParserCallback);
-    } else {
+Uploader::~Uploader() {
+    // in case destroy() was not called
+    this->stop();
+
+    if (this->curpart) {
+        this->freed.push_back(this->curpart);
+        this->curpart = NULL;
+    }
+    while (!this->queued.empty()) {
+        this->freed.push_back(this->queued.front());
+        this->queued.pop_front();
+    }
+    for (size_t i = 0; i < this->freed.size(); i++) {
+        free(this->freed[i]->data);
+        delete this->freed[i];
+    }
+    this->freed.clear();
+
+    if (this->threads) free(this->threads);
+
+    pthread_mutex_destroy(&this->mutex);
+    pthread_cond_destroy(&this->cond);
+}
+
+bool Uploader::init(const string &schema, const string &region,
+                    const string &bucket, const string &key,
+                    uint64_t chunksize, S3Credential *pcred) {
+    if (!this->threads || !pcred) {
         return false;
     }
 
-    header->CreateList();
-    struct curl_slist *chunk = header->GetList();
-    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, chunk);
-
-    CURLcode res = curl_easy_perform(curl);
-    if (res != CURLE_OK)
-        fprintf(stderr, "curl_easy_perform() failed: %s\n",
-                curl_easy_strerror(res));
-
-    // HTTP/1.1 200 OK
-    // x-amz-id-2: Uuag1LuByRx9e6j5Onimru9pO4ZVKnJ2Qz7/C1NPcfTWAtRPfTaOFg==
-    // x-amz-request-id: 656c76696e6727732072657175657374
-    // Date: Mon, 1 Nov 2010 20:34:56 GMT
-    // Connection: close
-    // Server: AmazonS3
-    //
-    // <?xml version="1.0" encoding="UTF-8"?>
-    // <CompleteMultipartUploadResult
-    // xmlns="http://s3.amazonaws.com/doc/2006-03-01/">
-    //   <Location>http://Example-Bucket.s3.amazonaws.com/Example-Object</Location>
-    //   <Bucket>Example-Bucket</Bucket>
-    //   <Key>Example-Object</Key>
-    //   <ETag>"3858f62230ac3c915f300c664312c11f-9"</ETag>
-    // </CompleteMultipartUploadResult>
-
-    // <Error>
-    //   <Code>AccessDenied</Code>
-    //   <Message>Access Denied</Message>
-    //   <RequestId>656c76696e6727732072657175657374</RequestId>
-    //   <HostId>Uuag1LuByRx9e6j5Onimru9pO4ZVKnJ2Qz7/C1NPcfTWAtRPfTaOFg==</HostId>
-    // </Error>
-    xmlParseChunk(xml.ctxt, "", 0, 1);
-    if (!xml.ctxt) {
-        printf("xmlParseChunk failed\n");
+    this->schema = schema;
+    this->region = region;
+    this->bucket = bucket;
+    this->key = key;
+    this->cred = *pcred;
+    this->partsize = std::max(chunksize, (uint64_t)S3_UPLOAD_MIN_PARTSIZE);
+
+    for (int i = 0; i < this->num; i++) {
+        if (pthread_create(&this->threads[i], NULL, UploadThreadfunc, this)) {
+            S3ERROR("Failed to create uploading thread");
+            return false;
+        }
+        this->threadcount++;
+    }
+
+    return true;
+}
+
+// Copies the data into parts, and hands the full ones to the threads
+bool Uploader::write(const char *buf, uint64_t len) {
+    while (len > 0) {
+        if (!this->curpart) {
+            pthread_mutex_lock(&this->mutex);
+            // a part more than there are threads, so that one can be written
+            // while all of them upload
+            while (this->freed.empty() && !this->error &&
+                   (this->allocated > this->num)) {
+                pthread_cond_wait(&this->cond, &this->mutex);
+            }
+
+            bool failed = this->error;
+            if (!failed && !this->freed.empty()) {
+                this->curpart = this->freed.back();
+                this->freed.pop_back();
+            }
+            pthread_mutex_unlock(&this->mutex);
+
+            if (failed) {
+                S3ERROR("Failed to upload data of %s", this->key.c_str());
+                return false;
+            }
+
+            if (!this->curpart) {
+                char *data = (char *)malloc(this->partsize);
+                if (!data) {
+                    S3ERROR("Failed to allocate part, no enough memory?");
+                    return false;
+                }
+                this->curpart = new UploadPart();
+                this->curpart->data = data;
+                this->allocated++;
+            }
+            this->curpart->len = 0;
+        }
+
+        uint64_t tocopy = std::min(len, this->partsize - this->curpart->len);
+        memcpy(this->curpart->data + this->curpart->len, buf, tocopy);
+        this->curpart->len += tocopy;
+        buf += tocopy;
+        len -= tocopy;
+
+        if (this->curpart->len == this->partsize) {
+            if (!this->queue(this->curpart)) {
+                return false;
+            }
+            this->curpart = NULL;
+        }
+    }
+
+    return true;
+}
+
+bool Uploader::destroy() {
+    bool ret = true;
+
+    pthread_mutex_lock(&this->mutex);
+    bool failed = this->error;
+    pthread_mutex_unlock(&this->mutex);
+
+    // the last part may be smaller than the others
+    if (this->curpart && (this->curpart->len > 0) && !failed) {
+        ret = this->queue(this->curpart);
+        if (ret) {
+            this->curpart = NULL;
+        }
+    }
+
+    this->stop();
+
+    if (this->uploadid.empty()) {
+        // nothing was written, so there is no object to complete
+        return ret && !this->error;
+    }
+
+    if (ret && !this->error) {
+        ret = CompleteMultiPutS3(this->schema, this->region, this->bucket,
+                                 this->key, this->uploadid, this->etags,
+                                 this->cred);
+    } else {
+        ret = false;
+    }
+
+    if (!ret) {
+        // or S3 keeps, and charges for, the uploaded parts
+        if (!AbortMultiPutS3(this->schema, this->region, this->bucket,
+                             this->key, this->uploadid, this->cred)) {
+            S3WARN("Failed to abort uploading of %s, upload id is %s",
+                   this->key.c_str(), this->uploadid.c_str());
+        }
+    }
+    this->uploadid.clear();
+
+    return ret;
+}
+
+void Uploader::cancel() {
+    pthread_mutex_lock(&this->mutex);
+    this->error = true;
+    pthread_cond_broadcast(&this->cond);
+    pthread_mutex_unlock(&this->mutex);
+}
+
+// Hands the part to the threads, the upload starts with the first part
+bool Uploader::queue(UploadPart *part) {
+    if (this->partcount >= S3_UPLOAD_MAX_PARTNUM) {
+        S3ERROR("Too many parts to upload for %s, increase chunksize",
+                this->key.c_str());
         return false;
     }
 
-    xmlNode *root_element = xmlDocGetRootElement(xml.ctxt->myDoc);
-    if (!root_element) return false;
+    if (this->uploadid.empty()) {
+        this->uploadid = GetUploadId(this->schema, this->region, this->bucket,
+                                     this->key, this->cred);
+        if (this->uploadid.empty()) {
+            return false;
+        }
+    }
 
-    char *response_code = NULL;
-    xmlNodePtr cur = root_element->xmlChildrenNode;
-    while (cur != NULL) {
-        if (!xmlStrcmp(cur->name, (const xmlChar *)"Code")) {
-            response_code = (char *)xmlNodeGetContent(cur);
+    pthread_mutex_lock(&this->mutex);
+    part->number = ++this->partcount;
+    this->etags.push_back("");
+    this->queued.push_back(part);
+    pthread_cond_broadcast(&this->cond);
+    pthread_mutex_unlock(&this->mutex);
+
+    return true;
+}
+
+// Next part for a thread to upload, or NULL when there is nothing left to
+// do. Once a part failed, the rest are not uploaded.
+UploadPart *Uploader::next() {
+    UploadPart *part = NULL;
+
+    pthread_mutex_lock(&this->mutex);
+    while (this->queued.empty() && !this->finished && !this->error) {
+        pthread_cond_wait(&this->cond, &this->mutex);
+    }
+    if (!this->queued.empty() && !this->error) {
+        part = this->queued.front();
+        this->queued.pop_front();
+    }
+    pthread_mutex_unlock(&this->mutex);
+
+    return part;
+}
+
+void Uploader::done(UploadPart *part, const string &etag) {
+    pthread_mutex_lock(&this->mutex);
+    if (etag.empty()) {
+        this->error = true;
+    } else {
+        this->etags[part->number - 1] = etag;
+    }
+    this->freed.push_back(part);
+    pthread_cond_broadcast(&this->cond);
+    pthread_mutex_unlock(&this->mutex);
+}
+
+// Waits for the threads to upload the queued parts, and to end
+void Uploader::stop() {
+    pthread_mutex_lock(&this->mutex);
+    this->finished = true;
+    pthread_cond_broadcast(&this->cond);
+    pthread_mutex_unlock(&this->mutex);
+
+    for (int i = 0; i < this->threadcount; i++) {
+        pthread_join(this->threads[i], NULL);
+    }
+    this->threadcount = 0;
+}
+
+void *CompressThreadfunc(void *data) {
+    Compressor *compressor = reinterpret_cast<Compressor *>(data);
+    bool ok = true;
+
+    S3INFO("Compressing thread starts");
+    pthread_mutex_lock(&compressor->mutex);
+    while (true) {
+        while (!compressor->pending && !compressor->finished) {
+            pthread_cond_wait(&compressor->cond, &compressor->mutex);
+        }
+        if (!compressor->pending || compressor->error) {
             break;
         }
 
-        cur = cur->next;
+        char *chunk = compressor->pending;
+        uint64_t len = compressor->pendinglen;
+        pthread_mutex_unlock(&compressor->mutex);
+
+        ok = compressor->deflateChunk(chunk, len, Z_NO_FLUSH);
+
+        pthread_mutex_lock(&compressor->mutex);
+        compressor->pending = NULL;
+        pthread_cond_broadcast(&compressor->cond);
+        if (!ok) {
+            break;
+        }
+    }
+    // the stream is only ended if all of the data made it
+    ok = ok && !compressor->error;
+    pthread_mutex_unlock(&compressor->mutex);
+
+    if (ok) {
+        ok = compressor->deflateChunk(NULL, 0, Z_FINISH);
+    }
+
+    if (!ok) {
+        pthread_mutex_lock(&compressor->mutex);
+        compressor->error = true;
+        pthread_cond_broadcast(&compressor->cond);
+        pthread_mutex_unlock(&compressor->mutex);
+    }
+    S3INFO("Compressing thread ended");
+
+    return NULL;
+}
+
+Compressor::Compressor(Uploader *uploader)
+    : uploader(uploader),
+      started(false),
+      zinited(false),
+      outbuf(NULL),
+      curchunk(0),
+      curlen(0),
+      pending(NULL),
+      pendinglen(0),
+      finished(false),
+      error(false) {
+    this->chunks[0] = NULL;
+    this->chunks[1] = NULL;
+
+    pthread_mutex_init(&this->mutex, NULL);
+    pthread_cond_init(&this->cond, NULL);
+}
+
+Compressor::~Compressor() {
+    if (this->started) {
+        // in case destroy() was not called, the stream is left unfinished
+        pthread_mutex_lock(&this->mutex);
+        this->error = true;
+        this->finished = true;
+        pthread_cond_broadcast(&this->cond);
+        pthread_mutex_unlock(&this->mutex);
+        pthread_join(this->thread, NULL);
     }
 
-    if (response_code) {
-        std::cout << "Error: " << response_code << std::endl;
+    if (this->zinited) {
+        deflateEnd(&this->zstream);
     }
 
-    delete header;
-    curl_easy_cleanup(curl);
-    free(body_data);
+    free(this->chunks[0]);
+    free(this->chunks[1]);
+    free(this->outbuf);
+
+    pthread_mutex_destroy(&this->mutex);
+    pthread_cond_destroy(&this->cond);
+}
+
+bool Compressor::init(int level) {
+    if (!this->uploader) {
+        return false;
+    }
 
-    if (response_code) {
-        xmlFree(response_code);
+    this->chunks[0] = (char *)malloc(S3_COMPRESS_CHUNKSIZE);
+    this->chunks[1] = (char *)malloc(S3_COMPRESS_CHUNKSIZE);
+    this->outbuf = (char *)malloc(S3_COMPRESS_CHUNKSIZE);
+    if (!this->chunks[0] || !this->chunks[1] || !this->outbuf) {
+        S3ERROR("Failed to allocate compression buffers, no enough memory?");
         return false;
     }
 
-    xmlDocPtr doc = xml.ctxt->myDoc;
-    xmlFreeParserCtxt(xml.ctxt);
-    xmlFreeDoc(doc);
+    this->zstream.zalloc = Z_NULL;
+    this->zstream.zfree = Z_NULL;
+    this->zstream.opaque = Z_NULL;
+
+    // 31 (15 + 16) makes a gzip stream with the largest window, which is
+    // what Downloader::set_compression() detects on the way back
+    if (deflateInit2(&this->zstream, level, Z_DEFLATED, 31, 8,
+                     Z_DEFAULT_STRATEGY) != Z_OK) {
+        S3ERROR("Failed to init gzip function");
+        return false;
+    }
+    this->zinited = true;
+
+    if (pthread_create(&this->thread, NULL, CompressThreadfunc, this)) {
+        S3ERROR("Failed to create compressing thread");
+        return false;
+    }
+    this->started = true;
 
     return true;
 }
 
-bool Uploader::init(const char *data, S3Credential *cred) {
-    // char *url = //TODO;
+// Copies the data into chunks, and hands the full ones to the thread
+bool Compressor::write(const char *buf, uint64_t len) {
+    while (len > 0) {
+        char *chunk = this->chunks[this->curchunk];
+        uint64_t tocopy = std::min(len, S3_COMPRESS_CHUNKSIZE - this->curlen);
+        memcpy(chunk + this->curlen, buf, tocopy);
+        this->curlen += tocopy;
+        buf += tocopy;
+        len -= tocopy;
+
+        if (this->curlen == S3_COMPRESS_CHUNKSIZE) {
+            if (!this->hand(chunk, this->curlen)) {
+                return false;
+            }
+            this->curchunk = 1 - this->curchunk;
+            this->curlen = 0;
+        }
+    }
 
     return true;
 }
 
-Uploader::Uploader() {
-    // fork //TODO
+bool Compressor::destroy() {
+    if (!this->started) {
+        return false;
+    }
+
+    bool ret = true;
+    if (this->curlen > 0) {
+        ret = this->hand(this->chunks[this->curchunk], this->curlen);
+        this->curlen = 0;
+    }
+
+    pthread_mutex_lock(&this->mutex);
+    if (!ret) {
+        this->error = true;
+    }
+    this->finished = true;
+    pthread_cond_broadcast(&this->cond);
+    pthread_mutex_unlock(&this->mutex);
 
-    // PutS3Object(host, bucket, url, cred, data);
+    pthread_join(this->thread, NULL);
+    this->started = false;
+
+    return !this->error;
 }
 
-Uploader::~Uploader() {}
+// Hands the chunk to the thread, once it is done with the previous one,
+// which is the other chunk
+bool Compressor::hand(char *chunk, uint64_t len) {
+    pthread_mutex_lock(&this->mutex);
+    while (this->pending && !this->error) {
+        pthread_cond_wait(&this->cond, &this->mutex);
+    }
 
-void Uploader::destroy() {}
+    bool failed = this->error;
+    if (!failed) {
+        this->pending = chunk;
+        this->pendinglen = len;
+        pthread_cond_broadcast(&this->cond);
+    }
+    pthread_mutex_unlock(&this->mutex);
 
-bool Uploader::write(char *data, uint64_t &len) { return true; }
+    if (failed) {
+        S3ERROR("Failed to compress data of the upload");
+    }
+
+    return !failed;
+}
+
+// Deflates the chunk, and writes out the compressed data as the output
+// buffer fills up
+bool Compressor::deflateChunk(const char *chunk, uint64_t len, int flush) {
+    z_stream *strm = &this->zstream;
+
+    strm->next_in = (Bytef *)chunk;
+    strm->avail_in = len;
+
+    do {
+        strm->next_out = (Bytef *)this->outbuf;
+        strm->avail_out = S3_COMPRESS_CHUNKSIZE;
+
+        if (deflate(strm, flush) == Z_STREAM_ERROR) {
+            S3ERROR("Failed to compress data");
+            return false;
+        }
+
+        uint64_t have = S3_COMPRESS_CHUNKSIZE - strm->avail_out;
+        if ((have > 0) && !this->uploader->write(this->outbuf, have)) {
+            return false;
+        }
+    } while (strm->avail_out == 0);
+
+    return true;
+}
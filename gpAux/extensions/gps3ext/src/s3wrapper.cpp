@@ -1,5 +1,9 @@
+#include <algorithm>
+#include <functional>
+#include <queue>
 #include <sstream>
 #include <string>
+#include <utility>
 
 #include "gps3ext.h"
 #include "s3conf.h"
@@ -42,7 +46,7 @@ S3ExtBase::~S3ExtBase() {}
 S3Reader::~S3Reader() {}
 
 S3Reader::S3Reader(const string &url) : S3ExtBase(url) {
-    this->contentindex = -1;
+    this->contentindex = 0;
     this->filedownloader = NULL;
     this->keylist = NULL;
 }
@@ -53,7 +57,7 @@ bool S3Reader::Init(int segid, int segnum, int chunksize) {
         // set segment id and num
         this->segid = s3ext_segid;
         this->segnum = s3ext_segnum;
-        this->contentindex = this->segid;
+        this->contentindex = 0;
 
         this->chunksize = chunksize;
 
@@ -96,6 +100,12 @@ bool S3Reader::Init(int segid, int segnum, int chunksize) {
             break;
         }
         S3INFO("Got %d files to download", this->keylist->contents.size());
+
+        this->keyranges = AssignKeyRanges(this->keylist, this->segid,
+                                          this->segnum, s3ext_autosplit);
+        S3INFO("Got %d of them, or ranges of them, to download",
+               this->keyranges.size());
+
         if (!this->getNextDownloader()) {
             return false;
         }
@@ -115,7 +125,7 @@ bool S3Reader::getNextDownloader() {
         this->filedownloader = NULL;
     }
 
-    if (this->contentindex >= this->keylist->contents.size()) {
+    if (this->contentindex >= this->keyranges.size()) {
         S3DEBUG("No more files to download");
         return true;
     }
@@ -131,24 +141,107 @@ bool S3Reader::getNextDownloader() {
         S3ERROR("Failed to create filedownloader");
         return false;
     }
-    BucketContent *c = this->keylist->contents[this->contentindex];
+    const KeyRange &kr = this->keyranges[this->contentindex];
+    BucketContent *c = kr.content;
     string keyurl = this->getKeyURL(c->Key());
-    S3DEBUG("key: %s, size: %llu", keyurl.c_str(), c->Size());
+    S3DEBUG("key: %s, size: %llu, range: %llu+%llu", keyurl.c_str(),
+            c->Size(), kr.range.offset, kr.range.len);
 
     if (!filedownloader->init(keyurl, this->region, c->Size(), this->chunksize,
-                              &this->cred)) {
+                              &this->cred, kr.range)) {
         delete this->filedownloader;
         this->filedownloader = NULL;
         return false;
     } else {  // move to next file
-        // for now, every segment downloads its assigned files(mod)
-        // better to build a workqueue in case not all segments are available
-        this->contentindex += this->segnum;
+        this->contentindex++;
     }
 
     return true;
 }
 
+// Larger first, the order must be the same on all segments
+static bool KeyRangeLarger(const KeyRange &a, const KeyRange &b) {
+    if (a.range.len != b.range.len) {
+        return a.range.len > b.range.len;
+    }
+    if (a.content->Key() != b.content->Key()) {
+        return a.content->Key() < b.content->Key();
+    }
+    return a.range.offset < b.range.offset;
+}
+
+// Returns the keys, or ranges of them, the segment is to read.
+//
+// Keys are assigned by size, so that segments are done at about the same
+// time even if a few keys are much larger than the others: the largest key
+// goes first, each to the segment with the fewest bytes so far. Keys larger
+// than the share of a segment are split into ranges first, unless they look
+// compressed. All segments list the same keys and compute the same
+// assignment, so each reads its own share without talking to the others.
+vector<KeyRange> AssignKeyRanges(const ListBucketResult *keylist, int segid,
+                                 int segnum, bool split) {
+    vector<KeyRange> all;
+    vector<KeyRange> mine;
+    uint64_t total = 0;
+
+    if (!keylist || (segnum <= 0)) {
+        return mine;
+    }
+
+    for (size_t i = 0; i < keylist->contents.size(); i++) {
+        total += keylist->contents[i]->Size();
+    }
+    uint64_t splitsize = std::max(total / segnum, S3_SPLIT_MINSIZE);
+
+    for (size_t i = 0; i < keylist->contents.size(); i++) {
+        BucketContent *c = keylist->contents[i];
+        uint64_t size = c->Size();
+        string key = c->Key();
+        bool gz = (key.length() >= 3) &&
+                  (key.compare(key.length() - 3, 3, ".gz") == 0);
+
+        uint64_t len = size;
+        if (split && (size > splitsize) && !gz) {
+            uint64_t n = (size + splitsize - 1) / splitsize;
+            len = (size + n - 1) / n;
+        }
+
+        uint64_t offset = 0;
+        do {
+            KeyRange kr;
+            kr.content = c;
+            kr.range.offset = offset;
+            kr.range.len = std::min(len, size - offset);
+            all.push_back(kr);
+            offset += kr.range.len;
+        } while (offset < size);
+    }
+
+    std::sort(all.begin(), all.end(), KeyRangeLarger);
+
+    // segments by bytes assigned, then by id
+    typedef std::pair<uint64_t, int> SegLoad;
+    std::priority_queue<SegLoad, vector<SegLoad>, std::greater<SegLoad> >
+        loads;
+    for (int i = 0; i < segnum; i++) {
+        loads.push(SegLoad(0, i));
+    }
+
+    for (size_t i = 0; i < all.size(); i++) {
+        SegLoad least = loads.top();
+        loads.pop();
+
+        if (least.second == segid) {
+            mine.push_back(all[i]);
+        }
+
+        least.first += all[i].range.len;
+        loads.push(least);
+    }
+
+    return mine;
+}
+
 string S3Reader::getKeyURL(const string &key) {
     stringstream sstr;
     sstr << this->schema << "://"
@@ -262,22 +355,155 @@ bool S3ExtBase::ValidateURL() {
     return true;
 }
 
-/*
-bool S3Protocol_t::Write(char *data, size_t &len) {
-    if (!this->fileuploader) {
-        // not initialized?
+S3Writer::S3Writer(const string &url) : S3ExtBase(url) {
+    this->fileuploader = NULL;
+    this->compressor = NULL;
+}
+
+S3Writer::~S3Writer() {
+    // the compressor writes to the uploader
+    delete this->compressor;
+    delete this->fileuploader;
+}
+
+// invoked by s3_export(), need to be exception safe
+bool S3Writer::Init(int segid, int segnum, int chunksize) {
+    try {
+        // set segment id and num
+        this->segid = s3ext_segid;
+        this->segnum = s3ext_segnum;
+
+        this->chunksize = chunksize;
+
+        // Validate url first
+        if (!this->ValidateURL()) {
+            S3ERROR("The given URL(%s) is invalid", this->url.c_str());
+            return false;
+        }
+
+        if (this->concurrent_num > 0) {
+            this->fileuploader = new Uploader(this->concurrent_num);
+        } else {
+            S3ERROR("Failed to create fileuploader due to threadnum");
+            return false;
+        }
+
+        string key = this->getKeyName();
+        S3DEBUG("key: %s", key.c_str());
+
+        if (!this->fileuploader->init(this->schema, this->region, this->bucket,
+                                      key, this->chunksize, &this->cred)) {
+            S3ERROR("Failed to init fileuploader");
+            return false;
+        }
+
+        if (s3ext_autocompress) {
+            this->compressor = new Compressor(this->fileuploader);
+            if (!this->compressor->init(s3ext_compresslevel)) {
+                S3ERROR("Failed to init compressor");
+                return false;
+            }
+        }
+    } catch (...) {
+        S3ERROR("Caught an exception, aborting");
+        return false;
+    }
+
+    return true;
+}
+
+// Every segment writes an object of its own, named after the segment and
+// the time, process and sequence number of the writer, so that objects of
+// different segments and queries don't overwrite each other. Compressed
+// objects end with ".gz".
+string S3Writer::getKeyName() {
+    static unsigned int sequence = 0;
+
+    stringstream sstr;
+    sstr << this->prefix << "data" << this->segid << "_" << std::hex
+         << time(NULL) << "_" << getpid() << "_" << sequence++
+         << (s3ext_autocompress ? ".gz" : ".data");
+    return sstr.str();
+}
+
+// invoked by s3_export(), need to be exception safe
+bool S3Writer::TransferData(char *data, uint64_t &len) {
+    try {
+        if (!this->fileuploader) {
+            // not initialized?
+            return false;
+        }
+
+        if (this->compressor) {
+            if (!this->compressor->write(data, len)) {
+                S3ERROR("Failed to write data via compressor");
+                return false;
+            }
+        } else if (!this->fileuploader->write(data, len)) {
+            S3ERROR("Failed to write data via fileuploader");
+            return false;
+        }
+    } catch (...) {
+        S3ERROR("Caught an exception, aborting");
         return false;
     }
 
-    bool result = fileuploader->write(data, len);
+    return true;
+}
+
+// invoked by s3_export(), need to be exception safe
+bool S3Writer::Destroy() {
+    bool ret = true;
+
+    try {
+        if (this->compressor) {
+            // an unfinished stream must not make it to S3
+            if (!this->compressor->destroy() && this->fileuploader) {
+                this->fileuploader->cancel();
+            }
+            delete this->compressor;
+            this->compressor = NULL;
+        }
+
+        if (this->fileuploader) {
+            ret = this->fileuploader->destroy();
+            delete this->fileuploader;
+            this->fileuploader = NULL;
+        }
+    } catch (...) {
+        S3ERROR("Caught an exception, aborting");
+        return false;
+    }
+
+    return ret;
+}
+
+void S3Writer::Cancel() {
+    if (this->fileuploader) {
+        this->fileuploader->cancel();
+    }
+}
+
+// Loads the configuration given in the options of the url, and sets up
+// logging according to it.
+static bool load_config(const char *url_with_options) {
+    char *config_path = get_opt_s3(url_with_options, "config");
+    if (!config_path) {
+        // no config path in url, use default value
+        // data_folder/gpseg0/s3/s3.conf
+        config_path = strdup("s3/s3.conf");
+    }
+
+    bool result = InitConfig(config_path, "default");
+    free(config_path);
     if (!result) {
-        S3DEBUG("Failed to write data via fileuploader");
         return false;
     }
 
+    InitRemoteLog();
+
     return true;
 }
-*/
 
 // invoked by s3_import(), need to be exception safe
 S3Reader *reader_init(const char *url_with_options) {
@@ -293,24 +519,11 @@ S3Reader *reader_init(const char *url_with_options) {
             return NULL;
         }
 
-        char *config_path = get_opt_s3(url_with_options, "config");
-        if (!config_path) {
-            // no config path in url, use default value
-            // data_folder/gpseg0/s3/s3.conf
-            config_path = strdup("s3/s3.conf");
-        }
-
-        bool result = InitConfig(config_path, "default");
-        if (!result) {
+        if (!load_config(url_with_options)) {
             free(url);
-            free(config_path);
             return NULL;
-        } else {
-            free(config_path);
         }
 
-        InitRemoteLog();
-
         S3Reader *reader = (S3Reader *)CreateExtWrapper(url);
 
         free(url);
@@ -385,3 +598,98 @@ bool reader_cleanup(S3Reader **reader) {
 
     return true;
 }
+
+// invoked by s3_export(), need to be exception safe
+S3Writer *writer_init(const char *url_with_options) {
+    try {
+        if (!url_with_options) {
+            return NULL;
+        }
+
+        curl_global_init(CURL_GLOBAL_ALL);
+
+        char *url = truncate_options(url_with_options);
+        if (!url) {
+            return NULL;
+        }
+
+        if (!load_config(url_with_options)) {
+            free(url);
+            return NULL;
+        }
+
+        S3Writer *writer = new S3Writer(url);
+
+        free(url);
+
+        if (!writer->Init(s3ext_segid, s3ext_segnum, s3ext_chunksize)) {
+            writer->Destroy();
+            delete writer;
+            return NULL;
+        }
+
+        return writer;
+    } catch (...) {
+        S3ERROR("Caught an exception, aborting");
+        return NULL;
+    }
+}
+
+// invoked by s3_export(), need to be exception safe
+bool writer_transfer_data(S3Writer *writer, char *data_buf, int data_len) {
+    try {
+        if (!writer || !data_buf || (data_len < 0)) {
+            return false;
+        }
+
+        if (data_len == 0) {
+            return true;
+        }
+
+        uint64_t write_len = data_len;
+        if (!writer->TransferData(data_buf, write_len)) {
+            return false;
+        }
+    } catch (...) {
+        S3ERROR("Caught an exception, aborting");
+        return false;
+    }
+
+    return true;
+}
+
+// invoked by s3_export(), need to be exception safe
+void writer_cancel(S3Writer *writer) {
+    try {
+        if (writer) {
+            writer->Cancel();
+        }
+    } catch (...) {
+        S3ERROR("Caught an exception, aborting");
+    }
+}
+
+// invoked by s3_export(), need to be exception safe
+bool writer_cleanup(S3Writer **writer) {
+    bool ret = true;
+
+    try {
+        if (*writer) {
+            ret = (*writer)->Destroy();
+            delete *writer;
+            *writer = NULL;
+        } else {
+            return false;
+        }
+
+        /*
+         * Cleanup function for the XML library.
+         */
+        xmlCleanupParser();
+    } catch (...) {
+        S3ERROR("Caught an exception, aborting");
+        return false;
+    }
+
+    return ret;
+}
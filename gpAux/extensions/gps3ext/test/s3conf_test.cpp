@@ -31,6 +31,10 @@ TEST(Config, Basic) {
 
     EXPECT_EQ(1024, s3ext_low_speed_limit);
     EXPECT_EQ(600, s3ext_low_speed_time);
+
+    EXPECT_TRUE(s3ext_autocompress);
+    EXPECT_EQ(1, s3ext_compresslevel);
+    EXPECT_TRUE(s3ext_autosplit);
 }
 
 TEST(Config, SpecialSectionValues) {
@@ -40,6 +44,9 @@ TEST(Config, SpecialSectionValues) {
     EXPECT_EQ(128 * 1024 * 1024, s3ext_chunksize);
     EXPECT_EQ(10240, s3ext_low_speed_limit);
     EXPECT_EQ(60, s3ext_low_speed_time);
+    EXPECT_FALSE(s3ext_autocompress);
+    EXPECT_EQ(9, s3ext_compresslevel);
+    EXPECT_FALSE(s3ext_autosplit);
 }
 
 TEST(Config, SpecialSectionLowValues) {
@@ -47,6 +54,7 @@ TEST(Config, SpecialSectionLowValues) {
 
     EXPECT_EQ(1, s3ext_threadnum);
     EXPECT_EQ(2 * 1024 * 1024, s3ext_chunksize);
+    EXPECT_EQ(1, s3ext_compresslevel);
 }
 
 TEST(Config, SpecialSectionWrongKeyName) {
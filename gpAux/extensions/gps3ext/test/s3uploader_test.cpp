@@ -1,2 +1,67 @@
 #include "s3uploader.cpp"
 #include "gtest/gtest.h"
+
+TEST(Uploader, GetHeaderValue) {
+    string headers =
+        "HTTP/1.1 200 OK\r\n"
+        "x-amz-request-id: 656c76696e6727732072657175657374\r\n"
+        "ETag: \"b54357faf0632cce46e942fa68356b38\"\r\n"
+        "Content-Length: 0\r\n"
+        "\r\n";
+
+    EXPECT_EQ("\"b54357faf0632cce46e942fa68356b38\"",
+              GetHeaderValue(headers, "ETag"));
+    EXPECT_EQ("0", GetHeaderValue(headers, "content-length"));
+    EXPECT_EQ("", GetHeaderValue(headers, "Content"));
+    EXPECT_EQ("", GetHeaderValue(headers, "Date"));
+}
+
+TEST(Uploader, GetHeaderValue_empty) {
+    EXPECT_EQ("", GetHeaderValue("", "ETag"));
+    EXPECT_EQ("", GetHeaderValue("HTTP/1.1 200 OK", "ETag"));
+    EXPECT_EQ("", GetHeaderValue("ETag:", "ETag"));
+}
+
+TEST(Uploader, init) {
+    S3Credential cred;
+    Uploader *u = new Uploader(4);
+
+    EXPECT_FALSE(u->init("https", "us-west-2", "bucket", "key", 8 * 1024 * 1024,
+                         NULL));
+    EXPECT_TRUE(u->init("https", "us-west-2", "bucket", "key", 8 * 1024 * 1024,
+                        &cred));
+
+    // nothing written, nothing to upload
+    EXPECT_TRUE(u->destroy());
+    delete u;
+}
+
+TEST(Compressor, init) {
+    Compressor *z = new Compressor(NULL);
+
+    EXPECT_FALSE(z->init(6));
+    EXPECT_FALSE(z->destroy());
+    delete z;
+}
+
+TEST(Compressor, destroy_unfinished) {
+    S3Credential cred;
+    Uploader *u = new Uploader(2);
+    Compressor *z = new Compressor(u);
+
+    EXPECT_TRUE(u->init("https", "us-west-2", "bucket", "key", 8 * 1024 * 1024,
+                        &cred));
+    EXPECT_TRUE(z->init(1));
+
+    // less than a part, nothing is uploaded
+    char buf[4096];
+    memset(buf, 'a', sizeof(buf));
+    EXPECT_TRUE(z->write(buf, sizeof(buf)));
+
+    // deleted without destroy(), the stream is not ended
+    delete z;
+
+    u->cancel();
+    EXPECT_FALSE(u->destroy());
+    delete u;
+}
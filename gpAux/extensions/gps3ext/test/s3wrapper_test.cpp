@@ -79,3 +79,68 @@ TEST(ExtWrapper, ValidateURL_apnortheast21) {
 
     delete myData;
 }
+
+#define MB ((uint64_t)1024 * 1024)
+
+TEST(ExtWrapper, AssignKeyRanges_largestFirst) {
+    ListBucketResult keylist;
+    keylist.contents.push_back(CreateBucketContentItem("a", 100 * MB));
+    keylist.contents.push_back(CreateBucketContentItem("b", 300 * MB));
+    keylist.contents.push_back(CreateBucketContentItem("c", 100 * MB));
+    keylist.contents.push_back(CreateBucketContentItem("d", 200 * MB));
+
+    // b goes to 0, d to 1, a to 1 and c to 0
+    vector<KeyRange> seg0 = AssignKeyRanges(&keylist, 0, 2, true);
+    ASSERT_EQ(2, seg0.size());
+    EXPECT_EQ("b", seg0[0].content->Key());
+    EXPECT_EQ("c", seg0[1].content->Key());
+
+    vector<KeyRange> seg1 = AssignKeyRanges(&keylist, 1, 2, true);
+    ASSERT_EQ(2, seg1.size());
+    EXPECT_EQ("d", seg1[0].content->Key());
+    EXPECT_EQ("a", seg1[1].content->Key());
+
+    for (size_t i = 0; i < seg0.size(); i++) {
+        EXPECT_EQ(0, seg0[i].range.offset);
+        EXPECT_EQ(seg0[i].content->Size(), seg0[i].range.len);
+    }
+
+    EXPECT_EQ(0, AssignKeyRanges(&keylist, 2, 2, true).size());
+}
+
+TEST(ExtWrapper, AssignKeyRanges_split) {
+    ListBucketResult keylist;
+    keylist.contents.push_back(CreateBucketContentItem("large", 6000 * MB));
+    keylist.contents.push_back(CreateBucketContentItem("large.gz", 3000 * MB));
+    keylist.contents.push_back(CreateBucketContentItem("small", 100 * MB));
+
+    // a segment's share is 2275MB, large is split in 3 ranges of 2000MB,
+    // large.gz is not
+    uint64_t offsets = 0;
+    int ranges = 0;
+    uint64_t bytes[4] = {0, 0, 0, 0};
+    for (int seg = 0; seg < 4; seg++) {
+        vector<KeyRange> krs = AssignKeyRanges(&keylist, seg, 4, true);
+        for (size_t i = 0; i < krs.size(); i++) {
+            bytes[seg] += krs[i].range.len;
+            if (krs[i].content->Key() == "large") {
+                EXPECT_EQ(2000 * MB, krs[i].range.len);
+                offsets += krs[i].range.offset;
+                ranges++;
+            } else {
+                EXPECT_EQ(0, krs[i].range.offset);
+                EXPECT_EQ(krs[i].content->Size(), krs[i].range.len);
+            }
+        }
+    }
+    EXPECT_EQ(3, ranges);
+    EXPECT_EQ(6000 * MB, offsets);
+    EXPECT_EQ(3000 * MB, bytes[0]);
+    EXPECT_EQ(2100 * MB, bytes[1]);
+    EXPECT_EQ(2000 * MB, bytes[2]);
+    EXPECT_EQ(2000 * MB, bytes[3]);
+
+    // not split
+    EXPECT_EQ(3, AssignKeyRanges(&keylist, 0, 1, true).size());
+    EXPECT_EQ(1, AssignKeyRanges(&keylist, 0, 4, false).size());
+}
@@ -1127,7 +1127,10 @@ heap_deformtuple(HeapTuple tuple,
  *		re-computing information about previously extracted attributes.
  *		slot->tts_nvalid is the number of attributes already extracted.
  */
-static void
+#ifndef USE_CODEGEN
+static
+#endif
+void
 slot_deform_tuple(TupleTableSlot *slot, int natts)
 {
 	HeapTuple	tuple = TupGetHeapTuple(slot); 
@@ -1241,7 +1244,7 @@ _slot_getsomeattrs(TupleTableSlot *slot, int attnum)
 	attno = HeapTupleHeaderGetNatts(tuple->t_data);
 	attno = Min(attno, attnum);
 
-	slot_deform_tuple(slot, attno);
+	call_slot_deform_tuple(slot, attno);
 
 	/*
 	 * If tuple doesn't have all the atts indicated by tupleDesc, read the
@@ -1257,6 +1260,24 @@ _slot_getsomeattrs(TupleTableSlot *slot, int attnum)
 	TupSetVirtualTuple(slot);
 }
 
+/*
+ * slot_deform_memtuple
+ *		Given a TupleTableSlot holding a memtuple, extract data from the
+ *		memtuple into the slot's Datum/isnull arrays.  Data is extracted up
+ *		through the natts'th column (caller must ensure this is a legal column
+ *		number).
+ */
+void
+slot_deform_memtuple(TupleTableSlot *slot, int natts)
+{
+	int			i;
+
+	for (i = 0; i < natts; ++i)
+		slot->PRIVATE_tts_values[i] = memtuple_getattr(
+				slot->PRIVATE_tts_memtuple, slot->tts_mt_bind,
+				i + 1, &(slot->PRIVATE_tts_isnull[i]));
+}
+
 /*
  * heap_freetuple
  */
@@ -31,6 +31,7 @@
 #include "access/xlogutils.h"
 #include "access/fileam.h"
 #include "catalog/namespace.h"
+#include "codegen/codegen_wrapper.h"
 #include "commands/async.h"
 #include "commands/tablecmds.h"
 #include "commands/trigger.h"
@@ -3963,6 +3964,14 @@ AbortTransaction(void)
 	 */
 	LockWaitCancel();
 
+	/*
+	 * Executor state is released without shutting down the executor, so
+	 * stop background compilations from swapping generated code into it,
+	 * and destroy the code generator managers of the failed queries.
+	 */
+	CodeGeneratorManagerCancelAsyncCompilations();
+	AtAbort_ExecutorCodegenManagers(InvalidSubTransactionId);
+
 	/*
 	 * check the current transaction state
 	 */
@@ -6309,6 +6318,9 @@ AbortSubTransaction(void)
 
 	LockWaitCancel();
 
+	CodeGeneratorManagerCancelAsyncCompilations();
+	AtAbort_ExecutorCodegenManagers(s->subTransactionId);
+
 	/*
 	 * check the current transaction state
 	 */
@@ -389,6 +389,33 @@ CREATE VIEW pg_stat_database AS
             pg_stat_get_db_blocks_hit(D.oid) AS blks_hit 
     FROM pg_database D;
 
+-- Compiled generated function cache of the current backend
+
+CREATE VIEW pg_stat_codegen_cache AS
+    SELECT
+            C.hits,
+            C.misses,
+            C.evictions,
+            C.entries
+    FROM pg_stat_get_codegen_cache() AS C;
+
+-- Time and memory the optimizer spent on the queries of the current backend
+
+CREATE VIEW pg_stat_optimizer AS
+    SELECT
+            O.queries,
+            O.cached_plans,
+            O.budget_exhausted,
+            O.md_fetches,
+            O.md_shared_hits,
+            O.md_fetch_time,
+            O.query_translation_time,
+            O.search_time,
+            O.plan_translation_time,
+            O.plan_copy_time,
+            O.peak_memory
+    FROM pg_stat_get_optimizer() AS O;
+
 CREATE VIEW pg_stat_resqueues AS
 	SELECT
 		Q.oid AS queueid,
@@ -24,8 +24,11 @@
 #include "optimizer/planmain.h"
 #include "parser/parse_expr.h"
 #include "utils/builtins.h"
+#include "utils/hsearch.h"
+#include "utils/inval.h"
 #include "utils/lsyscache.h"
 #include "utils/memutils.h"
+#include "utils/syscache.h"
 
 /* initial estimate for number of logical indexes */
 #define INITIAL_NUM_LOGICAL_INDEXES_ESTIMATE 100
@@ -68,6 +71,67 @@ typedef struct
 	List		*defaultPartList;
 } LogicalIndexInfoHashEntry;
 
+/*
+ * Hash entry for PartConstraintsHash
+ * hashkey is (partOid)
+ */
+typedef struct
+{
+	Oid			partOid;
+	Node	   *partCons;		/* check constraints, mapped to the root */
+	List	   *keys;			/* columns referenced by the constraints */
+} PartConstraintsHashEntry;
+
+/*
+ * Constraints of the parts fetched so far while building the partition
+ * metadata of a root, so that the pg_constraint rows of every part are
+ * fetched and mapped to the root only once, instead of once per logical
+ * index on the part and once more for the constraints of the root. NULL
+ * when not building.
+ */
+static HTAB *PartConstraintsHash = NULL;
+
+/*
+ * Partition metadata of a root, cached across queries in
+ * PartMetadataCache. The entry is removed once the partition hierarchy
+ * version moves, or once any of the parts, or the root, is invalidated. An
+ * entry built while that happened is stale from the start, and is rebuilt
+ * on the next lookup.
+ */
+typedef struct
+{
+	Oid			rootOid;
+	uint64		version;		/* partition hierarchy version */
+	bool		valid;			/* no part invalidated since */
+	MemoryContext context;		/* holds everything below */
+	List	   *partOids;		/* all the parts, including the root */
+	LogicalIndexes *logicalIndexes;
+	Node	   *partCons;
+	List	   *defaultLevels;
+} PartMetadataCacheEntry;
+
+/*
+ * Hash entry for PartMetadataMembers, which maps every part of a cached
+ * hierarchy to its root
+ */
+typedef struct
+{
+	Oid			partOid;
+	Oid			rootOid;
+} PartMetadataMemberEntry;
+
+static HTAB *PartMetadataCache = NULL;
+static HTAB *PartMetadataMembers = NULL;
+
+/*
+ * Bumped by every change to pg_partition or pg_partition_rule, which may
+ * affect any hierarchy, and by relcache resets.
+ */
+static uint64 partMetadataCacheVersion = 0;
+
+/* Bumped by every relcache invalidation, to detect those during a build */
+static uint64 partMetadataCacheInvalidations = 0;
+
 /*
  * Each node in the PartitionIndexNode tree describes a partition
  * and a list of it's logical indexes
@@ -100,6 +164,15 @@ static bool collapseIndexes(PartitionIndexNode **partitionIndexNode,
 static void createIndexHashTables(void);
 static IndexInfo *populateIndexInfo(cqContext *pcqCtx, HeapTuple tuple,
 					Form_pg_index indForm);
+static Node *getPartConstraints(Oid partOid, Oid rootOid, List *partKey);
+static Node *buildRelationPartConstraints(Oid rootOid, List **defaultLevels);
+static PartMetadataCacheEntry *lookupPartMetadata(Oid rootOid);
+static PartMetadataCacheEntry *buildPartMetadata(Oid rootOid);
+static void removePartMetadata(PartMetadataCacheEntry *entry);
+static void removeAllPartMetadata(void);
+static LogicalIndexes *copyLogicalIndexes(LogicalIndexes *li);
+static List *appendInterval(List *intervals, Node *interval);
+static Node *intervalsToNode(List *intervals);
 static Node *mergeIntervals(Node *intervalFst, Node *intervalSnd);
 static void extractStartEndRange(Node *clause, Node **ppnodeStart, Node **ppnodeEnd);
 static void extractOpExprComponents(OpExpr *opexpr, Var **ppvar, Const **ppconst, Oid *opno);
@@ -240,7 +313,11 @@ BuildLogicalIndexInfo(Oid relid)
 	getPartitionIndexNode(relid, 0, InvalidOid, &n, false, NIL);
 
 	if (!n)
+	{
+		MemoryContextSwitchTo(callerContext);
+		MemoryContextDelete(partContext);
 		return NULL;
+	}
 
 	/* create the hash tables to hold the logical index info */
 	createIndexHashTables();
@@ -793,13 +870,13 @@ static void indexParts(PartitionIndexNode **np, bool isDefault)
 }
 
 /*
- * getPartConstraints
+ * fetchPartConstraints
  *   Given an OID, returns a Node that represents all the check constraints
- *   on the table AND'd together, only if these constraints cover the keys in
- *   the given list. Otherwise, it returns NULL
+ *   on the table AND'd together, mapped to the root, and the columns they
+ *   reference in *keys.
  */
 static Node *
-getPartConstraints(Oid partOid, Oid rootOid, List *partKey)
+fetchPartConstraints(Oid partOid, Oid rootOid, List **keys)
 {
 	cqContext       *pcqCtx;
 	cqContext       cqc;
@@ -833,7 +910,7 @@ getPartConstraints(Oid partOid, Oid rootOid, List *partKey)
 				ObjectIdGetDatum(partOid)));
 
 	// list of keys referenced in the found constraints
-	List *keys = NIL;
+	*keys = NIL;
 
 	while (HeapTupleIsValid(conTup = caql_getnext(pcqCtx)))
 	{
@@ -870,14 +947,60 @@ getPartConstraints(Oid partOid, Oid rootOid, List *partKey)
 		for (int i = 0; i < numKeys; i++)
 		{
 			int16 key_elem =  DatumGetInt16(dats[i]);
-			keys = lappend_int(keys, key_elem);
+			*keys = lappend_int(*keys, key_elem);
 		}
 	}
 
 	caql_endscan(pcqCtx);
 	heap_close(conRel, AccessShareLock);
 
-	ListCell *lc = NULL;
+	if (map)
+	{
+		pfree(map);
+	}
+	return result;
+}
+
+/*
+ * getPartConstraints
+ *   Given an OID, returns a Node that represents all the check constraints
+ *   on the table AND'd together, only if these constraints cover the keys in
+ *   the given list. Otherwise, it returns NULL
+ *
+ *   While the partition metadata of a root is being built, the constraints
+ *   of each part are only fetched once, and the same Node is returned for
+ *   all the calls on the part.
+ */
+static Node *
+getPartConstraints(Oid partOid, Oid rootOid, List *partKey)
+{
+	Node	   *result;
+	List	   *keys = NIL;
+	ListCell   *lc;
+
+	if (NULL != PartConstraintsHash)
+	{
+		PartConstraintsHashEntry *entry;
+		bool		found;
+
+		entry = (PartConstraintsHashEntry *) hash_search(PartConstraintsHash,
+														 (void *) &partOid,
+														 HASH_ENTER,
+														 &found);
+		if (!found)
+		{
+			entry->partCons = NULL;
+			entry->keys = NIL;
+			entry->partCons = fetchPartConstraints(partOid, rootOid, &entry->keys);
+		}
+		result = entry->partCons;
+		keys = entry->keys;
+	}
+	else
+	{
+		result = fetchPartConstraints(partOid, rootOid, &keys);
+	}
+
 	foreach (lc, partKey)
 	{
 		int partKeyCol = lfirst_int(lc);
@@ -885,41 +1008,25 @@ getPartConstraints(Oid partOid, Oid rootOid, List *partKey)
 		if (list_find_int(keys, partKeyCol) < 0)
 		{
 			// passed in key is not found in the constraint. return NULL
-			if (NULL != result)
-			{
-				pfree(result);
-			}
-
-			result = NULL;
-			break;
+			return NULL;
 		}
 	}
 
-	if (map)
-	{
-		pfree(map);
-	}
-	list_free(keys);
 	return result;
 }
 
 /*
- * get_relation_part_constraints
- *  return the part constraints for a partitioned table given the oid of the root
+ * buildRelationPartConstraints
+ *  build the part constraints for a partitioned table given the oid of the root
  */
-Node *
-get_relation_part_constraints(Oid rootOid, List **defaultLevels)
+static Node *
+buildRelationPartConstraints(Oid rootOid, List **defaultLevels)
 {
-	if (!rel_is_partitioned(rootOid))
-	{
-		return NULL;
-	}
-
 	// get number of partitioning levels
 	List *partkeys = rel_partition_keys_ordered(rootOid);
 	int nLevels = list_length(partkeys);
 
-	Node *allCons = NULL;
+	List *intervals = NIL;
 	for (int level = 0; level < nLevels; level++)
 	{
 		List *partKey = (List *) list_nth(partkeys, level);
@@ -945,17 +1052,11 @@ get_relation_part_constraints(Oid rootOid, List **defaultLevels)
 			}
 
 			// OR them to current constraints
-			if (NULL == allCons)
-			{
-				allCons = partCons;
-			}
-			else
-			{
-				allCons = (Node *) mergeIntervals(allCons, partCons);
-			}
+			intervals = appendInterval(intervals, partCons);
 		}
 	}
 
+	Node *allCons = intervalsToNode(intervals);
 	if (NULL == allCons)
 	{
 		allCons = makeBoolConst(false /*value*/, false /*isnull*/);
@@ -965,6 +1066,333 @@ get_relation_part_constraints(Oid rootOid, List **defaultLevels)
 	return allCons;
 }
 
+/*
+ * get_relation_part_constraints
+ *  return the part constraints for a partitioned table given the oid of the root
+ *
+ *  Memory for result is allocated from caller context.
+ */
+Node *
+get_relation_part_constraints(Oid rootOid, List **defaultLevels)
+{
+	if (!rel_is_partitioned(rootOid))
+	{
+		return NULL;
+	}
+
+	if (Gp_role != GP_ROLE_DISPATCH)
+	{
+		return buildRelationPartConstraints(rootOid, defaultLevels);
+	}
+
+	PartMetadataCacheEntry *entry = lookupPartMetadata(rootOid);
+
+	*defaultLevels = list_concat(*defaultLevels, list_copy(entry->defaultLevels));
+	return (Node *) copyObject(entry->partCons);
+}
+
+/*
+ * GetLogicalIndexInfo
+ *   Returns the same as BuildLogicalIndexInfo, from the partition metadata
+ *   cache.
+ *
+ *   Memory for result is allocated from caller context.
+ */
+LogicalIndexes *
+GetLogicalIndexInfo(Oid relid)
+{
+	if (Gp_role != GP_ROLE_DISPATCH || !rel_is_partitioned(relid))
+	{
+		return BuildLogicalIndexInfo(relid);
+	}
+
+	PartMetadataCacheEntry *entry = lookupPartMetadata(relid);
+
+	return copyLogicalIndexes(entry->logicalIndexes);
+}
+
+/*
+ * The partition metadata of a root is invalidated by any change to the
+ * partitioning catalogs, which bumps the partition hierarchy version, and by
+ * a relcache invalidation of any of its parts. Adding or dropping an index or
+ * a constraint on a part always invalidates the relcache entry of the part.
+ *
+ * Invalidated entries are removed right away rather than at their next
+ * lookup, which never comes for a dropped table. Callers copy what they need
+ * out of an entry before doing anything that may process invalidations.
+ */
+static void
+partMetadataSyscacheCallback(Datum arg, Oid relid)
+{
+	partMetadataCacheVersion++;
+	removeAllPartMetadata();
+}
+
+static void
+partMetadataRelcacheCallback(Datum arg, Oid relid)
+{
+	PartMetadataMemberEntry *member;
+	PartMetadataCacheEntry *entry;
+
+	partMetadataCacheInvalidations++;
+
+	/* InvalidOid means that the whole relcache was reset */
+	if (!OidIsValid(relid))
+	{
+		partMetadataCacheVersion++;
+		removeAllPartMetadata();
+		return;
+	}
+
+	member = (PartMetadataMemberEntry *) hash_search(PartMetadataMembers,
+													 (void *) &relid,
+													 HASH_FIND,
+													 NULL);
+	if (NULL == member)
+		return;
+
+	entry = (PartMetadataCacheEntry *) hash_search(PartMetadataCache,
+												   (void *) &member->rootOid,
+												   HASH_FIND,
+												   NULL);
+	if (NULL != entry)
+		removePartMetadata(entry);
+}
+
+/*
+ * lookupPartMetadata
+ *   Returns the partition metadata of a root, building it if it is not
+ *   cached, or stale.
+ */
+static PartMetadataCacheEntry *
+lookupPartMetadata(Oid rootOid)
+{
+	PartMetadataCacheEntry *entry;
+
+	if (NULL == PartMetadataCache)
+	{
+		HASHCTL		ctl;
+
+		MemSet(&ctl, 0, sizeof(ctl));
+		ctl.keysize = sizeof(Oid);
+		ctl.entrysize = sizeof(PartMetadataCacheEntry);
+		ctl.hash = oid_hash;
+		ctl.hcxt = CacheMemoryContext;
+		PartMetadataCache = hash_create("Partition Metadata Cache", 64, &ctl,
+										HASH_ELEM | HASH_FUNCTION | HASH_CONTEXT);
+
+		MemSet(&ctl, 0, sizeof(ctl));
+		ctl.keysize = sizeof(Oid);
+		ctl.entrysize = sizeof(PartMetadataMemberEntry);
+		ctl.hash = oid_hash;
+		ctl.hcxt = CacheMemoryContext;
+		PartMetadataMembers = hash_create("Partition Metadata Members", 1024, &ctl,
+										  HASH_ELEM | HASH_FUNCTION | HASH_CONTEXT);
+
+		CacheRegisterSyscacheCallback(PARTOID, partMetadataSyscacheCallback, (Datum) 0);
+		CacheRegisterSyscacheCallback(PARTRULEOID, partMetadataSyscacheCallback, (Datum) 0);
+		CacheRegisterRelcacheCallback(partMetadataRelcacheCallback, (Datum) 0);
+	}
+
+	entry = (PartMetadataCacheEntry *) hash_search(PartMetadataCache,
+												   (void *) &rootOid,
+												   HASH_FIND,
+												   NULL);
+	if (NULL != entry)
+	{
+		if (entry->valid && entry->version == partMetadataCacheVersion)
+			return entry;
+
+		removePartMetadata(entry);
+	}
+
+	return buildPartMetadata(rootOid);
+}
+
+/*
+ * buildPartMetadata
+ *   Builds the partition metadata of a root, and adds it to the cache.
+ *
+ *   The constraints of each part are fetched once, and shared by the logical
+ *   indexes and the constraints of the root. If a relcache invalidation
+ *   arrives while building, the parts it is for may not be known yet, so the
+ *   entry is only good for the current call.
+ */
+static PartMetadataCacheEntry *
+buildPartMetadata(Oid rootOid)
+{
+	MemoryContext buildContext;
+	MemoryContext cacheContext;
+	MemoryContext oldContext;
+	HASHCTL		ctl;
+	uint64		version = partMetadataCacheVersion;
+	uint64		invalidations = partMetadataCacheInvalidations;
+	LogicalIndexes *li = NULL;
+	Node	   *partCons = NULL;
+	List	   *defaultLevels = NIL;
+	List	   *partOids = NIL;
+	PartMetadataCacheEntry *entry;
+	ListCell   *lc;
+	bool		found;
+
+	buildContext = AllocSetContextCreate(CurrentMemoryContext,
+										 "Partition Metadata Build Context",
+										 ALLOCSET_DEFAULT_MINSIZE,
+										 ALLOCSET_DEFAULT_INITSIZE,
+										 ALLOCSET_DEFAULT_MAXSIZE);
+	oldContext = MemoryContextSwitchTo(buildContext);
+
+	MemSet(&ctl, 0, sizeof(ctl));
+	ctl.keysize = sizeof(Oid);
+	ctl.entrysize = sizeof(PartConstraintsHashEntry);
+	ctl.hash = oid_hash;
+	ctl.hcxt = buildContext;
+	PartConstraintsHash = hash_create("Part Constraints", 1024, &ctl,
+									  HASH_ELEM | HASH_FUNCTION | HASH_CONTEXT);
+
+	PG_TRY();
+	{
+		li = BuildLogicalIndexInfo(rootOid);
+		partCons = buildRelationPartConstraints(rootOid, &defaultLevels);
+		partOids = lcons_oid(rootOid,
+							 all_partition_relids(get_parts(rootOid, 0 /*level*/, 0 /*parent*/,
+															false /*inctemplate*/,
+															true /*includesubparts*/)));
+	}
+	PG_CATCH();
+	{
+		PartConstraintsHash = NULL;
+		MemoryContextSwitchTo(oldContext);
+		MemoryContextDelete(buildContext);
+		PG_RE_THROW();
+	}
+	PG_END_TRY();
+
+	PartConstraintsHash = NULL;
+
+	/* copy everything out of the build context, which shares nodes freely */
+	cacheContext = AllocSetContextCreate(CacheMemoryContext,
+										 "Partition Metadata",
+										 ALLOCSET_SMALL_MINSIZE,
+										 ALLOCSET_SMALL_INITSIZE,
+										 ALLOCSET_DEFAULT_MAXSIZE);
+	MemoryContextSwitchTo(cacheContext);
+	li = copyLogicalIndexes(li);
+	partCons = (Node *) copyObject(partCons);
+	defaultLevels = list_copy(defaultLevels);
+	partOids = list_copy(partOids);
+	MemoryContextSwitchTo(oldContext);
+
+	MemoryContextDelete(buildContext);
+
+	entry = (PartMetadataCacheEntry *) hash_search(PartMetadataCache,
+												   (void *) &rootOid,
+												   HASH_ENTER,
+												   &found);
+	Assert(!found);
+	entry->version = version;
+	entry->valid = (invalidations == partMetadataCacheInvalidations);
+	entry->context = cacheContext;
+	entry->partOids = partOids;
+	entry->logicalIndexes = li;
+	entry->partCons = partCons;
+	entry->defaultLevels = defaultLevels;
+
+	foreach(lc, partOids)
+	{
+		Oid			partOid = lfirst_oid(lc);
+		PartMetadataMemberEntry *member;
+
+		member = (PartMetadataMemberEntry *) hash_search(PartMetadataMembers,
+														 (void *) &partOid,
+														 HASH_ENTER,
+														 &found);
+		member->rootOid = rootOid;
+	}
+
+	return entry;
+}
+
+/*
+ * removePartMetadata
+ *   Removes the partition metadata of a root from the cache.
+ */
+static void
+removePartMetadata(PartMetadataCacheEntry *entry)
+{
+	Oid			rootOid = entry->rootOid;
+	ListCell   *lc;
+
+	foreach(lc, entry->partOids)
+	{
+		Oid			partOid = lfirst_oid(lc);
+		PartMetadataMemberEntry *member;
+
+		member = (PartMetadataMemberEntry *) hash_search(PartMetadataMembers,
+														 (void *) &partOid,
+														 HASH_FIND,
+														 NULL);
+		/* the part may have moved to another hierarchy since */
+		if (NULL != member && member->rootOid == rootOid)
+			hash_search(PartMetadataMembers, (void *) &partOid, HASH_REMOVE, NULL);
+	}
+
+	MemoryContextDelete(entry->context);
+	hash_search(PartMetadataCache, (void *) &rootOid, HASH_REMOVE, NULL);
+}
+
+/*
+ * removeAllPartMetadata
+ *   Removes the partition metadata of all the roots from the cache.
+ */
+static void
+removeAllPartMetadata(void)
+{
+	HASH_SEQ_STATUS status;
+	PartMetadataCacheEntry *entry;
+
+	hash_seq_init(&status, PartMetadataCache);
+	while ((entry = (PartMetadataCacheEntry *) hash_seq_search(&status)) != NULL)
+		removePartMetadata(entry);
+}
+
+/*
+ * copyLogicalIndexes
+ *   Deep copy of the result of BuildLogicalIndexInfo, in the current memory
+ *   context.
+ */
+static LogicalIndexes *
+copyLogicalIndexes(LogicalIndexes *li)
+{
+	LogicalIndexes *copy;
+
+	if (NULL == li)
+		return NULL;
+
+	copy = (LogicalIndexes *) palloc0(sizeof(LogicalIndexes));
+	copy->numLogicalIndexes = li->numLogicalIndexes;
+	copy->logicalIndexInfo = (LogicalIndexInfo **)
+		palloc0(Max(li->numLogicalIndexes, 1) * sizeof(LogicalIndexInfo *));
+
+	for (int i = 0; i < li->numLogicalIndexes; i++)
+	{
+		LogicalIndexInfo *info = li->logicalIndexInfo[i];
+		LogicalIndexInfo *infoCopy = (LogicalIndexInfo *) palloc(sizeof(LogicalIndexInfo));
+
+		*infoCopy = *info;
+		infoCopy->indexKeys = (AttrNumber *) palloc(Max(info->nColumns, 1) * sizeof(AttrNumber));
+		memcpy(infoCopy->indexKeys, info->indexKeys, info->nColumns * sizeof(AttrNumber));
+		infoCopy->indPred = (List *) copyObject(info->indPred);
+		infoCopy->indExprs = (List *) copyObject(info->indExprs);
+		infoCopy->partCons = (Node *) copyObject(info->partCons);
+		infoCopy->defaultLevels = list_copy(info->defaultLevels);
+
+		copy->logicalIndexInfo[i] = infoCopy;
+	}
+
+	return copy;
+}
+
 /*
  * populateIndexInfo
  *  Populate the IndexInfo structure with the information from pg_index tuple. 
@@ -1032,6 +1460,7 @@ generateLogicalIndexPred(LogicalIndexes *li,
 				int *numLogicalIndexes)
 {
 	Node            *conList;
+	List		*intervals = NIL;
 	ListCell *lc; 
 	AttrNumber	*indexKeys;
 
@@ -1061,16 +1490,13 @@ generateLogicalIndexPred(LogicalIndexes *li,
 				conList = getPartConstraints(partOid, root, NIL /*partKey*/);
 	
 				/* OR them to current constraints */
-				if (li->logicalIndexInfo[*curIdx]->partCons)
+				if (conList)
 				{
-					li->logicalIndexInfo[*curIdx]->partCons = mergeIntervals(li->logicalIndexInfo[*curIdx]->partCons, conList);						
-				}
-				else
-				{
-					li->logicalIndexInfo[*curIdx]->partCons = conList;
+					intervals = appendInterval(intervals, conList);
 				}
 			}
 		}
+		li->logicalIndexInfo[*curIdx]->partCons = intervalsToNode(intervals);
 
 		(*curIdx)++;
 		(*numLogicalIndexes)++;
@@ -1293,14 +1719,60 @@ dumpPartsIndexInfo(PartitionIndexNode *n, int level)
 	}
 }
 
+/*
+ * appendInterval
+ *   add an interval to a list of intervals, collapsing it into the last one
+ *   when possible
+ *
+ *   Parts are visited in the order of their rules, which for range partitions
+ *   is the order of their bounds, so the constraints of adjacent parts collapse
+ *   into a single interval, and the list stays as short as the number of gaps
+ *   in the ranges.
+ */
+static List *
+appendInterval(List *intervals, Node *interval)
+{
+	if (NIL != intervals)
+	{
+		Node *merged = mergeIntervals((Node *) llast(intervals), interval);
+
+		if (NULL != merged)
+		{
+			llast(intervals) = merged;
+			return intervals;
+		}
+	}
+
+	return lappend(intervals, interval);
+}
+
+/*
+ * intervalsToNode
+ *   return the disjunction of a list of intervals, or NULL if the list is empty
+ */
+static Node *
+intervalsToNode(List *intervals)
+{
+	if (NIL == intervals)
+	{
+		return NULL;
+	}
+
+	if (1 == list_length(intervals))
+	{
+		return (Node *) linitial(intervals);
+	}
+
+	return (Node *) make_orclause(intervals);
+}
+
 /*
  * 	mergeIntervals
- *   merge the two intervals by creating a disjunction of the given intervals, or collapsing
- *   them into one interval when possible
+ *   collapse the two intervals into one interval when possible
  *   
  *   This function's arguments represent two range constraints, which the function attempts
  *   to collapse into one if they share a common boundary. If no collapse is possible, 
- *   the function returns a disjunction of the two intervals.
+ *   the function returns NULL.
  */
 static Node *
 mergeIntervals(Node *intervalFst, Node *intervalSnd)
@@ -1370,7 +1842,7 @@ mergeIntervals(Node *intervalFst, Node *intervalSnd)
 			return (Node *) makeBoolConst(true /*value*/, false /*isnull*/);
 		}
 	}
-	return (Node *) make_orclause(list_make2(intervalFst, intervalSnd));
+	return NULL;
 }
 
 /*
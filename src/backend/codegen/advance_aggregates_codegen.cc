@@ -0,0 +1,434 @@
+//---------------------------------------------------------------------------
+//  Greenplum Database
+//  Copyright (C) 2016 Pivotal Software, Inc.
+//
+//  @filename:
+//    advance_aggregates_codegen.cc
+//
+//  @doc:
+//    Generates code for advance_aggregates function.
+//
+//---------------------------------------------------------------------------
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <string>
+#include <utility>
+
+#include "codegen/advance_aggregates_codegen.h"
+#include "codegen/utils/utility.h"
+#include "codegen/utils/codegen_utils.h"
+
+#include "llvm/IR/BasicBlock.h"
+#include "llvm/IR/Constant.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Intrinsics.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/Type.h"
+#include "llvm/IR/Value.h"
+
+extern "C" {
+#include "postgres.h"
+#include "utils/elog.h"
+#include "utils/fmgroids.h"
+#include "nodes/execnodes.h"
+#include "nodes/pg_list.h"
+#include "executor/nodeAgg.h"
+#include "executor/tuptable.h"
+}
+
+using gpcodegen::AdvanceAggregatesCodegen;
+
+constexpr char AdvanceAggregatesCodegen::kAdvanceAggregatesNamePrefix[];
+
+namespace {
+
+// Number of arguments of the aggregate
+int NumAggArguments(AggStatePerAgg peraggstate) {
+  return list_length(peraggstate->aggref->args);
+}
+
+// Where the single argument of an inlined aggregate is read from: the
+// offset of the slot pointer in the ExprContext, and the attribute number.
+std::pair<int, AttrNumber> AggArgument(AggStatePerAgg peraggstate) {
+  ProjectionInfo* evalproj = peraggstate->evalproj;
+  return std::make_pair(evalproj->pi_varSlotOffsets[0],
+                        static_cast<AttrNumber>(evalproj->pi_varNumbers[0]));
+}
+
+// llvm.sadd.with.overflow.i64
+llvm::Value* CreateAddWithOverflow(gpcodegen::CodegenUtils* codegen_utils,
+                                   llvm::Value* lhs,
+                                   llvm::Value* rhs,
+                                   llvm::Value** overflow) {
+  auto irb = codegen_utils->ir_builder();
+  llvm::Function* llvm_sadd = llvm::Intrinsic::getDeclaration(
+      codegen_utils->module(), llvm::Intrinsic::sadd_with_overflow,
+      {codegen_utils->GetType<int64>()});
+  llvm::Value* llvm_result = irb->CreateCall(llvm_sadd, {lhs, rhs});
+  *overflow = irb->CreateExtractValue(llvm_result, 1);
+  return irb->CreateExtractValue(llvm_result, 0);
+}
+
+// float8_cmp_internal(lhs, rhs) > 0, where NaN is larger than anything else
+llvm::Value* CreateFloat8Greater(gpcodegen::CodegenUtils* codegen_utils,
+                                 llvm::Value* lhs,
+                                 llvm::Value* rhs) {
+  auto irb = codegen_utils->ir_builder();
+  return irb->CreateOr(
+      irb->CreateFCmpOGT(lhs, rhs),
+      irb->CreateAnd(irb->CreateFCmpUNO(lhs, lhs),
+                     irb->CreateFCmpORD(rhs, rhs)));
+}
+
+}  // namespace
+
+AdvanceAggregatesCodegen::AdvanceAggregatesCodegen(
+    AdvanceAggregatesFn regular_func_ptr,
+    AdvanceAggregatesFn* ptr_to_regular_func_ptr,
+    AggState* aggstate) :
+    BaseCodegen(kAdvanceAggregatesNamePrefix,
+                regular_func_ptr,
+                ptr_to_regular_func_ptr),
+    aggstate_(aggstate) {
+}
+
+bool AdvanceAggregatesCodegen::IsInlined(int aggno) const {
+  AggStatePerAgg peraggstate = &aggstate_->peragg[aggno];
+  if (NULL == peraggstate->aggref ||
+      peraggstate->numSortCols > 0 ||
+      !peraggstate->transtypeByVal) {
+    return false;
+  }
+
+  // int4_sum() is not strict, but it skips NULL inputs and starts from the
+  // first one like a strict function would, so the same code does for it
+  if (!peraggstate->transfn.fn_strict &&
+      F_INT4_SUM != peraggstate->transfn.fn_oid) {
+    return false;
+  }
+
+  int nargs = NumAggArguments(peraggstate);
+  switch (peraggstate->transfn.fn_oid) {
+    case F_INT8INC:
+      return 0 == nargs;
+    case F_INT8INC_ANY:
+    case F_INT4_SUM:
+    case F_INT8PL:
+    case F_FLOAT8PL:
+    case F_INT4LARGER:
+    case F_INT4SMALLER:
+    case F_INT8LARGER:
+    case F_INT8SMALLER:
+    case F_FLOAT8LARGER:
+    case F_FLOAT8SMALLER:
+      return 1 == nargs &&
+          peraggstate->evalproj->pi_isVarList &&
+          AggArgument(peraggstate).second > 0;
+    default:
+      return false;
+  }
+}
+
+llvm::Value* AdvanceAggregatesCodegen::GenerateTransition(
+    gpcodegen::CodegenUtils* codegen_utils,
+    int aggno,
+    llvm::Value* trans_value,
+    llvm::Value* arg,
+    llvm::Value** overflow) {
+  auto irb = codegen_utils->ir_builder();
+  *overflow = nullptr;
+
+  switch (aggstate_->peragg[aggno].transfn.fn_oid) {
+    case F_INT8INC:
+    case F_INT8INC_ANY:
+      return CreateAddWithOverflow(codegen_utils, trans_value,
+                                   codegen_utils->GetConstant<int64>(1),
+                                   overflow);
+    case F_INT8PL:
+      return CreateAddWithOverflow(codegen_utils, trans_value, arg, overflow);
+    case F_INT4_SUM:
+      return irb->CreateAdd(
+          trans_value,
+          irb->CreateSExt(
+              irb->CreateTrunc(arg, codegen_utils->GetType<int32>()),
+              codegen_utils->GetType<int64>()));
+    case F_FLOAT8PL: {
+      // As CHECKFLOATVAL(), let the regular function deal with infinite
+      // results
+      llvm::Value* llvm_result = irb->CreateFAdd(
+          irb->CreateBitCast(trans_value, codegen_utils->GetType<float8>()),
+          irb->CreateBitCast(arg, codegen_utils->GetType<float8>()));
+      *overflow = irb->CreateOr(
+          irb->CreateFCmpOEQ(llvm_result, codegen_utils->GetConstant<float8>(
+              std::numeric_limits<float8>::infinity())),
+          irb->CreateFCmpOEQ(llvm_result, codegen_utils->GetConstant<float8>(
+              -std::numeric_limits<float8>::infinity())));
+      return irb->CreateBitCast(llvm_result, codegen_utils->GetType<Datum>());
+    }
+    case F_INT4LARGER:
+    case F_INT4SMALLER: {
+      llvm::Value* llvm_trans_int4 =
+          irb->CreateTrunc(trans_value, codegen_utils->GetType<int32>());
+      llvm::Value* llvm_arg_int4 =
+          irb->CreateTrunc(arg, codegen_utils->GetType<int32>());
+      llvm::Value* llvm_keep_trans =
+          (F_INT4LARGER == aggstate_->peragg[aggno].transfn.fn_oid) ?
+          irb->CreateICmpSGT(llvm_trans_int4, llvm_arg_int4) :
+          irb->CreateICmpSLT(llvm_trans_int4, llvm_arg_int4);
+      return irb->CreateSExt(
+          irb->CreateSelect(llvm_keep_trans, llvm_trans_int4, llvm_arg_int4),
+          codegen_utils->GetType<Datum>());
+    }
+    case F_INT8LARGER:
+      return irb->CreateSelect(irb->CreateICmpSGT(trans_value, arg),
+                               trans_value, arg);
+    case F_INT8SMALLER:
+      return irb->CreateSelect(irb->CreateICmpSLT(trans_value, arg),
+                               trans_value, arg);
+    case F_FLOAT8LARGER:
+    case F_FLOAT8SMALLER: {
+      llvm::Value* llvm_trans_float8 =
+          irb->CreateBitCast(trans_value, codegen_utils->GetType<float8>());
+      llvm::Value* llvm_arg_float8 =
+          irb->CreateBitCast(arg, codegen_utils->GetType<float8>());
+      llvm::Value* llvm_keep_trans =
+          (F_FLOAT8LARGER == aggstate_->peragg[aggno].transfn.fn_oid) ?
+          CreateFloat8Greater(codegen_utils,
+                              llvm_trans_float8, llvm_arg_float8) :
+          CreateFloat8Greater(codegen_utils,
+                              llvm_arg_float8, llvm_trans_float8);
+      return irb->CreateSelect(llvm_keep_trans, trans_value, arg);
+    }
+    default:
+      assert(false);
+      return nullptr;
+  }
+}
+
+bool AdvanceAggregatesCodegen::GenerateAdvanceAggregates(
+    gpcodegen::CodegenUtils* codegen_utils) {
+  assert(NULL != codegen_utils);
+  static_assert(sizeof(Datum) == sizeof(int64),
+      "sizeof(Datum) doesn't match sizeof(int64)");
+
+  int numaggs = aggstate_->numaggs;
+
+  // The largest attribute number to deform, per input slot
+  std::map<int, AttrNumber> max_attrs;
+  int num_inlined = 0;
+  for (int aggno = 0; aggno < numaggs; ++aggno) {
+    if (!IsInlined(aggno)) {
+      continue;
+    }
+    num_inlined++;
+    if (NumAggArguments(&aggstate_->peragg[aggno]) > 0) {
+      std::pair<int, AttrNumber> argument =
+          AggArgument(&aggstate_->peragg[aggno]);
+      max_attrs[argument.first] =
+          std::max(max_attrs[argument.first], argument.second);
+    }
+  }
+
+  if (0 == num_inlined) {
+    elog(DEBUG1, "Cannot codegen advance_aggregates because no transition "
+                 "function is supported.");
+    return false;
+  }
+
+  llvm::Function* advance_aggregates_func =
+      CreateFunction<AdvanceAggregatesFn>(codegen_utils, GetUniqueFuncName());
+  auto irb = codegen_utils->ir_builder();
+
+  llvm::BasicBlock* entry_block = codegen_utils->CreateBasicBlock(
+      "entry", advance_aggregates_func);
+  llvm::BasicBlock* deform_block = codegen_utils->CreateBasicBlock(
+      "deform", advance_aggregates_func);
+  llvm::BasicBlock* fallback_block = codegen_utils->CreateBasicBlock(
+      "fallback", advance_aggregates_func);
+
+  // External functions
+  llvm::Function* llvm_slot_getsomeattrs =
+      codegen_utils->RegisterExternalFunction(slot_getsomeattrs);
+  llvm::Function* llvm_advance_aggregate =
+      codegen_utils->RegisterExternalFunction(advance_aggregate);
+
+  llvm::Value* llvm_aggstate = ArgumentByPosition(advance_aggregates_func, 0);
+  llvm::Value* llvm_pergroup = ArgumentByPosition(advance_aggregates_func, 1);
+  llvm::Value* llvm_mem_manager =
+      ArgumentByPosition(advance_aggregates_func, 2);
+
+  // Entry block
+  // -----------
+  // Fall back if the Agg node does not have the aggregates we generated
+  // code for.
+  irb->SetInsertPoint(entry_block);
+  llvm::Value* llvm_numaggs = irb->CreateLoad(
+      codegen_utils->GetPointerToMember(llvm_aggstate, &AggState::numaggs));
+  irb->CreateCondBr(
+      irb->CreateICmpEQ(llvm_numaggs,
+                        codegen_utils->GetConstant<int>(numaggs)),
+      deform_block /* true */,
+      fallback_block /* false */);
+
+  // Deform block
+  // ------------
+  // slot_getsomeattrs() on every input slot that inlined aggregates read,
+  // so that arguments can be read directly from the slots.
+  irb->SetInsertPoint(deform_block);
+  llvm::Value* llvm_econtext = irb->CreateLoad(
+      codegen_utils->GetPointerToMember(llvm_aggstate,
+                                        &AggState::tmpcontext));
+  std::map<int, std::pair<llvm::Value*, llvm::Value*>> slot_arrays;
+  for (const auto& max_attr : max_attrs) {
+    llvm::Value* llvm_slot = irb->CreateLoad(irb->CreateBitCast(
+        irb->CreateInBoundsGEP(
+            llvm_econtext,
+            {codegen_utils->GetConstant<int64>(max_attr.first)}),
+        codegen_utils->GetType<TupleTableSlot**>()));
+    irb->CreateCall(llvm_slot_getsomeattrs, {
+        llvm_slot,
+        codegen_utils->GetConstant<int>(max_attr.second)});
+    slot_arrays[max_attr.first] = std::make_pair(
+        irb->CreateLoad(codegen_utils->GetPointerToMember(
+            llvm_slot, &TupleTableSlot::PRIVATE_tts_values)),
+        irb->CreateLoad(codegen_utils->GetPointerToMember(
+            llvm_slot, &TupleTableSlot::PRIVATE_tts_isnull)));
+  }
+
+  // Aggregate blocks
+  // ----------------
+  for (int aggno = 0; aggno < numaggs; ++aggno) {
+    const std::string suffix = std::to_string(aggno);
+    llvm::Value* llvm_aggno = codegen_utils->GetConstant<int>(aggno);
+    llvm::BasicBlock* next_aggregate_block = codegen_utils->CreateBasicBlock(
+        "next_aggregate_" + suffix, advance_aggregates_func);
+
+    if (!IsInlined(aggno)) {
+      irb->CreateCall(llvm_advance_aggregate, {
+          llvm_aggstate, llvm_pergroup, llvm_aggno, llvm_mem_manager});
+      irb->CreateBr(next_aggregate_block);
+      irb->SetInsertPoint(next_aggregate_block);
+      continue;
+    }
+
+    llvm::BasicBlock* check_trans_block = codegen_utils->CreateBasicBlock(
+        "check_trans_" + suffix, advance_aggregates_func);
+    llvm::BasicBlock* transition_block = codegen_utils->CreateBasicBlock(
+        "transition_" + suffix, advance_aggregates_func);
+    llvm::BasicBlock* regular_block = codegen_utils->CreateBasicBlock(
+        "regular_" + suffix, advance_aggregates_func);
+
+    // &pergroup[aggno]
+    llvm::Value* llvm_pergroupstate = irb->CreateInBoundsGEP(
+        llvm_pergroup,
+        {codegen_utils->GetConstant<int64>(
+            aggno * sizeof(AggStatePerGroupData))});
+
+    // Null inputs leave the transition value alone
+    llvm::Value* llvm_arg = nullptr;
+    AggStatePerAgg peraggstate = &aggstate_->peragg[aggno];
+    if (NumAggArguments(peraggstate) > 0) {
+      std::pair<int, AttrNumber> argument = AggArgument(peraggstate);
+      const std::pair<llvm::Value*, llvm::Value*>& arrays =
+          slot_arrays[argument.first];
+      llvm::Value* llvm_attidx =
+          codegen_utils->GetConstant<int>(argument.second - 1);
+      llvm_arg = irb->CreateLoad(
+          irb->CreateInBoundsGEP(arrays.first, {llvm_attidx}));
+      irb->CreateCondBr(
+          irb->CreateLoad(irb->CreateInBoundsGEP(arrays.second,
+                                                 {llvm_attidx})),
+          next_aggregate_block /* true */,
+          check_trans_block /* false */);
+    } else {
+      irb->CreateBr(check_trans_block);
+    }
+
+    // The first input of the group, and NULL transition values, are
+    // handled by the regular function. noTransValue is only ever cleared
+    // for strict functions.
+    irb->SetInsertPoint(check_trans_block);
+    llvm::Value* llvm_trans_is_null = irb->CreateLoad(
+        codegen_utils->GetPointerToMember(
+            llvm_pergroupstate, &AggStatePerGroupData::transValueIsNull));
+    if (peraggstate->transfn.fn_strict) {
+      llvm_trans_is_null = irb->CreateOr(
+          irb->CreateLoad(codegen_utils->GetPointerToMember(
+              llvm_pergroupstate, &AggStatePerGroupData::noTransValue)),
+          llvm_trans_is_null);
+    }
+    irb->CreateCondBr(llvm_trans_is_null,
+                      regular_block /* true */,
+                      transition_block /* false */);
+
+    irb->SetInsertPoint(transition_block);
+    llvm::Value* llvm_trans_value_ptr = codegen_utils->GetPointerToMember(
+        llvm_pergroupstate, &AggStatePerGroupData::transValue);
+    llvm::Value* llvm_overflow = nullptr;
+    llvm::Value* llvm_new_trans_value = GenerateTransition(
+        codegen_utils, aggno, irb->CreateLoad(llvm_trans_value_ptr), llvm_arg,
+        &llvm_overflow);
+    if (nullptr != llvm_overflow) {
+      llvm::BasicBlock* store_block = codegen_utils->CreateBasicBlock(
+          "store_" + suffix, advance_aggregates_func);
+      irb->CreateCondBr(llvm_overflow,
+                        regular_block /* true */,
+                        store_block /* false */);
+      irb->SetInsertPoint(store_block);
+    }
+    irb->CreateStore(llvm_new_trans_value, llvm_trans_value_ptr);
+    irb->CreateBr(next_aggregate_block);
+
+    irb->SetInsertPoint(regular_block);
+    irb->CreateCall(llvm_advance_aggregate, {
+        llvm_aggstate, llvm_pergroup, llvm_aggno, llvm_mem_manager});
+    irb->CreateBr(next_aggregate_block);
+
+    irb->SetInsertPoint(next_aggregate_block);
+  }
+  irb->CreateRetVoid();
+
+  // Fall back block
+  // ---------------
+  irb->SetInsertPoint(fallback_block);
+  codegen_utils->CreateFallback<AdvanceAggregatesFn>(
+      codegen_utils->RegisterExternalFunction(GetRegularFuncPointer()),
+      advance_aggregates_func);
+  return true;
+}
+
+bool AdvanceAggregatesCodegen::GetFingerprint(std::string* fingerprint) const {
+  fingerprint->assign(kAdvanceAggregatesNamePrefix);
+  fingerprint->append(":" + std::to_string(aggstate_->numaggs));
+  for (int aggno = 0; aggno < aggstate_->numaggs; ++aggno) {
+    AggStatePerAgg peraggstate = &aggstate_->peragg[aggno];
+    if (!IsInlined(aggno)) {
+      fingerprint->append(":-");
+      continue;
+    }
+    fingerprint->append(":" + std::to_string(peraggstate->transfn.fn_oid));
+    if (NumAggArguments(peraggstate) > 0) {
+      std::pair<int, AttrNumber> argument = AggArgument(peraggstate);
+      fingerprint->append("/" + std::to_string(argument.first) +
+                          "/" + std::to_string(argument.second));
+    }
+  }
+  return true;
+}
+
+bool AdvanceAggregatesCodegen::GenerateCodeInternal(
+    CodegenUtils* codegen_utils) {
+  bool isGenerated = GenerateAdvanceAggregates(codegen_utils);
+
+  if (isGenerated) {
+    elog(DEBUG1, "advance_aggregates was generated successfully!");
+    return true;
+  } else {
+    elog(DEBUG1, "advance_aggregates generation failed!");
+    return false;
+  }
+}
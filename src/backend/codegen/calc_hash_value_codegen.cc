@@ -0,0 +1,196 @@
+//---------------------------------------------------------------------------
+//  Greenplum Database
+//  Copyright (C) 2016 Pivotal Software, Inc.
+//
+//  @filename:
+//    calc_hash_value_codegen.cc
+//
+//  @doc:
+//    Generates code for calc_hash_value function.
+//
+//---------------------------------------------------------------------------
+#include <algorithm>
+#include <cstdint>
+#include <string>
+
+#include "codegen/calc_hash_value_codegen.h"
+#include "codegen/hash_key_generator.h"
+#include "codegen/utils/utility.h"
+#include "codegen/utils/codegen_utils.h"
+
+#include "llvm/IR/BasicBlock.h"
+#include "llvm/IR/Constant.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Value.h"
+
+extern "C" {
+#include "postgres.h"
+#include "access/hash.h"
+#include "utils/elog.h"
+#include "nodes/execnodes.h"
+#include "nodes/plannodes.h"
+#include "executor/execHHashagg.h"
+#include "executor/tuptable.h"
+}
+
+using gpcodegen::CalcHashValueCodegen;
+using gpcodegen::HashKeyGenerator;
+
+constexpr char CalcHashValueCodegen::kCalcHashValueNamePrefix[];
+
+namespace {
+
+// The value the regular function hashes a NULL grouping column to
+constexpr uint32_t kNullHashKey = 0xdeadbeef;
+
+}  // namespace
+
+CalcHashValueCodegen::CalcHashValueCodegen(
+    CalcHashValueFn regular_func_ptr,
+    CalcHashValueFn* ptr_to_regular_func_ptr,
+    AggState* aggstate) :
+    BaseCodegen(kCalcHashValueNamePrefix,
+                regular_func_ptr,
+                ptr_to_regular_func_ptr),
+    aggstate_(aggstate) {
+}
+
+bool CalcHashValueCodegen::IsSupported() const {
+  Agg* agg = reinterpret_cast<Agg*>(aggstate_->ss.ps.plan);
+  if (agg->numCols <= 0 || NULL == aggstate_->hashfunctions) {
+    return false;
+  }
+  for (int i = 0; i < agg->numCols; ++i) {
+    if (!HashKeyGenerator::IsHashFuncSupported(
+            aggstate_->hashfunctions[i].fn_oid)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool CalcHashValueCodegen::GenerateCalcHashValue(
+    gpcodegen::CodegenUtils* codegen_utils) {
+  assert(NULL != codegen_utils);
+  static_assert(sizeof(HashKey) == sizeof(uint32),
+      "sizeof(HashKey) doesn't match sizeof(uint32)");
+
+  if (!IsSupported()) {
+    elog(DEBUG1, "Cannot codegen calc_hash_value because some hash "
+                 "functions are not supported.");
+    return false;
+  }
+
+  Agg* agg = reinterpret_cast<Agg*>(aggstate_->ss.ps.plan);
+  AttrNumber max_attr = 0;
+  for (int i = 0; i < agg->numCols; ++i) {
+    max_attr = std::max(max_attr, agg->grpColIdx[i]);
+  }
+
+  llvm::Function* calc_hash_value_func =
+      CreateFunction<CalcHashValueFn>(codegen_utils, GetUniqueFuncName());
+  auto irb = codegen_utils->ir_builder();
+
+  llvm::BasicBlock* entry_block = codegen_utils->CreateBasicBlock(
+      "entry", calc_hash_value_func);
+  llvm::BasicBlock* hash_block = codegen_utils->CreateBasicBlock(
+      "hash", calc_hash_value_func);
+  llvm::BasicBlock* fallback_block = codegen_utils->CreateBasicBlock(
+      "fallback", calc_hash_value_func);
+
+  llvm::Value* llvm_aggstate = ArgumentByPosition(calc_hash_value_func, 0);
+  llvm::Value* llvm_inputslot = ArgumentByPosition(calc_hash_value_func, 1);
+
+  // Entry block
+  // -----------
+  // Fall back if the Agg node does not have the grouping columns we
+  // generated code for.
+  irb->SetInsertPoint(entry_block);
+  llvm::Value* llvm_agg = irb->CreateLoad(codegen_utils->GetPointerToMember(
+      llvm_aggstate, &AggState::ss, &ScanState::ps, &PlanState::plan));
+  llvm::Value* llvm_numcols = irb->CreateLoad(
+      codegen_utils->GetPointerToMember(llvm_agg, &Agg::numCols));
+  irb->CreateCondBr(
+      irb->CreateICmpEQ(llvm_numcols,
+                        codegen_utils->GetConstant<int>(agg->numCols)),
+      hash_block /* true */,
+      fallback_block /* false */);
+
+  // Hash block
+  // ----------
+  // Hash every grouping column into the hashkey_buf of the hash table, and
+  // combine them with hash_any().
+  irb->SetInsertPoint(hash_block);
+  irb->CreateCall(
+      codegen_utils->RegisterExternalFunction(slot_getsomeattrs), {
+          llvm_inputslot,
+          codegen_utils->GetConstant<int>(max_attr)});
+  llvm::Value* llvm_values = irb->CreateLoad(codegen_utils->GetPointerToMember(
+      llvm_inputslot, &TupleTableSlot::PRIVATE_tts_values));
+  llvm::Value* llvm_isnull = irb->CreateLoad(codegen_utils->GetPointerToMember(
+      llvm_inputslot, &TupleTableSlot::PRIVATE_tts_isnull));
+  llvm::Value* llvm_hashtable = irb->CreateLoad(
+      codegen_utils->GetPointerToMember(llvm_aggstate,
+                                        &AggState::hhashtable));
+  llvm::Value* llvm_hashkey_buf = irb->CreateLoad(
+      codegen_utils->GetPointerToMember(llvm_hashtable,
+                                        &HashAggTable::hashkey_buf));
+
+  for (int i = 0; i < agg->numCols; ++i) {
+    llvm::Value* llvm_attidx =
+        codegen_utils->GetConstant<int>(agg->grpColIdx[i] - 1);
+    llvm::Value* llvm_value = irb->CreateLoad(
+        irb->CreateInBoundsGEP(llvm_values, {llvm_attidx}));
+    llvm::Value* llvm_hkey = irb->CreateSelect(
+        irb->CreateLoad(irb->CreateInBoundsGEP(llvm_isnull, {llvm_attidx})),
+        codegen_utils->GetConstant<uint32>(kNullHashKey),
+        HashKeyGenerator::GenerateHashFunc(
+            codegen_utils, aggstate_->hashfunctions[i].fn_oid, llvm_value));
+    irb->CreateStore(llvm_hkey, irb->CreateInBoundsGEP(
+        llvm_hashkey_buf, {codegen_utils->GetConstant<int>(i)}));
+  }
+
+  llvm::Value* llvm_hash = irb->CreateCall(
+      codegen_utils->RegisterExternalFunction(hash_any), {
+          irb->CreateBitCast(llvm_hashkey_buf,
+                             codegen_utils->GetType<const unsigned char*>()),
+          codegen_utils->GetConstant<int>(agg->numCols * sizeof(HashKey))});
+  irb->CreateRet(irb->CreateTrunc(llvm_hash,
+                                  codegen_utils->GetType<uint32>()));
+
+  // Fall back block
+  // ---------------
+  irb->SetInsertPoint(fallback_block);
+  codegen_utils->CreateFallback<CalcHashValueFn>(
+      codegen_utils->RegisterExternalFunction(GetRegularFuncPointer()),
+      calc_hash_value_func);
+  return true;
+}
+
+bool CalcHashValueCodegen::GetFingerprint(std::string* fingerprint) const {
+  if (!IsSupported()) {
+    return false;
+  }
+
+  Agg* agg = reinterpret_cast<Agg*>(aggstate_->ss.ps.plan);
+  fingerprint->assign(kCalcHashValueNamePrefix);
+  for (int i = 0; i < agg->numCols; ++i) {
+    fingerprint->append(":" + std::to_string(agg->grpColIdx[i]) +
+                        "/" +
+                        std::to_string(aggstate_->hashfunctions[i].fn_oid));
+  }
+  return true;
+}
+
+bool CalcHashValueCodegen::GenerateCodeInternal(
+    CodegenUtils* codegen_utils) {
+  bool isGenerated = GenerateCalcHashValue(codegen_utils);
+
+  if (isGenerated) {
+    elog(DEBUG1, "calc_hash_value was generated successfully!");
+    return true;
+  } else {
+    elog(DEBUG1, "calc_hash_value generation failed!");
+    return false;
+  }
+}
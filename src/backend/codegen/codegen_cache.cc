@@ -0,0 +1,99 @@
+//---------------------------------------------------------------------------
+//  Greenplum Database
+//  Copyright (C) 2016 Pivotal Software, Inc.
+//
+//  @filename:
+//    codegen_cache.cc
+//
+//  @doc:
+//    Implementation of the per-backend cache of compiled generated functions
+//
+//---------------------------------------------------------------------------
+
+#include "codegen/codegen_cache.h"
+
+#include <cassert>
+#include <string>
+
+#include "codegen/utils/codegen_utils.h"
+
+using gpcodegen::CodegenCache;
+
+CodegenCache* CodegenCache::GetInstance() {
+  // Every backend is a separate process, so one instance per process is one
+  // instance per backend. The instance is never destroyed, so that cached
+  // LLVM modules are not torn down by static destructors at backend exit.
+  static CodegenCache* instance = new CodegenCache();
+  return instance;
+}
+
+CodegenCache::CodegenCache()
+    : capacity_(0),
+      hits_(0),
+      misses_(0),
+      evictions_(0) {
+}
+
+bool CodegenCache::Lookup(const std::string& fingerprint, Entry* entry) {
+  assert(nullptr != entry);
+  std::lock_guard<std::mutex> guard(mutex_);
+  auto it = index_.find(fingerprint);
+  if (index_.end() == it) {
+    misses_++;
+    return false;
+  }
+  // Move the entry to the front of the LRU list
+  lru_list_.splice(lru_list_.begin(), lru_list_, it->second);
+  *entry = it->second->second;
+  hits_++;
+  return true;
+}
+
+void CodegenCache::Insert(const std::string& fingerprint,
+                          const Entry& entry) {
+  assert(nullptr != entry.codegen_utils);
+  std::lock_guard<std::mutex> guard(mutex_);
+  if (0 == capacity_) {
+    return;
+  }
+  auto it = index_.find(fingerprint);
+  if (index_.end() != it) {
+    // Another generator of the same query compiled the same function.
+    // Keep the existing entry.
+    lru_list_.splice(lru_list_.begin(), lru_list_, it->second);
+    return;
+  }
+  EvictTo(capacity_ - 1);
+  lru_list_.emplace_front(fingerprint, entry);
+  index_[fingerprint] = lru_list_.begin();
+}
+
+void CodegenCache::SetCapacity(std::size_t capacity) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  capacity_ = capacity;
+  EvictTo(capacity_);
+}
+
+void CodegenCache::Clear() {
+  std::lock_guard<std::mutex> guard(mutex_);
+  lru_list_.clear();
+  index_.clear();
+}
+
+CodegenCache::Stats CodegenCache::GetStats() const {
+  std::lock_guard<std::mutex> guard(mutex_);
+  Stats stats;
+  stats.hits = hits_;
+  stats.misses = misses_;
+  stats.evictions = evictions_;
+  stats.entries = lru_list_.size();
+  return stats;
+}
+
+void CodegenCache::EvictTo(std::size_t capacity) {
+  while (lru_list_.size() > capacity) {
+    index_.erase(lru_list_.back().first);
+    lru_list_.pop_back();
+    evictions_++;
+  }
+}
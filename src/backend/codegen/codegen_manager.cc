@@ -11,11 +11,21 @@
 //---------------------------------------------------------------------------
 
 extern "C" {
+#include <postgres.h>
 #include <utils/elog.h>
 }
 
+#include <algorithm>
+#include <cstddef>
 #include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
 #include <string>
+#include <system_error>  // NOLINT(build/c++11)
+#include <thread>  // NOLINT(build/c++11)
+#include <utility>
+#include <vector>
 
 #include "codegen/utils/clang_compiler.h"
 #include "codegen/utils/utility.h"
@@ -24,6 +34,7 @@ extern "C" {
 #include "codegen/codegen_interface.h"
 
 #include "codegen/codegen_manager.h"
+#include "codegen/object_code_cache.h"
 #include "llvm/ADT/APFloat.h"
 #include "llvm/ADT/APInt.h"
 #include "llvm/IR/Argument.h"
@@ -41,12 +52,40 @@ extern "C" {
 #include "llvm/Support/Casting.h"
 
 using gpcodegen::CodegenManager;
+using gpcodegen::ObjectCodeCache;
 
-CodegenManager::CodegenManager(const std::string& module_name) {
+struct CodegenManager::AsyncCompilation {
+  // Held by the background thread while it swaps in compiled functions.
+  std::mutex mutex;
+  // Generators the background thread may still swap in. Cancelling the
+  // compilation, or detaching a generator, takes them off.
+  std::vector<CodegenInterface*> generated;
+
+  void Cancel() {
+    std::lock_guard<std::mutex> guard(mutex);
+    generated.clear();
+  }
+
+  void Detach(CodegenInterface* generator) {
+    std::lock_guard<std::mutex> guard(mutex);
+    generated.erase(std::remove(generated.begin(), generated.end(), generator),
+                    generated.end());
+  }
+};
+
+
+CodegenManager::CodegenManager(const std::string& module_name)
+    : instruction_limit_(0) {
   module_name_ = module_name;
   codegen_utils_.reset(new gpcodegen::CodegenUtils(module_name));
 }
 
+CodegenManager::~CodegenManager() {
+  if (nullptr != async_compilation_) {
+    async_compilation_->Cancel();
+  }
+}
+
 bool CodegenManager::EnrollCodeGenerator(
     CodegenFuncLifespan funcLifespan, CodegenInterface* generator) {
   // Only CodegenFuncLifespan_Parameter_Invariant is supported as of now
@@ -58,24 +97,172 @@ bool CodegenManager::EnrollCodeGenerator(
 
 unsigned int CodegenManager::GenerateCode() {
   unsigned int success_count = 0;
+  CodegenCache* cache = CodegenCache::GetInstance();
+  std::size_t instruction_budget = (0 == instruction_limit_) ?
+      std::numeric_limits<std::size_t>::max() : instruction_limit_;
   for (std::unique_ptr<CodegenInterface>& generator :
       enrolled_code_generators_) {
-    success_count += generator->GenerateCode(codegen_utils_.get());
+    std::string fingerprint;
+    if (cache->IsEnabled() && generator->GetFingerprint(&fingerprint)) {
+      CodegenCache::Entry entry;
+      if (cache->Lookup(fingerprint, &entry)) {
+        // The entry keeps the compiled module alive until we are done
+        cache_hits_.emplace_back(generator.get(), entry);
+        success_count++;
+        continue;
+      }
+      cache_misses_.emplace_back(generator.get(), fingerprint);
+    }
+    success_count += generator->GenerateCode(codegen_utils_.get(),
+                                             &instruction_budget);
   }
   return success_count;
 }
 
 unsigned int CodegenManager::PrepareGeneratedFunctions() {
-  unsigned int success_count = 0;
-
   // If no generator registered, just return with success count as 0
   if (enrolled_code_generators_.empty()) {
+    return 0;
+  }
+
+  // Functions found in the cache are already compiled
+  unsigned int success_count = SetToCachedFunctions();
+
+  // Nothing left to compile if every generator found its function in the
+  // cache.
+  if (cache_hits_.size() == enrolled_code_generators_.size()) {
     return success_count;
   }
 
+  std::vector<CodegenInterface*> generated;
+  std::vector<std::pair<std::string, std::string>> cacheable;
+  GetGeneratedFunctions(&generated, &cacheable);
+  return success_count + CompileAndSetToGenerated(
+      nullptr, codegen_utils_, generated, cacheable);
+}
+
+unsigned int CodegenManager::PrepareGeneratedFunctionsAsync() {
+  assert(nullptr == async_compilation_);
+  if (enrolled_code_generators_.empty()) {
+    return 0;
+  }
+
+  unsigned int success_count = SetToCachedFunctions();
+  if (cache_hits_.size() == enrolled_code_generators_.size()) {
+    return success_count;
+  }
+
+  std::vector<CodegenInterface*> generated;
+  std::vector<std::pair<std::string, std::string>> cacheable;
+  GetGeneratedFunctions(&generated, &cacheable);
+  if (generated.empty()) {
+    return success_count;
+  }
+
+  std::shared_ptr<AsyncCompilation> async_compilation =
+      std::make_shared<AsyncCompilation>();
+  async_compilation->generated = generated;
+  try {
+    // The thread owns copies of everything it uses except the generators,
+    // which it only touches while holding the lock and still listed.
+    std::shared_ptr<gpcodegen::CodegenUtils> codegen_utils = codegen_utils_;
+    std::thread([async_compilation, codegen_utils, cacheable]() {
+      gp_set_thread_sigmasks();
+      CompileAndSetToGenerated(
+          async_compilation, codegen_utils, {}, cacheable);
+    }).detach();
+  } catch (const std::system_error&) {
+    // Could not start a thread; compile right here instead.
+    return success_count + CompileAndSetToGenerated(
+        nullptr, codegen_utils_, generated, cacheable);
+  }
+
+  async_compilation_ = async_compilation;
+  RegisterAsyncCompilation(async_compilation_);
+  return success_count;
+}
+
+void CodegenManager::CancelAsyncCompilations() {
+  for (std::weak_ptr<AsyncCompilation>& weak : AsyncCompilations()) {
+    std::shared_ptr<AsyncCompilation> async_compilation = weak.lock();
+    if (nullptr != async_compilation) {
+      async_compilation->Cancel();
+    }
+  }
+  AsyncCompilations().clear();
+}
+
+void CodegenManager::DetachGenerator(CodegenInterface* generator) {
+  for (std::weak_ptr<AsyncCompilation>& weak : AsyncCompilations()) {
+    std::shared_ptr<AsyncCompilation> async_compilation = weak.lock();
+    if (nullptr != async_compilation) {
+      async_compilation->Detach(generator);
+    }
+  }
+}
+
+std::vector<std::weak_ptr<CodegenManager::AsyncCompilation>>&
+CodegenManager::AsyncCompilations() {
+  // Never destroyed, like the CodegenCache
+  static std::vector<std::weak_ptr<AsyncCompilation>>* async_compilations =
+      new std::vector<std::weak_ptr<AsyncCompilation>>();
+  return *async_compilations;
+}
+
+void CodegenManager::RegisterAsyncCompilation(
+    const std::shared_ptr<AsyncCompilation>& async_compilation) {
+  std::vector<std::weak_ptr<AsyncCompilation>>& async_compilations =
+      AsyncCompilations();
+  // Forget compilations that finished and whose manager is gone
+  async_compilations.erase(
+      std::remove_if(async_compilations.begin(), async_compilations.end(),
+                     [](const std::weak_ptr<AsyncCompilation>& weak) {
+                       return weak.expired();
+                     }),
+      async_compilations.end());
+  async_compilations.push_back(async_compilation);
+}
+
+unsigned int CodegenManager::SetToCachedFunctions() {
+  unsigned int success_count = 0;
+  for (auto& hit : cache_hits_) {
+    success_count += hit.first->SetToCompiledFunction(
+        hit.second.codegen_utils.get(), hit.second.func_name);
+  }
+  return success_count;
+}
+
+void CodegenManager::GetGeneratedFunctions(
+    std::vector<CodegenInterface*>* generated,
+    std::vector<std::pair<std::string, std::string>>* cacheable) const {
+  for (const std::unique_ptr<CodegenInterface>& generator :
+      enrolled_code_generators_) {
+    if (generator->IsGenerated()) {
+      generated->push_back(generator.get());
+    }
+  }
+  for (const auto& miss : cache_misses_) {
+    if (miss.first->IsGenerated()) {
+      cacheable->emplace_back(miss.second, miss.first->GetUniqueFuncName());
+    }
+  }
+}
+
+unsigned int CodegenManager::CompileAndSetToGenerated(
+    const std::shared_ptr<AsyncCompilation>& async_compilation,
+    const std::shared_ptr<gpcodegen::CodegenUtils>& codegen_utils,
+    const std::vector<CodegenInterface*>& generated,
+    const std::vector<std::pair<std::string, std::string>>& cacheable) {
+  unsigned int success_count = 0;
+
+  // Reuse the machine code of an identical module compiled by any backend
+  ObjectCodeCache* object_cache = ObjectCodeCache::GetInstance();
+  if (object_cache->IsEnabled()) {
+    codegen_utils->SetObjectCache(object_cache);
+  }
 
   // Call CodegenUtils to compile entire module
-  bool compilation_status = codegen_utils_->PrepareForExecution(
+  bool compilation_status = codegen_utils->PrepareForExecution(
       gpcodegen::CodegenUtils::OptimizationLevel::kDefault, true);
 
   if (!compilation_status) {
@@ -84,10 +271,25 @@ unsigned int CodegenManager::PrepareGeneratedFunctions() {
 
   // On successful compilation, go through all generator and swap
   // the pointer so compiled function get called
-  gpcodegen::CodegenUtils* codegen_utils = codegen_utils_.get();
-  for (std::unique_ptr<CodegenInterface>& generator :
-      enrolled_code_generators_) {
-    success_count += generator->SetToGenerated(codegen_utils);
+  {
+    std::unique_lock<std::mutex> guard;
+    const std::vector<CodegenInterface*>* to_swap_in = &generated;
+    if (nullptr != async_compilation) {
+      guard = std::unique_lock<std::mutex>(async_compilation->mutex);
+      to_swap_in = &async_compilation->generated;
+    }
+    for (CodegenInterface* generator : *to_swap_in) {
+      success_count += generator->SetToGenerated(codegen_utils.get());
+    }
+  }
+
+  // Make the newly compiled functions available to later queries
+  CodegenCache* cache = CodegenCache::GetInstance();
+  for (const auto& fingerprint_and_func_name : cacheable) {
+    CodegenCache::Entry entry;
+    entry.codegen_utils = codegen_utils;
+    entry.func_name = fingerprint_and_func_name.second;
+    cache->Insert(fingerprint_and_func_name.first, entry);
   }
   return success_count;
 }
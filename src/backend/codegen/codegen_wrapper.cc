@@ -11,16 +11,32 @@
 //---------------------------------------------------------------------------
 
 #include "codegen/codegen_wrapper.h"
+#include "codegen/advance_aggregates_codegen.h"
+#include "codegen/calc_hash_value_codegen.h"
+#include "codegen/codegen_cache.h"
 #include "codegen/codegen_manager.h"
+#include "codegen/eval_hash_key_codegen.h"
+#include "codegen/exec_hash_get_hash_value_codegen.h"
 #include "codegen/exec_variable_list_codegen.h"
 #include "codegen/exec_qual_codegen.h"
+#include "codegen/object_code_cache.h"
+#include "codegen/slot_deform_memtuple_codegen.h"
+#include "codegen/slot_deform_tuple_codegen.h"
 
 #include "codegen/utils/codegen_utils.h"
 
+using gpcodegen::AdvanceAggregatesCodegen;
+using gpcodegen::CalcHashValueCodegen;
+using gpcodegen::CodegenCache;
 using gpcodegen::CodegenManager;
 using gpcodegen::BaseCodegen;
+using gpcodegen::EvalHashKeyCodegen;
+using gpcodegen::ExecHashGetHashValueCodegen;
 using gpcodegen::ExecVariableListCodegen;
 using gpcodegen::ExecQualCodegen;
+using gpcodegen::ObjectCodeCache;
+using gpcodegen::SlotDeformMemTupleCodegen;
+using gpcodegen::SlotDeformTupleCodegen;
 
 // Current code generator manager that oversees all code generators
 static void* ActiveCodeGeneratorManager = nullptr;
@@ -28,6 +44,11 @@ static bool is_codegen_initalized = false;
 
 extern bool codegen;  // defined from guc
 extern bool init_codegen;  // defined from guc
+extern int codegen_cache_size;  // defined from guc
+extern bool codegen_async_compile;  // defined from guc
+extern int codegen_max_instructions;  // defined from guc
+extern int codegen_object_cache_size;  // defined from guc
+extern char* codegen_object_cache_directory;  // defined from guc
 
 // Perform global set-up tasks for code generation. Returns 0 on
 // success, nonzero on error.
@@ -46,6 +67,14 @@ unsigned int CodeGeneratorManagerGenerateCode(void* manager) {
   if (!codegen) {
     return 0;
   }
+  // Pick up any change of the cache size before looking up functions
+  CodegenCache::GetInstance()->SetCapacity(codegen_cache_size);
+  ObjectCodeCache::GetInstance()->Configure(
+      nullptr == codegen_object_cache_directory ?
+          "" : codegen_object_cache_directory,
+      static_cast<std::size_t>(codegen_object_cache_size) * 1024);
+  static_cast<CodegenManager*>(manager)->SetInstructionLimit(
+      codegen_max_instructions);
   return static_cast<CodegenManager*>(manager)->GenerateCode();
 }
 
@@ -53,6 +82,10 @@ unsigned int CodeGeneratorManagerPrepareGeneratedFunctions(void* manager) {
   if (!codegen) {
     return 0;
   }
+  if (codegen_async_compile) {
+    return static_cast<CodegenManager*>(
+        manager)->PrepareGeneratedFunctionsAsync();
+  }
   return static_cast<CodegenManager*>(manager)->PrepareGeneratedFunctions();
 }
 
@@ -66,6 +99,16 @@ void CodeGeneratorManagerDestroy(void* manager) {
   delete (static_cast<CodegenManager*>(manager));
 }
 
+void CodeGeneratorManagerCancelAsyncCompilations() {
+  CodegenManager::CancelAsyncCompilations();
+}
+
+void CodeGeneratorDetach(void* generator) {
+  // Every generator handed out derives from CodegenInterface only
+  CodegenManager::DetachGenerator(
+      static_cast<gpcodegen::CodegenInterface*>(generator));
+}
+
 void* GetActiveCodeGeneratorManager() {
   return ActiveCodeGeneratorManager;
 }
@@ -74,6 +117,14 @@ void SetActiveCodeGeneratorManager(void* manager) {
   ActiveCodeGeneratorManager = manager;
 }
 
+void GetCodegenCacheStats(CodegenCacheStats* stats) {
+  CodegenCache::Stats cache_stats = CodegenCache::GetInstance()->GetStats();
+  stats->hits = cache_stats.hits;
+  stats->misses = cache_stats.misses;
+  stats->evictions = cache_stats.evictions;
+  stats->entries = cache_stats.entries;
+}
+
 /**
  * @brief Template function to facilitate enroll for any type of
  *        codegen
@@ -128,3 +179,63 @@ void* ExecQualCodegenEnroll(
   return generator;
 }
 
+void* SlotDeformTupleCodegenEnroll(
+    SlotDeformTupleFn regular_func_ptr,
+    SlotDeformTupleFn* ptr_to_chosen_func_ptr,
+    TupleTableSlot* slot) {
+  SlotDeformTupleCodegen* generator = CodegenEnroll<SlotDeformTupleCodegen>(
+      regular_func_ptr, ptr_to_chosen_func_ptr, slot);
+  return generator;
+}
+
+void* SlotDeformMemTupleCodegenEnroll(
+    SlotDeformMemTupleFn regular_func_ptr,
+    SlotDeformMemTupleFn* ptr_to_chosen_func_ptr,
+    TupleTableSlot* slot) {
+  SlotDeformMemTupleCodegen* generator =
+      CodegenEnroll<SlotDeformMemTupleCodegen>(
+          regular_func_ptr, ptr_to_chosen_func_ptr, slot);
+  return generator;
+}
+
+void* AdvanceAggregatesCodegenEnroll(
+    AdvanceAggregatesFn regular_func_ptr,
+    AdvanceAggregatesFn* ptr_to_chosen_func_ptr,
+    AggState* aggstate) {
+  AdvanceAggregatesCodegen* generator =
+      CodegenEnroll<AdvanceAggregatesCodegen>(
+          regular_func_ptr, ptr_to_chosen_func_ptr, aggstate);
+  return generator;
+}
+
+void* ExecHashGetHashValueCodegenEnroll(
+    ExecHashGetHashValueFn regular_func_ptr,
+    ExecHashGetHashValueFn* ptr_to_chosen_func_ptr,
+    List* hashkeys,
+    List* hashoperators,
+    bool outer_tuple) {
+  ExecHashGetHashValueCodegen* generator =
+      CodegenEnroll<ExecHashGetHashValueCodegen>(
+          regular_func_ptr, ptr_to_chosen_func_ptr, hashkeys, hashoperators,
+          outer_tuple);
+  return generator;
+}
+
+void* CalcHashValueCodegenEnroll(
+    CalcHashValueFn regular_func_ptr,
+    CalcHashValueFn* ptr_to_chosen_func_ptr,
+    AggState* aggstate) {
+  CalcHashValueCodegen* generator = CodegenEnroll<CalcHashValueCodegen>(
+      regular_func_ptr, ptr_to_chosen_func_ptr, aggstate);
+  return generator;
+}
+
+void* EvalHashKeyCodegenEnroll(
+    EvalHashKeyFn regular_func_ptr,
+    EvalHashKeyFn* ptr_to_chosen_func_ptr,
+    List* hashkeys,
+    List* hashtypes) {
+  EvalHashKeyCodegen* generator = CodegenEnroll<EvalHashKeyCodegen>(
+      regular_func_ptr, ptr_to_chosen_func_ptr, hashkeys, hashtypes);
+  return generator;
+}
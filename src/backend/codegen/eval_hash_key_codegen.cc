@@ -0,0 +1,163 @@
+//---------------------------------------------------------------------------
+//  Greenplum Database
+//  Copyright (C) 2016 Pivotal Software, Inc.
+//
+//  @filename:
+//    eval_hash_key_codegen.cc
+//
+//  @doc:
+//    Generates code for evalHashKey function.
+//
+//---------------------------------------------------------------------------
+#include <string>
+
+#include "codegen/eval_hash_key_codegen.h"
+#include "codegen/hash_key_generator.h"
+#include "codegen/utils/utility.h"
+#include "codegen/utils/codegen_utils.h"
+
+#include "llvm/IR/BasicBlock.h"
+#include "llvm/IR/Constant.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Value.h"
+
+extern "C" {
+#include "postgres.h"
+#include "utils/elog.h"
+#include "nodes/execnodes.h"
+#include "nodes/pg_list.h"
+#include "cdb/cdbhash.h"
+}
+
+using gpcodegen::EvalHashKeyCodegen;
+using gpcodegen::HashKeyGenerator;
+
+constexpr char EvalHashKeyCodegen::kEvalHashKeyNamePrefix[];
+
+EvalHashKeyCodegen::EvalHashKeyCodegen(
+    EvalHashKeyFn regular_func_ptr,
+    EvalHashKeyFn* ptr_to_regular_func_ptr,
+    List* hashkeys,
+    List* hashtypes) :
+    BaseCodegen(kEvalHashKeyNamePrefix,
+                regular_func_ptr,
+                ptr_to_regular_func_ptr),
+    hashkeys_(hashkeys),
+    hashtypes_(hashtypes) {
+}
+
+bool EvalHashKeyCodegen::IsSupported() const {
+  if (NIL == hashkeys_ ||
+      list_length(hashkeys_) != list_length(hashtypes_)) {
+    return false;
+  }
+
+  ListCell* hk;
+  ListCell* ht;
+  forboth(hk, hashkeys_, ht, hashtypes_) {
+    if (!HashKeyGenerator::IsVarKey(
+            reinterpret_cast<ExprState*>(lfirst(hk))) ||
+        !HashKeyGenerator::IsCdbHashTypeSupported(lfirst_oid(ht))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool EvalHashKeyCodegen::GenerateEvalHashKey(
+    gpcodegen::CodegenUtils* codegen_utils) {
+  assert(NULL != codegen_utils);
+
+  if (!IsSupported()) {
+    elog(DEBUG1, "Cannot codegen evalHashKey because some hash keys "
+                 "are not supported.");
+    return false;
+  }
+
+  llvm::Function* eval_hash_key_func =
+      CreateFunction<EvalHashKeyFn>(codegen_utils, GetUniqueFuncName());
+  auto irb = codegen_utils->ir_builder();
+
+  llvm::BasicBlock* entry_block = codegen_utils->CreateBasicBlock(
+      "entry", eval_hash_key_func);
+  llvm::BasicBlock* hash_block = codegen_utils->CreateBasicBlock(
+      "hash", eval_hash_key_func);
+  llvm::BasicBlock* fallback_block = codegen_utils->CreateBasicBlock(
+      "fallback", eval_hash_key_func);
+
+  llvm::Value* llvm_econtext = ArgumentByPosition(eval_hash_key_func, 0);
+  llvm::Value* llvm_h = ArgumentByPosition(eval_hash_key_func, 3);
+
+  // Entry block
+  // -----------
+  // Fall back for the hash algorithms we do not generate code for.
+  irb->SetInsertPoint(entry_block);
+  llvm::Value* llvm_hashalg = irb->CreateLoad(
+      codegen_utils->GetPointerToMember(llvm_h, &CdbHash::hashalg));
+  irb->CreateCondBr(
+      irb->CreateICmpEQ(llvm_hashalg,
+                        codegen_utils->GetConstant<CdbHashAlg>(HASH_FNV_1)),
+      hash_block /* true */,
+      fallback_block /* false */);
+
+  // Hash block
+  // ----------
+  // As cdbhashinit(), then cdbhash() or cdbhashnull() for every key.
+  irb->SetInsertPoint(hash_block);
+  llvm::Value* llvm_hash = HashKeyGenerator::GenerateCdbHashInit(
+      codegen_utils);
+  ListCell* hk;
+  ListCell* ht;
+  forboth(hk, hashkeys_, ht, hashtypes_) {
+    llvm::Value* llvm_keyval = nullptr;
+    llvm::Value* llvm_isnull = nullptr;
+    HashKeyGenerator::GenerateVarKey(codegen_utils, llvm_econtext,
+                                     reinterpret_cast<ExprState*>(lfirst(hk)),
+                                     &llvm_keyval, &llvm_isnull);
+    llvm_hash = irb->CreateSelect(
+        llvm_isnull,
+        HashKeyGenerator::GenerateCdbHashNull(codegen_utils, llvm_hash),
+        HashKeyGenerator::GenerateCdbHash(codegen_utils, lfirst_oid(ht),
+                                          llvm_hash, llvm_keyval));
+  }
+  irb->CreateStore(llvm_hash,
+                   codegen_utils->GetPointerToMember(llvm_h, &CdbHash::hash));
+  irb->CreateRet(irb->CreateCall(
+      codegen_utils->RegisterExternalFunction(cdbhashreduce), {llvm_h}));
+
+  // Fall back block
+  // ---------------
+  irb->SetInsertPoint(fallback_block);
+  codegen_utils->CreateFallback<EvalHashKeyFn>(
+      codegen_utils->RegisterExternalFunction(GetRegularFuncPointer()),
+      eval_hash_key_func);
+  return true;
+}
+
+bool EvalHashKeyCodegen::GetFingerprint(std::string* fingerprint) const {
+  if (!IsSupported()) {
+    return false;
+  }
+
+  fingerprint->assign(kEvalHashKeyNamePrefix);
+  ListCell* hk;
+  ListCell* ht;
+  forboth(hk, hashkeys_, ht, hashtypes_) {
+    HashKeyGenerator::AppendVarKeyFingerprint(
+        reinterpret_cast<ExprState*>(lfirst(hk)), fingerprint);
+    fingerprint->append("/" + std::to_string(lfirst_oid(ht)));
+  }
+  return true;
+}
+
+bool EvalHashKeyCodegen::GenerateCodeInternal(CodegenUtils* codegen_utils) {
+  bool isGenerated = GenerateEvalHashKey(codegen_utils);
+
+  if (isGenerated) {
+    elog(DEBUG1, "evalHashKey was generated successfully!");
+    return true;
+  } else {
+    elog(DEBUG1, "evalHashKey generation failed!");
+    return false;
+  }
+}
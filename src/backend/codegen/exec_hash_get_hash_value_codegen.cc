@@ -0,0 +1,212 @@
+//---------------------------------------------------------------------------
+//  Greenplum Database
+//  Copyright (C) 2016 Pivotal Software, Inc.
+//
+//  @filename:
+//    exec_hash_get_hash_value_codegen.cc
+//
+//  @doc:
+//    Generates code for ExecHashGetHashValue function.
+//
+//---------------------------------------------------------------------------
+#include <string>
+#include <vector>
+
+#include "codegen/exec_hash_get_hash_value_codegen.h"
+#include "codegen/hash_key_generator.h"
+#include "codegen/utils/utility.h"
+#include "codegen/utils/codegen_utils.h"
+
+#include "llvm/IR/BasicBlock.h"
+#include "llvm/IR/Constant.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Value.h"
+
+extern "C" {
+#include "postgres.h"
+#include "utils/elog.h"
+#include "utils/lsyscache.h"
+#include "nodes/execnodes.h"
+#include "nodes/pg_list.h"
+#include "executor/nodeHash.h"
+}
+
+using gpcodegen::ExecHashGetHashValueCodegen;
+using gpcodegen::HashKeyGenerator;
+
+constexpr char ExecHashGetHashValueCodegen::kExecHashGetHashValueNamePrefix[];
+
+ExecHashGetHashValueCodegen::ExecHashGetHashValueCodegen(
+    ExecHashGetHashValueFn regular_func_ptr,
+    ExecHashGetHashValueFn* ptr_to_regular_func_ptr,
+    List* hashkeys,
+    List* hashoperators,
+    bool outer_tuple) :
+    BaseCodegen(kExecHashGetHashValueNamePrefix,
+                regular_func_ptr,
+                ptr_to_regular_func_ptr),
+    hashkeys_(hashkeys),
+    hashoperators_(hashoperators),
+    outer_tuple_(outer_tuple) {
+}
+
+bool ExecHashGetHashValueCodegen::GetHashFunctions(
+    std::vector<Oid>* hashfns,
+    std::vector<bool>* strict) const {
+  if (NIL == hashkeys_ ||
+      list_length(hashkeys_) != list_length(hashoperators_)) {
+    return false;
+  }
+
+  ListCell* hk;
+  ListCell* ho;
+  forboth(hk, hashkeys_, ho, hashoperators_) {
+    Oid hashop = lfirst_oid(ho);
+    Oid left_hashfn;
+    Oid right_hashfn;
+    if (!HashKeyGenerator::IsVarKey(
+            reinterpret_cast<ExprState*>(lfirst(hk))) ||
+        !get_op_hash_functions(hashop, &left_hashfn, &right_hashfn)) {
+      return false;
+    }
+    Oid hashfn = outer_tuple_ ? left_hashfn : right_hashfn;
+    if (!HashKeyGenerator::IsHashFuncSupported(hashfn)) {
+      return false;
+    }
+    hashfns->push_back(hashfn);
+    strict->push_back(op_strict(hashop));
+  }
+  return true;
+}
+
+bool ExecHashGetHashValueCodegen::GenerateExecHashGetHashValue(
+    gpcodegen::CodegenUtils* codegen_utils) {
+  assert(NULL != codegen_utils);
+
+  std::vector<Oid> hashfns;
+  std::vector<bool> strict;
+  if (!GetHashFunctions(&hashfns, &strict)) {
+    elog(DEBUG1, "Cannot codegen ExecHashGetHashValue because some hash "
+                 "keys or hash functions are not supported.");
+    return false;
+  }
+
+  llvm::Function* exec_hash_get_hash_value_func =
+      CreateFunction<ExecHashGetHashValueFn>(codegen_utils,
+                                             GetUniqueFuncName());
+  auto irb = codegen_utils->ir_builder();
+
+  llvm::BasicBlock* entry_block = codegen_utils->CreateBasicBlock(
+      "entry", exec_hash_get_hash_value_func);
+  llvm::BasicBlock* hash_block = codegen_utils->CreateBasicBlock(
+      "hash", exec_hash_get_hash_value_func);
+  llvm::BasicBlock* fallback_block = codegen_utils->CreateBasicBlock(
+      "fallback", exec_hash_get_hash_value_func);
+
+  llvm::Value* llvm_econtext =
+      ArgumentByPosition(exec_hash_get_hash_value_func, 2);
+  llvm::Value* llvm_outer_tuple =
+      ArgumentByPosition(exec_hash_get_hash_value_func, 4);
+  llvm::Value* llvm_keep_nulls =
+      ArgumentByPosition(exec_hash_get_hash_value_func, 5);
+  llvm::Value* llvm_hashvalue_ptr =
+      ArgumentByPosition(exec_hash_get_hash_value_func, 6);
+  llvm::Value* llvm_hashkeys_null_ptr =
+      ArgumentByPosition(exec_hash_get_hash_value_func, 7);
+
+  // Entry block
+  // -----------
+  // Fall back if called for the other side of the join.
+  irb->SetInsertPoint(entry_block);
+  irb->CreateCondBr(
+      irb->CreateICmpEQ(llvm_outer_tuple,
+                        codegen_utils->GetConstant<bool>(outer_tuple_)),
+      hash_block /* true */,
+      fallback_block /* false */);
+
+  // Hash block
+  // ----------
+  // As the regular function, rotate the hash value left one bit for every
+  // key and xor in the hash of the key, treating NULLs as hashing to 0. A
+  // NULL key of a strict operator rejects the tuple unless keep_nulls, after
+  // which no more keys are hashed.
+  irb->SetInsertPoint(hash_block);
+  llvm::Value* llvm_hashkey = codegen_utils->GetConstant<uint32>(0);
+  llvm::Value* llvm_result = codegen_utils->GetConstant<bool>(true);
+  llvm::Value* llvm_hashkeys_null = codegen_utils->GetConstant<bool>(true);
+  int i = 0;
+  ListCell* hk;
+  foreach(hk, hashkeys_) {
+    llvm_hashkey = irb->CreateOr(irb->CreateShl(llvm_hashkey, 1),
+                                 irb->CreateLShr(llvm_hashkey, 31));
+
+    llvm::Value* llvm_keyval = nullptr;
+    llvm::Value* llvm_isnull = nullptr;
+    HashKeyGenerator::GenerateVarKey(codegen_utils, llvm_econtext,
+                                     reinterpret_cast<ExprState*>(lfirst(hk)),
+                                     &llvm_keyval, &llvm_isnull);
+    llvm_hashkeys_null = irb->CreateAnd(llvm_hashkeys_null, llvm_isnull);
+
+    if (strict[i]) {
+      llvm_result = irb->CreateAnd(
+          llvm_result,
+          irb->CreateOr(irb->CreateNot(llvm_isnull), llvm_keep_nulls));
+    }
+
+    llvm::Value* llvm_hkey = HashKeyGenerator::GenerateHashFunc(
+        codegen_utils, hashfns[i], llvm_keyval);
+    llvm_hashkey = irb->CreateXor(
+        llvm_hashkey,
+        irb->CreateSelect(
+            irb->CreateAnd(irb->CreateNot(llvm_isnull), llvm_result),
+            llvm_hkey,
+            codegen_utils->GetConstant<uint32>(0)));
+    i++;
+  }
+  irb->CreateStore(llvm_hashkey, llvm_hashvalue_ptr);
+  irb->CreateStore(llvm_hashkeys_null, llvm_hashkeys_null_ptr);
+  irb->CreateRet(llvm_result);
+
+  // Fall back block
+  // ---------------
+  irb->SetInsertPoint(fallback_block);
+  codegen_utils->CreateFallback<ExecHashGetHashValueFn>(
+      codegen_utils->RegisterExternalFunction(GetRegularFuncPointer()),
+      exec_hash_get_hash_value_func);
+  return true;
+}
+
+bool ExecHashGetHashValueCodegen::GetFingerprint(
+    std::string* fingerprint) const {
+  std::vector<Oid> hashfns;
+  std::vector<bool> strict;
+  if (!GetHashFunctions(&hashfns, &strict)) {
+    return false;
+  }
+
+  fingerprint->assign(kExecHashGetHashValueNamePrefix);
+  fingerprint->append(outer_tuple_ ? ":outer" : ":inner");
+  int i = 0;
+  ListCell* hk;
+  foreach(hk, hashkeys_) {
+    HashKeyGenerator::AppendVarKeyFingerprint(
+        reinterpret_cast<ExprState*>(lfirst(hk)), fingerprint);
+    fingerprint->append("/" + std::to_string(hashfns[i]) +
+                        (strict[i] ? "/s" : ""));
+    i++;
+  }
+  return true;
+}
+
+bool ExecHashGetHashValueCodegen::GenerateCodeInternal(
+    CodegenUtils* codegen_utils) {
+  bool isGenerated = GenerateExecHashGetHashValue(codegen_utils);
+
+  if (isGenerated) {
+    elog(DEBUG1, "ExecHashGetHashValue was generated successfully!");
+    return true;
+  } else {
+    elog(DEBUG1, "ExecHashGetHashValue generation failed!");
+    return false;
+  }
+}
@@ -38,6 +38,14 @@
 extern "C" {
 #include "postgres.h"
 #include "utils/elog.h"
+#include "utils/fmgroids.h"
+#include "utils/lsyscache.h"
+#include "catalog/pg_type.h"
+#include "nodes/execnodes.h"
+#include "nodes/nodes.h"
+#include "nodes/pg_list.h"
+#include "nodes/primnodes.h"
+#include "executor/tuptable.h"
 }
 
 using gpcodegen::ExecQualCodegen;
@@ -106,6 +114,541 @@ class ElogWrapper {
 
 };
 
+namespace {
+
+// Comparison implemented by a built-in comparison procedure.
+enum class CmpKind {
+  kEq, kNe, kLt, kLe, kGt, kGe
+};
+
+struct CmpProc {
+  Oid funcoid;
+  CmpKind kind;
+};
+
+// Built-in comparison procedures that we evaluate inline. Each of them is a
+// strict, plain comparison of its two fixed-width, by-value inputs. The input
+// types are validated separately by GetScalarTypeInfo().
+//
+// Note that fmgroids.h names the timestamptz procedures F_TIMESTAMP_xx (their
+// prosrc is timestamp_xx), and has no entry at all for the timestamp without
+// time zone procedures, so we spell out their OIDs.
+const CmpProc kCmpProcs[] = {
+  {F_INT2EQ, CmpKind::kEq}, {F_INT2NE, CmpKind::kNe},
+  {F_INT2LT, CmpKind::kLt}, {F_INT2LE, CmpKind::kLe},
+  {F_INT2GT, CmpKind::kGt}, {F_INT2GE, CmpKind::kGe},
+  {F_INT4EQ, CmpKind::kEq}, {F_INT4NE, CmpKind::kNe},
+  {F_INT4LT, CmpKind::kLt}, {F_INT4LE, CmpKind::kLe},
+  {F_INT4GT, CmpKind::kGt}, {F_INT4GE, CmpKind::kGe},
+  {F_INT8EQ, CmpKind::kEq}, {F_INT8NE, CmpKind::kNe},
+  {F_INT8LT, CmpKind::kLt}, {F_INT8LE, CmpKind::kLe},
+  {F_INT8GT, CmpKind::kGt}, {F_INT8GE, CmpKind::kGe},
+  {F_INT24EQ, CmpKind::kEq}, {F_INT24NE, CmpKind::kNe},
+  {F_INT24LT, CmpKind::kLt}, {F_INT24LE, CmpKind::kLe},
+  {F_INT24GT, CmpKind::kGt}, {F_INT24GE, CmpKind::kGe},
+  {F_INT42EQ, CmpKind::kEq}, {F_INT42NE, CmpKind::kNe},
+  {F_INT42LT, CmpKind::kLt}, {F_INT42LE, CmpKind::kLe},
+  {F_INT42GT, CmpKind::kGt}, {F_INT42GE, CmpKind::kGe},
+  {F_INT28EQ, CmpKind::kEq}, {F_INT28NE, CmpKind::kNe},
+  {F_INT28LT, CmpKind::kLt}, {F_INT28LE, CmpKind::kLe},
+  {F_INT28GT, CmpKind::kGt}, {F_INT28GE, CmpKind::kGe},
+  {F_INT82EQ, CmpKind::kEq}, {F_INT82NE, CmpKind::kNe},
+  {F_INT82LT, CmpKind::kLt}, {F_INT82LE, CmpKind::kLe},
+  {F_INT82GT, CmpKind::kGt}, {F_INT82GE, CmpKind::kGe},
+  {F_INT48EQ, CmpKind::kEq}, {F_INT48NE, CmpKind::kNe},
+  {F_INT48LT, CmpKind::kLt}, {F_INT48LE, CmpKind::kLe},
+  {F_INT48GT, CmpKind::kGt}, {F_INT48GE, CmpKind::kGe},
+  {F_INT84EQ, CmpKind::kEq}, {F_INT84NE, CmpKind::kNe},
+  {F_INT84LT, CmpKind::kLt}, {F_INT84LE, CmpKind::kLe},
+  {F_INT84GT, CmpKind::kGt}, {F_INT84GE, CmpKind::kGe},
+  {F_FLOAT4EQ, CmpKind::kEq}, {F_FLOAT4NE, CmpKind::kNe},
+  {F_FLOAT4LT, CmpKind::kLt}, {F_FLOAT4LE, CmpKind::kLe},
+  {F_FLOAT4GT, CmpKind::kGt}, {F_FLOAT4GE, CmpKind::kGe},
+  {F_FLOAT8EQ, CmpKind::kEq}, {F_FLOAT8NE, CmpKind::kNe},
+  {F_FLOAT8LT, CmpKind::kLt}, {F_FLOAT8LE, CmpKind::kLe},
+  {F_FLOAT8GT, CmpKind::kGt}, {F_FLOAT8GE, CmpKind::kGe},
+  {F_FLOAT48EQ, CmpKind::kEq}, {F_FLOAT48NE, CmpKind::kNe},
+  {F_FLOAT48LT, CmpKind::kLt}, {F_FLOAT48LE, CmpKind::kLe},
+  {F_FLOAT48GT, CmpKind::kGt}, {F_FLOAT48GE, CmpKind::kGe},
+  {F_FLOAT84EQ, CmpKind::kEq}, {F_FLOAT84NE, CmpKind::kNe},
+  {F_FLOAT84LT, CmpKind::kLt}, {F_FLOAT84LE, CmpKind::kLe},
+  {F_FLOAT84GT, CmpKind::kGt}, {F_FLOAT84GE, CmpKind::kGe},
+  {F_DATE_EQ, CmpKind::kEq}, {F_DATE_NE, CmpKind::kNe},
+  {F_DATE_LT, CmpKind::kLt}, {F_DATE_LE, CmpKind::kLe},
+  {F_DATE_GT, CmpKind::kGt}, {F_DATE_GE, CmpKind::kGe},
+  {F_TIMESTAMP_EQ, CmpKind::kEq}, {F_TIMESTAMP_NE, CmpKind::kNe},
+  {F_TIMESTAMP_LT, CmpKind::kLt}, {F_TIMESTAMP_LE, CmpKind::kLe},
+  {F_TIMESTAMP_GT, CmpKind::kGt}, {F_TIMESTAMP_GE, CmpKind::kGe},
+  {2052 /* timestamp_eq */, CmpKind::kEq},
+  {2053 /* timestamp_ne */, CmpKind::kNe},
+  {2054 /* timestamp_lt */, CmpKind::kLt},
+  {2055 /* timestamp_le */, CmpKind::kLe},
+  {2056 /* timestamp_ge */, CmpKind::kGe},
+  {2057 /* timestamp_gt */, CmpKind::kGt},
+};
+
+// Look up the comparison implemented by the given procedure.
+bool GetCmpKind(Oid funcoid, CmpKind* kind) {
+  for (const CmpProc& proc : kCmpProcs) {
+    if (proc.funcoid == funcoid) {
+      *kind = proc.kind;
+      return true;
+    }
+  }
+  return false;
+}
+
+// Comparison to use after swapping the operands of a comparison.
+CmpKind CommuteCmpKind(CmpKind kind) {
+  switch (kind) {
+    case CmpKind::kLt: return CmpKind::kGt;
+    case CmpKind::kLe: return CmpKind::kGe;
+    case CmpKind::kGt: return CmpKind::kLt;
+    case CmpKind::kGe: return CmpKind::kLe;
+    default: return kind;
+  }
+}
+
+// Describes how a by-value Datum of a supported type is laid out.
+struct ScalarTypeInfo {
+  bool is_float;
+  int width;  // in bits
+};
+
+bool GetScalarTypeInfo(Oid type_oid, ScalarTypeInfo* info) {
+  switch (type_oid) {
+    case INT2OID:
+      *info = {false, 16};
+      return true;
+    case INT4OID:
+    case DATEOID:
+      *info = {false, 32};
+      return true;
+    case INT8OID:
+      *info = {false, 64};
+      return true;
+    case TIMESTAMPOID:
+    case TIMESTAMPTZOID:
+#ifdef HAVE_INT64_TIMESTAMP
+      *info = {false, 64};
+#else
+      *info = {true, 64};
+#endif
+      return true;
+    case FLOAT4OID:
+      *info = {true, 32};
+      return true;
+    case FLOAT8OID:
+      *info = {true, 64};
+      return true;
+    default:
+      return false;
+  }
+}
+
+// A Var that we can read directly from the deformed scan tuple.
+bool IsScanVar(Expr* expr) {
+  if (!IsA(expr, Var)) {
+    return false;
+  }
+  Var* var = reinterpret_cast<Var*>(expr);
+  return var->varno != INNER && var->varno != OUTER && var->varattno > 0;
+}
+
+// Decomposed form of "Var op Const", after commuting "Const op Var".
+struct Comparison {
+  Var* var;
+  Const* con;
+  CmpKind kind;
+  ScalarTypeInfo var_type;
+  ScalarTypeInfo const_type;
+};
+
+bool DecomposeComparison(FuncExprState* fstate, Comparison* cmp) {
+  OpExpr* opexpr = reinterpret_cast<OpExpr*>(fstate->xprstate.expr);
+  if (list_length(fstate->args) != 2) {
+    return false;
+  }
+
+  Oid funcoid = opexpr->opfuncid;
+  if (!OidIsValid(funcoid)) {
+    funcoid = get_opcode(opexpr->opno);
+  }
+  if (!GetCmpKind(funcoid, &cmp->kind)) {
+    return false;
+  }
+
+  Expr* left = static_cast<ExprState*>(linitial(fstate->args))->expr;
+  Expr* right = static_cast<ExprState*>(lsecond(fstate->args))->expr;
+  if (IsScanVar(left) && IsA(right, Const)) {
+    cmp->var = reinterpret_cast<Var*>(left);
+    cmp->con = reinterpret_cast<Const*>(right);
+  } else if (IsA(left, Const) && IsScanVar(right)) {
+    cmp->var = reinterpret_cast<Var*>(right);
+    cmp->con = reinterpret_cast<Const*>(left);
+    cmp->kind = CommuteCmpKind(cmp->kind);
+  } else {
+    return false;
+  }
+
+  return GetScalarTypeInfo(cmp->var->vartype, &cmp->var_type) &&
+      GetScalarTypeInfo(cmp->con->consttype, &cmp->const_type) &&
+      cmp->var_type.is_float == cmp->const_type.is_float;
+}
+
+/**
+ * @brief Generates code for the boolean expressions in a qual.
+ *
+ * @note Each supported expression evaluates to a pair of i1 values (value,
+ *       isnull) following the SQL three-valued logic of the regular
+ *       evaluation functions. Since none of the supported expressions can
+ *       fail or have side effects, sub-expressions are evaluated eagerly
+ *       without branches.
+ **/
+class QualExprGenerator {
+ public:
+  explicit QualExprGenerator(gpcodegen::CodegenUtils* codegen_utils) :
+    codegen_utils_(codegen_utils),
+    llvm_values_(nullptr),
+    llvm_isnull_(nullptr) {
+  }
+
+  /**
+   * @brief Check whether code can be generated for the given expression.
+   *
+   * @param exprstate Expression to check.
+   * @param max_attr  Updated with the largest attribute number referenced.
+   * @return true if the expression is supported.
+   **/
+  static bool IsSupported(ExprState* exprstate, AttrNumber* max_attr) {
+    Expr* expr = exprstate->expr;
+    switch (nodeTag(expr)) {
+      case T_OpExpr: {
+        Comparison cmp;
+        if (!DecomposeComparison(
+            reinterpret_cast<FuncExprState*>(exprstate), &cmp)) {
+          return false;
+        }
+        *max_attr = std::max(*max_attr, cmp.var->varattno);
+        return true;
+      }
+      case T_BoolExpr: {
+        ListCell* cell;
+        foreach(cell, reinterpret_cast<BoolExprState*>(exprstate)->args) {
+          if (!IsSupported(static_cast<ExprState*>(lfirst(cell)), max_attr)) {
+            return false;
+          }
+        }
+        return true;
+      }
+      case T_NullTest: {
+        NullTestState* nstate = reinterpret_cast<NullTestState*>(exprstate);
+        if (nstate->argisrow) {
+          return false;
+        }
+        if (IsScanVar(nstate->arg->expr)) {
+          *max_attr = std::max(*max_attr,
+                               reinterpret_cast<Var*>(
+                                   nstate->arg->expr)->varattno);
+          return true;
+        }
+        return IsSupported(nstate->arg, max_attr);
+      }
+      case T_Var: {
+        Var* var = reinterpret_cast<Var*>(expr);
+        if (!IsScanVar(expr) || var->vartype != BOOLOID) {
+          return false;
+        }
+        *max_attr = std::max(*max_attr, var->varattno);
+        return true;
+      }
+      case T_Const:
+        return reinterpret_cast<Const*>(expr)->consttype == BOOLOID;
+      default:
+        return false;
+    }
+  }
+
+  /**
+   * @brief Set the values and isnull arrays of the deformed scan tuple.
+   **/
+  void SetSlotArrays(llvm::Value* llvm_values, llvm::Value* llvm_isnull) {
+    llvm_values_ = llvm_values;
+    llvm_isnull_ = llvm_isnull;
+  }
+
+  /**
+   * @brief Generate code for a supported expression at the current insertion
+   *        point.
+   *
+   * @param exprstate   Expression for which IsSupported() returned true.
+   * @param llvm_value  Set to the i1 result of the expression.
+   * @param llvm_isnull Set to the i1 null flag of the expression.
+   **/
+  void Generate(ExprState* exprstate,
+                llvm::Value** llvm_value,
+                llvm::Value** llvm_isnull) {
+    auto irb = codegen_utils_->ir_builder();
+    Expr* expr = exprstate->expr;
+
+    switch (nodeTag(expr)) {
+      case T_OpExpr:
+        GenerateComparison(reinterpret_cast<FuncExprState*>(exprstate),
+                           llvm_value, llvm_isnull);
+        break;
+      case T_BoolExpr:
+        GenerateBoolExpr(reinterpret_cast<BoolExprState*>(exprstate),
+                         llvm_value, llvm_isnull);
+        break;
+      case T_NullTest: {
+        NullTestState* nstate = reinterpret_cast<NullTestState*>(exprstate);
+        llvm::Value* llvm_arg_value = nullptr;
+        llvm::Value* llvm_arg_isnull = nullptr;
+        if (IsScanVar(nstate->arg->expr)) {
+          GenerateVar(reinterpret_cast<Var*>(nstate->arg->expr),
+                      &llvm_arg_value, &llvm_arg_isnull);
+        } else {
+          Generate(nstate->arg, &llvm_arg_value, &llvm_arg_isnull);
+        }
+        if (reinterpret_cast<NullTest*>(expr)->nulltesttype == IS_NULL) {
+          *llvm_value = llvm_arg_isnull;
+        } else {
+          *llvm_value = irb->CreateNot(llvm_arg_isnull);
+        }
+        *llvm_isnull = codegen_utils_->GetConstant<bool>(false);
+        break;
+      }
+      case T_Var: {
+        llvm::Value* llvm_datum = nullptr;
+        GenerateVar(reinterpret_cast<Var*>(expr), &llvm_datum, llvm_isnull);
+        // DatumGetBool(datum)
+        *llvm_value = irb->CreateICmpNE(
+            llvm_datum, codegen_utils_->GetConstant<Datum>(0));
+        break;
+      }
+      case T_Const: {
+        Const* con = reinterpret_cast<Const*>(expr);
+        *llvm_value = codegen_utils_->GetConstant<bool>(
+            !con->constisnull && DatumGetBool(con->constvalue));
+        *llvm_isnull = codegen_utils_->GetConstant<bool>(con->constisnull);
+        break;
+      }
+      default:
+        assert(false);
+    }
+  }
+
+ private:
+  gpcodegen::CodegenUtils* codegen_utils_;
+  llvm::Value* llvm_values_;  // Datum* of the scan slot
+  llvm::Value* llvm_isnull_;  // bool* of the scan slot
+
+  // Reads an attribute of the deformed scan tuple.
+  void GenerateVar(Var* var,
+                   llvm::Value** llvm_datum,
+                   llvm::Value** llvm_isnull) {
+    assert(nullptr != llvm_values_ && nullptr != llvm_isnull_);
+    auto irb = codegen_utils_->ir_builder();
+    llvm::Value* llvm_idx = codegen_utils_->GetConstant<int>(
+        var->varattno - 1);
+    *llvm_datum = irb->CreateLoad(
+        irb->CreateInBoundsGEP(llvm_values_, {llvm_idx}));
+    *llvm_isnull = irb->CreateLoad(
+        irb->CreateInBoundsGEP(llvm_isnull_, {llvm_idx}));
+  }
+
+  // Converts a by-value Datum into a native integer or floating point value.
+  llvm::Value* DatumToScalar(llvm::Value* llvm_datum,
+                             const ScalarTypeInfo& type) {
+    auto irb = codegen_utils_->ir_builder();
+    if (!type.is_float) {
+      // DatumGetInt16/32/64(datum)
+      return irb->CreateTrunc(
+          llvm_datum, llvm::Type::getIntNTy(irb->getContext(), type.width));
+    }
+    if (type.width == 32) {
+      // DatumGetFloat4(datum)
+      return irb->CreateBitCast(
+          irb->CreateTrunc(llvm_datum, codegen_utils_->GetType<int32>()),
+          codegen_utils_->GetType<float>());
+    }
+    // DatumGetFloat8(datum)
+    return irb->CreateBitCast(llvm_datum, codegen_utils_->GetType<double>());
+  }
+
+  void GenerateComparison(FuncExprState* fstate,
+                          llvm::Value** llvm_value,
+                          llvm::Value** llvm_isnull) {
+    auto irb = codegen_utils_->ir_builder();
+    Comparison cmp;
+    bool is_comparison = DecomposeComparison(fstate, &cmp);
+    assert(is_comparison);
+
+    // All the comparison procedures are strict.
+    llvm::Value* llvm_datum = nullptr;
+    llvm::Value* llvm_var_isnull = nullptr;
+    GenerateVar(cmp.var, &llvm_datum, &llvm_var_isnull);
+    if (cmp.con->constisnull) {
+      *llvm_value = codegen_utils_->GetConstant<bool>(false);
+      *llvm_isnull = codegen_utils_->GetConstant<bool>(true);
+      return;
+    }
+    *llvm_isnull = llvm_var_isnull;
+
+    // IRBuilder folds the conversion of the constant at generation time.
+    llvm::Value* llvm_lhs = DatumToScalar(llvm_datum, cmp.var_type);
+    llvm::Value* llvm_rhs = DatumToScalar(
+        codegen_utils_->GetConstant<Datum>(cmp.con->constvalue),
+        cmp.const_type);
+
+    // Promote both sides to the wider type, as the cross-type procedures do.
+    if (cmp.var_type.width < cmp.const_type.width) {
+      llvm_lhs = cmp.var_type.is_float ?
+          irb->CreateFPExt(llvm_lhs, llvm_rhs->getType()) :
+          irb->CreateSExt(llvm_lhs, llvm_rhs->getType());
+    } else if (cmp.const_type.width < cmp.var_type.width) {
+      llvm_rhs = cmp.var_type.is_float ?
+          irb->CreateFPExt(llvm_rhs, llvm_lhs->getType()) :
+          irb->CreateSExt(llvm_rhs, llvm_lhs->getType());
+    }
+
+    if (cmp.var_type.is_float) {
+      *llvm_value = GenerateFloatComparison(cmp.kind, llvm_lhs, llvm_rhs);
+      return;
+    }
+
+    switch (cmp.kind) {
+      case CmpKind::kEq:
+        *llvm_value = irb->CreateICmpEQ(llvm_lhs, llvm_rhs);
+        break;
+      case CmpKind::kNe:
+        *llvm_value = irb->CreateICmpNE(llvm_lhs, llvm_rhs);
+        break;
+      case CmpKind::kLt:
+        *llvm_value = irb->CreateICmpSLT(llvm_lhs, llvm_rhs);
+        break;
+      case CmpKind::kLe:
+        *llvm_value = irb->CreateICmpSLE(llvm_lhs, llvm_rhs);
+        break;
+      case CmpKind::kGt:
+        *llvm_value = irb->CreateICmpSGT(llvm_lhs, llvm_rhs);
+        break;
+      case CmpKind::kGe:
+        *llvm_value = irb->CreateICmpSGE(llvm_lhs, llvm_rhs);
+        break;
+    }
+  }
+
+  // Floating point comparison following float8_cmp_internal(): NaNs are
+  // equal to each other and greater than any non-NaN value.
+  llvm::Value* GenerateFloatComparison(CmpKind kind,
+                                       llvm::Value* llvm_lhs,
+                                       llvm::Value* llvm_rhs) {
+    auto irb = codegen_utils_->ir_builder();
+    llvm::Value* llvm_lhs_isnan = irb->CreateFCmpUNO(llvm_lhs, llvm_lhs);
+    llvm::Value* llvm_rhs_isnan = irb->CreateFCmpUNO(llvm_rhs, llvm_rhs);
+
+    switch (kind) {
+      case CmpKind::kEq:
+        return irb->CreateOr(irb->CreateFCmpOEQ(llvm_lhs, llvm_rhs),
+                             irb->CreateAnd(llvm_lhs_isnan, llvm_rhs_isnan));
+      case CmpKind::kNe:
+        return irb->CreateNot(
+            irb->CreateOr(irb->CreateFCmpOEQ(llvm_lhs, llvm_rhs),
+                          irb->CreateAnd(llvm_lhs_isnan, llvm_rhs_isnan)));
+      case CmpKind::kLt:
+        return irb->CreateOr(irb->CreateFCmpOLT(llvm_lhs, llvm_rhs),
+                             irb->CreateAnd(irb->CreateNot(llvm_lhs_isnan),
+                                            llvm_rhs_isnan));
+      case CmpKind::kLe:
+        return irb->CreateOr(irb->CreateFCmpOLE(llvm_lhs, llvm_rhs),
+                             llvm_rhs_isnan);
+      case CmpKind::kGt:
+        return irb->CreateOr(irb->CreateFCmpOGT(llvm_lhs, llvm_rhs),
+                             irb->CreateAnd(llvm_lhs_isnan,
+                                            irb->CreateNot(llvm_rhs_isnan)));
+      case CmpKind::kGe:
+        return irb->CreateOr(irb->CreateFCmpOGE(llvm_lhs, llvm_rhs),
+                             llvm_lhs_isnan);
+    }
+    assert(false);
+    return nullptr;
+  }
+
+  // AND is false if any argument is false, else null if any argument is
+  // null. OR is true if any argument is true, else null if any argument is
+  // null. NOT inverts the value and keeps the null flag.
+  void GenerateBoolExpr(BoolExprState* bstate,
+                        llvm::Value** llvm_value,
+                        llvm::Value** llvm_isnull) {
+    auto irb = codegen_utils_->ir_builder();
+    BoolExprType boolop = reinterpret_cast<BoolExpr*>(
+        bstate->xprstate.expr)->boolop;
+
+    if (NOT_EXPR == boolop) {
+      llvm::Value* llvm_arg_value = nullptr;
+      Generate(static_cast<ExprState*>(linitial(bstate->args)),
+               &llvm_arg_value, llvm_isnull);
+      *llvm_value = irb->CreateNot(llvm_arg_value);
+      return;
+    }
+
+    // For AND, 'decided' tracks whether some argument is false; for OR,
+    // whether some argument is true.
+    bool is_and = (AND_EXPR == boolop);
+    llvm::Value* llvm_decided = codegen_utils_->GetConstant<bool>(false);
+    llvm::Value* llvm_any_null = codegen_utils_->GetConstant<bool>(false);
+    ListCell* cell;
+    foreach(cell, bstate->args) {
+      llvm::Value* llvm_arg_value = nullptr;
+      llvm::Value* llvm_arg_isnull = nullptr;
+      Generate(static_cast<ExprState*>(lfirst(cell)),
+               &llvm_arg_value, &llvm_arg_isnull);
+      llvm::Value* llvm_arg_decides = irb->CreateAnd(
+          irb->CreateNot(llvm_arg_isnull),
+          is_and ? irb->CreateNot(llvm_arg_value) : llvm_arg_value);
+      llvm_decided = irb->CreateOr(llvm_decided, llvm_arg_decides);
+      llvm_any_null = irb->CreateOr(llvm_any_null, llvm_arg_isnull);
+    }
+
+    *llvm_isnull = irb->CreateAnd(irb->CreateNot(llvm_decided), llvm_any_null);
+    *llvm_value = is_and ? irb->CreateNot(llvm_decided) : llvm_decided;
+  }
+};
+
+// Returns the number of leading clauses of the qual that we can generate
+// code for, and sets max_attr to the largest attribute number they reference.
+int CountSupportedClauses(List* qual, AttrNumber* max_attr) {
+  int num_supported_clauses = 0;
+  *max_attr = 0;
+  ListCell* cell;
+  foreach(cell, qual) {
+    AttrNumber clause_max_attr = *max_attr;
+    if (!QualExprGenerator::IsSupported(
+        static_cast<ExprState*>(lfirst(cell)), &clause_max_attr)) {
+      break;
+    }
+    *max_attr = clause_max_attr;
+    num_supported_clauses++;
+  }
+  return num_supported_clauses;
+}
+
+// Evaluates the clauses of the qual that follow the first 'skip' ones with
+// the regular ExecQual. The generated code calls this for the unsupported
+// clauses, so that it does not refer to any list of the current query.
+bool ExecQualRemaining(List* qual,
+                       int skip,
+                       ExprContext* econtext,
+                       bool resultForNull) {
+  List remaining = *qual;
+  remaining.length -= skip;
+  remaining.head = list_nth_cell(qual, skip);
+  return ExecQual(&remaining, econtext, resultForNull);
+}
+
+}  // namespace
+
 ExecQualCodegen::ExecQualCodegen
 (
     ExecQualFn regular_func_ptr,
@@ -121,29 +664,187 @@ bool ExecQualCodegen::GenerateExecQual(
 
   assert(NULL != codegen_utils);
 
+  List* qual = planstate_->qual;
+  if (NIL == qual) {
+    elog(DEBUG1, "Cannot codegen ExecQual because qual is empty.");
+    return false;
+  }
+
+  // Find the longest prefix of supported clauses, and the largest attribute
+  // number they reference.
+  AttrNumber max_attr = 0;
+  int num_supported_clauses = CountSupportedClauses(qual, &max_attr);
+
+  if (0 == num_supported_clauses) {
+    elog(DEBUG1,
+         "Cannot codegen ExecQual because first clause is not supported.");
+    return false;
+  }
+
   ElogWrapper elogwrapper(codegen_utils);
+  QualExprGenerator expr_generator(codegen_utils);
 
-  llvm::Function* exec_qual_func = codegen_utils->
-        CreateFunction<ExecQualFn>(
-            GetUniqueFuncName());
+  llvm::Function* exec_qual_func = CreateFunction<ExecQualFn>(
+      codegen_utils, GetUniqueFuncName());
+
+  auto irb = codegen_utils->ir_builder();
 
   // BasicBlock of function entry.
   llvm::BasicBlock* entry_block = codegen_utils->CreateBasicBlock(
       "entry", exec_qual_func);
+  // BasicBlock for checking the length of the qual.
+  llvm::BasicBlock* length_check_block = codegen_utils->CreateBasicBlock(
+      "length_check", exec_qual_func);
+  // BasicBlock for deforming the scan tuple.
+  llvm::BasicBlock* deform_block = codegen_utils->CreateBasicBlock(
+      "deform", exec_qual_func);
+  // BasicBlock for a failed qual.
+  llvm::BasicBlock* return_false_block = codegen_utils->CreateBasicBlock(
+      "return_false", exec_qual_func);
+  // BasicBlock for fall back.
+  llvm::BasicBlock* fallback_block = codegen_utils->CreateBasicBlock(
+      "fallback", exec_qual_func);
 
-  auto irb = codegen_utils->ir_builder();
+  // External functions
+  llvm::Function* llvm_slot_getsomeattrs =
+      codegen_utils->RegisterExternalFunction(slot_getsomeattrs);
+  llvm::Function* llvm_regular_exec_qual =
+      codegen_utils->RegisterExternalFunction(GetRegularFuncPointer());
+  llvm::Function* llvm_exec_qual_remaining =
+      codegen_utils->RegisterExternalFunction(ExecQualRemaining);
+
+  // Function arguments to ExecQual
+  llvm::Value* llvm_qual_arg = ArgumentByPosition(exec_qual_func, 0);
+  llvm::Value* llvm_econtext_arg = ArgumentByPosition(exec_qual_func, 1);
+  llvm::Value* llvm_result_for_null_arg =
+      ArgumentByPosition(exec_qual_func, 2);
 
+  // Entry block
+  // -----------
+  // The generated code does not refer to the qual it was generated from, so
+  // that it can be reused by other executions of the same qual (see
+  // GetFingerprint()). We fall back if we are asked to evaluate a qual that
+  // is empty or of a different length.
   irb->SetInsertPoint(entry_block);
+  irb->CreateCondBr(
+      irb->CreateICmpEQ(llvm_qual_arg, codegen_utils->GetConstant<List*>(NIL)),
+      fallback_block /* true */,
+      length_check_block /* false */);
+
+  // Length check block
+  // ------------------
+  irb->SetInsertPoint(length_check_block);
+  llvm::Value* llvm_qual_length = irb->CreateLoad(
+      codegen_utils->GetPointerToMember(llvm_qual_arg, &List::length));
+  irb->CreateCondBr(
+      irb->CreateICmpEQ(llvm_qual_length,
+                        codegen_utils->GetConstant<int>(list_length(qual))),
+      deform_block /* true */,
+      fallback_block /* false */);
+
+  // Deform block
+  // ------------
+  // slot_getsomeattrs(econtext->ecxt_scantuple, max_attr), so that all the
+  // attributes we need can be read directly from the slot.
+  irb->SetInsertPoint(deform_block);
+  if (max_attr > 0) {
+    llvm::Value* llvm_slot = irb->CreateLoad(
+        codegen_utils->GetPointerToMember(
+            llvm_econtext_arg, &ExprContext::ecxt_scantuple));
+    irb->CreateCall(llvm_slot_getsomeattrs, {
+        llvm_slot,
+        codegen_utils->GetConstant<int>(max_attr)});
+    expr_generator.SetSlotArrays(
+        irb->CreateLoad(codegen_utils->GetPointerToMember(
+            llvm_slot, &TupleTableSlot::PRIVATE_tts_values)),
+        irb->CreateLoad(codegen_utils->GetPointerToMember(
+            llvm_slot, &TupleTableSlot::PRIVATE_tts_isnull)));
+  }
+
+  // Clause blocks
+  // -------------
+  // As in ExecQual, stop at the first clause that is false, or null when
+  // resultForNull is false.
+  int clause_idx = 0;
+  ListCell* cell;
+  foreach(cell, qual) {
+    if (clause_idx == num_supported_clauses) {
+      break;
+    }
+    llvm::Value* llvm_value = nullptr;
+    llvm::Value* llvm_isnull = nullptr;
+    expr_generator.Generate(static_cast<ExprState*>(lfirst(cell)),
+                            &llvm_value, &llvm_isnull);
+
+    llvm::BasicBlock* next_clause_block = codegen_utils->CreateBasicBlock(
+        "clause_" + std::to_string(clause_idx + 1), exec_qual_func);
+    irb->CreateCondBr(
+        irb->CreateSelect(llvm_isnull, llvm_result_for_null_arg, llvm_value),
+        next_clause_block /* true */,
+        return_false_block /* false */);
+    irb->SetInsertPoint(next_clause_block);
+    clause_idx++;
+  }
+
+  // All the supported clauses passed. Hand the rest of the qual, if any, to
+  // the regular ExecQual.
+  if (num_supported_clauses < list_length(qual)) {
+    irb->CreateRet(irb->CreateCall(llvm_exec_qual_remaining, {
+        llvm_qual_arg,
+        codegen_utils->GetConstant<int>(num_supported_clauses),
+        llvm_econtext_arg,
+        llvm_result_for_null_arg}));
+  } else {
+    irb->CreateRet(codegen_utils->GetConstant<bool>(true));
+  }
+
+  // Return false block
+  // ------------------
+  irb->SetInsertPoint(return_false_block);
+  irb->CreateRet(codegen_utils->GetConstant<bool>(false));
+
+  // Fall back block
+  // ---------------
+  irb->SetInsertPoint(fallback_block);
 
   elogwrapper.CreateElog(DEBUG1, "Falling back to regular ExecQual.");
 
-  codegen_utils->CreateFallback<ExecQualFn>(
-      codegen_utils->RegisterExternalFunction(GetRegularFuncPointer()),
-	  exec_qual_func);
+  codegen_utils->CreateFallback<ExecQualFn>(llvm_regular_exec_qual,
+                                            exec_qual_func);
   return true;
 }
 
 
+bool ExecQualCodegen::GetFingerprint(std::string* fingerprint) const {
+  List* qual = planstate_->qual;
+  if (NIL == qual) {
+    return false;
+  }
+  AttrNumber max_attr = 0;
+  int num_supported_clauses = CountSupportedClauses(qual, &max_attr);
+  if (0 == num_supported_clauses) {
+    return false;
+  }
+
+  // The generated code depends on the length of the qual and on the
+  // supported clauses only; the remaining clauses are evaluated by the
+  // regular ExecQual.
+  fingerprint->assign(kExecQualPrefix);
+  fingerprint->append(":" + std::to_string(list_length(qual)));
+  int clause_idx = 0;
+  ListCell* cell;
+  foreach(cell, qual) {
+    if (clause_idx++ == num_supported_clauses) {
+      break;
+    }
+    char* clause_str = nodeToString(static_cast<ExprState*>(lfirst(cell))->expr);
+    fingerprint->append(":");
+    fingerprint->append(clause_str);
+    pfree(clause_str);
+  }
+  return true;
+}
+
 bool ExecQualCodegen::GenerateCodeInternal(CodegenUtils* codegen_utils) {
   bool isGenerated = GenerateExecQual(codegen_utils);
 
@@ -12,6 +12,7 @@
 #include "codegen/exec_variable_list_codegen.h"
 
 #include <algorithm>
+#include <cstddef>
 #include <cstdint>
 #include <string>
 
@@ -150,6 +151,17 @@ bool ExecVariableListCodegen::GenerateExecVariableList(
     }
   }
 
+  // The generated code reads the slot from the expression context, just as
+  // ExecVariableList does, instead of referring to the slot it was generated
+  // for. This way it can be reused by other executions of the same plan (see
+  // GetFingerprint()).
+  if (proj_info_->pi_varSlotOffsets[0] !=
+      offsetof(ExprContext, ecxt_scantuple)) {
+    elog(DEBUG1,
+        "Cannot codegen ExecVariableList because slot is not the scan tuple.");
+    return false;
+  }
+
   // Find the largest attribute index in projInfo->pi_targetlist
   int max_attr = *std::max_element(
       proj_info_->pi_varNumbers,
@@ -199,7 +211,6 @@ bool ExecVariableListCodegen::GenerateExecVariableList(
 
   // Generation-time constants
   llvm::Value* llvm_max_attr = codegen_utils->GetConstant(max_attr);
-  llvm::Value* llvm_slot = codegen_utils->GetConstant(slot_);
 
   // Function arguments to ExecVariableList
   llvm::Value* llvm_projInfo_arg = ArgumentByPosition(exec_variable_list_func, 0);
@@ -221,20 +232,24 @@ bool ExecVariableListCodegen::GenerateExecVariableList(
   llvm::Value* llvm_econtext =
       irb->CreateLoad(codegen_utils->GetPointerToMember(
           llvm_projInfo_arg, &ProjectionInfo::pi_exprContext));
-  llvm::Value* llvm_varSlotOffsets =
-      irb->CreateLoad(codegen_utils->GetPointerToMember(
-          llvm_projInfo_arg, &ProjectionInfo::pi_varSlotOffsets));
 
-  // We want to fall back when ExecVariableList is called with a slot that's
-  // different from the one we generated the function (eg HashJoin). We also
-  // assume only 1 slot and that the slot is in a scan node ie from
-  // exprContext->ecxt_scantuple or varOffset = 0
-  llvm::Value* llvm_slot_arg =
+  // We assume only 1 slot and that the slot is in a scan node ie from
+  // exprContext->ecxt_scantuple. We want to fall back when the slot does
+  // not have the tuple descriptor layout we generated the function for.
+  llvm::Value* llvm_slot =
       irb->CreateLoad(codegen_utils->GetPointerToMember(
           llvm_econtext, &ExprContext::ecxt_scantuple));
+  llvm::Value* llvm_slot_tupdesc =
+      irb->CreateLoad(codegen_utils->GetPointerToMember(
+          llvm_slot, &TupleTableSlot::tts_tupleDescriptor));
+  llvm::Value* llvm_slot_natts =
+      irb->CreateLoad(codegen_utils->GetPointerToMember(
+          llvm_slot_tupdesc, &tupleDesc::natts));
 
   irb->CreateCondBr(
-      irb->CreateICmpEQ(llvm_slot, llvm_slot_arg),
+      irb->CreateICmpEQ(llvm_slot_natts,
+                        codegen_utils->GetConstant<int>(
+                            slot_->tts_tupleDescriptor->natts)),
       tuple_type_check_block /* true */,
       fallback_block /* false */);
 
@@ -654,6 +669,35 @@ bool ExecVariableListCodegen::GenerateExecVariableList(
 }
 
 
+bool ExecVariableListCodegen::GetFingerprint(std::string* fingerprint) const {
+  if (NULL == proj_info_->pi_varSlotOffsets) {
+    return false;
+  }
+
+  // Everything that GenerateExecVariableList() decides on: the slot and
+  // attribute of each target, and the layout of the tuple descriptor.
+  TupleDesc tupleDesc = slot_->tts_tupleDescriptor;
+  fingerprint->assign(kExecVariableListPrefix);
+  fingerprint->append(":" + std::to_string(tupleDesc->natts));
+  int max_attr = 0;
+  for (int i = 0; i < list_length(proj_info_->pi_targetlist); i++) {
+    fingerprint->append(
+        ":" + std::to_string(proj_info_->pi_varSlotOffsets[i]) +
+        "/" + std::to_string(proj_info_->pi_varNumbers[i]));
+    max_attr = std::max(max_attr, proj_info_->pi_varNumbers[i]);
+  }
+  for (int attnum = 0; attnum < std::min(max_attr, tupleDesc->natts);
+      ++attnum) {
+    Form_pg_attribute thisatt = tupleDesc->attrs[attnum];
+    fingerprint->append(
+        ":" + std::to_string(thisatt->attlen) +
+        "/" + std::string(1, thisatt->attalign) +
+        "/" + std::to_string(thisatt->attbyval) +
+        "/" + std::to_string(thisatt->attnotnull));
+  }
+  return true;
+}
+
 bool ExecVariableListCodegen::GenerateCodeInternal(
     CodegenUtils* codegen_utils) {
   bool isGenerated = GenerateExecVariableList(codegen_utils);
@@ -0,0 +1,231 @@
+//---------------------------------------------------------------------------
+//  Greenplum Database
+//  Copyright (C) 2016 Pivotal Software, Inc.
+//
+//  @filename:
+//    hash_key_generator.cc
+//
+//  @doc:
+//    Generation of hash key evaluation shared by the hash codegens.
+//
+//---------------------------------------------------------------------------
+#include <cstdint>
+#include <string>
+
+#include "codegen/hash_key_generator.h"
+#include "codegen/utils/codegen_utils.h"
+
+#include "llvm/IR/Constant.h"
+#include "llvm/IR/Type.h"
+#include "llvm/IR/Value.h"
+
+extern "C" {
+#include "postgres.h"
+#include "catalog/pg_type.h"
+#include "nodes/execnodes.h"
+#include "nodes/primnodes.h"
+#include "executor/tuptable.h"
+#include "utils/fmgroids.h"
+}
+
+using gpcodegen::HashKeyGenerator;
+
+namespace {
+
+// FNV-1 offset basis and prime, as in cdbhash.c
+constexpr uint32_t kFNV32Init = 0x811c9dc5;
+constexpr uint32_t kFNV32Prime = 0x01000193;
+
+// The value cdbhashnull() hashes for a NULL
+constexpr uint32_t kCdbHashNullValue = 0xF0F0F0F1;
+
+// The ExprContext slot a Var reads from, as ExecEvalVar()
+TupleTableSlot* ExprContext::* VarSlot(Var* variable) {
+  switch (variable->varno) {
+    case INNER:
+      return &ExprContext::ecxt_innertuple;
+    case OUTER:
+      return &ExprContext::ecxt_outertuple;
+    default:
+      return &ExprContext::ecxt_scantuple;
+  }
+}
+
+}  // namespace
+
+bool HashKeyGenerator::IsVarKey(ExprState* keyexpr) {
+  return nullptr != keyexpr->expr &&
+      IsA(keyexpr->expr, Var) &&
+      reinterpret_cast<Var*>(keyexpr->expr)->varattno > 0;
+}
+
+void HashKeyGenerator::AppendVarKeyFingerprint(ExprState* keyexpr,
+                                               std::string* fingerprint) {
+  Var* variable = reinterpret_cast<Var*>(keyexpr->expr);
+  int varno = (INNER == variable->varno || OUTER == variable->varno) ?
+      variable->varno : 0;
+  fingerprint->append(":" + std::to_string(varno) +
+                      "/" + std::to_string(variable->varattno));
+}
+
+void HashKeyGenerator::GenerateVarKey(gpcodegen::CodegenUtils* codegen_utils,
+                                      llvm::Value* llvm_econtext,
+                                      ExprState* keyexpr,
+                                      llvm::Value** value,
+                                      llvm::Value** isnull) {
+  assert(IsVarKey(keyexpr));
+  auto irb = codegen_utils->ir_builder();
+  Var* variable = reinterpret_cast<Var*>(keyexpr->expr);
+
+  llvm::Value* llvm_slot = irb->CreateLoad(
+      codegen_utils->GetPointerToMember(llvm_econtext, VarSlot(variable)));
+  irb->CreateCall(codegen_utils->RegisterExternalFunction(slot_getsomeattrs), {
+      llvm_slot,
+      codegen_utils->GetConstant<int>(variable->varattno)});
+
+  llvm::Value* llvm_attidx =
+      codegen_utils->GetConstant<int>(variable->varattno - 1);
+  *value = irb->CreateLoad(irb->CreateInBoundsGEP(
+      irb->CreateLoad(codegen_utils->GetPointerToMember(
+          llvm_slot, &TupleTableSlot::PRIVATE_tts_values)),
+      {llvm_attidx}));
+  *isnull = irb->CreateLoad(irb->CreateInBoundsGEP(
+      irb->CreateLoad(codegen_utils->GetPointerToMember(
+          llvm_slot, &TupleTableSlot::PRIVATE_tts_isnull)),
+      {llvm_attidx}));
+}
+
+bool HashKeyGenerator::IsHashFuncSupported(Oid hashfn_oid) {
+  switch (hashfn_oid) {
+    case F_HASHINT2:
+    case F_HASHINT4:
+    case F_HASHINT8:
+    case F_HASHOID:
+      return true;
+    default:
+      return false;
+  }
+}
+
+llvm::Value* HashKeyGenerator::GenerateHashFunc(
+    gpcodegen::CodegenUtils* codegen_utils,
+    Oid hashfn_oid,
+    llvm::Value* llvm_datum) {
+  auto irb = codegen_utils->ir_builder();
+  switch (hashfn_oid) {
+    case F_HASHINT2:
+      // ~((uint32) PG_GETARG_INT16(0))
+      return irb->CreateNot(irb->CreateSExt(
+          irb->CreateTrunc(llvm_datum, codegen_utils->GetType<int16>()),
+          codegen_utils->GetType<uint32>()));
+    case F_HASHINT4:
+    case F_HASHOID:
+      // ~PG_GETARG_UINT32(0)
+      return irb->CreateNot(
+          irb->CreateTrunc(llvm_datum, codegen_utils->GetType<uint32>()));
+    case F_HASHINT8: {
+      // Fold the high half into the low half, complemented for negative
+      // values, so that the hash is compatible with hashint4
+      llvm::Value* llvm_lohalf =
+          irb->CreateTrunc(llvm_datum, codegen_utils->GetType<uint32>());
+      llvm::Value* llvm_hihalf = irb->CreateTrunc(
+          irb->CreateLShr(llvm_datum, 32), codegen_utils->GetType<uint32>());
+      llvm::Value* llvm_is_negative = irb->CreateICmpSLT(
+          llvm_datum, codegen_utils->GetConstant<int64>(0));
+      llvm_lohalf = irb->CreateXor(
+          llvm_lohalf,
+          irb->CreateSelect(llvm_is_negative,
+                            irb->CreateNot(llvm_hihalf), llvm_hihalf));
+      return irb->CreateNot(llvm_lohalf);
+    }
+    default:
+      assert(false);
+      return nullptr;
+  }
+}
+
+bool HashKeyGenerator::IsCdbHashTypeSupported(Oid typeoid) {
+  switch (typeoid) {
+    case INT2OID:
+    case INT4OID:
+    case INT8OID:
+    case DATEOID:
+      return true;
+    default:
+      return false;
+  }
+}
+
+llvm::Value* HashKeyGenerator::GenerateCdbHashInit(
+    gpcodegen::CodegenUtils* codegen_utils) {
+  return codegen_utils->GetConstant<uint32>(kFNV32Init);
+}
+
+llvm::Value* HashKeyGenerator::GenerateCdbHash(
+    gpcodegen::CodegenUtils* codegen_utils,
+    Oid typeoid,
+    llvm::Value* llvm_hash,
+    llvm::Value* llvm_datum) {
+  auto irb = codegen_utils->ir_builder();
+  switch (typeoid) {
+    case INT2OID:
+      // Integers are hashed as int64
+      return GenerateFNV1(
+          codegen_utils, llvm_hash,
+          irb->CreateSExt(
+              irb->CreateTrunc(llvm_datum, codegen_utils->GetType<int16>()),
+              codegen_utils->GetType<int64>()),
+          sizeof(int64));
+    case INT4OID:
+      return GenerateFNV1(
+          codegen_utils, llvm_hash,
+          irb->CreateSExt(
+              irb->CreateTrunc(llvm_datum, codegen_utils->GetType<int32>()),
+              codegen_utils->GetType<int64>()),
+          sizeof(int64));
+    case INT8OID:
+      return GenerateFNV1(codegen_utils, llvm_hash, llvm_datum,
+                          sizeof(int64));
+    case DATEOID:
+      // DateADT is an int32
+      return GenerateFNV1(
+          codegen_utils, llvm_hash,
+          irb->CreateTrunc(llvm_datum, codegen_utils->GetType<int32>()),
+          sizeof(int32));
+    default:
+      assert(false);
+      return nullptr;
+  }
+}
+
+llvm::Value* HashKeyGenerator::GenerateCdbHashNull(
+    gpcodegen::CodegenUtils* codegen_utils,
+    llvm::Value* llvm_hash) {
+  return GenerateFNV1(codegen_utils, llvm_hash,
+                      codegen_utils->GetConstant<uint32>(kCdbHashNullValue),
+                      sizeof(uint32));
+}
+
+llvm::Value* HashKeyGenerator::GenerateFNV1(
+    gpcodegen::CodegenUtils* codegen_utils,
+    llvm::Value* llvm_hash,
+    llvm::Value* llvm_value,
+    int len) {
+  auto irb = codegen_utils->ir_builder();
+  for (int i = 0; i < len; ++i) {
+#ifdef WORDS_BIGENDIAN
+    int shift = 8 * (len - 1 - i);
+#else
+    int shift = 8 * i;
+#endif
+    llvm::Value* llvm_octet = irb->CreateZExt(
+        irb->CreateTrunc(irb->CreateLShr(llvm_value, shift),
+                         codegen_utils->GetType<uint8>()),
+        codegen_utils->GetType<uint32>());
+    llvm_hash = irb->CreateXor(
+        irb->CreateMul(llvm_hash,
+                       codegen_utils->GetConstant<uint32>(kFNV32Prime)),
+        llvm_octet);
+  }
+  return llvm_hash;
+}
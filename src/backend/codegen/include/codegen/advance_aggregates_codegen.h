@@ -0,0 +1,128 @@
+//---------------------------------------------------------------------------
+//  Greenplum Database
+//  Copyright (C) 2016 Pivotal Software, Inc.
+//
+//  @filename:
+//    advance_aggregates_codegen.h
+//
+//  @doc:
+//    Headers for advance_aggregates codegen.
+//
+//---------------------------------------------------------------------------
+
+#ifndef GPCODEGEN_ADVANCE_AGGREGATES_CODEGEN_H_  // NOLINT(build/header_guard)
+#define GPCODEGEN_ADVANCE_AGGREGATES_CODEGEN_H_
+
+#include <string>
+
+#include "codegen/codegen_wrapper.h"
+#include "codegen/base_codegen.h"
+
+namespace llvm {
+class Value;
+}  // namespace llvm
+
+namespace gpcodegen {
+
+/** \addtogroup gpcodegen
+ *  @{
+ */
+
+class AdvanceAggregatesCodegen: public BaseCodegen<AdvanceAggregatesFn> {
+ public:
+  /**
+   * @brief Constructor
+   *
+   * @param regular_func_ptr       Regular version of the target function.
+   * @param ptr_to_chosen_func_ptr Reference to the function pointer that the caller will call.
+   * @param aggstate               The Agg node to generate code for.
+   *
+   * @note 	The ptr_to_chosen_func_ptr can refer to either the generated function or the
+   * 			corresponding regular version.
+   *
+   **/
+  explicit AdvanceAggregatesCodegen(
+      AdvanceAggregatesFn regular_func_ptr,
+      AdvanceAggregatesFn* ptr_to_regular_func_ptr,
+      AggState* aggstate);
+
+  virtual ~AdvanceAggregatesCodegen() = default;
+
+ protected:
+  /**
+   * @brief Generate code for advance_aggregates.
+   *
+   * @param codegen_utils
+   *
+   * @return true on successful generation; false otherwise.
+   *
+   * @note The loop over the aggregates of the Agg node is unrolled. The
+   * transition step is inlined for aggregates that
+   *  (1) have no DISTINCT or ORDER BY,
+   *  (2) take no argument, or a single Var of one of the input slots, and
+   *  (3) use one of the following by-value transition functions:
+   *      int8inc and int8inc_any (count), int4_sum, int8pl and float8pl
+   *      (sum, and the combining step of two-stage count and sum), and
+   *      int4larger, int4smaller, int8larger, int8smaller, float8larger and
+   *      float8smaller (min and max). All of them are strict but int4_sum,
+   *      which handles NULLs the way a strict function would.
+   *
+   * For those, the argument is read from the deformed input slot and
+   * combined with the transition value without going through fmgr. Null
+   * inputs are skipped, and a NULL transition value is kept, as for strict
+   * transition functions. The first input of a group, overflow, and all
+   * other aggregates go through the regular advance_aggregate for the
+   * aggregate. No code is generated if no aggregate can be inlined.
+   *
+   * At execution time, we fall back to the regular advance_aggregates when
+   * the Agg node has a different number of aggregates.
+   */
+  bool GenerateCodeInternal(gpcodegen::CodegenUtils* codegen_utils) final;
+
+  /**
+   * @note The fingerprint consists of the transition function and input
+   * attribute of every inlined aggregate, and the positions of the others.
+   */
+  bool GetFingerprint(std::string* fingerprint) const final;
+
+ private:
+  AggState* aggstate_;
+
+  static constexpr char kAdvanceAggregatesNamePrefix[] = "advance_aggregates";
+
+  /**
+   * @return true if the transition step of aggregate 'aggno' is inlined.
+   **/
+  bool IsInlined(int aggno) const;
+
+  /**
+   * @brief Generates runtime code that implements advance_aggregates.
+   *
+   * @param codegen_utils Utility to ease the code generation process.
+   * @return true on successful generation.
+   **/
+  bool GenerateAdvanceAggregates(gpcodegen::CodegenUtils* codegen_utils);
+
+  /**
+   * @brief Generates the transition step of an inlined aggregate.
+   *
+   * @param codegen_utils Utility to ease the code generation process.
+   * @param aggno         The aggregate.
+   * @param trans_value   The current, non-NULL transition value.
+   * @param arg           The non-NULL input value, or nullptr if the
+   *                      aggregate takes no argument.
+   * @param overflow      Set to an i1 that is true if the regular transition
+   *                      function must be used instead.
+   * @return The new transition value.
+   **/
+  llvm::Value* GenerateTransition(gpcodegen::CodegenUtils* codegen_utils,
+                                  int aggno,
+                                  llvm::Value* trans_value,
+                                  llvm::Value* arg,
+                                  llvm::Value** overflow);
+};
+
+/** @} */
+
+}  // namespace gpcodegen
+#endif  // GPCODEGEN_ADVANCE_AGGREGATES_CODEGEN_H_
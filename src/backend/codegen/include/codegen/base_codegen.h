@@ -12,11 +12,13 @@
 #ifndef GPCODEGEN_BASE_CODEGEN_H_  // NOLINT(build/header_guard)
 #define GPCODEGEN_BASE_CODEGEN_H_
 
+#include <cstddef>
 #include <string>
 #include <vector>
 #include "codegen/utils/codegen_utils.h"
 #include "codegen/codegen_interface.h"
 
+#include "llvm/IR/BasicBlock.h"
 #include "llvm/IR/Function.h"
 
 namespace gpcodegen {
@@ -43,8 +45,24 @@ class BaseCodegen: public CodegenInterface {
     SetToRegular(regular_func_ptr_, ptr_to_chosen_func_ptr_);
   }
 
-  bool GenerateCode(gpcodegen::CodegenUtils* codegen_utils) final {
+  bool GenerateCode(gpcodegen::CodegenUtils* codegen_utils,
+                    std::size_t* instruction_budget) final {
+    assert(nullptr != instruction_budget);
     is_generated_ = GenerateCodeInternal(codegen_utils);
+    if (is_generated_) {
+      std::size_t instruction_count = 0;
+      for (llvm::Function* function : uncompiled_generated_functions_) {
+        for (const llvm::BasicBlock& block : *function) {
+          instruction_count += block.size();
+        }
+      }
+      // Compiling more code would cost more than the query can gain
+      if (instruction_count > *instruction_budget) {
+        is_generated_ = false;
+      } else {
+        *instruction_budget -= instruction_count;
+      }
+    }
     if (!is_generated_) {
       // If failed to generate, make sure we do clean up
       // by erasing all the llvm functions.
@@ -70,16 +88,34 @@ class BaseCodegen: public CodegenInterface {
       return false;
     }
 
+    return SetToCompiledFunction(codegen_utils, GetUniqueFuncName());
+  }
+
+  bool SetToCompiledFunction(gpcodegen::CodegenUtils* codegen_utils,
+                             const std::string& func_name) final {
     FuncPtrType compiled_func_ptr = codegen_utils->GetFunctionPointer<
-        FuncPtrType>(GetUniqueFuncName());
+        FuncPtrType>(func_name);
 
     if (nullptr != compiled_func_ptr) {
-      *ptr_to_chosen_func_ptr_ = compiled_func_ptr;
+      // The function may be swapped in by a background compilation while
+      // the executor is calling through the pointer, so store it atomically,
+      // to pair with the load of call_* in codegen_wrapper.h.
+      __atomic_store_n(ptr_to_chosen_func_ptr_, compiled_func_ptr,
+                       __ATOMIC_RELEASE);
       return true;
     }
     return false;
   }
 
+  /**
+   * @note By default generated code is not shared between generators.
+   *       Derived classes whose generated code only depends on the
+   *       fingerprinted inputs override this.
+   **/
+  bool GetFingerprint(std::string* fingerprint) const override {
+    return false;
+  }
+
   void Reset() final {
     SetToRegular();
   }
@@ -117,7 +153,8 @@ class BaseCodegen: public CodegenInterface {
                            FuncPtrType* ptr_to_chosen_func_ptr) {
     assert(nullptr != ptr_to_chosen_func_ptr);
     assert(nullptr != regular_func_ptr);
-    *ptr_to_chosen_func_ptr = regular_func_ptr;
+    __atomic_store_n(ptr_to_chosen_func_ptr, regular_func_ptr,
+                     __ATOMIC_RELEASE);
     return true;
   }
 
@@ -0,0 +1,93 @@
+//---------------------------------------------------------------------------
+//  Greenplum Database
+//  Copyright (C) 2016 Pivotal Software, Inc.
+//
+//  @filename:
+//    calc_hash_value_codegen.h
+//
+//  @doc:
+//    Headers for calc_hash_value codegen.
+//
+//---------------------------------------------------------------------------
+
+#ifndef GPCODEGEN_CALC_HASH_VALUE_CODEGEN_H_  // NOLINT(build/header_guard)
+#define GPCODEGEN_CALC_HASH_VALUE_CODEGEN_H_
+
+#include <string>
+
+#include "codegen/codegen_wrapper.h"
+#include "codegen/base_codegen.h"
+
+namespace gpcodegen {
+
+/** \addtogroup gpcodegen
+ *  @{
+ */
+
+class CalcHashValueCodegen: public BaseCodegen<CalcHashValueFn> {
+ public:
+  /**
+   * @brief Constructor
+   *
+   * @param regular_func_ptr       Regular version of the target function.
+   * @param ptr_to_chosen_func_ptr Reference to the function pointer that the caller will call.
+   * @param aggstate               The hashed Agg node to generate code for.
+   *
+   * @note 	The ptr_to_chosen_func_ptr can refer to either the generated function or the
+   * 			corresponding regular version.
+   *
+   **/
+  explicit CalcHashValueCodegen(CalcHashValueFn regular_func_ptr,
+                                CalcHashValueFn* ptr_to_regular_func_ptr,
+                                AggState* aggstate);
+
+  virtual ~CalcHashValueCodegen() = default;
+
+ protected:
+  /**
+   * @brief Generate code for calc_hash_value.
+   *
+   * @param codegen_utils
+   *
+   * @return true on successful generation; false otherwise.
+   *
+   * @note Code is only generated when the hash function of every grouping
+   * column is one of hashint2, hashint4, hashint8 or hashoid. The grouping
+   * columns are read directly from the deformed input slot, and their hash
+   * functions are inlined. The per-column hash values are combined with
+   * hash_any(), as in the regular function.
+   *
+   * At execution time, we fall back to the regular calc_hash_value when the
+   * Agg node has a different number of grouping columns.
+   */
+  bool GenerateCodeInternal(gpcodegen::CodegenUtils* codegen_utils) final;
+
+  /**
+   * @note The fingerprint consists of the attribute number and hash function
+   * of every grouping column.
+   */
+  bool GetFingerprint(std::string* fingerprint) const final;
+
+ private:
+  AggState* aggstate_;
+
+  static constexpr char kCalcHashValueNamePrefix[] = "calc_hash_value";
+
+  /**
+   * @return true if the hash functions of all grouping columns are supported.
+   **/
+  bool IsSupported() const;
+
+  /**
+   * @brief Generates runtime code that implements calc_hash_value.
+   *
+   * @param codegen_utils Utility to ease the code generation process.
+   * @return true on successful generation.
+   **/
+  bool GenerateCalcHashValue(gpcodegen::CodegenUtils* codegen_utils);
+};
+
+/** @} */
+
+}  // namespace gpcodegen
+#endif  // GPCODEGEN_CALC_HASH_VALUE_CODEGEN_H_
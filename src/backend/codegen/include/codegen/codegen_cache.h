@@ -0,0 +1,145 @@
+//---------------------------------------------------------------------------
+//  Greenplum Database
+//  Copyright (C) 2016 Pivotal Software, Inc.
+//
+//  @filename:
+//    codegen_cache.h
+//
+//  @doc:
+//    Per-backend cache of compiled generated functions
+//
+//---------------------------------------------------------------------------
+
+#ifndef GPCODEGEN_CODEGEN_CACHE_H_  // NOLINT(build/header_guard)
+#define GPCODEGEN_CODEGEN_CACHE_H_
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include "codegen/utils/macros.h"
+
+namespace gpcodegen {
+/** \addtogroup gpcodegen
+ *  @{
+ */
+
+// Forward declaration of CodegenUtils that owns the compiled module
+class CodegenUtils;
+
+/**
+ * @brief Cache of compiled generated functions, keyed by the fingerprint of
+ *        the code generator that produced them.
+ *
+ * @note  Entries keep the compiled module that contains their function
+ *        alive, so that the function remains callable after the
+ *        CodegenManager that generated it is destroyed. A module is released
+ *        once the last entry that refers to it is evicted and no manager
+ *        uses it any more. Entries are evicted in least recently used order
+ *        once the number of entries exceeds the capacity.
+ *
+ * @note  Functions compiled in the background are inserted from the
+ *        compilation thread, so all methods are serialized by a mutex.
+ **/
+class CodegenCache {
+ public:
+  /**
+   * @brief A compiled function in the cache.
+   **/
+  struct Entry {
+    // Compiled module that contains the function.
+    std::shared_ptr<CodegenUtils> codegen_utils;
+    // Name of the function in the module.
+    std::string func_name;
+  };
+
+  /**
+   * @brief Hit, miss and eviction counters of the cache.
+   **/
+  struct Stats {
+    std::uint64_t hits;
+    std::uint64_t misses;
+    std::uint64_t evictions;
+    std::uint64_t entries;
+  };
+
+  /**
+   * @return The cache of the current backend.
+   **/
+  static CodegenCache* GetInstance();
+
+  /**
+   * @brief Look up a compiled function, and mark it as most recently used.
+   *
+   * @param fingerprint Fingerprint of the requesting code generator.
+   * @param entry       Set to the cached function on a hit.
+   * @return true on a hit.
+   **/
+  bool Lookup(const std::string& fingerprint, Entry* entry);
+
+  /**
+   * @brief Add a compiled function to the cache, evicting the least recently
+   *        used entries if the cache is full.
+   *
+   * @param fingerprint Fingerprint of the code generator that generated the
+   *                    function.
+   * @param entry       The compiled function.
+   **/
+  void Insert(const std::string& fingerprint, const Entry& entry);
+
+  /**
+   * @brief Set the maximum number of cached functions. A capacity of zero
+   *        disables the cache and releases all entries.
+   **/
+  void SetCapacity(std::size_t capacity);
+
+  /**
+   * @return true if functions are cached at all.
+   **/
+  bool IsEnabled() const {
+    std::lock_guard<std::mutex> guard(mutex_);
+    return capacity_ > 0;
+  }
+
+  /**
+   * @brief Release all the cached functions.
+   **/
+  void Clear();
+
+  /**
+   * @return Current hit, miss and eviction counters.
+   **/
+  Stats GetStats() const;
+
+ private:
+  typedef std::pair<std::string, Entry> LruItem;
+
+  CodegenCache();
+
+  // Evict least recently used entries until at most 'capacity' remain.
+  // Must be called with mutex_ held.
+  void EvictTo(std::size_t capacity);
+
+  mutable std::mutex mutex_;
+
+  std::size_t capacity_;
+
+  // Most recently used entries are at the front.
+  std::list<LruItem> lru_list_;
+  std::unordered_map<std::string, std::list<LruItem>::iterator> index_;
+
+  std::uint64_t hits_;
+  std::uint64_t misses_;
+  std::uint64_t evictions_;
+
+  DISALLOW_COPY_AND_ASSIGN(CodegenCache);
+};
+
+/** @} */
+
+}  // namespace gpcodegen
+#endif  // GPCODEGEN_CODEGEN_CACHE_H_
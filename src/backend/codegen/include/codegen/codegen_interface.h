@@ -12,6 +12,7 @@
 #ifndef GPCODEGEN_CODEGEN_INTERFACE_H_  // NOLINT(build/header_guard)
 #define GPCODEGEN_CODEGEN_INTERFACE_H_
 
+#include <cstddef>
 #include <string>
 #include <vector>
 
@@ -37,9 +38,14 @@ class CodegenInterface {
    *
    *
    * @param codegen_utils Utility to ease the code generation process.
+   * @param instruction_budget Number of LLVM IR instructions the generated
+   *        code may add to the module. Generation fails if the code would
+   *        exceed it, otherwise the budget is reduced by the instructions
+   *        generated.
    * @return true on successful generation.
    **/
-  virtual bool GenerateCode(gpcodegen::CodegenUtils* codegen_utils) = 0;
+  virtual bool GenerateCode(gpcodegen::CodegenUtils* codegen_utils,
+                            std::size_t* instruction_budget) = 0;
 
   /**
    * @brief Sets up the caller to use the corresponding regular version of the
@@ -60,6 +66,33 @@ class CodegenInterface {
    **/
   virtual bool SetToGenerated(gpcodegen::CodegenUtils* codegen_utils) = 0;
 
+  /**
+   * @brief Sets up the caller to use an already compiled function, e.g. one
+   *        that was generated by an earlier generator with the same
+   *        fingerprint.
+   *
+   * @param codegen_utils Compiled module that contains the function.
+   * @param func_name     Name of the function in that module.
+   * @return true on successfully setting to the compiled function
+   **/
+  virtual bool SetToCompiledFunction(gpcodegen::CodegenUtils* codegen_utils,
+                                     const std::string& func_name) = 0;
+
+  /**
+   * @brief Computes a structural fingerprint of the generator inputs.
+   *
+   * @note  Two generators with equal fingerprints must generate functions
+   *        that behave identically, so that a function compiled for one can
+   *        be reused by the other. The generated code must therefore not
+   *        depend on anything that is not captured in the fingerprint, such
+   *        as addresses of per-query data structures.
+   *
+   * @param fingerprint Set to the fingerprint on success.
+   * @return true if the generated function can be shared through the code
+   *         cache; false otherwise.
+   **/
+  virtual bool GetFingerprint(std::string* fingerprint) const = 0;
+
   /**
    * @brief Resets the state of the generator, including reverting back to
    *        the regular version of the function.
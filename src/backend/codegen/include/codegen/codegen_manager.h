@@ -13,11 +13,14 @@
 #ifndef GPCODEGEN_CODEGEN_MANAGER_H_  // NOLINT(build/header_guard)
 #define GPCODEGEN_CODEGEN_MANAGER_H_
 
+#include <cstddef>
 #include <memory>
 #include <vector>
 #include <string>
+#include <utility>
 
 #include "codegen/utils/macros.h"
+#include "codegen/codegen_cache.h"
 #include "codegen/codegen_wrapper.h"
 
 namespace gpcodegen {
@@ -44,7 +47,13 @@ class CodegenManager {
    **/
   explicit CodegenManager(const std::string& module_name);
 
-  ~CodegenManager() = default;
+  /**
+   * @brief Destructor.
+   *
+   * @note  A background compilation that is still running is cancelled, so
+   *        that it never touches the destroyed generators.
+   **/
+  ~CodegenManager();
 
   /**
    * @brief Enroll a code generator with manager
@@ -59,10 +68,26 @@ class CodegenManager {
   bool EnrollCodeGenerator(CodegenFuncLifespan funcLifespan,
                            CodegenInterface* generator);
 
+  /**
+   * @brief Limit the number of LLVM IR instructions that GenerateCode() may
+   *        add to the module. Generators whose code does not fit any more
+   *        keep using the regular function.
+   *
+   * @param instruction_limit Maximum number of instructions, or 0 for no
+   *        limit.
+   **/
+  void SetInstructionLimit(std::size_t instruction_limit) {
+    instruction_limit_ = instruction_limit;
+  }
+
   /**
    * @brief Request all enrolled generators to generate code.
    *
-   * @return The number of enrolled codegen that successfully generated code.
+   * @note  Generators whose fingerprint is found in the CodegenCache do not
+   *        generate code again; they reuse the cached function instead.
+   *
+   * @return The number of enrolled codegen that successfully generated code
+   *         or found it in the cache.
    **/
   unsigned int GenerateCode();
 
@@ -70,11 +95,50 @@ class CodegenManager {
    * @brief Compile all the generated functions. On success,
    *        a pointer to the generated method becomes available to the caller.
    *
+   * @note  Cached functions are made available without compilation, and
+   *        newly compiled functions of cacheable generators are added to the
+   *        CodegenCache.
+   *
    * @return The number of enrolled codegen that successully generated code
    *         and 0 on failure
    **/
   unsigned int PrepareGeneratedFunctions();
 
+  /**
+   * @brief Compile all the generated functions on a background thread.
+   *        Callers keep using the regular functions until the compiled ones
+   *        are swapped in by the background thread.
+   *
+   * @note  Cached functions are made available right away. If no thread can
+   *        be started, the functions are compiled synchronously instead.
+   *
+   * @return The number of enrolled codegen that are already using a compiled
+   *         function when this returns.
+   **/
+  unsigned int PrepareGeneratedFunctionsAsync();
+
+  /**
+   * @brief Cancel all background compilations of this backend. Compiled
+   *        functions are still added to the CodegenCache, but no longer
+   *        swapped in.
+   *
+   * @note  Called on transaction abort, where managers are not destroyed
+   *        but the memory of their callers is released.
+   **/
+  static void CancelAsyncCompilations();
+
+  /**
+   * @brief Stop the background compilations of this backend from swapping
+   *        in the function of one generator. The others are still swapped
+   *        in.
+   *
+   * @note  Called when the caller of the generator changes in a way the
+   *        generated function was not specialized on.
+   *
+   * @param generator Generator to detach.
+   **/
+  static void DetachGenerator(CodegenInterface* generator);
+
   /**
    * @brief 	Notifies the manager of a parameter change.
    *
@@ -100,14 +164,57 @@ class CodegenManager {
   }
 
  private:
-  // CodegenUtils provides a facade to LLVM subsystem.
-  std::unique_ptr<gpcodegen::CodegenUtils> codegen_utils_;
+  // State shared between a manager and its background compilation.
+  struct AsyncCompilation;
+
+  // Set all generators that found their function in the cache to use it.
+  unsigned int SetToCachedFunctions();
+
+  // Generators that generated code, and the cache entries to add for them
+  // once their module is compiled.
+  void GetGeneratedFunctions(
+      std::vector<CodegenInterface*>* generated,
+      std::vector<std::pair<std::string, std::string>>* cacheable) const;
+
+  // Background compilations of this backend that may still be running, so
+  // that CancelAsyncCompilations() can reach them. Only used by the main
+  // thread.
+  static std::vector<std::weak_ptr<AsyncCompilation>>& AsyncCompilations();
+  static void RegisterAsyncCompilation(
+      const std::shared_ptr<AsyncCompilation>& async_compilation);
+
+  // Compile the module of 'codegen_utils' and swap in the functions of
+  // 'generated' or, for a background compilation, of the generators still
+  // listed in 'async_compilation'.
+  static unsigned int CompileAndSetToGenerated(
+      const std::shared_ptr<AsyncCompilation>& async_compilation,
+      const std::shared_ptr<gpcodegen::CodegenUtils>& codegen_utils,
+      const std::vector<CodegenInterface*>& generated,
+      const std::vector<std::pair<std::string, std::string>>& cacheable);
+
+  // CodegenUtils provides a facade to LLVM subsystem. It is shared with the
+  // CodegenCache, which may keep the compiled module beyond this manager.
+  std::shared_ptr<gpcodegen::CodegenUtils> codegen_utils_;
 
   std::string module_name_;
 
+  // Maximum number of IR instructions to generate, 0 if unlimited.
+  std::size_t instruction_limit_;
+
   // List of all enrolled code generators.
   std::vector<std::unique_ptr<CodegenInterface>> enrolled_code_generators_;
 
+  // Generators that found their function in the cache.
+  std::vector<std::pair<CodegenInterface*, CodegenCache::Entry>>
+      cache_hits_;
+
+  // Cacheable generators that generate their function in this manager,
+  // along with their fingerprints.
+  std::vector<std::pair<CodegenInterface*, std::string>> cache_misses_;
+
+  // Background compilation started by PrepareGeneratedFunctionsAsync().
+  std::shared_ptr<AsyncCompilation> async_compilation_;
+
   DISALLOW_COPY_AND_ASSIGN(CodegenManager);
 };
 
@@ -0,0 +1,95 @@
+//---------------------------------------------------------------------------
+//  Greenplum Database
+//  Copyright (C) 2016 Pivotal Software, Inc.
+//
+//  @filename:
+//    eval_hash_key_codegen.h
+//
+//  @doc:
+//    Headers for evalHashKey codegen.
+//
+//---------------------------------------------------------------------------
+
+#ifndef GPCODEGEN_EVAL_HASH_KEY_CODEGEN_H_  // NOLINT(build/header_guard)
+#define GPCODEGEN_EVAL_HASH_KEY_CODEGEN_H_
+
+#include <string>
+
+#include "codegen/codegen_wrapper.h"
+#include "codegen/base_codegen.h"
+
+namespace gpcodegen {
+
+/** \addtogroup gpcodegen
+ *  @{
+ */
+
+class EvalHashKeyCodegen: public BaseCodegen<EvalHashKeyFn> {
+ public:
+  /**
+   * @brief Constructor
+   *
+   * @param regular_func_ptr       Regular version of the target function.
+   * @param ptr_to_chosen_func_ptr Reference to the function pointer that the caller will call.
+   * @param hashkeys               The redistribution keys of the Motion node.
+   * @param hashtypes              The types of the keys.
+   *
+   * @note 	The ptr_to_chosen_func_ptr can refer to either the generated function or the
+   * 			corresponding regular version.
+   *
+   **/
+  explicit EvalHashKeyCodegen(EvalHashKeyFn regular_func_ptr,
+                              EvalHashKeyFn* ptr_to_regular_func_ptr,
+                              List* hashkeys,
+                              List* hashtypes);
+
+  virtual ~EvalHashKeyCodegen() = default;
+
+ protected:
+  /**
+   * @brief Generate code for evalHashKey.
+   *
+   * @param codegen_utils
+   *
+   * @return true on successful generation; false otherwise.
+   *
+   * @note Code is only generated when every key is a Var of type int2, int4,
+   * int8 or date. The keys are read directly from their slots, and cdbhash()
+   * of every key is inlined as FNV-1 over its bytes. Only the final reduction
+   * to a segment goes through cdbhashreduce().
+   *
+   * At execution time, we fall back to the regular evalHashKey when the
+   * CdbHash does not use the FNV-1 algorithm.
+   */
+  bool GenerateCodeInternal(gpcodegen::CodegenUtils* codegen_utils) final;
+
+  /**
+   * @note The fingerprint consists of the input attribute and type of every
+   * key.
+   */
+  bool GetFingerprint(std::string* fingerprint) const final;
+
+ private:
+  List* hashkeys_;
+  List* hashtypes_;
+
+  static constexpr char kEvalHashKeyNamePrefix[] = "evalHashKey";
+
+  /**
+   * @return true if all keys are supported.
+   **/
+  bool IsSupported() const;
+
+  /**
+   * @brief Generates runtime code that implements evalHashKey.
+   *
+   * @param codegen_utils Utility to ease the code generation process.
+   * @return true on successful generation.
+   **/
+  bool GenerateEvalHashKey(gpcodegen::CodegenUtils* codegen_utils);
+};
+
+/** @} */
+
+}  // namespace gpcodegen
+#endif  // GPCODEGEN_EVAL_HASH_KEY_CODEGEN_H_
@@ -0,0 +1,107 @@
+//---------------------------------------------------------------------------
+//  Greenplum Database
+//  Copyright (C) 2016 Pivotal Software, Inc.
+//
+//  @filename:
+//    exec_hash_get_hash_value_codegen.h
+//
+//  @doc:
+//    Headers for ExecHashGetHashValue codegen.
+//
+//---------------------------------------------------------------------------
+
+#ifndef GPCODEGEN_EXEC_HASH_GET_HASH_VALUE_CODEGEN_H_  // NOLINT(build/header_guard)
+#define GPCODEGEN_EXEC_HASH_GET_HASH_VALUE_CODEGEN_H_
+
+#include <string>
+#include <vector>
+
+#include "codegen/codegen_wrapper.h"
+#include "codegen/base_codegen.h"
+
+namespace gpcodegen {
+
+/** \addtogroup gpcodegen
+ *  @{
+ */
+
+class ExecHashGetHashValueCodegen: public BaseCodegen<ExecHashGetHashValueFn> {
+ public:
+  /**
+   * @brief Constructor
+   *
+   * @param regular_func_ptr       Regular version of the target function.
+   * @param ptr_to_chosen_func_ptr Reference to the function pointer that the caller will call.
+   * @param hashkeys               The hash keys of one side of the join.
+   * @param hashoperators          The hash join operators.
+   * @param outer_tuple            true if the keys are those of the outer side.
+   *
+   * @note 	The ptr_to_chosen_func_ptr can refer to either the generated function or the
+   * 			corresponding regular version.
+   *
+   **/
+  explicit ExecHashGetHashValueCodegen(
+      ExecHashGetHashValueFn regular_func_ptr,
+      ExecHashGetHashValueFn* ptr_to_regular_func_ptr,
+      List* hashkeys,
+      List* hashoperators,
+      bool outer_tuple);
+
+  virtual ~ExecHashGetHashValueCodegen() = default;
+
+ protected:
+  /**
+   * @brief Generate code for ExecHashGetHashValue.
+   *
+   * @param codegen_utils
+   *
+   * @return true on successful generation; false otherwise.
+   *
+   * @note Code is only generated when every hash key is a Var, and the hash
+   * function of every key is one of hashint2, hashint4, hashint8 or hashoid
+   * (e.g. int2, int4, int8, date and oid keys). The keys are read directly
+   * from their slots, and the hash functions and the rotate-and-xor
+   * combination of the keys are inlined. Since no expression is evaluated,
+   * the per-tuple memory of the ExprContext is not reset.
+   *
+   * At execution time, we fall back to the regular ExecHashGetHashValue when
+   * it is called for the other side of the join.
+   */
+  bool GenerateCodeInternal(gpcodegen::CodegenUtils* codegen_utils) final;
+
+  /**
+   * @note The fingerprint consists of the side of the join, and the input
+   * attribute, hash function and strictness of every key.
+   */
+  bool GetFingerprint(std::string* fingerprint) const final;
+
+ private:
+  List* hashkeys_;
+  List* hashoperators_;
+  bool outer_tuple_;
+
+  static constexpr char kExecHashGetHashValueNamePrefix[] =
+      "ExecHashGetHashValue";
+
+  /**
+   * @brief Looks up the hash function for this side of the join, and the
+   *        strictness, of the operator of every key.
+   *
+   * @return true if every key can be inlined.
+   **/
+  bool GetHashFunctions(std::vector<Oid>* hashfns,
+                        std::vector<bool>* strict) const;
+
+  /**
+   * @brief Generates runtime code that implements ExecHashGetHashValue.
+   *
+   * @param codegen_utils Utility to ease the code generation process.
+   * @return true on successful generation.
+   **/
+  bool GenerateExecHashGetHashValue(gpcodegen::CodegenUtils* codegen_utils);
+};
+
+/** @} */
+
+}  // namespace gpcodegen
+#endif  // GPCODEGEN_EXEC_HASH_GET_HASH_VALUE_CODEGEN_H_
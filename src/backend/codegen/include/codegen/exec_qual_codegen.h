@@ -49,10 +49,35 @@ class ExecQualCodegen: public BaseCodegen<ExecQualFn> {
    *
    * @return true on successful generation; false otherwise.
    *
-   * @note Currently, it simply falls back to regular ExecQual.
+   * @note The qual of the enrolled PlanState is walked at generation time and
+   * compiled into straight-line code for the following shapes:
+   *  (1) Var op Const (or Const op Var) where op is a built-in comparison
+   *      (=, <>, <, <=, >, >=) on int2, int4, int8, float4, float8, date,
+   *      timestamp or timestamptz, including the cross-type integer and
+   *      float variants
+   *  (2) AND / OR / NOT trees over supported expressions
+   *  (3) IS [NOT] NULL over a scan attribute or a supported expression
+   *  (4) Boolean scan attributes and boolean constants
+   *
+   * Vars must come from the scan tuple. All referenced attributes are
+   * deformed once per tuple with slot_getsomeattrs(), after which values are
+   * read directly from the slot.
+   *
+   * Code is generated for the longest prefix of supported clauses. If any
+   * clause is unsupported, a tuple that passes the generated prefix is handed
+   * to the regular ExecQual for the remaining clauses. If the first clause is
+   * unsupported, no code is generated at all. At execution time, we also fall
+   * back to the regular ExecQual when called with a qual of a different
+   * length than the one we generated code for.
    */
   bool GenerateCodeInternal(gpcodegen::CodegenUtils* codegen_utils) final;
 
+  /**
+   * @note The fingerprint consists of the length of the qual and the node
+   * trees of the clauses that we generate code for.
+   */
+  bool GetFingerprint(std::string* fingerprint) const final;
+
  private:
   PlanState *planstate_;
 
@@ -78,6 +78,12 @@ class ExecVariableListCodegen: public BaseCodegen<ExecVariableListFn> {
    */
   bool GenerateCodeInternal(gpcodegen::CodegenUtils* codegen_utils) final;
 
+  /**
+   * @note The fingerprint consists of the slot offset and attribute number of
+   * each target and the layout of the referenced attributes.
+   */
+  bool GetFingerprint(std::string* fingerprint) const final;
+
  private:
   ProjectionInfo* proj_info_;
   TupleTableSlot* slot_;
@@ -0,0 +1,132 @@
+//---------------------------------------------------------------------------
+//  Greenplum Database
+//  Copyright (C) 2016 Pivotal Software, Inc.
+//
+//  @filename:
+//    hash_key_generator.h
+//
+//  @doc:
+//    Generation of hash key evaluation shared by the hash codegens.
+//
+//---------------------------------------------------------------------------
+
+#ifndef GPCODEGEN_HASH_KEY_GENERATOR_H_  // NOLINT(build/header_guard)
+#define GPCODEGEN_HASH_KEY_GENERATOR_H_
+
+#include <string>
+
+#include "codegen/codegen_wrapper.h"
+
+struct ExprState;
+
+namespace llvm {
+class Value;
+}  // namespace llvm
+
+namespace gpcodegen {
+
+/** \addtogroup gpcodegen
+ *  @{
+ */
+
+class CodegenUtils;
+
+/**
+ * @brief Static helpers that generate code for reading hash keys and for
+ *        the hash functions of common by-value key types.
+ **/
+class HashKeyGenerator {
+ public:
+  /**
+   * @return true if the hash key expression is a Var of a user attribute,
+   *         which GenerateVarKey() can read directly from its slot.
+   **/
+  static bool IsVarKey(ExprState* keyexpr);
+
+  /**
+   * @brief Appends the slot and attribute number of a Var key to the
+   *        fingerprint.
+   **/
+  static void AppendVarKeyFingerprint(ExprState* keyexpr,
+                                      std::string* fingerprint);
+
+  /**
+   * @brief Generates code that reads a Var key from the slot of the
+   *        ExprContext that the Var refers to, after deforming the slot up
+   *        to the attribute.
+   *
+   * @param codegen_utils Utility to ease the code generation process.
+   * @param econtext      The ExprContext the key is evaluated in.
+   * @param keyexpr       The key, for which IsVarKey() holds.
+   * @param value         Set to the Datum of the key.
+   * @param isnull        Set to an i1 that is true if the key is NULL.
+   **/
+  static void GenerateVarKey(gpcodegen::CodegenUtils* codegen_utils,
+                             llvm::Value* econtext,
+                             ExprState* keyexpr,
+                             llvm::Value** value,
+                             llvm::Value** isnull);
+
+  /**
+   * @return true if GenerateHashFunc() can inline the hash support function.
+   **/
+  static bool IsHashFuncSupported(Oid hashfn_oid);
+
+  /**
+   * @brief Generates the hash support function 'hashfn_oid' (hashint2,
+   *        hashint4, hashint8 or hashoid) applied to a non-NULL Datum.
+   *
+   * @return The uint32 hash value.
+   **/
+  static llvm::Value* GenerateHashFunc(gpcodegen::CodegenUtils* codegen_utils,
+                                       Oid hashfn_oid,
+                                       llvm::Value* datum);
+
+  /**
+   * @return true if GenerateCdbHash() can inline the hashing of the type.
+   **/
+  static bool IsCdbHashTypeSupported(Oid typeoid);
+
+  /**
+   * @return The hash value cdbhashinit() starts from.
+   **/
+  static llvm::Value* GenerateCdbHashInit(
+      gpcodegen::CodegenUtils* codegen_utils);
+
+  /**
+   * @brief Generates cdbhash() with the FNV-1 algorithm for a non-NULL Datum
+   *        of type 'typeoid' (int2, int4, int8 or date).
+   *
+   * @param hash  The current uint32 hash value.
+   * @return The new hash value.
+   **/
+  static llvm::Value* GenerateCdbHash(gpcodegen::CodegenUtils* codegen_utils,
+                                      Oid typeoid,
+                                      llvm::Value* hash,
+                                      llvm::Value* datum);
+
+  /**
+   * @brief Generates cdbhashnull() with the FNV-1 algorithm.
+   *
+   * @param hash  The current uint32 hash value.
+   * @return The new hash value.
+   **/
+  static llvm::Value* GenerateCdbHashNull(
+      gpcodegen::CodegenUtils* codegen_utils,
+      llvm::Value* hash);
+
+ private:
+  /**
+   * @brief Generates FNV-1 over the 'len' bytes of the integer 'value', in
+   *        the order they are laid out in memory.
+   **/
+  static llvm::Value* GenerateFNV1(gpcodegen::CodegenUtils* codegen_utils,
+                                   llvm::Value* hash,
+                                   llvm::Value* value,
+                                   int len);
+};
+
+/** @} */
+
+}  // namespace gpcodegen
+#endif  // GPCODEGEN_HASH_KEY_GENERATOR_H_
@@ -0,0 +1,127 @@
+//---------------------------------------------------------------------------
+//  Greenplum Database
+//  Copyright (C) 2016 Pivotal Software, Inc.
+//
+//  @filename:
+//    object_code_cache.h
+//
+//  @doc:
+//    On-disk cache of compiled object code, shared between backends
+//
+//---------------------------------------------------------------------------
+
+#ifndef GPCODEGEN_OBJECT_CODE_CACHE_H_  // NOLINT(build/header_guard)
+#define GPCODEGEN_OBJECT_CODE_CACHE_H_
+
+#include <cstddef>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <string>
+#include <unordered_map>
+
+#include "codegen/utils/macros.h"
+#include "llvm/ExecutionEngine/ObjectCache.h"
+#include "llvm/Support/MemoryBuffer.h"
+
+namespace llvm { class Module; }
+
+namespace gpcodegen {
+/** \addtogroup gpcodegen
+ *  @{
+ */
+
+/**
+ * @brief Cache of the machine code that MCJIT compiles generated modules
+ *        to, kept as one object file per module in a directory.
+ *
+ * @note  Objects are keyed by a hash of the IR of their module, salted
+ *        with the LLVM version, the host CPU and its features. Since
+ *        generated code refers to everything outside of the module by
+ *        symbol, and the symbols are resolved whenever an object is loaded,
+ *        an object can be reused by any backend that generates the same IR.
+ *        Backends of all segments on a host may share one directory.
+ *
+ * @note  Objects are written to a temporary file and renamed into place, so
+ *        that concurrent readers never see a partial object. Once the
+ *        objects in the directory exceed the capacity, the least recently
+ *        used ones are removed, as told by their modification time, which
+ *        is updated on every hit.
+ *
+ * @note  Objects are looked up and stored by the thread that compiles the
+ *        module, which may be a background thread, so this class only uses
+ *        POSIX and LLVM facilities, and serializes its methods with a mutex.
+ **/
+class ObjectCodeCache : public llvm::ObjectCache {
+ public:
+  /**
+   * @return The object code cache of the current backend.
+   **/
+  static ObjectCodeCache* GetInstance();
+
+  /**
+   * @brief Set the directory to keep objects in, and the maximum total size
+   *        of the objects in it. A capacity of zero disables the cache.
+   *
+   * @param directory      Path of the directory, created on first store if
+   *                       missing. Relative paths are relative to the data
+   *                       directory of the backend.
+   * @param capacity_bytes Maximum total size of the objects in the directory.
+   **/
+  void Configure(const std::string& directory, std::size_t capacity_bytes);
+
+  /**
+   * @return true if objects are cached at all.
+   **/
+  bool IsEnabled() const {
+    std::lock_guard<std::mutex> guard(mutex_);
+    return capacity_bytes_ > 0 && !directory_.empty();
+  }
+
+  /**
+   * @brief Store the object code MCJIT compiled 'module' to.
+   **/
+  void notifyObjectCompiled(const llvm::Module* module,
+                            llvm::MemoryBufferRef object) override;
+
+  /**
+   * @return The object code of 'module' from an earlier compilation, or
+   *         nullptr if it has to be compiled.
+   **/
+  std::unique_ptr<llvm::MemoryBuffer> getObject(
+      const llvm::Module* module) override;
+
+ private:
+  ObjectCodeCache();
+
+  // Hash of the IR of 'module' and the salt, as a hex string.
+  std::string ComputeKey(const llvm::Module* module) const;
+
+  // Remove the least recently used objects until their total size is within
+  // the capacity. Must be called with mutex_ held.
+  void EvictObjects() const;
+
+  // Path of the object file for 'key'.
+  std::string ObjectPath(const std::string& key) const {
+    return directory_ + "/" + key + ".o";
+  }
+
+  mutable std::mutex mutex_;
+
+  std::string directory_;
+  std::size_t capacity_bytes_;
+
+  // Everything besides the IR that determines the compiled code.
+  std::string salt_;
+
+  // Keys of the modules looked up and not stored yet. MCJIT may change the
+  // IR of a module while compiling it, so the key computed in getObject()
+  // is the one to store the object under.
+  std::unordered_map<const llvm::Module*, std::string> pending_keys_;
+
+  DISALLOW_COPY_AND_ASSIGN(ObjectCodeCache);
+};
+
+/** @} */
+
+}  // namespace gpcodegen
+#endif  // GPCODEGEN_OBJECT_CODE_CACHE_H_
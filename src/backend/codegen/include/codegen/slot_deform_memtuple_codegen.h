@@ -0,0 +1,110 @@
+//---------------------------------------------------------------------------
+//  Greenplum Database
+//  Copyright (C) 2016 Pivotal Software, Inc.
+//
+//  @filename:
+//    slot_deform_memtuple_codegen.h
+//
+//  @doc:
+//    Headers for slot_deform_memtuple codegen.
+//
+//---------------------------------------------------------------------------
+
+#ifndef GPCODEGEN_SLOT_DEFORM_MEMTUPLE_CODEGEN_H_  // NOLINT(build/header_guard)
+#define GPCODEGEN_SLOT_DEFORM_MEMTUPLE_CODEGEN_H_
+
+#include <string>
+
+#include "codegen/codegen_wrapper.h"
+#include "codegen/base_codegen.h"
+
+namespace gpcodegen {
+
+/** \addtogroup gpcodegen
+ *  @{
+ */
+
+class SlotDeformMemTupleCodegen: public BaseCodegen<SlotDeformMemTupleFn> {
+ public:
+  /**
+   * @brief Constructor
+   *
+   * @param regular_func_ptr       Regular version of the target function.
+   * @param ptr_to_chosen_func_ptr Reference to the function pointer that the caller will call.
+   * @param slot                   The slot whose memtuple binding the code is
+   *                               specialized on.
+   *
+   * @note 	The ptr_to_chosen_func_ptr can refer to either the generated function or the
+   * 			corresponding regular version.
+   *
+   **/
+  explicit SlotDeformMemTupleCodegen(
+      SlotDeformMemTupleFn regular_func_ptr,
+      SlotDeformMemTupleFn* ptr_to_regular_func_ptr,
+      TupleTableSlot* slot);
+
+  virtual ~SlotDeformMemTupleCodegen() = default;
+
+ protected:
+  /**
+   * @brief Generate code for slot_deform_memtuple.
+   *
+   * @param codegen_utils
+   *
+   * @return true on successful generation; false otherwise.
+   *
+   * @note The loop over the attributes is unrolled, and the offset, length
+   * and binding flag of each attribute in the slot's MemTupleBinding are
+   * baked into the code. In a memtuple without nulls every attribute, or its
+   * varlena offset, is at a constant offset from the start of the tuple.
+   * Tuples with nulls go through a second copy of the loop that subtracts the
+   * space saved by the preceding null attributes, computed from the null
+   * bitmap one byte at a time and shared between the attributes.
+   *
+   * At execution time, we fall back to the regular slot_deform_memtuple for
+   * large memtuples, which use 4-byte varlena offsets, or when the slot has
+   * a tuple descriptor with a different number of attributes.
+   */
+  bool GenerateCodeInternal(gpcodegen::CodegenUtils* codegen_utils) final;
+
+  /**
+   * @note The fingerprint consists of the binding of every attribute for
+   * tuples that are not large, and of the layout of the null bitmap.
+   */
+  bool GetFingerprint(std::string* fingerprint) const final;
+
+ private:
+  TupleTableSlot* slot_;
+
+  static constexpr char kSlotDeformMemTupleNamePrefix[] =
+      "slot_deform_memtuple";
+
+  // IR values shared by both copies of the unrolled loop.
+  struct DeformState;
+
+  /**
+   * @brief Generates runtime code that implements slot_deform_memtuple.
+   *
+   * @param codegen_utils Utility to ease the code generation process.
+   * @return true on successful generation.
+   **/
+  bool GenerateSlotDeformMemTuple(gpcodegen::CodegenUtils* codegen_utils);
+
+  /**
+   * @brief Generates one copy of the unrolled loop over the attributes,
+   *        starting at the current insert point.
+   *
+   * @param codegen_utils  Utility to ease the code generation process.
+   * @param state          IR values of the tuple being deformed.
+   * @param may_have_nulls false if the copy is only used for tuples without
+   *                       nulls.
+   **/
+  void GenerateDeformAttributes(gpcodegen::CodegenUtils* codegen_utils,
+                                const DeformState& state,
+                                bool may_have_nulls);
+};
+
+/** @} */
+
+}  // namespace gpcodegen
+#endif  // GPCODEGEN_SLOT_DEFORM_MEMTUPLE_CODEGEN_H_
@@ -0,0 +1,127 @@
+//---------------------------------------------------------------------------
+//  Greenplum Database
+//  Copyright (C) 2016 Pivotal Software, Inc.
+//
+//  @filename:
+//    slot_deform_tuple_codegen.h
+//
+//  @doc:
+//    Headers for slot_deform_tuple codegen.
+//
+//---------------------------------------------------------------------------
+
+#ifndef GPCODEGEN_SLOT_DEFORM_TUPLE_CODEGEN_H_  // NOLINT(build/header_guard)
+#define GPCODEGEN_SLOT_DEFORM_TUPLE_CODEGEN_H_
+
+#include <string>
+
+#include "codegen/codegen_wrapper.h"
+#include "codegen/base_codegen.h"
+
+namespace llvm {
+class BasicBlock;
+class Function;
+class PHINode;
+class Value;
+}  // namespace llvm
+
+namespace gpcodegen {
+
+/** \addtogroup gpcodegen
+ *  @{
+ */
+
+class SlotDeformTupleCodegen: public BaseCodegen<SlotDeformTupleFn> {
+ public:
+  /**
+   * @brief Constructor
+   *
+   * @param regular_func_ptr       Regular version of the target function.
+   * @param ptr_to_chosen_func_ptr Reference to the function pointer that the caller will call.
+   * @param slot                   The slot whose tuple descriptor the code is
+   *                               specialized on.
+   *
+   * @note 	The ptr_to_chosen_func_ptr can refer to either the generated function or the
+   * 			corresponding regular version.
+   *
+   **/
+  explicit SlotDeformTupleCodegen(SlotDeformTupleFn regular_func_ptr,
+                                  SlotDeformTupleFn* ptr_to_regular_func_ptr,
+                                  TupleTableSlot* slot);
+
+  virtual ~SlotDeformTupleCodegen() = default;
+
+ protected:
+  /**
+   * @brief Generate code for slot_deform_tuple.
+   *
+   * @param codegen_utils
+   *
+   * @return true on successful generation; false otherwise.
+   *
+   * @note The loop over the attributes of the slot's tuple descriptor is
+   * unrolled, and the length, alignment and by-value-ness of each attribute
+   * are baked into the code. Offsets are computed at generation time for as
+   * long as they do not depend on the data, i.e. for the leading fixed-width
+   * attributes that cannot be null, and alignment of constant offsets is
+   * folded away. The attributes are deformed by one of two copies of the
+   * unrolled loop: one for tuples without nulls, which does not look at the
+   * null bitmap and keeps offsets constant up to the first variable-length
+   * attribute, and one for tuples with nulls.
+   *
+   * At execution time, we fall back to the regular slot_deform_tuple when
+   * some of the attributes have already been deformed, or when the slot has
+   * a tuple descriptor with a different number of attributes.
+   */
+  bool GenerateCodeInternal(gpcodegen::CodegenUtils* codegen_utils) final;
+
+  /**
+   * @note The fingerprint consists of the length, alignment, by-value-ness
+   * and NOT NULL constraint of every attribute of the tuple descriptor.
+   */
+  bool GetFingerprint(std::string* fingerprint) const final;
+
+ private:
+  TupleTableSlot* slot_;
+
+  static constexpr char kSlotDeformTupleNamePrefix[] = "slot_deform_tuple";
+
+  // IR values shared by both copies of the unrolled loop.
+  struct DeformState;
+
+  /**
+   * @brief Generates runtime code that implements slot_deform_tuple.
+   *
+   * @param codegen_utils Utility to ease the code generation process.
+   * @return true on successful generation.
+   **/
+  bool GenerateSlotDeformTuple(gpcodegen::CodegenUtils* codegen_utils);
+
+  /**
+   * @brief Generates one copy of the unrolled loop over the attributes,
+   *        starting at the current insert point.
+   *
+   * @param codegen_utils  Utility to ease the code generation process.
+   * @param state          IR values of the tuple being deformed.
+   * @param may_have_nulls false if the copy is only used for tuples without
+   *                       nulls.
+   **/
+  void GenerateDeformAttributes(gpcodegen::CodegenUtils* codegen_utils,
+                                const DeformState& state,
+                                bool may_have_nulls);
+
+  /**
+   * @brief Generates code that computes VARSIZE_ANY() of the varlena at
+   *        'attptr', starting at the current insert point.
+   *
+   * @return The size as an offset increment.
+   **/
+  llvm::Value* GenerateVarsizeAny(gpcodegen::CodegenUtils* codegen_utils,
+                                  llvm::Function* function,
+                                  llvm::Value* attptr);
+};
+
+/** @} */
+
+}  // namespace gpcodegen
+#endif  // GPCODEGEN_SLOT_DEFORM_TUPLE_CODEGEN_H_
@@ -30,6 +30,7 @@
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/Twine.h"
 #include "llvm/ExecutionEngine/ExecutionEngine.h"
+#include "llvm/ExecutionEngine/ObjectCache.h"
 #include "llvm/IR/BasicBlock.h"
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/DerivedTypes.h"
@@ -361,9 +362,9 @@ class CodegenUtils {
   /**
    * @brief Prepare code generated by this CodegenUtils for execution.
    *
-   * Internally, this creates an LLVM MCJIT ExecutionEngine and gives ownership
-   * of the Module to it. Actual compilation of functions may be deferred until
-   * the first call to GetUntypedFunctionPointer().
+   * Internally, this creates an LLVM MCJIT ExecutionEngine, gives ownership
+   * of the Module to it and compiles all of its functions, so that
+   * GetUntypedFunctionPointer() only has to look up the compiled code.
    *
    * @note The cpu_opt_level and optimize_for_host_cpu options for this method
    *       only affect the actual generation of machine code. See also the
@@ -380,6 +381,20 @@ class CodegenUtils {
   bool PrepareForExecution(const OptimizationLevel cpu_opt_level,
                            const bool optimize_for_host_cpu);
 
+  /**
+   * @brief Set a cache of compiled object code that PrepareForExecution()
+   *        consults before translating the Module to machine code, and
+   *        populates after doing so.
+   *
+   * @note Must be called before PrepareForExecution(). The cache is not owned
+   *       by this CodegenUtils and must outlive it.
+   *
+   * @param object_cache The cache to use, or nullptr to always compile.
+   **/
+  void SetObjectCache(llvm::ObjectCache* object_cache) {
+    object_cache_ = object_cache;
+  }
+
   /**
    * @brief Get a pointer to the compiled machine-code version of a function
    *        generated by this CodegenUtils.
@@ -511,6 +526,9 @@ class CodegenUtils {
 
   std::unique_ptr<llvm::ExecutionEngine> engine_;
 
+  // Optional cache of object code given to '*engine_' after creating it.
+  llvm::ObjectCache* object_cache_;
+
   // Pairs of (function_name, address) for each external function registered by
   // RegisterExternalFunction(). PrepareForExecution() adds a mapping for each
   // such function to '*engine_' after creating it.
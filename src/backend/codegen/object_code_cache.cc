@@ -0,0 +1,228 @@
+//---------------------------------------------------------------------------
+//  Greenplum Database
+//  Copyright (C) 2016 Pivotal Software, Inc.
+//
+//  @filename:
+//    object_code_cache.cc
+//
+//  @doc:
+//    Implementation of the on-disk cache of compiled object code
+//
+//---------------------------------------------------------------------------
+
+#include "codegen/object_code_cache.h"
+
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include <utime.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/Host.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/raw_ostream.h"
+
+using gpcodegen::ObjectCodeCache;
+
+namespace {
+
+constexpr char kObjectSuffix[] = ".o";
+constexpr char kTemporaryFilePattern[] = "/tmp_object.XXXXXX";
+
+bool HasObjectSuffix(const std::string& name) {
+  const std::size_t suffix_length = sizeof(kObjectSuffix) - 1;
+  return name.size() > suffix_length &&
+      0 == name.compare(name.size() - suffix_length, suffix_length,
+                        kObjectSuffix);
+}
+
+// Write all of 'size' bytes of 'data' to 'fd'.
+bool WriteAll(int fd, const char* data, std::size_t size) {
+  while (size > 0) {
+    ssize_t written = write(fd, data, size);
+    if (written < 0) {
+      if (EINTR == errno) {
+        continue;
+      }
+      return false;
+    }
+    data += written;
+    size -= written;
+  }
+  return true;
+}
+
+}  // namespace
+
+ObjectCodeCache* ObjectCodeCache::GetInstance() {
+  // Never destroyed, like the CodegenCache, as background compilations may
+  // still use it at backend exit.
+  static ObjectCodeCache* instance = new ObjectCodeCache();
+  return instance;
+}
+
+ObjectCodeCache::ObjectCodeCache()
+    : capacity_bytes_(0) {
+  // The modules are always compiled for the host CPU, so objects compiled
+  // on a different CPU, or by a different LLVM, must not be picked up.
+  salt_.append(LLVM_VERSION_STRING);
+  salt_.append(":");
+  salt_.append(llvm::sys::getHostCPUName().str());
+  llvm::StringMap<bool> host_features;
+  if (llvm::sys::getHostCPUFeatures(host_features)) {
+    std::vector<std::string> enabled_features;
+    for (const auto& feature : host_features) {
+      if (feature.getValue()) {
+        enabled_features.push_back(feature.getKey().str());
+      }
+    }
+    // StringMap iteration order is unspecified
+    std::sort(enabled_features.begin(), enabled_features.end());
+    for (const std::string& feature : enabled_features) {
+      salt_.append(",+" + feature);
+    }
+  }
+}
+
+void ObjectCodeCache::Configure(const std::string& directory,
+                                std::size_t capacity_bytes) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  bool shrunk = capacity_bytes < capacity_bytes_ || directory != directory_;
+  directory_ = directory;
+  capacity_bytes_ = capacity_bytes;
+  if (shrunk && capacity_bytes_ > 0 && !directory_.empty()) {
+    EvictObjects();
+  }
+}
+
+std::string ObjectCodeCache::ComputeKey(const llvm::Module* module) const {
+  std::string ir;
+  llvm::raw_string_ostream ir_stream(ir);
+  module->print(ir_stream, nullptr);
+  ir_stream.flush();
+
+  llvm::MD5 hash;
+  hash.update(salt_);
+  hash.update(ir);
+  llvm::MD5::MD5Result result;
+  hash.final(result);
+  llvm::SmallString<32> key;
+  llvm::MD5::stringifyResult(result, key);
+  return std::string(key.data(), key.size());
+}
+
+std::unique_ptr<llvm::MemoryBuffer> ObjectCodeCache::getObject(
+    const llvm::Module* module) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  if (0 == capacity_bytes_ || directory_.empty()) {
+    return nullptr;
+  }
+
+  std::string key = ComputeKey(module);
+  std::string path = ObjectPath(key);
+  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> object =
+      llvm::MemoryBuffer::getFile(path);
+  if (!object) {
+    // Remember the key, MCJIT stores the object once it is compiled
+    pending_keys_[module] = key;
+    return nullptr;
+  }
+
+  // Mark the object as most recently used. Failing to do so only makes it
+  // more likely to be evicted.
+  utime(path.c_str(), nullptr);
+  return std::move(object.get());
+}
+
+void ObjectCodeCache::notifyObjectCompiled(const llvm::Module* module,
+                                           llvm::MemoryBufferRef object) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  auto it = pending_keys_.find(module);
+  if (pending_keys_.end() == it) {
+    return;
+  }
+  std::string key = it->second;
+  pending_keys_.erase(it);
+  if (0 == capacity_bytes_ || directory_.empty() ||
+      object.getBufferSize() > capacity_bytes_) {
+    return;
+  }
+
+  if (0 != mkdir(directory_.c_str(), S_IRWXU) && EEXIST != errno) {
+    return;
+  }
+
+  // Other backends may read the object any time after the rename, so it is
+  // only renamed once completely written.
+  std::string temporary_path = directory_ + kTemporaryFilePattern;
+  std::vector<char> temporary_path_buffer(temporary_path.begin(),
+                                          temporary_path.end());
+  temporary_path_buffer.push_back('\0');
+  int fd = mkstemp(temporary_path_buffer.data());
+  if (fd < 0) {
+    return;
+  }
+  bool written = WriteAll(fd, object.getBufferStart(),
+                          object.getBufferSize());
+  written = (0 == close(fd)) && written;
+  if (!written ||
+      0 != rename(temporary_path_buffer.data(), ObjectPath(key).c_str())) {
+    unlink(temporary_path_buffer.data());
+    return;
+  }
+  EvictObjects();
+}
+
+void ObjectCodeCache::EvictObjects() const {
+  DIR* dir = opendir(directory_.c_str());
+  if (nullptr == dir) {
+    return;
+  }
+
+  // (modification time, size, path) of every object in the directory
+  std::vector<std::tuple<std::time_t, std::size_t, std::string>> objects;
+  std::size_t total_size = 0;
+  while (struct dirent* entry = readdir(dir)) {
+    std::string name(entry->d_name);
+    if (!HasObjectSuffix(name)) {
+      continue;
+    }
+    std::string path = directory_ + "/" + name;
+    struct stat st;
+    if (0 != stat(path.c_str(), &st) || !S_ISREG(st.st_mode)) {
+      continue;
+    }
+    objects.emplace_back(st.st_mtime, st.st_size, path);
+    total_size += st.st_size;
+  }
+  closedir(dir);
+
+  if (total_size <= capacity_bytes_) {
+    return;
+  }
+
+  // Oldest first. Other backends may remove the same objects concurrently,
+  // in which case unlink() fails harmlessly.
+  std::sort(objects.begin(), objects.end());
+  for (const auto& object : objects) {
+    if (total_size <= capacity_bytes_) {
+      break;
+    }
+    unlink(std::get<2>(object).c_str());
+    total_size -= std::get<1>(object);
+  }
+}
@@ -0,0 +1,405 @@
+//---------------------------------------------------------------------------
+//  Greenplum Database
+//  Copyright (C) 2016 Pivotal Software, Inc.
+//
+//  @filename:
+//    slot_deform_memtuple_codegen.cc
+//
+//  @doc:
+//    Generates code for slot_deform_memtuple function.
+//
+//---------------------------------------------------------------------------
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "codegen/slot_deform_memtuple_codegen.h"
+#include "codegen/utils/utility.h"
+#include "codegen/utils/codegen_utils.h"
+
+#include "llvm/IR/BasicBlock.h"
+#include "llvm/IR/Constant.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Type.h"
+#include "llvm/IR/Value.h"
+
+extern "C" {
+#include "postgres.h"
+#include "utils/elog.h"
+#include "access/memtup.h"
+#include "executor/tuptable.h"
+}
+
+using gpcodegen::SlotDeformMemTupleCodegen;
+
+constexpr char SlotDeformMemTupleCodegen::kSlotDeformMemTupleNamePrefix[];
+
+struct SlotDeformMemTupleCodegen::DeformState {
+  llvm::Function* function;
+  // Number of attributes the caller asks for
+  llvm::Value* natts;
+  // Where offsets in the binding are counted from
+  llvm::Value* start;
+  // Null bitmap and the binding's null_saves_aligned, only set for tuples
+  // with nulls
+  llvm::Value* null_bitmap;
+  llvm::Value* null_saves;
+  // slot->PRIVATE_tts_values and slot->PRIVATE_tts_isnull
+  llvm::Value* values;
+  llvm::Value* isnull;
+  llvm::BasicBlock* done_block;
+};
+
+namespace {
+
+// compute_null_save_b() for byte 'nbyte' of the null bitmap, whose value
+// is 'null_bits'
+llvm::Value* CreateNullSaveByte(gpcodegen::CodegenUtils* codegen_utils,
+                                llvm::Value* null_saves,
+                                int nbyte,
+                                llvm::Value* null_bits) {
+  auto irb = codegen_utils->ir_builder();
+  llvm::Value* llvm_low = irb->CreateAdd(
+      irb->CreateZExt(
+          irb->CreateAnd(null_bits, codegen_utils->GetConstant<uint8>(0xF)),
+          codegen_utils->GetType<int64>()),
+      codegen_utils->GetConstant<int64>(32 * nbyte));
+  llvm::Value* llvm_high = irb->CreateAdd(
+      irb->CreateZExt(irb->CreateLShr(null_bits, 4),
+                      codegen_utils->GetType<int64>()),
+      codegen_utils->GetConstant<int64>(32 * nbyte + 16));
+  return irb->CreateAdd(
+      irb->CreateLoad(irb->CreateInBoundsGEP(null_saves, {llvm_low})),
+      irb->CreateLoad(irb->CreateInBoundsGEP(null_saves, {llvm_high})));
+}
+
+}  // namespace
+
+SlotDeformMemTupleCodegen::SlotDeformMemTupleCodegen(
+    SlotDeformMemTupleFn regular_func_ptr,
+    SlotDeformMemTupleFn* ptr_to_regular_func_ptr,
+    TupleTableSlot* slot) :
+    BaseCodegen(kSlotDeformMemTupleNamePrefix,
+                regular_func_ptr,
+                ptr_to_regular_func_ptr),
+    slot_(slot) {
+}
+
+bool SlotDeformMemTupleCodegen::GenerateSlotDeformMemTuple(
+    gpcodegen::CodegenUtils* codegen_utils) {
+  assert(NULL != codegen_utils);
+  static_assert(sizeof(Datum) == sizeof(int64),
+      "sizeof(Datum) doesn't match sizeof(int64)");
+
+  MemTupleBinding* pbind = slot_->tts_mt_bind;
+  if (NULL == pbind || 0 == pbind->tupdesc->natts) {
+    elog(DEBUG1, "Cannot codegen slot_deform_memtuple without attributes");
+    return false;
+  }
+
+  TupleDesc tupdesc = pbind->tupdesc;
+  for (int attnum = 0; attnum < tupdesc->natts; ++attnum) {
+    MemTupleAttrBinding* attrbind = &pbind->bind.bindings[attnum];
+    bool supported_len = (MTB_ByVal_Native == attrbind->flag) ?
+        (1 == attrbind->len || 2 == attrbind->len ||
+         4 == attrbind->len || 8 == attrbind->len) :
+        (MTB_ByVal_Ptr == attrbind->flag || 2 == attrbind->len);
+    if (!supported_len) {
+      elog(DEBUG1, "Cannot codegen slot_deform_memtuple for attribute %d "
+                   "of length %d", attnum + 1, attrbind->len);
+      return false;
+    }
+  }
+
+  llvm::Function* slot_deform_memtuple_func =
+      CreateFunction<SlotDeformMemTupleFn>(codegen_utils, GetUniqueFuncName());
+  auto irb = codegen_utils->ir_builder();
+
+  llvm::BasicBlock* entry_block = codegen_utils->CreateBasicBlock(
+      "entry", slot_deform_memtuple_func);
+  llvm::BasicBlock* prologue_block = codegen_utils->CreateBasicBlock(
+      "prologue", slot_deform_memtuple_func);
+  llvm::BasicBlock* no_nulls_block = codegen_utils->CreateBasicBlock(
+      "no_nulls", slot_deform_memtuple_func);
+  llvm::BasicBlock* has_nulls_block = codegen_utils->CreateBasicBlock(
+      "has_nulls", slot_deform_memtuple_func);
+  llvm::BasicBlock* done_block = codegen_utils->CreateBasicBlock(
+      "done", slot_deform_memtuple_func);
+  llvm::BasicBlock* fallback_block = codegen_utils->CreateBasicBlock(
+      "fallback", slot_deform_memtuple_func);
+
+  llvm::Value* llvm_slot = ArgumentByPosition(slot_deform_memtuple_func, 0);
+  llvm::Value* llvm_natts = ArgumentByPosition(slot_deform_memtuple_func, 1);
+
+  // Entry block
+  // -----------
+  // Fall back for large memtuples, which are laid out by a different
+  // binding, and if the slot does not have the descriptor we generated
+  // code for.
+  irb->SetInsertPoint(entry_block);
+  llvm::Value* llvm_tupdesc = irb->CreateLoad(
+      codegen_utils->GetPointerToMember(
+          llvm_slot, &TupleTableSlot::tts_tupleDescriptor));
+  llvm::Value* llvm_tupdesc_natts = irb->CreateLoad(
+      codegen_utils->GetPointerToMember(llvm_tupdesc, &tupleDesc::natts));
+  llvm::Value* llvm_mtup = irb->CreateLoad(
+      codegen_utils->GetPointerToMember(
+          llvm_slot, &TupleTableSlot::PRIVATE_tts_memtuple));
+  llvm::Value* llvm_mt_len = irb->CreateLoad(
+      codegen_utils->GetPointerToMember(llvm_mtup,
+                                        &MemTupleData::PRIVATE_mt_len));
+  irb->CreateCondBr(
+      irb->CreateAnd(
+          irb->CreateICmpEQ(llvm_tupdesc_natts,
+                            codegen_utils->GetConstant<int>(tupdesc->natts)),
+          irb->CreateICmpEQ(
+              irb->CreateAnd(llvm_mt_len,
+                             codegen_utils->GetConstant<uint32>(
+                                 MEMTUP_LARGETUP)),
+              codegen_utils->GetConstant<uint32>(0))),
+      prologue_block /* true */,
+      fallback_block /* false */);
+
+  // Prologue block
+  // --------------
+  irb->SetInsertPoint(prologue_block);
+  DeformState state;
+  state.function = slot_deform_memtuple_func;
+  state.natts = llvm_natts;
+  state.values = irb->CreateLoad(codegen_utils->GetPointerToMember(
+      llvm_slot, &TupleTableSlot::PRIVATE_tts_values));
+  state.isnull = irb->CreateLoad(codegen_utils->GetPointerToMember(
+      llvm_slot, &TupleTableSlot::PRIVATE_tts_isnull));
+  state.done_block = done_block;
+  irb->CreateCondBr(
+      irb->CreateICmpNE(
+          irb->CreateAnd(llvm_mt_len,
+                         codegen_utils->GetConstant<uint32>(MEMTUP_HASNULL)),
+          codegen_utils->GetConstant<uint32>(0)),
+      has_nulls_block /* true */,
+      no_nulls_block /* false */);
+
+  irb->SetInsertPoint(no_nulls_block);
+  state.start = llvm_mtup;
+  state.null_bitmap = nullptr;
+  state.null_saves = nullptr;
+  GenerateDeformAttributes(codegen_utils, state, false);
+
+  // With nulls, the attributes start after the extra space of the null
+  // bitmap, and offsets are reduced by the space saved by null attributes.
+  irb->SetInsertPoint(has_nulls_block);
+  state.start = irb->CreateInBoundsGEP(
+      llvm_mtup,
+      {codegen_utils->GetConstant<int64>(pbind->null_bitmap_extra_size)});
+  state.null_bitmap = irb->CreateInBoundsGEP(
+      llvm_mtup,
+      {codegen_utils->GetConstant<int64>(
+          offsetof(MemTupleData, PRIVATE_mt_bits) +
+          (mtbind_has_oid(pbind) ? sizeof(Oid) : 0))});
+  llvm::Value* llvm_pbind = irb->CreateLoad(
+      codegen_utils->GetPointerToMember(
+          llvm_slot, &TupleTableSlot::tts_mt_bind));
+  state.null_saves = irb->CreateLoad(
+      codegen_utils->GetPointerToMember(
+          llvm_pbind, &MemTupleBinding::bind,
+          &MemTupleBindingCols::null_saves_aligned));
+  GenerateDeformAttributes(codegen_utils, state, true);
+
+  // Done block
+  // ----------
+  irb->SetInsertPoint(done_block);
+  irb->CreateRetVoid();
+
+  // Fall back block
+  // ---------------
+  irb->SetInsertPoint(fallback_block);
+  codegen_utils->CreateFallback<SlotDeformMemTupleFn>(
+      codegen_utils->RegisterExternalFunction(GetRegularFuncPointer()),
+      slot_deform_memtuple_func);
+  return true;
+}
+
+void SlotDeformMemTupleCodegen::GenerateDeformAttributes(
+    gpcodegen::CodegenUtils* codegen_utils,
+    const DeformState& state,
+    bool may_have_nulls) {
+  auto irb = codegen_utils->ir_builder();
+  MemTupleBinding* pbind = slot_->tts_mt_bind;
+  TupleDesc tupdesc = pbind->tupdesc;
+  const std::string suffix = may_have_nulls ? "_nulls" : "";
+
+  // Bytes of the null bitmap, and the space saved by the null attributes in
+  // all the bytes before, computed as the attributes need them.
+  std::vector<llvm::Value*> null_bits;
+  std::vector<llvm::Value*> null_save_before = {
+      codegen_utils->GetConstant<int16>(0)};
+
+  for (int attnum = 0; attnum < tupdesc->natts; ++attnum) {
+    MemTupleAttrBinding* attrbind = &pbind->bind.bindings[attnum];
+    const std::string name_suffix = std::to_string(attnum) + suffix;
+    llvm::Value* llvm_attnum = codegen_utils->GetConstant<int>(attnum);
+
+    // Stop once all the attributes the caller asked for are deformed
+    llvm::BasicBlock* attribute_block = codegen_utils->CreateBasicBlock(
+        "attribute_" + name_suffix, state.function);
+    llvm::BasicBlock* next_attribute_block = codegen_utils->CreateBasicBlock(
+        "next_attribute_" + name_suffix, state.function);
+    irb->CreateCondBr(irb->CreateICmpSLT(llvm_attnum, state.natts),
+                      attribute_block /* true */,
+                      state.done_block /* false */);
+    irb->SetInsertPoint(attribute_block);
+
+    llvm::Value* llvm_values_ptr =
+        irb->CreateInBoundsGEP(state.values, {llvm_attnum});
+    llvm::Value* llvm_isnull_ptr =
+        irb->CreateInBoundsGEP(state.isnull, {llvm_attnum});
+
+    llvm::Value* llvm_offset =
+        codegen_utils->GetConstant<int64>(attrbind->offset);
+    if (may_have_nulls) {
+      // Load the bytes of the null bitmap up to this attribute's, here
+      // where every following attribute can use them
+      const std::size_t null_byte = attrbind->null_byte;
+      while (null_bits.size() <= null_byte) {
+        null_bits.push_back(irb->CreateLoad(irb->CreateInBoundsGEP(
+            state.null_bitmap,
+            {codegen_utils->GetConstant<int64>(null_bits.size())})));
+      }
+      while (null_save_before.size() <= null_byte) {
+        int nbyte = null_save_before.size() - 1;
+        null_save_before.push_back(irb->CreateAdd(
+            null_save_before.back(),
+            CreateNullSaveByte(codegen_utils, state.null_saves, nbyte,
+                               null_bits[nbyte])));
+      }
+      llvm::Value* llvm_null_bits = null_bits[attrbind->null_byte];
+
+      llvm::BasicBlock* is_null_block = codegen_utils->CreateBasicBlock(
+          "is_null_" + name_suffix, state.function);
+      llvm::BasicBlock* is_not_null_block = codegen_utils->CreateBasicBlock(
+          "is_not_null_" + name_suffix, state.function);
+      irb->CreateCondBr(
+          irb->CreateICmpNE(
+              irb->CreateAnd(llvm_null_bits,
+                             codegen_utils->GetConstant<uint8>(
+                                 attrbind->null_mask)),
+              codegen_utils->GetConstant<uint8>(0)),
+          is_null_block /* true */,
+          is_not_null_block /* false */);
+
+      irb->SetInsertPoint(is_null_block);
+      irb->CreateStore(codegen_utils->GetConstant<Datum>(0), llvm_values_ptr);
+      irb->CreateStore(codegen_utils->GetConstant<bool>(true),
+                       llvm_isnull_ptr);
+      irb->CreateBr(next_attribute_block);
+
+      // compute_null_save() for the attribute: the bytes before its own,
+      // and the bits before its own in its byte
+      irb->SetInsertPoint(is_not_null_block);
+      llvm::Value* llvm_null_save = irb->CreateAdd(
+          null_save_before[attrbind->null_byte],
+          CreateNullSaveByte(
+              codegen_utils, state.null_saves, attrbind->null_byte,
+              irb->CreateAnd(llvm_null_bits,
+                             codegen_utils->GetConstant<uint8>(
+                                 attrbind->null_mask - 1))));
+      llvm_offset = irb->CreateSub(
+          llvm_offset,
+          irb->CreateSExt(llvm_null_save, codegen_utils->GetType<int64>()));
+    }
+
+    // values[attnum] = fetchatt(attr, memtuple_get_attr_data_ptr(...))
+    llvm::Value* llvm_attptr =
+        irb->CreateInBoundsGEP(state.start, {llvm_offset});
+    llvm::Value* llvm_value = nullptr;
+    switch (attrbind->flag) {
+      case MTB_ByVal_Native: {
+        llvm::Type* value_type = nullptr;
+        switch (attrbind->len) {
+          case sizeof(char):
+            value_type = codegen_utils->GetType<int8>();
+            break;
+          case sizeof(int16):
+            value_type = codegen_utils->GetType<int16>();
+            break;
+          case sizeof(int32):
+            value_type = codegen_utils->GetType<int32>();
+            break;
+          default:
+            assert(sizeof(Datum) == attrbind->len);
+            value_type = codegen_utils->GetType<int64>();
+            break;
+        }
+        // Like the Int32GetDatum() etc. casts, sign-extend the value
+        llvm_value = irb->CreateSExtOrTrunc(
+            irb->CreateLoad(irb->CreateBitCast(llvm_attptr,
+                                               value_type->getPointerTo())),
+            codegen_utils->GetType<Datum>());
+        break;
+      }
+      case MTB_ByVal_Ptr:
+        llvm_value = irb->CreatePtrToInt(llvm_attptr,
+                                         codegen_utils->GetType<Datum>());
+        break;
+      default: {
+        // Varlena data is at the 2-byte offset stored in the attribute
+        assert(2 == attrbind->len);
+        llvm::Value* llvm_data_offset = irb->CreateZExt(
+            irb->CreateLoad(irb->CreateBitCast(
+                llvm_attptr, codegen_utils->GetType<uint16*>())),
+            codegen_utils->GetType<int64>());
+        llvm_value = irb->CreatePtrToInt(
+            irb->CreateInBoundsGEP(state.start, {llvm_data_offset}),
+            codegen_utils->GetType<Datum>());
+        break;
+      }
+    }
+    irb->CreateStore(llvm_value, llvm_values_ptr);
+    irb->CreateStore(codegen_utils->GetConstant<bool>(false), llvm_isnull_ptr);
+    irb->CreateBr(next_attribute_block);
+
+    irb->SetInsertPoint(next_attribute_block);
+  }
+
+  // All attributes are deformed
+  irb->CreateBr(state.done_block);
+}
+
+bool SlotDeformMemTupleCodegen::GetFingerprint(
+    std::string* fingerprint) const {
+  MemTupleBinding* pbind = slot_->tts_mt_bind;
+  if (NULL == pbind) {
+    return false;
+  }
+
+  TupleDesc tupdesc = pbind->tupdesc;
+  fingerprint->assign(kSlotDeformMemTupleNamePrefix);
+  fingerprint->append(
+      ":" + std::to_string(tupdesc->natts) +
+      ":" + std::to_string(mtbind_has_oid(pbind)) +
+      ":" + std::to_string(pbind->null_bitmap_extra_size));
+  for (int attnum = 0; attnum < tupdesc->natts; ++attnum) {
+    MemTupleAttrBinding* attrbind = &pbind->bind.bindings[attnum];
+    fingerprint->append(
+        ":" + std::to_string(attrbind->offset) +
+        "/" + std::to_string(attrbind->len) +
+        "/" + std::to_string(attrbind->flag) +
+        "/" + std::to_string(attrbind->null_byte) +
+        "/" + std::to_string(attrbind->null_mask));
+  }
+  return true;
+}
+
+bool SlotDeformMemTupleCodegen::GenerateCodeInternal(
+    CodegenUtils* codegen_utils) {
+  bool isGenerated = GenerateSlotDeformMemTuple(codegen_utils);
+
+  if (isGenerated) {
+    elog(DEBUG1, "slot_deform_memtuple was generated successfully!");
+    return true;
+  } else {
+    elog(DEBUG1, "slot_deform_memtuple generation failed!");
+    return false;
+  }
+}
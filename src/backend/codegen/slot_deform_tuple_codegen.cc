@@ -0,0 +1,512 @@
+//---------------------------------------------------------------------------
+//  Greenplum Database
+//  Copyright (C) 2016 Pivotal Software, Inc.
+//
+//  @filename:
+//    slot_deform_tuple_codegen.cc
+//
+//  @doc:
+//    Generates code for slot_deform_tuple function.
+//
+//---------------------------------------------------------------------------
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "codegen/slot_deform_tuple_codegen.h"
+#include "codegen/utils/utility.h"
+#include "codegen/utils/codegen_utils.h"
+
+#include "llvm/IR/BasicBlock.h"
+#include "llvm/IR/Constant.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Intrinsics.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/Type.h"
+#include "llvm/IR/Value.h"
+#include "llvm/Support/Casting.h"
+
+extern "C" {
+#include "postgres.h"
+#include "utils/elog.h"
+#include "access/htup.h"
+#include "access/tupmacs.h"
+#include "executor/tuptable.h"
+}
+
+using gpcodegen::SlotDeformTupleCodegen;
+
+constexpr char SlotDeformTupleCodegen::kSlotDeformTupleNamePrefix[];
+
+struct SlotDeformTupleCodegen::DeformState {
+  llvm::Function* function;
+  // Number of attributes the caller asks for
+  llvm::Value* natts;
+  // tp and bp of slot_deform_tuple
+  llvm::Value* tuple_data;
+  llvm::Value* null_bitmap;
+  // slot->PRIVATE_tts_values and slot->PRIVATE_tts_isnull
+  llvm::Value* values;
+  llvm::Value* isnull;
+  // Where we save the loop state in the slot and return
+  llvm::BasicBlock* done_block;
+  llvm::PHINode* attnum;
+  llvm::PHINode* off;
+  llvm::PHINode* slow;
+};
+
+namespace {
+
+// att_align() for an offset that is only known at execution time. Constant
+// offsets are folded by the IRBuilder.
+llvm::Value* CreateAttAlign(gpcodegen::CodegenUtils* codegen_utils,
+                            llvm::Value* off,
+                            char attalign) {
+  long alignment = att_align(1, attalign);  // NOLINT(runtime/int)
+  if (1 == alignment) {
+    return off;
+  }
+  auto irb = codegen_utils->ir_builder();
+  return irb->CreateAnd(
+      irb->CreateAdd(off, codegen_utils->GetConstant<long>(  // NOLINT
+          alignment - 1)),
+      codegen_utils->GetConstant<long>(~(alignment - 1)));  // NOLINT
+}
+
+// true if 'off' is known to be aligned at generation time
+bool IsAttAligned(llvm::Value* off, char attalign) {
+  llvm::ConstantInt* constant_off = llvm::dyn_cast<llvm::ConstantInt>(off);
+  if (nullptr == constant_off) {
+    return false;
+  }
+  long value = constant_off->getSExtValue();  // NOLINT(runtime/int)
+  return att_align(value, attalign) == value;
+}
+
+}  // namespace
+
+SlotDeformTupleCodegen::SlotDeformTupleCodegen(
+    SlotDeformTupleFn regular_func_ptr,
+    SlotDeformTupleFn* ptr_to_regular_func_ptr,
+    TupleTableSlot* slot) :
+    BaseCodegen(kSlotDeformTupleNamePrefix,
+                regular_func_ptr,
+                ptr_to_regular_func_ptr),
+    slot_(slot) {
+}
+
+bool SlotDeformTupleCodegen::GenerateSlotDeformTuple(
+    gpcodegen::CodegenUtils* codegen_utils) {
+  assert(NULL != codegen_utils);
+  static_assert(sizeof(Datum) == sizeof(int64),
+      "sizeof(Datum) doesn't match sizeof(int64)");
+
+  TupleDesc tupdesc = slot_->tts_tupleDescriptor;
+  if (NULL == tupdesc || 0 == tupdesc->natts) {
+    elog(DEBUG1, "Cannot codegen slot_deform_tuple without attributes");
+    return false;
+  }
+
+  for (int attnum = 0; attnum < tupdesc->natts; ++attnum) {
+    Form_pg_attribute thisatt = tupdesc->attrs[attnum];
+    bool supported_len = thisatt->attbyval ?
+        (1 == thisatt->attlen || 2 == thisatt->attlen ||
+         4 == thisatt->attlen || 8 == thisatt->attlen) :
+        (thisatt->attlen > 0 || -1 == thisatt->attlen ||
+         -2 == thisatt->attlen);
+    if (!supported_len) {
+      elog(DEBUG1, "Cannot codegen slot_deform_tuple for attribute %d "
+                   "of length %d", attnum + 1, thisatt->attlen);
+      return false;
+    }
+  }
+
+  llvm::Function* slot_deform_tuple_func = CreateFunction<SlotDeformTupleFn>(
+      codegen_utils, GetUniqueFuncName());
+  auto irb = codegen_utils->ir_builder();
+
+  llvm::BasicBlock* entry_block = codegen_utils->CreateBasicBlock(
+      "entry", slot_deform_tuple_func);
+  llvm::BasicBlock* prologue_block = codegen_utils->CreateBasicBlock(
+      "prologue", slot_deform_tuple_func);
+  llvm::BasicBlock* no_nulls_block = codegen_utils->CreateBasicBlock(
+      "no_nulls", slot_deform_tuple_func);
+  llvm::BasicBlock* has_nulls_block = codegen_utils->CreateBasicBlock(
+      "has_nulls", slot_deform_tuple_func);
+  llvm::BasicBlock* done_block = codegen_utils->CreateBasicBlock(
+      "done", slot_deform_tuple_func);
+  llvm::BasicBlock* fallback_block = codegen_utils->CreateBasicBlock(
+      "fallback", slot_deform_tuple_func);
+
+  llvm::Value* llvm_slot = ArgumentByPosition(slot_deform_tuple_func, 0);
+  llvm::Value* llvm_natts = ArgumentByPosition(slot_deform_tuple_func, 1);
+
+  // Entry block
+  // -----------
+  // Fall back if we have already started deforming this tuple, or if the
+  // slot does not have the descriptor we generated code for.
+  irb->SetInsertPoint(entry_block);
+  llvm::Value* llvm_tupdesc = irb->CreateLoad(
+      codegen_utils->GetPointerToMember(
+          llvm_slot, &TupleTableSlot::tts_tupleDescriptor));
+  llvm::Value* llvm_tupdesc_natts = irb->CreateLoad(
+      codegen_utils->GetPointerToMember(llvm_tupdesc, &tupleDesc::natts));
+  llvm::Value* llvm_nvalid_ptr = codegen_utils->GetPointerToMember(
+      llvm_slot, &TupleTableSlot::PRIVATE_tts_nvalid);
+  irb->CreateCondBr(
+      irb->CreateAnd(
+          irb->CreateICmpEQ(llvm_tupdesc_natts,
+                            codegen_utils->GetConstant<int>(tupdesc->natts)),
+          irb->CreateICmpEQ(irb->CreateLoad(llvm_nvalid_ptr),
+                            codegen_utils->GetConstant<int>(0))),
+      prologue_block /* true */,
+      fallback_block /* false */);
+
+  // Prologue block
+  // --------------
+  // The caller guarantees that the slot holds a heap tuple.
+  irb->SetInsertPoint(prologue_block);
+  llvm::Value* llvm_heaptuple = irb->CreateLoad(
+      codegen_utils->GetPointerToMember(
+          llvm_slot, &TupleTableSlot::PRIVATE_tts_heaptuple));
+  llvm::Value* llvm_tup = irb->CreateLoad(
+      codegen_utils->GetPointerToMember(llvm_heaptuple,
+                                        &HeapTupleData::t_data));
+  llvm::Value* llvm_infomask = irb->CreateLoad(
+      codegen_utils->GetPointerToMember(llvm_tup,
+                                        &HeapTupleHeaderData::t_infomask));
+  llvm::Value* llvm_hoff = irb->CreateLoad(
+      codegen_utils->GetPointerToMember(llvm_tup,
+                                        &HeapTupleHeaderData::t_hoff));
+
+  DeformState state;
+  state.function = slot_deform_tuple_func;
+  state.natts = llvm_natts;
+  // tp = (char *) tup + tup->t_hoff
+  state.tuple_data = irb->CreateInBoundsGEP(
+      llvm_tup, {irb->CreateZExt(llvm_hoff, codegen_utils->GetType<int64>())});
+  // bp = tup->t_bits
+  state.null_bitmap = irb->CreateBitCast(
+      codegen_utils->GetPointerToMember(llvm_tup,
+                                        &HeapTupleHeaderData::t_bits),
+      codegen_utils->GetType<int8*>());
+  state.values = irb->CreateLoad(codegen_utils->GetPointerToMember(
+      llvm_slot, &TupleTableSlot::PRIVATE_tts_values));
+  state.isnull = irb->CreateLoad(codegen_utils->GetPointerToMember(
+      llvm_slot, &TupleTableSlot::PRIVATE_tts_isnull));
+  state.done_block = done_block;
+
+  // The loop state to save in the slot, coming from every place where the
+  // unrolled loops stop.
+  irb->SetInsertPoint(done_block);
+  state.attnum = irb->CreatePHI(codegen_utils->GetType<int>(), 0, "attnum");
+  state.off = irb->CreatePHI(codegen_utils->GetType<long>(), 0,  // NOLINT
+                             "off");
+  state.slow = irb->CreatePHI(codegen_utils->GetType<bool>(), 0, "slow");
+
+  // if (hasnulls) ...
+  irb->SetInsertPoint(prologue_block);
+  irb->CreateCondBr(
+      irb->CreateICmpNE(
+          irb->CreateAnd(llvm_infomask,
+                         codegen_utils->GetConstant<uint16>(HEAP_HASNULL)),
+          codegen_utils->GetConstant<uint16>(0)),
+      has_nulls_block /* true */,
+      no_nulls_block /* false */);
+
+  irb->SetInsertPoint(no_nulls_block);
+  GenerateDeformAttributes(codegen_utils, state, false);
+
+  irb->SetInsertPoint(has_nulls_block);
+  GenerateDeformAttributes(codegen_utils, state, true);
+
+  // Done block
+  // ----------
+  // Save state for next execution
+  irb->SetInsertPoint(done_block);
+  irb->CreateStore(state.attnum, llvm_nvalid_ptr);
+  irb->CreateStore(state.off, codegen_utils->GetPointerToMember(
+      llvm_slot, &TupleTableSlot::PRIVATE_tts_off));
+  irb->CreateStore(state.slow, codegen_utils->GetPointerToMember(
+      llvm_slot, &TupleTableSlot::PRIVATE_tts_slow));
+  irb->CreateRetVoid();
+
+  // Fall back block
+  // ---------------
+  irb->SetInsertPoint(fallback_block);
+  codegen_utils->CreateFallback<SlotDeformTupleFn>(
+      codegen_utils->RegisterExternalFunction(GetRegularFuncPointer()),
+      slot_deform_tuple_func);
+  return true;
+}
+
+void SlotDeformTupleCodegen::GenerateDeformAttributes(
+    gpcodegen::CodegenUtils* codegen_utils,
+    const DeformState& state,
+    bool may_have_nulls) {
+  auto irb = codegen_utils->ir_builder();
+  TupleDesc tupdesc = slot_->tts_tupleDescriptor;
+  const std::string suffix = may_have_nulls ? "_nulls" : "";
+
+  // The offset stays a constant for as long as it does not depend on the
+  // data, so that the IRBuilder folds all computations on it.
+  llvm::Value* off = codegen_utils->GetConstant<long>(0);  // NOLINT
+  llvm::Value* slow = codegen_utils->GetConstant<bool>(false);
+
+  for (int attnum = 0; attnum < tupdesc->natts; ++attnum) {
+    Form_pg_attribute thisatt = tupdesc->attrs[attnum];
+    const std::string name_suffix = std::to_string(attnum) + suffix;
+    llvm::Value* llvm_attnum = codegen_utils->GetConstant<int>(attnum);
+
+    // Stop once all the attributes the caller asked for are deformed
+    llvm::BasicBlock* attribute_block = codegen_utils->CreateBasicBlock(
+        "attribute_" + name_suffix, state.function);
+    state.attnum->addIncoming(llvm_attnum, irb->GetInsertBlock());
+    state.off->addIncoming(off, irb->GetInsertBlock());
+    state.slow->addIncoming(slow, irb->GetInsertBlock());
+    irb->CreateCondBr(irb->CreateICmpSLT(llvm_attnum, state.natts),
+                      attribute_block /* true */,
+                      state.done_block /* false */);
+    irb->SetInsertPoint(attribute_block);
+
+    llvm::Value* llvm_values_ptr =
+        irb->CreateInBoundsGEP(state.values, {llvm_attnum});
+    llvm::Value* llvm_isnull_ptr =
+        irb->CreateInBoundsGEP(state.isnull, {llvm_attnum});
+
+    llvm::BasicBlock* is_null_block = nullptr;
+    llvm::BasicBlock* next_attribute_block = nullptr;
+    llvm::Value* off_if_null = off;
+    if (may_have_nulls && !thisatt->attnotnull) {
+      is_null_block = codegen_utils->CreateBasicBlock(
+          "is_null_" + name_suffix, state.function);
+      llvm::BasicBlock* is_not_null_block = codegen_utils->CreateBasicBlock(
+          "is_not_null_" + name_suffix, state.function);
+      next_attribute_block = codegen_utils->CreateBasicBlock(
+          "next_attribute_" + name_suffix, state.function);
+
+      // att_isnull(attnum, bp), with the byte and bit folded to constants
+      llvm::Value* llvm_null_bits = irb->CreateLoad(irb->CreateInBoundsGEP(
+          state.null_bitmap, {codegen_utils->GetConstant<int>(attnum >> 3)}));
+      irb->CreateCondBr(
+          irb->CreateICmpEQ(
+              irb->CreateAnd(llvm_null_bits,
+                             codegen_utils->GetConstant<int8>(
+                                 1 << (attnum & 0x07))),
+              codegen_utils->GetConstant<int8>(0)),
+          is_null_block /* true */,
+          is_not_null_block /* false */);
+
+      irb->SetInsertPoint(is_null_block);
+      irb->CreateStore(codegen_utils->GetConstant<Datum>(0), llvm_values_ptr);
+      irb->CreateStore(codegen_utils->GetConstant<bool>(true),
+                       llvm_isnull_ptr);
+      irb->CreateBr(next_attribute_block);
+
+      irb->SetInsertPoint(is_not_null_block);
+    }
+
+    // A varlena may or may not be aligned: if there is something that looks
+    // like a padding byte we align, otherwise it is a 1-byte header.
+    if (-1 != thisatt->attlen) {
+      off = CreateAttAlign(codegen_utils, off, thisatt->attalign);
+    } else if (!IsAttAligned(off, thisatt->attalign)) {
+      llvm::Value* llvm_first_byte = irb->CreateLoad(
+          irb->CreateInBoundsGEP(state.tuple_data, {off}));
+      off = irb->CreateSelect(
+          irb->CreateICmpEQ(llvm_first_byte,
+                            codegen_utils->GetConstant<int8>(0)),
+          CreateAttAlign(codegen_utils, off, thisatt->attalign),
+          off);
+    }
+
+    // values[attnum] = fetchatt(thisatt, tp + off)
+    llvm::Value* llvm_attptr = irb->CreateInBoundsGEP(state.tuple_data, {off});
+    llvm::Value* llvm_value = nullptr;
+    if (thisatt->attbyval) {
+      llvm::Type* value_type = nullptr;
+      switch (thisatt->attlen) {
+        case sizeof(char):
+          value_type = codegen_utils->GetType<int8>();
+          break;
+        case sizeof(int16):
+          value_type = codegen_utils->GetType<int16>();
+          break;
+        case sizeof(int32):
+          value_type = codegen_utils->GetType<int32>();
+          break;
+        default:
+          assert(sizeof(Datum) == thisatt->attlen);
+          value_type = codegen_utils->GetType<int64>();
+          break;
+      }
+      // Like the Int32GetDatum() etc. casts, sign-extend the value
+      llvm_value = irb->CreateSExtOrTrunc(
+          irb->CreateLoad(irb->CreateBitCast(llvm_attptr,
+                                             value_type->getPointerTo())),
+          codegen_utils->GetType<Datum>());
+    } else {
+      llvm_value = irb->CreatePtrToInt(llvm_attptr,
+                                       codegen_utils->GetType<Datum>());
+    }
+    irb->CreateStore(llvm_value, llvm_values_ptr);
+    irb->CreateStore(codegen_utils->GetConstant<bool>(false), llvm_isnull_ptr);
+
+    // off = att_addlength(off, thisatt->attlen, PointerGetDatum(tp + off))
+    if (thisatt->attlen > 0) {
+      off = irb->CreateAdd(off, codegen_utils->GetConstant<long>(  // NOLINT
+          thisatt->attlen));
+    } else if (-1 == thisatt->attlen) {
+      off = irb->CreateAdd(off, GenerateVarsizeAny(
+          codegen_utils, state.function, llvm_attptr));
+    } else {
+      llvm::Function* llvm_strlen =
+          codegen_utils->RegisterExternalFunction(strlen);
+      off = irb->CreateAdd(
+          off,
+          irb->CreateAdd(
+              irb->CreateZExtOrTrunc(
+                  irb->CreateCall(llvm_strlen, {llvm_attptr}),
+                  codegen_utils->GetType<long>()),  // NOLINT
+              codegen_utils->GetConstant<long>(1)));  // NOLINT
+    }
+    if (thisatt->attlen < 0) {
+      slow = codegen_utils->GetConstant<bool>(true);
+    }
+
+    if (nullptr != is_null_block) {
+      // A null attribute takes no space, but we can't use constant offsets
+      // anymore
+      llvm::BasicBlock* is_not_null_end_block = irb->GetInsertBlock();
+      irb->CreateBr(next_attribute_block);
+      irb->SetInsertPoint(next_attribute_block);
+
+      llvm::PHINode* off_phi = irb->CreatePHI(
+          codegen_utils->GetType<long>(), 2);  // NOLINT
+      off_phi->addIncoming(off_if_null, is_null_block);
+      off_phi->addIncoming(off, is_not_null_end_block);
+      off = off_phi;
+
+      llvm::PHINode* slow_phi = irb->CreatePHI(
+          codegen_utils->GetType<bool>(), 2);
+      slow_phi->addIncoming(codegen_utils->GetConstant<bool>(true),
+                            is_null_block);
+      slow_phi->addIncoming(slow, is_not_null_end_block);
+      slow = slow_phi;
+    }
+  }
+
+  // All attributes are deformed
+  state.attnum->addIncoming(codegen_utils->GetConstant<int>(tupdesc->natts),
+                            irb->GetInsertBlock());
+  state.off->addIncoming(off, irb->GetInsertBlock());
+  state.slow->addIncoming(slow, irb->GetInsertBlock());
+  irb->CreateBr(state.done_block);
+}
+
+llvm::Value* SlotDeformTupleCodegen::GenerateVarsizeAny(
+    gpcodegen::CodegenUtils* codegen_utils,
+    llvm::Function* function,
+    llvm::Value* attptr) {
+  auto irb = codegen_utils->ir_builder();
+
+  llvm::BasicBlock* varsize_1b_e_block = codegen_utils->CreateBasicBlock(
+      "varsize_1b_e", function);
+  llvm::BasicBlock* varsize_not_1b_e_block = codegen_utils->CreateBasicBlock(
+      "varsize_not_1b_e", function);
+  llvm::BasicBlock* varsize_1b_block = codegen_utils->CreateBasicBlock(
+      "varsize_1b", function);
+  llvm::BasicBlock* varsize_4b_block = codegen_utils->CreateBasicBlock(
+      "varsize_4b", function);
+  llvm::BasicBlock* varsize_done_block = codegen_utils->CreateBasicBlock(
+      "varsize_done", function);
+
+  // VARATT_IS_1B_E(PTR)
+  llvm::Value* llvm_header = irb->CreateLoad(attptr);
+  irb->CreateCondBr(
+      irb->CreateICmpEQ(llvm_header,
+                        codegen_utils->GetConstant<uint8>(0x80)),
+      varsize_1b_e_block /* true */,
+      varsize_not_1b_e_block /* false */);
+
+  // VARSIZE_1B_E(PTR)
+  irb->SetInsertPoint(varsize_1b_e_block);
+  llvm::Value* llvm_size_1b_e = codegen_utils->GetConstant<long>(  // NOLINT
+      VARHDRSZ_EXTERNAL + sizeof(struct varatt_external));
+  irb->CreateBr(varsize_done_block);
+
+  // VARATT_IS_1B(PTR)
+  irb->SetInsertPoint(varsize_not_1b_e_block);
+  irb->CreateCondBr(
+      irb->CreateICmpNE(
+          irb->CreateAnd(llvm_header,
+                         codegen_utils->GetConstant<uint8>(0x80)),
+          codegen_utils->GetConstant<uint8>(0)),
+      varsize_1b_block /* true */,
+      varsize_4b_block /* false */);
+
+  // VARSIZE_1B(PTR)
+  irb->SetInsertPoint(varsize_1b_block);
+  llvm::Value* llvm_size_1b = irb->CreateZExt(
+      irb->CreateAnd(llvm_header, codegen_utils->GetConstant<uint8>(0x7F)),
+      codegen_utils->GetType<long>());  // NOLINT
+  irb->CreateBr(varsize_done_block);
+
+  // VARSIZE_4B(PTR): ntohl(va_header) & 0x3FFFFFFF
+  irb->SetInsertPoint(varsize_4b_block);
+  llvm::Value* llvm_header_4b = irb->CreateLoad(irb->CreateBitCast(
+      attptr, codegen_utils->GetType<uint32*>()));
+#ifndef WORDS_BIGENDIAN
+  llvm::Function* llvm_bswap = llvm::Intrinsic::getDeclaration(
+      codegen_utils->module(), llvm::Intrinsic::bswap,
+      {codegen_utils->GetType<uint32>()});
+  llvm_header_4b = irb->CreateCall(llvm_bswap, {llvm_header_4b});
+#endif
+  llvm::Value* llvm_size_4b = irb->CreateZExt(
+      irb->CreateAnd(llvm_header_4b,
+                     codegen_utils->GetConstant<uint32>(0x3FFFFFFF)),
+      codegen_utils->GetType<long>());  // NOLINT
+  irb->CreateBr(varsize_done_block);
+
+  irb->SetInsertPoint(varsize_done_block);
+  llvm::PHINode* llvm_size = irb->CreatePHI(
+      codegen_utils->GetType<long>(), 3);  // NOLINT
+  llvm_size->addIncoming(llvm_size_1b_e, varsize_1b_e_block);
+  llvm_size->addIncoming(llvm_size_1b, varsize_1b_block);
+  llvm_size->addIncoming(llvm_size_4b, varsize_4b_block);
+  return llvm_size;
+}
+
+bool SlotDeformTupleCodegen::GetFingerprint(std::string* fingerprint) const {
+  TupleDesc tupdesc = slot_->tts_tupleDescriptor;
+  if (NULL == tupdesc) {
+    return false;
+  }
+
+  fingerprint->assign(kSlotDeformTupleNamePrefix);
+  fingerprint->append(":" + std::to_string(tupdesc->natts));
+  for (int attnum = 0; attnum < tupdesc->natts; ++attnum) {
+    Form_pg_attribute thisatt = tupdesc->attrs[attnum];
+    fingerprint->append(
+        ":" + std::to_string(thisatt->attlen) +
+        "/" + std::string(1, thisatt->attalign) +
+        "/" + std::to_string(thisatt->attbyval) +
+        "/" + std::to_string(thisatt->attnotnull));
+  }
+  return true;
+}
+
+bool SlotDeformTupleCodegen::GenerateCodeInternal(
+    CodegenUtils* codegen_utils) {
+  bool isGenerated = GenerateSlotDeformTuple(codegen_utils);
+
+  if (isGenerated) {
+    elog(DEBUG1, "slot_deform_tuple was generated successfully!");
+    return true;
+  } else {
+    elog(DEBUG1, "slot_deform_tuple generation failed!");
+    return false;
+  }
+}
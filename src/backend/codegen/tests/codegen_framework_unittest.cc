@@ -13,6 +13,7 @@
 //---------------------------------------------------------------------------
 
 #include <cassert>
+#include <chrono>  // NOLINT(build/c++11)
 #include <cmath>
 #include <cstddef>
 #include <cstdint>
@@ -22,6 +23,7 @@
 #include <limits>
 #include <memory>
 #include <string>
+#include <thread>  // NOLINT(build/c++11)
 #include <type_traits>
 #include <utility>
 #include <vector>
@@ -46,6 +48,7 @@
 
 #include "codegen/utils/codegen_utils.h"
 #include "codegen/utils/utility.h"
+#include "codegen/codegen_cache.h"
 #include "codegen/codegen_manager.h"
 #include "codegen/codegen_wrapper.h"
 #include "codegen/codegen_interface.h"
@@ -99,6 +102,22 @@ class SumCodeGenerator : public BaseCodegen<SumFunc> {
   static constexpr char kAddFuncNamePrefix[] = "SumFunc";
 };
 
+class CacheableSumCodeGenerator : public SumCodeGenerator {
+ public:
+  explicit CacheableSumCodeGenerator(SumFunc regular_func_ptr,
+                                     SumFunc* ptr_to_regular_func_ptr) :
+                                     SumCodeGenerator(regular_func_ptr,
+                                                      ptr_to_regular_func_ptr) {
+  }
+
+  virtual ~CacheableSumCodeGenerator() = default;
+
+  bool GetFingerprint(std::string* fingerprint) const final {
+    fingerprint->assign(kAddFuncNamePrefix);
+    return true;
+  }
+};
+
 class FailingCodeGenerator : public BaseCodegen<SumFunc> {
  public:
   explicit FailingCodeGenerator(SumFunc regular_func_ptr,
@@ -228,6 +247,23 @@ TEST_F(CodegenManagerTest, GenerateCodeTest) {
   EXPECT_EQ(2, manager_->GenerateCode());
 }
 
+TEST_F(CodegenManagerTest, InstructionLimitTest) {
+  // Each SumCodeGenerator generates an add and a return instruction, so only
+  // the first one fits in the limit.
+  manager_->SetInstructionLimit(3);
+  sum_func_ptr = nullptr;
+  EnrollCodegen<SumCodeGenerator, SumFunc>(SumFuncRegular, &sum_func_ptr);
+  SumFunc second_sum_func_ptr = nullptr;
+  EnrollCodegen<SumCodeGenerator, SumFunc>(SumFuncRegular,
+                                           &second_sum_func_ptr);
+  EXPECT_EQ(1, manager_->GenerateCode());
+
+  ASSERT_TRUE(manager_->PrepareGeneratedFunctions());
+  ASSERT_TRUE(SumFuncRegular != sum_func_ptr);
+  ASSERT_TRUE(SumFuncRegular == second_sum_func_ptr);
+  EXPECT_EQ(3, sum_func_ptr(1, 2));
+}
+
 TEST_F(CodegenManagerTest, PrepareGeneratedFunctionsNoCompilationErrorTest) {
   // Test if generation happens successfully
   sum_func_ptr = nullptr;
@@ -268,6 +304,93 @@ TEST_F(CodegenManagerTest, PrepareGeneratedFunctionsNoCompilationErrorTest) {
   ASSERT_TRUE(SumFuncRegular == failed_func_ptr);
 }
 
+TEST_F(CodegenManagerTest, PrepareGeneratedFunctionsAsyncTest) {
+  sum_func_ptr = nullptr;
+  EnrollCodegen<SumCodeGenerator, SumFunc>(SumFuncRegular, &sum_func_ptr);
+  failed_func_ptr = nullptr;
+  EnrollCodegen<FailingCodeGenerator, SumFunc>(SumFuncRegular,
+                                               &failed_func_ptr);
+  EXPECT_EQ(1, manager_->GenerateCode());
+
+  // Nothing is compiled yet, so nothing is swapped in on return
+  EXPECT_EQ(0, manager_->PrepareGeneratedFunctionsAsync());
+
+  // The regular function can be called while compilation is in progress
+  EXPECT_EQ(3, __atomic_load_n(&sum_func_ptr, __ATOMIC_ACQUIRE)(1, 2));
+
+  // Wait for the background thread to swap in the generated function
+  for (int i = 0; i < 1000; ++i) {
+    if (SumFuncRegular != __atomic_load_n(&sum_func_ptr, __ATOMIC_ACQUIRE)) {
+      break;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  ASSERT_TRUE(SumFuncRegular !=
+              __atomic_load_n(&sum_func_ptr, __ATOMIC_ACQUIRE));
+  EXPECT_EQ(3, sum_func_ptr(1, 2));
+
+  // Code generation failed, so the pointer does not change.
+  ASSERT_TRUE(SumFuncRegular == failed_func_ptr);
+
+  manager_.reset(nullptr);
+  ASSERT_TRUE(SumFuncRegular == sum_func_ptr);
+}
+
+TEST_F(CodegenManagerTest, CancelAsyncCompilationsTest) {
+  sum_func_ptr = nullptr;
+  EnrollCodegen<SumCodeGenerator, SumFunc>(SumFuncRegular, &sum_func_ptr);
+  EXPECT_EQ(1, manager_->GenerateCode());
+
+  EXPECT_EQ(0, manager_->PrepareGeneratedFunctionsAsync());
+  CodegenManager::CancelAsyncCompilations();
+
+  // Once cancelled, the generated function may only have been swapped in
+  // before the cancellation, and the pointer no longer changes.
+  SumFunc func_after_cancel = __atomic_load_n(&sum_func_ptr,
+                                              __ATOMIC_ACQUIRE);
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  EXPECT_TRUE(func_after_cancel ==
+              __atomic_load_n(&sum_func_ptr, __ATOMIC_ACQUIRE));
+  EXPECT_EQ(3, func_after_cancel(1, 2));
+
+  // Destroying a manager whose compilation may still run must be safe
+  manager_.reset(nullptr);
+  ASSERT_TRUE(SumFuncRegular == sum_func_ptr);
+}
+
+TEST_F(CodegenManagerTest, DetachGeneratorTest) {
+  sum_func_ptr = nullptr;
+  EnrollCodegen<SumCodeGenerator, SumFunc>(SumFuncRegular, &sum_func_ptr);
+  SumFunc detached_func_ptr = nullptr;
+  SumCodeGenerator* detached = new SumCodeGenerator(SumFuncRegular,
+                                                    &detached_func_ptr);
+  ASSERT_TRUE(manager_->EnrollCodeGenerator(
+      CodegenFuncLifespan_Parameter_Invariant, detached));
+  EXPECT_EQ(2, manager_->GenerateCode());
+
+  EXPECT_EQ(0, manager_->PrepareGeneratedFunctionsAsync());
+  CodegenManager::DetachGenerator(detached);
+  SumFunc func_after_detach = __atomic_load_n(&detached_func_ptr,
+                                              __ATOMIC_ACQUIRE);
+
+  // The generator that is still attached is swapped in
+  for (int i = 0; i < 1000; ++i) {
+    if (SumFuncRegular != __atomic_load_n(&sum_func_ptr, __ATOMIC_ACQUIRE)) {
+      break;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  ASSERT_TRUE(SumFuncRegular !=
+              __atomic_load_n(&sum_func_ptr, __ATOMIC_ACQUIRE));
+
+  // The detached one no longer changes
+  EXPECT_TRUE(func_after_detach ==
+              __atomic_load_n(&detached_func_ptr, __ATOMIC_ACQUIRE));
+
+  manager_.reset(nullptr);
+  ASSERT_TRUE(SumFuncRegular == sum_func_ptr);
+}
+
 TEST_F(CodegenManagerTest, UnCompilableFailedGenerationTest) {
   // Test if generation happens successfully
   sum_func_ptr = nullptr;
@@ -385,6 +508,41 @@ TEST_F(CodegenManagerTest, ResetTest) {
   ASSERT_TRUE(SumFuncRegular == sum_func_ptr);
 }
 
+TEST_F(CodegenManagerTest, CodegenCacheTest) {
+  CodegenCache* cache = CodegenCache::GetInstance();
+  cache->SetCapacity(1);
+  CodegenCache::Stats initial_stats = cache->GetStats();
+
+  // First manager generates and compiles the function, and caches it
+  sum_func_ptr = nullptr;
+  EnrollCodegen<CacheableSumCodeGenerator, SumFunc>(SumFuncRegular,
+                                                    &sum_func_ptr);
+  EXPECT_EQ(1, manager_->GenerateCode());
+  EXPECT_EQ(1, manager_->PrepareGeneratedFunctions());
+  ASSERT_TRUE(SumFuncRegular != sum_func_ptr);
+  SumFunc compiled_func_ptr = sum_func_ptr;
+  EXPECT_EQ(initial_stats.misses + 1, cache->GetStats().misses);
+  EXPECT_EQ(1, cache->GetStats().entries);
+
+  // Destroying the manager restores the regular version
+  manager_.reset(new CodegenManager("CodegenManagerTest"));
+  ASSERT_TRUE(SumFuncRegular == sum_func_ptr);
+
+  // Second manager reuses the cached function without generating code
+  EnrollCodegen<CacheableSumCodeGenerator, SumFunc>(SumFuncRegular,
+                                                    &sum_func_ptr);
+  EXPECT_EQ(1, manager_->GenerateCode());
+  EXPECT_EQ(1, manager_->PrepareGeneratedFunctions());
+  EXPECT_EQ(initial_stats.hits + 1, cache->GetStats().hits);
+  ASSERT_TRUE(compiled_func_ptr == sum_func_ptr);
+
+  // Evicting the entry does not release the module while it is in use
+  cache->SetCapacity(0);
+  EXPECT_EQ(initial_stats.evictions + 1, cache->GetStats().evictions);
+  EXPECT_EQ(0, cache->GetStats().entries);
+  EXPECT_EQ(5, sum_func_ptr(2, 3));
+}
+
 }  // namespace gpcodegen
 
 int main(int argc, char **argv) {
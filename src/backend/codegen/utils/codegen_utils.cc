@@ -84,6 +84,7 @@ constexpr char CodegenUtils::kExternalFunctionNamePrefix[];
 CodegenUtils::CodegenUtils(llvm::StringRef module_name)
     : ir_builder_(context_),
       module_(new llvm::Module(module_name, context_)),
+      object_cache_(nullptr),
       external_variable_counter_(0),
       external_function_counter_(0) {
 }
@@ -224,6 +225,10 @@ bool CodegenUtils::PrepareForExecution(const OptimizationLevel cpu_opt_level,
     return false;
   }
 
+  if (object_cache_ != nullptr) {
+    engine_->setObjectCache(object_cache_);
+  }
+
   // Add auxiliary modules generated by companion tools to the ExecutionEngine.
   for (std::unique_ptr<llvm::Module>& auxiliary_module : auxiliary_modules_) {
     engine_->addModule(std::move(auxiliary_module));
@@ -260,6 +265,10 @@ bool CodegenUtils::PrepareForExecution(const OptimizationLevel cpu_opt_level,
         external_function.second);
   }
 
+  // Compile everything now rather than on the first function lookup, so that
+  // all of the expensive work happens in this call.
+  engine_->finalizeObject();
+
   return true;
 }
 
@@ -298,7 +298,15 @@ ExplainOneQuery(Query *query, ExplainStmt *stmt, const char *queryString,
 	//							None_Receiver, params,
 	//							stmt->analyze);
 
-	ExplainOnePlan(plan, stmt, queryString, params, tstate);
+	/* the optimizer records what planning the query took */
+	if (plan->planGen == PLANGEN_OPTIMIZER)
+	{
+		OptimizerStats optstats = OptimizerQueryStats;
+
+		ExplainOnePlan(plan, stmt, queryString, params, &optstats, tstate);
+	}
+	else
+		ExplainOnePlan(plan, stmt, queryString, params, NULL, tstate);
 }
 
 /*
@@ -338,6 +346,9 @@ ExplainOneUtility(Node *utilityStmt, ExplainStmt *stmt,
  * query.  This is different from pre-8.3 behavior but seems more useful than
  * not running the query.  No cursor will be created, however.
  *
+ * optstats, if not NULL, is what it took the optimizer to produce the plan,
+ * shown by EXPLAIN ANALYZE.
+ *
  * This is exported because it's called back from prepare.c in the
  * EXPLAIN EXECUTE case, and because an index advisor plugin would need
  * to call it.
@@ -346,6 +357,7 @@ void
 ExplainOnePlan(PlannedStmt *plannedstmt, ExplainStmt *stmt,
 			   const char *queryString,
 			   ParamListInfo params,
+			   const OptimizerStats *optstats,
 			   TupOutputState *tstate)
 {
 	QueryDesc  *queryDesc;
@@ -671,6 +683,30 @@ ExplainOnePlan(PlannedStmt *plannedstmt, ExplainStmt *stmt,
     }
 #endif
 
+    /*
+     * Display where the time planning the query went.
+     */
+	if (stmt->analyze && optstats != NULL)
+	{
+		if (optstats->cachedPlans > 0)
+			appendStringInfo(&buf, "Optimizer plan cache: hit, plan copy %.3f ms\n",
+							 optstats->copyPlanTime);
+		else
+			appendStringInfo(&buf, "Optimizer time: query translation %.3f ms, "
+							 "search %.3f ms, plan translation %.3f ms\n",
+							 optstats->translateQueryTime,
+							 optstats->searchTime,
+							 optstats->translatePlanTime);
+		appendStringInfo(&buf, "Optimizer metadata: " INT64_FORMAT " objects fetched "
+						 "in %.3f ms, " INT64_FORMAT " from the shared cache\n",
+						 optstats->mdFetches,
+						 optstats->mdFetchTime,
+						 optstats->mdSharedHits);
+		if (optstats->peakMemory > 0)
+			appendStringInfo(&buf, "Optimizer memory: " INT64_FORMAT "K bytes\n",
+							 (optstats->peakMemory + 1023) / 1024);
+	}
+
     /*
      * Display final elapsed time.
      */
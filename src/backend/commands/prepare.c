@@ -683,7 +683,7 @@ ExplainExecuteQuery(ExecuteStmt *execstmt, ExplainStmt *stmt,
 			}
 
 
-			ExplainOnePlan(pstmt, stmt, "EXECUTE", paramLI, tstate);
+			ExplainOnePlan(pstmt, stmt, "EXECUTE", paramLI, NULL, tstate);
 		}
 
 		/* No need for CommandCounterIncrement, as ExplainOnePlan did it */
@@ -103,7 +103,10 @@ static void *readHashEntry(AggState *aggstate,
 						   int32 *p_input_size);
 
 /* Methods for hash table */
-static uint32 calc_hash_value(AggState* aggstate, TupleTableSlot *inputslot);
+#ifndef USE_CODEGEN
+static
+#endif
+uint32 calc_hash_value(AggState* aggstate, TupleTableSlot *inputslot);
 static void spill_hash_table(AggState *aggstate);
 static void init_agg_hash_iter(HashAggTable* ht);
 static HashAggEntry *lookup_agg_hash_entry(AggState *aggstate, void *input_record,
@@ -821,7 +824,7 @@ agg_hash_initial_pass(AggState *aggstate)
 
 		/* Find or (if there's room) build a hash table entry for the
 		 * input tuple's group. */
-		hashkey = calc_hash_value(aggstate, outerslot);
+		hashkey = call_calc_hash_value(aggstate, outerslot);
 		entry = lookup_agg_hash_entry(aggstate, (void *)outerslot,
 									  INPUT_RECORD_TUPLE, 0, hashkey, 0, &isNew);
 		
@@ -868,7 +871,7 @@ agg_hash_initial_pass(AggState *aggstate)
 		}
 			
 		/* Advance the aggregates */
-		advance_aggregates(aggstate, hashtable->groupaggs->aggs, &(aggstate->mem_manager));
+		call_advance_aggregates(aggstate, hashtable->groupaggs->aggs, &(aggstate->mem_manager));
 		
 		hashtable->num_tuples++;
 
@@ -1803,8 +1803,20 @@ InitPlan(QueryDesc *queryDesc, int eflags)
 	 * Initialize the private state information for all the nodes in the query
 	 * tree.  This opens files, allocates storage and leaves us ready to start
 	 * processing tuples.
+	 *
+	 * All nodes enroll their code generators into a single query-scoped
+	 * manager, so the whole plan tree is compiled as one LLVM module rather
+	 * than paying module setup and optimization once per node.
 	 */
-	planstate = ExecInitNode(plannedstmt->planTree, estate, eflags);
+	estate->CodegenManager = CreateExecutorCodegenManager("execMain-InitPlan");
+	START_CODE_GENERATOR_MANAGER(estate->CodegenManager);
+	{
+		planstate = ExecInitNode(plannedstmt->planTree, estate, eflags);
+
+		CodeGeneratorManagerGenerateCode(estate->CodegenManager);
+		CodeGeneratorManagerPrepareGeneratedFunctions(estate->CodegenManager);
+	}
+	END_CODE_GENERATOR_MANAGER();
 
 	queryDesc->planstate = planstate;
 
@@ -2414,6 +2426,13 @@ ExecEndPlan(PlanState *planstate, EState *estate)
 	if (planstate != NULL)
 		ExecEndNode(planstate);
 
+	/*
+	 * Release the query's generated code only after all nodes are shut down,
+	 * since their function pointers may still refer into the module.
+	 */
+	DestroyExecutorCodegenManager(estate->CodegenManager);
+	estate->CodegenManager = NULL;
+
 	ExecDropTupleTable(estate->es_tupleTable, true);
 	estate->es_tupleTable = NULL;
 
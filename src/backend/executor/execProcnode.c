@@ -123,6 +123,7 @@
 #include "executor/nodePartitionSelector.h"
 #include "miscadmin.h"
 #include "tcop/tcopprot.h"
+#include "utils/guc.h"
 #include "cdb/cdbvars.h"
 
 #include "cdb/ml_ipc.h" /* interconnect context */
@@ -190,6 +191,30 @@ setSubplanSliceId(SubPlan *subplan, EState *estate)
 }
 
 
+#ifdef USE_CODEGEN
+/*
+ * ExecCodegenIsWorthwhile
+ *   Whether the optimizer expects a plan node to process at least
+ *   codegen_min_plan_rows rows.
+ *
+ * The quals and projections of scans and joins are evaluated on every input
+ * row, not just on the rows that pass, so the estimates of the children
+ * count as well.
+ */
+static bool
+ExecCodegenIsWorthwhile(Plan *node)
+{
+	double		rows = node->plan_rows;
+
+	if (node->lefttree != NULL)
+		rows = Max(rows, node->lefttree->plan_rows);
+	if (node->righttree != NULL)
+		rows = Max(rows, node->righttree->plan_rows);
+
+	return rows >= codegen_min_plan_rows;
+}
+#endif   /* USE_CODEGEN */
+
 /* ------------------------------------------------------------------------
  *		ExecInitNode
  *
@@ -223,13 +248,6 @@ ExecInitNode(Plan *node, EState *estate, int eflags)
 
 	MemoryAccount* curMemoryAccount = NULL;
 
-	StringInfo codegenManagerName = makeStringInfo();
-	appendStringInfo(codegenManagerName, "%s-%d-%d", "execProcnode", node->plan_node_id, node->type);
-	void* CodegenManager = CodeGeneratorManagerCreate(codegenManagerName->data);
-	START_CODE_GENERATOR_MANAGER(CodegenManager);
-	{
-
-
 	/*
 	 * Is current plan node supposed to execute in current slice?
 	 * Special case is sending motion node, which is supposed to
@@ -242,6 +260,18 @@ ExecInitNode(Plan *node, EState *estate, int eflags)
 	bool isAlienPlanNode = !((currentSliceId == origSliceIdInPlan) ||
 			(nodeTag(node) == T_Motion && ((Motion*)node)->motionID == currentSliceId));
 
+	/*
+	 * Let this node enroll code generators only if it is expected to process
+	 * enough rows to pay for compiling them. Its children decide for
+	 * themselves, and restore this node's choice when they are done.
+	 */
+#ifdef USE_CODEGEN
+	void	   *savedCodegenManager = GetActiveCodeGeneratorManager();
+
+	SetActiveCodeGeneratorManager(ExecCodegenIsWorthwhile(node) ?
+								  estate->CodegenManager : NULL);
+#endif
+
 	/*
 	 * As of 03/28/2014, there is no support for BitmapTableScan
 	 * in the planner/optimizer. Therefore, for testing purpose
@@ -757,12 +787,11 @@ ExecInitNode(Plan *node, EState *estate, int eflags)
 	          &result->ExecQual_gen_info.ExecQual_fn, result);
 
 		SAVE_EXECUTOR_MEMORY_ACCOUNT(result, curMemoryAccount);
-		result->CodegenManager = CodegenManager;
-		CodeGeneratorManagerGenerateCode(CodegenManager);
-		CodeGeneratorManagerPrepareGeneratedFunctions(CodegenManager);
-	}
 	}
-	END_CODE_GENERATOR_MANAGER();
+
+#ifdef USE_CODEGEN
+	SetActiveCodeGeneratorManager(savedCodegenManager);
+#endif
 
 	return result;
 }
@@ -820,8 +849,6 @@ ExecProcNode(PlanState *node)
 {
 	TupleTableSlot *result = NULL;
 
-	START_CODE_GENERATOR_MANAGER(node->CodegenManager);
-	{
 	START_MEMORY_ACCOUNT(node->plan->memoryAccount);
 	{
 
@@ -1241,8 +1268,6 @@ Exec_Jmp_Done:
 
 	}
 	END_MEMORY_ACCOUNT();
-	}
-	END_CODE_GENERATOR_MANAGER();
 	return result;
 }
 
@@ -1761,13 +1786,6 @@ ExecEndNode(PlanState *node)
 			break;
 	}
 
-	/*
-	 * if codegen guc is true, then assert if CodegenManager is NULL
-	 */
-	AssertImply(codegen, NULL != node->CodegenManager);
-	CodeGeneratorManagerDestroy(node->CodegenManager);
-	node->CodegenManager = NULL;
-
 	estate->currentSliceIdInPlan = origSliceIdInPlan;
 	estate->currentExecutingSliceId = origExecutingSliceId;
 }
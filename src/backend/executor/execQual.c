@@ -5875,6 +5875,20 @@ ExecVariableList(ProjectionInfo *projInfo,
 	int		   *varNumbers = projInfo->pi_varNumbers;
 	int			i;
 
+	/*
+	 * Force extraction of all input values that we'll need, so that memtuples
+	 * are deformed in one go rather than one memtuple_getattr() at a time.
+	 */
+	if (projInfo->pi_lastInnerVar > 0)
+		slot_getsomeattrs(econtext->ecxt_innertuple,
+						  projInfo->pi_lastInnerVar);
+	if (projInfo->pi_lastOuterVar > 0)
+		slot_getsomeattrs(econtext->ecxt_outertuple,
+						  projInfo->pi_lastOuterVar);
+	if (projInfo->pi_lastScanVar > 0)
+		slot_getsomeattrs(econtext->ecxt_scantuple,
+						  projInfo->pi_lastScanVar);
+
 	/*
 	 * Assign to result by direct extraction of fields from source slots ... a
 	 * mite ugly, but fast ...
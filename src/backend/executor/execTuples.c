@@ -130,6 +130,12 @@ void init_slot(TupleTableSlot *slot, TupleDesc tupdesc)
 	slot->tts_tupleDescriptor = tupdesc;
 	slot->tts_mcxt = CurrentMemoryContext;
 	slot->tts_buffer = InvalidBuffer;
+
+#ifdef USE_CODEGEN
+	/* Set the default locations for slot_deform_tuple and slot_deform_memtuple */
+	slot->slot_deform_tuple_gen_info.slot_deform_tuple_fn = slot_deform_tuple;
+	slot->slot_deform_memtuple_gen_info.slot_deform_memtuple_fn = slot_deform_memtuple;
+#endif
 }
 
 static void cleanup_slot(TupleTableSlot *slot)
@@ -347,6 +353,20 @@ ExecSetSlotDescriptor(TupleTableSlot *slot,		/* slot to change */
 	slot->tts_tupleDescriptor = tupdesc;
 	PinTupleDesc(tupdesc);
 
+#ifdef USE_CODEGEN
+	/*
+	 * Any generated deformer was specialized on the old descriptor. One that
+	 * is still being compiled in the background must not be swapped in
+	 * later either; the other generators of the query are left alone.
+	 */
+	if (NULL != slot->slot_deform_tuple_gen_info.code_generator)
+		CodeGeneratorDetach(slot->slot_deform_tuple_gen_info.code_generator);
+	if (NULL != slot->slot_deform_memtuple_gen_info.code_generator)
+		CodeGeneratorDetach(slot->slot_deform_memtuple_gen_info.code_generator);
+	slot->slot_deform_tuple_gen_info.slot_deform_tuple_fn = slot_deform_tuple;
+	slot->slot_deform_memtuple_gen_info.slot_deform_memtuple_fn = slot_deform_memtuple;
+#endif
+
 	{
 		/*
 		 * Allocate Datum/isnull arrays of the appropriate size.  These must have
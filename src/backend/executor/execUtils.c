@@ -47,6 +47,7 @@
 #include "access/genam.h"
 #include "access/heapam.h"
 #include "access/appendonlywriter.h"
+#include "access/xact.h"
 #include "catalog/index.h"
 #include "executor/execdebug.h"
 #include "parser/parsetree.h"
@@ -308,6 +309,8 @@ InternalCreateExecutorState(MemoryContext qcontext, bool is_subquery)
 	estate->subplanLevel = 0;
 	estate->rootSliceId = 0;
 
+	estate->CodegenManager = NULL;
+
 	/*
 	 * Return the executor state structure
 	 */
@@ -338,6 +341,123 @@ freeDynamicTableScanInfo(DynamicTableScanInfo *scanInfo)
 	pfree(scanInfo);
 }
 
+/*
+ * Code generator managers of executor states that are not freed yet, each
+ * with the subtransaction that created it. An ERROR skips ExecEndPlan()
+ * and FreeExecutorState(), so the managers of the failed queries, with
+ * their LLVM modules, are destroyed at abort instead.
+ */
+typedef struct ExecCodegenManager
+{
+	void	   *manager;
+	SubTransactionId subid;
+} ExecCodegenManager;
+
+static List *execCodegenManagers = NIL;
+
+/* ----------------
+ *      CreateExecutorCodegenManager
+ *
+ *      Create the code generator manager of an EState, or return NULL if
+ *      code generation is off.
+ * ----------------
+ */
+void *
+CreateExecutorCodegenManager(const char *module_name)
+{
+	void	   *manager = CodeGeneratorManagerCreate(module_name);
+	MemoryContext oldcontext;
+	ExecCodegenManager *entry;
+
+	if (manager == NULL)
+		return NULL;
+
+	oldcontext = MemoryContextSwitchTo(TopMemoryContext);
+	PG_TRY();
+	{
+		entry = (ExecCodegenManager *) palloc(sizeof(ExecCodegenManager));
+		entry->manager = manager;
+		entry->subid = GetCurrentSubTransactionId();
+		execCodegenManagers = lappend(execCodegenManagers, entry);
+	}
+	PG_CATCH();
+	{
+		CodeGeneratorManagerDestroy(manager);
+		PG_RE_THROW();
+	}
+	PG_END_TRY();
+	MemoryContextSwitchTo(oldcontext);
+
+	return manager;
+}
+
+/* ----------------
+ *      DestroyExecutorCodegenManager
+ *
+ *      Destroy a manager created by CreateExecutorCodegenManager().
+ *
+ * A manager that is no longer in the list was destroyed at abort already;
+ * AtAbort_Portals() still ends the executor of a failed portal afterwards,
+ * with the EState pointing at it.
+ * ----------------
+ */
+void
+DestroyExecutorCodegenManager(void *manager)
+{
+	ListCell   *lc;
+
+	if (manager == NULL)
+		return;
+
+	foreach(lc, execCodegenManagers)
+	{
+		ExecCodegenManager *entry = (ExecCodegenManager *) lfirst(lc);
+
+		if (entry->manager == manager)
+		{
+			execCodegenManagers = list_delete_ptr(execCodegenManagers, entry);
+			pfree(entry);
+			CodeGeneratorManagerDestroy(manager);
+			return;
+		}
+	}
+}
+
+/* ----------------
+ *      AtAbort_ExecutorCodegenManagers
+ *
+ *      Destroy the managers left over by the queries of an aborting
+ *      transaction (mySubid is InvalidSubTransactionId), or of an aborting
+ *      subtransaction and its children.
+ *
+ * This must run before the memory of the executor states is released, as
+ * destroying a manager resets the function pointers of its callers to the
+ * regular functions.
+ * ----------------
+ */
+void
+AtAbort_ExecutorCodegenManagers(SubTransactionId mySubid)
+{
+	ListCell   *lc;
+	ListCell   *prev = NULL;
+	ListCell   *next;
+
+	for (lc = list_head(execCodegenManagers); lc != NULL; lc = next)
+	{
+		ExecCodegenManager *entry = (ExecCodegenManager *) lfirst(lc);
+
+		next = lnext(lc);
+		if (mySubid == InvalidSubTransactionId || entry->subid >= mySubid)
+		{
+			execCodegenManagers = list_delete_cell(execCodegenManagers, lc, prev);
+			CodeGeneratorManagerDestroy(entry->manager);
+			pfree(entry);
+		}
+		else
+			prev = lc;
+	}
+}
+
 /* ----------------
  *      FreeExecutorState
  *
@@ -400,6 +520,16 @@ FreeExecutorState(EState *estate)
 		estate->dynamicTableScanInfo = NULL;
 	}
 
+	/*
+	 * Release the query's code generator manager if ExecEndPlan did not get
+	 * a chance to (e.g. the plan was never run to completion).
+	 */
+	if (estate->CodegenManager != NULL)
+	{
+		DestroyExecutorCodegenManager(estate->CodegenManager);
+		estate->CodegenManager = NULL;
+	}
+
 	/*
 	 * Greenplum: release partition-related resources (esp. TupleDesc ref counts).
 	 */
@@ -1023,6 +1153,9 @@ ExecAssignScanType(ScanState *scanstate, TupleDesc tupDesc)
 	TupleTableSlot *slot = scanstate->ss_ScanTupleSlot;
 
 	ExecSetSlotDescriptor(slot, tupDesc);
+
+	enroll_slot_deform_tuple_codegen(slot_deform_tuple,
+			&slot->slot_deform_tuple_gen_info.slot_deform_tuple_fn, slot);
 }
 
 /* ----------------
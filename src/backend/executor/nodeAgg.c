@@ -515,117 +515,128 @@ advance_aggregates(AggState *aggstate, AggStatePerGroup pergroup,
 	int			aggno;
 
 	for (aggno = 0; aggno < aggstate->numaggs; aggno++)
+		advance_aggregate(aggstate, pergroup, aggno, mem_manager);
+}
+
+/*
+ * Advance aggregate number aggno for one input tuple, as advance_aggregates.
+ *
+ * This is also called by the generated version of advance_aggregates for
+ * the aggregates whose transition it does not inline.
+ */
+void
+advance_aggregate(AggState *aggstate, AggStatePerGroup pergroup, int aggno,
+				  MemoryManagerContainer *mem_manager)
+{
+	Datum value;
+	bool isnull;
+	AggStatePerAgg peraggstate = &aggstate->peragg[aggno];
+	AggStatePerGroup pergroupstate = &pergroup[aggno];
+	Aggref	   *aggref = peraggstate->aggref;
+	PercentileExpr *perc = peraggstate->perc;
+	int			i;
+	TupleTableSlot *slot;
+	int nargs;
+
+	if (aggref)
+		nargs = list_length(aggref->args);
+	else
 	{
-		Datum value;
-		bool isnull;
-		AggStatePerAgg peraggstate = &aggstate->peragg[aggno];
-		AggStatePerGroup pergroupstate = &pergroup[aggno];
-		Aggref	   *aggref = peraggstate->aggref;
-		PercentileExpr *perc = peraggstate->perc;
-		int			i;
-		TupleTableSlot *slot;
-		int nargs;
+		Assert (perc);
+		nargs = list_length(perc->args);
+	}
 
-		if (aggref)
-			nargs = list_length(aggref->args);
-		else
-		{
-			Assert (perc);
-			nargs = list_length(perc->args);
-		}
+	/* Evaluate the current input expressions for this aggregate */
+	slot = ExecProject(peraggstate->evalproj, NULL);
+	slot_getallattrs(slot);	
+	
+	if (peraggstate->numSortCols > 0)
+	{
+		/* DISTINCT and/or ORDER BY case */
+		Assert(slot->PRIVATE_tts_nvalid == peraggstate->numInputs);
+		Assert(!perc);
 
-		/* Evaluate the current input expressions for this aggregate */
-		slot = ExecProject(peraggstate->evalproj, NULL);
-		slot_getallattrs(slot);	
-		
-		if (peraggstate->numSortCols > 0)
+		/*
+		 * If the transfn is strict, we want to check for nullity before
+		 * storing the row in the sorter, to save space if there are a lot
+		 * of nulls.  Note that we must only check numArguments columns,
+		 * not numInputs, since nullity in columns used only for sorting
+		 * is not relevant here.
+		 */
+		if (peraggstate->transfn.fn_strict)
 		{
-			/* DISTINCT and/or ORDER BY case */
-			Assert(slot->PRIVATE_tts_nvalid == peraggstate->numInputs);
-			Assert(!perc);
-
-			/*
-			 * If the transfn is strict, we want to check for nullity before
-			 * storing the row in the sorter, to save space if there are a lot
-			 * of nulls.  Note that we must only check numArguments columns,
-			 * not numInputs, since nullity in columns used only for sorting
-			 * is not relevant here.
-			 */
-			if (peraggstate->transfn.fn_strict)
+			for (i = 0; i < nargs; i++)
 			{
-				for (i = 0; i < nargs; i++)
-				{
-					value = slot_getattr(slot, i+1, &isnull);
-					
-					if (isnull)
-						break; /* arg loop */
-				}
-				if (i < nargs)
-					continue; /* aggno loop */
-			}
-			
-			/* OK, put the tuple into the tuplesort object */
-			if (peraggstate->numInputs == 1)
-			{
-				value = slot_getattr(slot, 1, &isnull);
+				value = slot_getattr(slot, i+1, &isnull);
 				
-				if (gp_enable_mk_sort)
-					tuplesort_putdatum_mk((Tuplesortstate_mk*) peraggstate->sortstate,
-									   value,
-									   isnull);
-				else 
-					tuplesort_putdatum((Tuplesortstate*) peraggstate->sortstate,
-									   value,
-									   isnull);
+				if (isnull)
+					break; /* arg loop */
 			}
-			else
+			if (i < nargs)
+				return;
+		}
+		
+		/* OK, put the tuple into the tuplesort object */
+		if (peraggstate->numInputs == 1)
+		{
+			value = slot_getattr(slot, 1, &isnull);
+			
+			if (gp_enable_mk_sort)
+				tuplesort_putdatum_mk((Tuplesortstate_mk*) peraggstate->sortstate,
+								   value,
+								   isnull);
+			else 
+				tuplesort_putdatum((Tuplesortstate*) peraggstate->sortstate,
+								   value,
+								   isnull);
+		}
+		else
+		{
+			if (gp_enable_mk_sort)
+				tuplesort_puttupleslot_mk((Tuplesortstate_mk*) peraggstate->sortstate, 
+										  slot);
+			else 
+				tuplesort_puttupleslot((Tuplesortstate*) peraggstate->sortstate, 
+									   slot);
+		}
+	}
+	else
+	{
+		/* We can apply the transition function immediately */
+		FunctionCallInfoData fcinfo;
+		
+		/* Load values into fcinfo */
+		/* Start from 1, since the 0th arg will be the transition value */
+		Assert(slot->PRIVATE_tts_nvalid >= nargs);
+		if (aggref)
+		{
+			for (i = 0; i < nargs; i++)
 			{
-				if (gp_enable_mk_sort)
-					tuplesort_puttupleslot_mk((Tuplesortstate_mk*) peraggstate->sortstate, 
-											  slot);
-				else 
-					tuplesort_puttupleslot((Tuplesortstate*) peraggstate->sortstate, 
-										   slot);
+				fcinfo.arg[i + 1] = slot_getattr(slot, i+1, &isnull);
+				fcinfo.argnull[i + 1] = isnull;
 			}
+
 		}
 		else
 		{
-			/* We can apply the transition function immediately */
-			FunctionCallInfoData fcinfo;
-			
-			/* Load values into fcinfo */
-			/* Start from 1, since the 0th arg will be the transition value */
-			Assert(slot->PRIVATE_tts_nvalid >= nargs);
-			if (aggref)
-			{
-				for (i = 0; i < nargs; i++)
-				{
-					fcinfo.arg[i + 1] = slot_getattr(slot, i+1, &isnull);
-					fcinfo.argnull[i + 1] = isnull;
-				}
+			/*
+			 * In case of percentile functions, put everything into
+			 * fcinfo's argument since there should be the required
+			 * attributes as arguments in the tuple.
+			 */
+			int		natts;
 
-			}
-			else
+			Assert(perc);
+			natts = slot->tts_tupleDescriptor->natts;
+			for (i = 0; i < natts; i++)
 			{
-				/*
-				 * In case of percentile functions, put everything into
-				 * fcinfo's argument since there should be the required
-				 * attributes as arguments in the tuple.
-				 */
-				int		natts;
-
-				Assert(perc);
-				natts = slot->tts_tupleDescriptor->natts;
-				for (i = 0; i < natts; i++)
-				{
-					fcinfo.arg[i + 1] = slot_getattr(slot, i + 1, &isnull);
-					fcinfo.argnull[i + 1] = isnull;
-				}
+				fcinfo.arg[i + 1] = slot_getattr(slot, i + 1, &isnull);
+				fcinfo.argnull[i + 1] = isnull;
 			}
-			advance_transition_function(aggstate, peraggstate, pergroupstate,
-										&fcinfo, mem_manager);
 		}
-	} /* aggno loop */
+		advance_transition_function(aggstate, peraggstate, pergroupstate,
+									&fcinfo, mem_manager);
+	}
 }
 
 /*
@@ -1322,7 +1333,7 @@ agg_retrieve_direct(AggState *aggstate)
 					if (!aggstate->has_partial_agg)
 					{
 						has_partial_agg = true;
-						advance_aggregates(aggstate, pergroup, &(aggstate->mem_manager));
+						call_advance_aggregates(aggstate, pergroup, &(aggstate->mem_manager));
 					}
 
 					/* Reset per-input-tuple context after each tuple */
@@ -1398,7 +1409,7 @@ agg_retrieve_direct(AggState *aggstate)
 							{
 								has_partial_agg = true;
 								tmpcontext->ecxt_outertuple = outerslot;
-								advance_aggregates(aggstate, pergroup, &(aggstate->mem_manager));
+								call_advance_aggregates(aggstate, pergroup, &(aggstate->mem_manager));
 							}
 							
 							passthru_ready = true;
@@ -1438,7 +1449,7 @@ agg_retrieve_direct(AggState *aggstate)
 			ResetExprContext(tmpcontext);
 			tmpcontext->ecxt_outertuple = outerslot;
 
-			advance_aggregates(aggstate, perpassthru, &(aggstate->mem_manager));
+			call_advance_aggregates(aggstate, perpassthru, &(aggstate->mem_manager));
 		}
 		
 
@@ -1727,6 +1738,13 @@ ExecInitAgg(Agg *node, EState *estate, int eflags)
 	aggstate->grp_firstTuple = NULL;
 	aggstate->hashtable = NULL;
 
+#ifdef USE_CODEGEN
+	/* Set the default location for advance_aggregates */
+	aggstate->advance_aggregates_gen_info.advance_aggregates_fn = advance_aggregates;
+	/* Set the default location for calc_hash_value */
+	aggstate->calc_hash_value_gen_info.calc_hash_value_fn = calc_hash_value;
+#endif
+
 	/*
 	 * Create expression contexts.	We need two, one for per-input-tuple
 	 * processing and one for per-output-tuple processing.	We cheat a little
@@ -2431,6 +2449,17 @@ ExecInitAgg(Agg *node, EState *estate, int eflags)
 	aggstate->mem_manager.manager = aggstate->aggcontext;
 	aggstate->mem_manager.realloc_ratio = 1;
 
+	enroll_advance_aggregates_codegen(advance_aggregates,
+			&aggstate->advance_aggregates_gen_info.advance_aggregates_fn,
+			aggstate);
+
+	if (node->aggstrategy == AGG_HASHED)
+	{
+		enroll_calc_hash_value_codegen(calc_hash_value,
+				&aggstate->calc_hash_value_gen_info.calc_hash_value_fn,
+				aggstate);
+	}
+
 	initGpmonPktForAgg((Plan *)node, &aggstate->ss.ps.gpmon_pkt, estate);
 	
 	return aggstate;
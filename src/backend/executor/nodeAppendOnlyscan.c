@@ -161,6 +161,11 @@ ExecInitAppendOnlyScan(AppendOnlyScan *node, EState *estate, int eflags)
 	currentRelation = ExecOpenScanRelation(estate, node->scan.scanrelid);	
 	appendonlystate->ss.ss_currentRelation = currentRelation;
 	ExecAssignScanType(&appendonlystate->ss, RelationGetDescr(currentRelation));
+
+	/* Append-only rows are stored as memtuples */
+	enroll_slot_deform_memtuple_codegen(slot_deform_memtuple,
+			&appendonlystate->ss.ss_ScanTupleSlot->slot_deform_memtuple_gen_info.slot_deform_memtuple_fn,
+			appendonlystate->ss.ss_ScanTupleSlot);
 	
 	/*
 	 * Initialize result tuple type and projection info.
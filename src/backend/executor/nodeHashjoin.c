@@ -451,6 +451,10 @@ ExecInitHashJoin(HashJoin *node, EState *estate, int eflags)
 	hjstate = makeNode(HashJoinState);
 	hjstate->js.ps.plan = (Plan *) node;
 	hjstate->js.ps.state = estate;
+#ifdef USE_CODEGEN
+	/* Set the default location for ExecHashGetHashValue */
+	hjstate->ExecHashGetHashValue_gen_info.ExecHashGetHashValue_fn = ExecHashGetHashValue;
+#endif
 
 	/*
 	 * Miscellaneous initialization
@@ -608,6 +612,13 @@ ExecInitHashJoin(HashJoin *node, EState *estate, int eflags)
 	/* child Hash node needs to evaluate inner hash keys, too */
 	((HashState *) innerPlanState(hjstate))->hashkeys = rclauses;
 
+	enroll_ExecHashGetHashValue_codegen(ExecHashGetHashValue,
+			&hjstate->ExecHashGetHashValue_gen_info.ExecHashGetHashValue_fn,
+			hjstate, lclauses, hoperators, true);
+	enroll_ExecHashGetHashValue_codegen(ExecHashGetHashValue,
+			&((HashState *) innerPlanState(hjstate))->ExecHashGetHashValue_gen_info.ExecHashGetHashValue_fn,
+			((HashState *) innerPlanState(hjstate)), rclauses, hoperators, false);
+
 	hjstate->js.ps.ps_OuterTupleSlot = NULL;
 	hjstate->hj_NeedNewOuter = true;
 	hjstate->hj_MatchedOuter = false;
@@ -723,7 +734,7 @@ ExecHashJoinOuterGetTuple(PlanState *outerNode,
 					(hjstate->js.jointype == JOIN_LASJ) ||
 					(hjstate->js.jointype == JOIN_LASJ_NOTIN) ||
 					hjstate->hj_nonequijoin;
-			if (ExecHashGetHashValue(hashState, hashtable, econtext,
+			if (call_ExecHashGetHashValue(hjstate, hashState, hashtable, econtext,
 						hjstate->hj_OuterHashKeys,
 						true,
 						keep_nulls,
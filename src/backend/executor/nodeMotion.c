@@ -113,7 +113,10 @@ static void execMotionSortedReceiverFirstTime(MotionState * node);
 
 static int
 CdbMergeComparator(void *lhs, void *rhs, void *context);
-static uint32 evalHashKey(ExprContext *econtext, List *hashkeys, List *hashtypes, CdbHash * h);
+#ifndef USE_CODEGEN
+static
+#endif
+uint32 evalHashKey(ExprContext *econtext, List *hashkeys, List *hashtypes, CdbHash * h);
 
 static void doSendEndOfStream(Motion * motion, MotionState * node);
 static void doSendTuple(Motion * motion, MotionState * node, TupleTableSlot *outerTupleSlot);
@@ -942,6 +945,10 @@ ExecInitMotion(Motion * node, EState *estate, int eflags)
 	motionstate->stopRequested = false;
 	motionstate->hashExpr = NULL;
 	motionstate->cdbhash = NULL;
+#ifdef USE_CODEGEN
+	/* Set the default location for evalHashKey */
+	motionstate->evalHashKey_gen_info.evalHashKey_fn = evalHashKey;
+#endif
 
     /* Look up the sending gang's slice table entry. */
     sendSlice = (Slice *)list_nth(sliceTable->slices, node->motionID);
@@ -1073,6 +1080,11 @@ ExecInitMotion(Motion * node, EState *estate, int eflags)
 	 */
 	ExecAssignResultTypeFromTL(&motionstate->ps);
 	motionstate->ps.ps_ProjInfo = NULL;
+
+	/* Received tuples are memtuples */
+	enroll_slot_deform_memtuple_codegen(slot_deform_memtuple,
+			&motionstate->ps.ps_ResultTupleSlot->slot_deform_memtuple_gen_info.slot_deform_memtuple_fn,
+			motionstate->ps.ps_ResultTupleSlot);
 	tupDesc = ExecGetResultType(&motionstate->ps);
 
 	/* Set up motion send data structures */
@@ -1092,6 +1104,13 @@ ExecInitMotion(Motion * node, EState *estate, int eflags)
 		 * Create hash API reference
 		 */
 		motionstate->cdbhash = makeCdbHash(node->numOutputSegs, HASH_FNV_1);
+
+		if (nkeys > 0)
+		{
+			enroll_evalHashKey_codegen(evalHashKey,
+					&motionstate->evalHashKey_gen_info.evalHashKey_fn,
+					motionstate, motionstate->hashExpr, node->hashDataTypes);
+		}
     }
 
 	/* Merge Receive: Set up the key comparator and priority queue. */
@@ -1597,7 +1616,7 @@ doSendTuple(Motion * motion, MotionState * node, TupleTableSlot *outerTupleSlot)
 
 		Assert(node->cdbhash->numsegs == motion->numOutputSegs);
 		
-		hval = evalHashKey(econtext, node->hashExpr,
+		hval = call_evalHashKey(node, econtext, node->hashExpr,
 				motion->hashDataTypes, node->cdbhash);
 
 		Assert(hval < getgpsegmentCount() && "redistribute destination outside segment array");
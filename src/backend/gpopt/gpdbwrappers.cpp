@@ -91,6 +91,7 @@
 #define ALLOW_rel_is_leaf_partition
 #define ALLOW_rel_partition_get_master
 #define ALLOW_BuildLogicalIndexInfo
+#define ALLOW_GetLogicalIndexInfo
 #define ALLOW_get_parts
 #define ALLOW_countLeafPartTables
 #define ALLOW_get_relation_keys
@@ -2521,7 +2522,7 @@ gpdb::Plgidx
 	GP_WRAP_START;
 	{
 		/* catalog tables: pg_partition, pg_partition_rule, pg_index */
-		return BuildLogicalIndexInfo(oid);
+		return GetLogicalIndexInfo(oid);
 	}
 	GP_WRAP_END;
 	return NULL;
@@ -3047,11 +3048,16 @@ gpdb::UlLeafPartitions
  * We register a callback to a cache on all the catalog tables that contain
  * information that's contained in the ORCA metadata cache.
 
- * There is no fine-grained mechanism in the metadata cache for invalidating
- * individual entries ATM, so we just blow the whole cache whenever anything
- * changes. The callback simply increments a counter. Whenever we start
- * planning a query, we check the counter to see if it has changed since the
- * last planned query, and reset the whole cache if it has.
+ * Syscache invalidation events don't tell which object changed, so for those
+ * we just blow the whole cache. The syscache callback simply increments a
+ * counter. Whenever we start planning a query, we check the counter to see if
+ * it has changed since the last planned query, and reset the whole cache if
+ * it has.
+ *
+ * Relcache invalidation events carry the OID of the relation, so the relcache
+ * callback only remembers the relation, and the optimizer evicts the entries
+ * of just that relation (see PlMDCacheInvalidatedRels()). That's what keeps
+ * TRUNCATE and ANALYZE of one table from wiping the cache of every session.
  *
  * To make sure we've covered all catalog tables that contain information
  * that's stored in the metadata cache, there are "catalog tables: xxx"
@@ -3064,12 +3070,43 @@ static bool mdcache_invalidation_counter_registered = false;
 static int64 mdcache_invalidation_counter = 0;
 static int64 last_mdcache_invalidation_counter = 0;
 
+/*
+ * Relations invalidated since the last call of PlMDCacheInvalidatedRels().
+ * Invalidation callbacks must not allocate memory, so they are kept in a
+ * fixed-size array. If more relations are invalidated between two queries,
+ * we fall back to resetting the whole cache.
+ */
+#define MDCACHE_MAX_INVALIDATED_RELS 64
+static Oid	mdcache_invalidated_rels[MDCACHE_MAX_INVALIDATED_RELS];
+static int	mdcache_num_invalidated_rels = 0;
+
 static void
 mdcache_invalidation_counter_callback(Datum arg, Oid relid)
 {
 	mdcache_invalidation_counter++;
 }
 
+static void
+mdcache_relcache_invalidation_callback(Datum arg, Oid relid)
+{
+	int			i;
+
+	/* InvalidOid means that the whole relcache was reset */
+	if (!OidIsValid(relid) ||
+		mdcache_num_invalidated_rels == MDCACHE_MAX_INVALIDATED_RELS)
+	{
+		mdcache_invalidation_counter++;
+		return;
+	}
+
+	for (i = 0; i < mdcache_num_invalidated_rels; i++)
+	{
+		if (mdcache_invalidated_rels[i] == relid)
+			return;
+	}
+	mdcache_invalidated_rels[mdcache_num_invalidated_rels++] = relid;
+}
+
 static void
 register_mdcache_invalidation_callbacks(void)
 {
@@ -3083,7 +3120,6 @@ register_mdcache_invalidation_callbacks(void)
 		OPFAMILYOID,		/* pg_opfamily */
 		PARTOID,			/* pg_partition */
 		PARTRULEOID,		/* pg_partition_rule */
-		STATRELATT,			/* pg_statistics */
 		TYPEOID,			/* pg_type */
 		PROCOID,			/* pg_proc */
 
@@ -3105,6 +3141,14 @@ register_mdcache_invalidation_callbacks(void)
 		/* pg_index */
 		/* pg_trigger */
 
+		/*
+		 * Any change to a pg_statistic row, including a direct UPDATE of the
+		 * catalog, also sends a relcache invalidation of its starelid (see
+		 * PrepareForTupleInvalidation()), so the statistics of a relation
+		 * are evicted along with it, without resetting the whole cache.
+		 */
+		/* pg_statistic */
+
 		/*
 		 * pg_exttable is only updated when a new external table is dropped/created,
 		 * which will trigger a relcache invalidation event.
@@ -3134,7 +3178,7 @@ register_mdcache_invalidation_callbacks(void)
 	}
 
 	/* also register the relcache callback */
-	CacheRegisterRelcacheCallback(&mdcache_invalidation_counter_callback,
+	CacheRegisterRelcacheCallback(&mdcache_relcache_invalidation_callback,
 								  (Datum) 0);
 }
 
@@ -3157,6 +3201,8 @@ gpdb::FMDCacheNeedsReset
 		else
 		{
 			last_mdcache_invalidation_counter = mdcache_invalidation_counter;
+			/* the relations go along with the rest of the cache */
+			mdcache_num_invalidated_rels = 0;
 			return true;
 		}
 	}
@@ -3165,4 +3211,230 @@ gpdb::FMDCacheNeedsReset
 	return true;
 }
 
+// Relations invalidated since the last call, whose metadata cache entries
+// need to be evicted
+List *
+gpdb::PlMDCacheInvalidatedRels
+		(
+			void
+		)
+{
+	GP_WRAP_START;
+	{
+		List	   *plRelOids = NIL;
+		int			i;
+
+		for (i = 0; i < mdcache_num_invalidated_rels; i++)
+			plRelOids = lappend_oid(plRelOids, mdcache_invalidated_rels[i]);
+		mdcache_num_invalidated_rels = 0;
+
+		return plRelOids;
+	}
+	GP_WRAP_END;
+
+	return NIL;
+}
+
+// Can the current transaction use the metadata cache shared by all backends?
+bool
+gpdb::FMDSharedCacheEnabled
+		(
+			void
+		)
+{
+	GP_WRAP_START;
+	{
+		if (!MDSharedCacheIsEnabled())
+			return false;
+
+		/*
+		 * A transaction that changed the catalogs must neither see the
+		 * objects of other backends, nor share its own.
+		 */
+		return !CacheInvalidationsPending();
+	}
+	GP_WRAP_END;
+
+	return false;
+}
+
+// Can the metadata objects of the given relation be shared by all backends?
+// Only those of relations that are entirely described by their own relcache
+// entry can.
+bool
+gpdb::FMDSharedCacheRelation
+		(
+			Oid relid
+		)
+{
+	GP_WRAP_START;
+	{
+		/* catalog tables: relcache, pg_partition, pg_partition_rule */
+		Relation	rel;
+		bool		fDistributed;
+		PartStatus	partStatus;
+
+		if (relid < FirstNormalObjectId)
+			return false;
+
+		rel = RelationIdGetRelation(relid);
+		if (NULL == rel)
+			return false;
+
+		/*
+		 * The row count of relations that are not distributed is estimated
+		 * from their size on disk, which doesn't send invalidations.
+		 */
+		fDistributed = RELKIND_RELATION == rel->rd_rel->relkind &&
+			NULL != rel->rd_cdbpolicy &&
+			POLICYTYPE_PARTITIONED == rel->rd_cdbpolicy->ptype;
+		RelationClose(rel);
+		if (!fDistributed)
+			return false;
+
+		/* The metadata of a partitioned table includes that of its parts */
+		partStatus = rel_part_status(relid);
+		return PART_STATUS_ROOT != partStatus &&
+			PART_STATUS_INTERIOR != partStatus;
+	}
+	GP_WRAP_END;
+
+	return false;
+}
+
+// Version of the shared metadata objects of the given relation. Accepts
+// invalidation messages afterwards, so that whatever is translated from the
+// relcache is at least as recent as the version.
+uint64
+gpdb::UllMDSharedCacheVersion
+		(
+			Oid relid
+		)
+{
+	GP_WRAP_START;
+	{
+		uint64		ullVersion = MDSharedCacheGetVersion(relid);
+
+		AcceptInvalidationMessages();
+
+		return ullVersion;
+	}
+	GP_WRAP_END;
+
+	return 0;
+}
+
+// Shared serialized metadata object with the given id and version, or NULL
+char *
+gpdb::SzMDSharedCacheLookup
+		(
+			const char *szMDId,
+			uint64 ullVersion
+		)
+{
+	GP_WRAP_START;
+	{
+		return MDSharedCacheLookup(szMDId, ullVersion);
+	}
+	GP_WRAP_END;
+
+	return NULL;
+}
+
+// Share a serialized metadata object under the given id and version
+void
+gpdb::MDSharedCacheStore
+		(
+			const char *szMDId,
+			uint64 ullVersion,
+			const char *szObject
+		)
+{
+	GP_WRAP_START;
+	{
+		::MDSharedCacheStore(szMDId, ullVersion, szObject);
+		return;
+	}
+	GP_WRAP_END;
+}
+
+// Key to cache the plan of the given query under, or NULL if the plan must
+// not be cached
+char *
+gpdb::SzOptPlanCacheKey
+		(
+			Query *pquery
+		)
+{
+	GP_WRAP_START;
+	{
+		return OptPlanCacheKey(pquery);
+	}
+	GP_WRAP_END;
+
+	return NULL;
+}
+
+// Copy of the plan cached under the given key, or NULL
+PlannedStmt *
+gpdb::PplstmtOptPlanCacheLookup
+		(
+			const char *szKey
+		)
+{
+	GP_WRAP_START;
+	{
+		return OptPlanCacheLookup(szKey);
+	}
+	GP_WRAP_END;
+
+	return NULL;
+}
+
+// Cache a copy of the given plan under the given key
+void
+gpdb::OptPlanCacheStore
+		(
+			const char *szKey,
+			PlannedStmt *pplstmt
+		)
+{
+	GP_WRAP_START;
+	{
+		::OptPlanCacheStore(szKey, pplstmt);
+		return;
+	}
+	GP_WRAP_END;
+}
+
+// Drop all cached plans
+void
+gpdb::OptPlanCacheReset
+		(
+			void
+		)
+{
+	GP_WRAP_START;
+	{
+		::OptPlanCacheReset();
+		return;
+	}
+	GP_WRAP_END;
+}
+
+// Drop the cached plans that depend on any of the given relations
+void
+gpdb::OptPlanCacheEvictRelations
+		(
+			List *plRelOids
+		)
+{
+	GP_WRAP_START;
+	{
+		::OptPlanCacheEvictRelations(plRelOids);
+		return;
+	}
+	GP_WRAP_END;
+}
+
 // EOF
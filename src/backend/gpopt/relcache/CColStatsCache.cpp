@@ -0,0 +1,156 @@
+//---------------------------------------------------------------------------
+//	Greenplum Database
+//	Copyright (C) 2016 Pivotal Software, Inc.
+//
+//	@filename:
+//		CColStatsCache.cpp
+//
+//	@doc:
+//		Implementation of the cache of transformed column statistics
+//
+//	@test:
+//
+//
+//---------------------------------------------------------------------------
+
+#include "postgres.h"
+#include "gpopt/relcache/CColStatsCache.h"
+
+#include "gpos/memory/CMemoryPoolManager.h"
+
+using namespace gpos;
+using namespace gpdxl;
+
+// maximum number of columns cached
+const ULONG CColStatsCache::m_ulMaxEntries = 4096;
+
+// memory pool of the cache
+IMemoryPool *CColStatsCache::m_pmp = NULL;
+
+// cached statistics
+CColStatsCache::HMColStats *CColStatsCache::m_phmcolstats = NULL;
+
+// number of cached columns
+ULONG CColStatsCache::m_ulEntries = 0;
+
+//---------------------------------------------------------------------------
+//	@function:
+//		CColStatsCache::Pmp
+//
+//	@doc:
+//		Memory pool to allocate the statistics to insert in, created on
+//		first use
+//
+//---------------------------------------------------------------------------
+IMemoryPool *
+CColStatsCache::Pmp()
+{
+	if (NULL == m_pmp)
+	{
+		m_pmp = CMemoryPoolManager::Pmpm()->PmpCreate(CMemoryPoolManager::EatTracker, false /*fThreadSafe*/, ULLONG_MAX);
+		m_phmcolstats = GPOS_NEW(m_pmp) HMColStats(m_pmp);
+		m_ulEntries = 0;
+	}
+
+	return m_pmp;
+}
+
+//---------------------------------------------------------------------------
+//	@function:
+//		CColStatsCache::Pcsentry
+//
+//	@doc:
+//		Cached statistics of the given version, or NULL
+//
+//---------------------------------------------------------------------------
+const CColStatsCacheEntry *
+CColStatsCache::Pcsentry
+	(
+	const CColStatsKey &cskey
+	)
+{
+	if (NULL == m_phmcolstats)
+	{
+		return NULL;
+	}
+
+	return m_phmcolstats->PtLookup(&cskey);
+}
+
+//---------------------------------------------------------------------------
+//	@function:
+//		CColStatsCache::PcsentryInsert
+//
+//	@doc:
+//		Cache the statistics of the given version, and return the cached
+//		entry. The entry must have been allocated in the memory pool of the
+//		cache
+//
+//---------------------------------------------------------------------------
+const CColStatsCacheEntry *
+CColStatsCache::PcsentryInsert
+	(
+	const CColStatsKey &cskey,
+	CColStatsCacheEntry *pcsentry
+	)
+{
+	IMemoryPool *pmp = Pmp();
+
+	CColStatsKey *pcskey = GPOS_NEW(pmp) CColStatsKey(cskey);
+	if (m_phmcolstats->FInsert(pcskey, pcsentry))
+	{
+		m_ulEntries++;
+		return pcsentry;
+	}
+
+	// already cached
+	GPOS_DELETE(pcskey);
+	pcsentry->Release();
+
+	return m_phmcolstats->PtLookup(&cskey);
+}
+
+//---------------------------------------------------------------------------
+//	@function:
+//		CColStatsCache::Reset
+//
+//	@doc:
+//		Drop all cached statistics, along with the memory pool
+//
+//---------------------------------------------------------------------------
+void
+CColStatsCache::Reset()
+{
+	if (NULL == m_pmp)
+	{
+		return;
+	}
+
+	m_phmcolstats->Release();
+	m_phmcolstats = NULL;
+	m_ulEntries = 0;
+
+	CMemoryPoolManager::Pmpm()->Destroy(m_pmp);
+	m_pmp = NULL;
+}
+
+//---------------------------------------------------------------------------
+//	@function:
+//		CColStatsCache::Trim
+//
+//	@doc:
+//		Drop all cached statistics if the cache is full. Entries of older
+//		versions of the statistics are never looked up again, so this is
+//		what eventually gets rid of them
+//
+//---------------------------------------------------------------------------
+void
+CColStatsCache::Trim()
+{
+	if (m_ulMaxEntries <= m_ulEntries)
+	{
+		Reset();
+	}
+}
+
+// EOF
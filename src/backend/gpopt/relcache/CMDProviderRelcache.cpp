@@ -15,13 +15,21 @@
 //---------------------------------------------------------------------------
 
 #include "postgres.h"
+#include "utils/guc.h"
+#include "optimizer/optstats.h"
 #include "gpopt/relcache/CMDProviderRelcache.h"
 #include "gpopt/translate/CTranslatorRelcacheToDXL.h"
+#include "gpopt/translate/CTranslatorUtils.h"
 #include "gpopt/mdcache/CMDAccessor.h"
+#include "gpopt/gpdbwrappers.h"
 
+#include "gpos/common/CWallClock.h"
 #include "gpos/io/COstreamString.h"
 
 #include "naucrates/dxl/CDXLUtils.h"
+#include "naucrates/md/CMDIdColStats.h"
+#include "naucrates/md/CMDIdGPDB.h"
+#include "naucrates/md/CMDIdRelStats.h"
 
 #include "naucrates/exception.h"
 
@@ -29,6 +37,44 @@ using namespace gpos;
 using namespace gpdxl;
 using namespace gpmd;
 
+namespace
+{
+	// counts a fetch of a metadata object and measures its time; objects
+	// fetched while translating another one are part of its time
+	class CAutoFetchTimer
+	{
+		private:
+
+			// number of fetches in progress
+			static
+			ULONG m_ulDepth;
+
+			// clock started when the fetch started
+			CWallClock m_clock;
+
+		public:
+
+			// ctor
+			CAutoFetchTimer()
+			{
+				m_ulDepth++;
+				OptimizerQueryStats.mdFetches++;
+			}
+
+			// dtor
+			~CAutoFetchTimer()
+			{
+				m_ulDepth--;
+				if (0 == m_ulDepth)
+				{
+					OptimizerQueryStats.mdFetchTime += m_clock.UlElapsedUS() / 1000.0;
+				}
+			}
+	};
+
+	ULONG CAutoFetchTimer::m_ulDepth = 0;
+}
+
 //---------------------------------------------------------------------------
 //	@function:
 //		CMDProviderRelcache::CMDProviderRelcache
@@ -47,12 +93,80 @@ CMDProviderRelcache::CMDProviderRelcache
 	GPOS_ASSERT(NULL != m_pmp);
 }
 
+//---------------------------------------------------------------------------
+//	@function:
+//		CMDProviderRelcache::OidSharedRelation
+//
+//	@doc:
+//		Returns the relation whose version the given object is shared under
+//		in the metadata cache shared by all backends, or InvalidOid if the
+//		object is never shared. Only relations and their statistics are,
+//		as every change to them invalidates the relcache entry of the
+//		relation.
+//
+//---------------------------------------------------------------------------
+OID
+CMDProviderRelcache::OidSharedRelation
+	(
+	IMDId *pmdid
+	)
+{
+	switch (pmdid->Emdidt())
+	{
+		case IMDId::EmdidGPDB:
+			// may not be a relation, which FShareable() tells once translated
+			return CMDIdGPDB::PmdidConvert(pmdid)->OidObjectId();
+
+		case IMDId::EmdidRelStats:
+			return CMDIdGPDB::PmdidConvert(CMDIdRelStats::PmdidConvert(pmdid)->PmdidRel())->OidObjectId();
+
+		case IMDId::EmdidColStats:
+			if (0 != optimizer_histogram_max_buckets)
+			{
+				// other backends may cap the histograms differently
+				return InvalidOid;
+			}
+			return CMDIdGPDB::PmdidConvert(CMDIdColStats::PmdidConvert(pmdid)->PmdidRel())->OidObjectId();
+
+		default:
+			return InvalidOid;
+	}
+}
+
+//---------------------------------------------------------------------------
+//	@function:
+//		CMDProviderRelcache::FShareable
+//
+//	@doc:
+//		Can the given translated object be shared by all backends?
+//
+//---------------------------------------------------------------------------
+BOOL
+CMDProviderRelcache::FShareable
+	(
+	IMDCacheObject *pimdobj
+	)
+{
+	switch (pimdobj->Emdt())
+	{
+		case IMDCacheObject::EmdtRel:
+		case IMDCacheObject::EmdtRelStats:
+		case IMDCacheObject::EmdtColStats:
+			return true;
+
+		default:
+			return false;
+	}
+}
+
 //---------------------------------------------------------------------------
 //	@function:
 //		CMDProviderRelcache::PstrObject
 //
 //	@doc:
-//		Returns the DXL of the requested object in the provided memory pool
+//		Returns the DXL of the requested object in the provided memory pool.
+//		Relations and their statistics are looked up in, and added to, the
+//		metadata cache shared by all backends, if there is one.
 //
 //---------------------------------------------------------------------------
 CWStringBase *
@@ -64,12 +178,49 @@ CMDProviderRelcache::PstrObject
 	)
 	const
 {
+	CAutoFetchTimer aft;
+
+	OID oidRel = OidSharedRelation(pmdid);
+	CHAR *szMDId = NULL;
+	ULLONG ullVersion = 0;
+
+	if (InvalidOid != oidRel && gpdb::FMDSharedCacheEnabled())
+	{
+		// read the version before translating anything, so that an object
+		// translated from a stale relcache entry is stored under a stale
+		// version
+		ullVersion = gpdb::UllMDSharedCacheVersion(oidRel);
+		szMDId = CTranslatorUtils::SzFromWsz(pmdid->Wsz());
+
+		CHAR *szObject = gpdb::SzMDSharedCacheLookup(szMDId, ullVersion);
+		if (NULL != szObject)
+		{
+			CWStringDynamic *pstr = CDXLUtils::PstrFromSz(m_pmp, szObject);
+			gpdb::GPDBFree(szObject);
+			gpdb::GPDBFree(szMDId);
+			OptimizerQueryStats.mdSharedHits++;
+
+			return pstr;
+		}
+	}
+
 	IMDCacheObject *pimdobj = CTranslatorRelcacheToDXL::Pimdobj(pmp, pmda, pmdid);
 
 	GPOS_ASSERT(NULL != pimdobj);
 
 	CWStringDynamic *pstr = CDXLUtils::PstrSerializeMDObj(m_pmp, pimdobj, true /*fSerializeHeaders*/, false /*findent*/);
 
+	if (NULL != szMDId)
+	{
+		if (FShareable(pimdobj) && gpdb::FMDSharedCacheRelation(oidRel))
+		{
+			CHAR *szObject = CTranslatorUtils::SzFromWsz(pstr->Wsz());
+			gpdb::MDSharedCacheStore(szMDId, ullVersion, szObject);
+			gpdb::GPDBFree(szObject);
+		}
+		gpdb::GPDBFree(szMDId);
+	}
+
 	// cleanup DXL object
 	pimdobj->Release();
 
@@ -291,7 +291,7 @@ CTranslatorDXLToPlStmt::PplstmtFromDXL
 				GPOS_ASSERT(gpdb::FMotionGather(pmotion));
 				
 				pmotion->plan.directDispatch.isDirectDispatch = true;
-				pmotion->plan.directDispatch.contentIds = pplan->directDispatch.contentIds;
+				pmotion->plan.directDispatch.contentIds = gpdb::PlCopy(pplan->directDispatch.contentIds);
 			}
 		}
 	}
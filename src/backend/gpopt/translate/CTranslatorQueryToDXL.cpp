@@ -3011,7 +3011,10 @@ CTranslatorQueryToDXL::PdxlnFromRelation
 //		CTranslatorQueryToDXL::PdxlnFromValues
 //
 //	@doc:
-//		Returns a CDXLNode representing a range table entry of values
+//		Returns a CDXLNode representing a range table entry of values.
+//		Consecutive tuples of constants are translated to a single const
+//		table get, so a VALUES list of constants becomes a single operator,
+//		rather than a UNION ALL of one operator per tuple
 //
 //---------------------------------------------------------------------------
 CDXLNode *
@@ -3037,6 +3040,10 @@ CTranslatorQueryToDXL::PdxlnFromValues
 	// array of column descriptor for the UNION ALL operator
 	DrgPdxlcd *pdrgpdxlcd = GPOS_NEW(m_pmp) DrgPdxlcd(m_pmp);
 	
+	// column descriptors and tuples of the current run of tuples of constants
+	DrgPdxlcd *pdrgpdxlcdRun = NULL;
+	DrgPdrgPdxldatum *pdrgpdrgpdxldatumRun = NULL;
+
 	// translate the tuples in the value scan
 	ULONG ulTuplePos = 0;
 	ListCell *plcTuple = NULL;
@@ -3046,6 +3053,34 @@ CTranslatorQueryToDXL::PdxlnFromValues
 		List *plTuple = (List *) lfirst(plcTuple);
 		GPOS_ASSERT(IsA(plTuple, List));
 
+		if (NULL != pdrgpdxlcdRun && !FConstValues(plTuple, pdrgpdxlcdRun))
+		{
+			// end of the current run
+			pdrgpdxln->Append(PdxlnConstValues(pdrgpdxlcdRun, pdrgpdrgpdxldatumRun, pdrgpdrgulInputColIds));
+			pdrgpdxlcdRun = NULL;
+			pdrgpdrgpdxldatumRun = NULL;
+		}
+
+		if (FConstValues(plTuple, pdrgpdxlcdRun))
+		{
+			if (NULL == pdrgpdxlcdRun)
+			{
+				// start a new run
+				pdrgpdxlcdRun = PdrgpdxlcdConstValues(plTuple, prte->eref->colnames);
+				pdrgpdrgpdxldatumRun = GPOS_NEW(m_pmp) DrgPdrgPdxldatum(m_pmp);
+
+				if (0 == ulTuplePos)
+				{
+					CUtils::AddRefAppend(pdrgpdxlcd, pdrgpdxlcdRun);
+				}
+			}
+
+			pdrgpdrgpdxldatumRun->Append(PdrgpdxldatumConstValues(plTuple));
+			ulTuplePos++;
+
+			continue;
+		}
+
 		// array of column colids  
 		DrgPul *pdrgpulColIds = GPOS_NEW(m_pmp) DrgPul(m_pmp);
 
@@ -3142,10 +3177,16 @@ CTranslatorQueryToDXL::PdxlnFromValues
 		pdrgpdxlnPrEl->Release();
 		pdrgpdxlcdCTG->Release();
 	}
+
+	if (NULL != pdrgpdxlcdRun)
+	{
+		pdrgpdxln->Append(PdxlnConstValues(pdrgpdxlcdRun, pdrgpdrgpdxldatumRun, pdrgpdrgulInputColIds));
+	}
 	
 	GPOS_ASSERT(NULL != pdrgpdxlcd);
+	GPOS_ASSERT(ulValues == ulTuplePos);
 
-	if (1 < ulValues)
+	if (1 < pdrgpdxln->UlLength())
 	{
 		// create a UNION ALL operator
 		CDXLLogicalSetOp *pdxlop = GPOS_NEW(m_pmp) CDXLLogicalSetOp(m_pmp, EdxlsetopUnionAll, pdrgpdxlcd, pdrgpdrgulInputColIds, false);
@@ -3174,6 +3215,154 @@ CTranslatorQueryToDXL::PdxlnFromValues
 	return pdxln;
 }
 
+//---------------------------------------------------------------------------
+//	@function:
+//		CTranslatorQueryToDXL::FConstValues
+//
+//	@doc:
+//		Is the given tuple of a value scan made of constants only, of the
+//		types of the given column descriptors, if any
+//
+//---------------------------------------------------------------------------
+BOOL
+CTranslatorQueryToDXL::FConstValues
+	(
+	List *plTuple,
+	DrgPdxlcd *pdrgpdxlcd
+	)
+	const
+{
+	ULONG ulColPos = 0;
+	ListCell *plcColumn = NULL;
+	ForEach (plcColumn, plTuple)
+	{
+		Node *pnode = (Node *) lfirst(plcColumn);
+		if (!IsA(pnode, Const))
+		{
+			return false;
+		}
+
+		if (NULL != pdrgpdxlcd)
+		{
+			OID oidType = CMDIdGPDB::PmdidConvert((*pdrgpdxlcd)[ulColPos]->PmdidType())->OidObjectId();
+			if (oidType != ((Const *) pnode)->consttype)
+			{
+				return false;
+			}
+		}
+		ulColPos++;
+	}
+
+	return true;
+}
+
+//---------------------------------------------------------------------------
+//	@function:
+//		CTranslatorQueryToDXL::PdrgpdxlcdConstValues
+//
+//	@doc:
+//		Column descriptors, with new column ids, of a const table get
+//		producing the given tuple of constants
+//
+//---------------------------------------------------------------------------
+DrgPdxlcd *
+CTranslatorQueryToDXL::PdrgpdxlcdConstValues
+	(
+	List *plTuple,
+	List *plColnames
+	)
+{
+	GPOS_ASSERT(NULL != plColnames);
+	GPOS_ASSERT(gpdb::UlListLength(plTuple) == gpdb::UlListLength(plColnames));
+
+	DrgPdxlcd *pdrgpdxlcd = GPOS_NEW(m_pmp) DrgPdxlcd(m_pmp);
+
+	ULONG ulColPos = 0;
+	ListCell *plcColumn = NULL;
+	ForEach (plcColumn, plTuple)
+	{
+		Const *pconst = (Const *) lfirst(plcColumn);
+		CHAR *szColName = (CHAR *) strVal(gpdb::PvListNth(plColnames, ulColPos));
+
+		CWStringDynamic *pstrAlias = CDXLUtils::PstrFromSz(m_pmp, szColName);
+		CMDName *pmdname = GPOS_NEW(m_pmp) CMDName(m_pmp, pstrAlias);
+		GPOS_DELETE(pstrAlias);
+
+		CDXLColDescr *pdxlcd = GPOS_NEW(m_pmp) CDXLColDescr
+											(
+											m_pmp,
+											pmdname,
+											m_pidgtorCol->UlNextId(),
+											ulColPos + 1 /* iAttno */,
+											GPOS_NEW(m_pmp) CMDIdGPDB(pconst->consttype),
+											false /* fDropped */
+											);
+		pdrgpdxlcd->Append(pdxlcd);
+		ulColPos++;
+	}
+
+	return pdrgpdxlcd;
+}
+
+//---------------------------------------------------------------------------
+//	@function:
+//		CTranslatorQueryToDXL::PdrgpdxldatumConstValues
+//
+//	@doc:
+//		Datums of the given tuple of constants
+//
+//---------------------------------------------------------------------------
+DrgPdxldatum *
+CTranslatorQueryToDXL::PdrgpdxldatumConstValues
+	(
+	List *plTuple
+	)
+	const
+{
+	DrgPdxldatum *pdrgpdxldatum = GPOS_NEW(m_pmp) DrgPdxldatum(m_pmp);
+
+	ListCell *plcColumn = NULL;
+	ForEach (plcColumn, plTuple)
+	{
+		Const *pconst = (Const *) lfirst(plcColumn);
+		pdrgpdxldatum->Append(m_psctranslator->Pdxldatum(pconst));
+	}
+
+	return pdrgpdxldatum;
+}
+
+//---------------------------------------------------------------------------
+//	@function:
+//		CTranslatorQueryToDXL::PdxlnConstValues
+//
+//	@doc:
+//		Const table get producing a run of tuples of constants. Takes
+//		ownership of the column descriptors and tuples, and appends the
+//		column ids it produces to the given array of input column ids
+//
+//---------------------------------------------------------------------------
+CDXLNode *
+CTranslatorQueryToDXL::PdxlnConstValues
+	(
+	DrgPdxlcd *pdrgpdxlcd,
+	DrgPdrgPdxldatum *pdrgpdrgpdxldatum,
+	DrgPdrgPul *pdrgpdrgulInputColIds
+	)
+	const
+{
+	DrgPul *pdrgpulColIds = GPOS_NEW(m_pmp) DrgPul(m_pmp);
+	const ULONG ulCols = pdrgpdxlcd->UlLength();
+	for (ULONG ul = 0; ul < ulCols; ul++)
+	{
+		pdrgpulColIds->Append(GPOS_NEW(m_pmp) ULONG((*pdrgpdxlcd)[ul]->UlID()));
+	}
+	pdrgpdrgulInputColIds->Append(pdrgpulColIds);
+
+	CDXLLogicalConstTable *pdxlop = GPOS_NEW(m_pmp) CDXLLogicalConstTable(m_pmp, pdrgpdxlcd, pdrgpdrgpdxldatum);
+
+	return GPOS_NEW(m_pmp) CDXLNode(m_pmp, pdxlop);
+}
+
 //---------------------------------------------------------------------------
 //	@function:
 //		CTranslatorQueryToDXL::PdxlnFromColumnValues
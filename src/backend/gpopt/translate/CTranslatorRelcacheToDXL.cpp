@@ -36,6 +36,7 @@
 #include "naucrates/md/CMDCastGPDB.h"
 #include "naucrates/md/CMDScCmpGPDB.h"
 
+#include "gpopt/relcache/CColStatsCache.h"
 #include "gpopt/translate/CTranslatorUtils.h"
 #include "gpopt/translate/CTranslatorRelcacheToDXL.h"
 #include "gpopt/translate/CTranslatorScalarToDXL.h"
@@ -2320,6 +2321,87 @@ CTranslatorRelcacheToDXL::PimdobjColStats
 	}
 
 
+	// transformed statistics of this version of the pg_statistic row, if
+	// they are cached
+	ULONG ulMaxBuckets = (ULONG) optimizer_histogram_max_buckets;
+	CColStatsKey cskey
+					(
+					oidRelation,
+					attrnum,
+					oidAttType,
+					(ULONG) HeapTupleHeaderGetXmin(heaptupleStats->t_data),
+					(ULONG) ItemPointerGetBlockNumber(&heaptupleStats->t_self),
+					(ULONG) ItemPointerGetOffsetNumber(&heaptupleStats->t_self),
+					dRows,
+					ulMaxBuckets
+					);
+
+	const CColStatsCacheEntry *pcsentry = CColStatsCache::Pcsentry(cskey);
+	if (NULL == pcsentry)
+	{
+		CColStatsCacheEntry *pcsentryNew = PcsentryTransformStats
+											(
+											CColStatsCache::Pmp(),
+											pmdrel,
+											pmdcol,
+											oidAttType,
+											dRows,
+											heaptupleStats,
+											ulMaxBuckets
+											);
+		pcsentry = CColStatsCache::PcsentryInsert(cskey, pcsentryNew);
+	}
+
+	// column width
+	Form_pg_statistic fpsStats = (Form_pg_statistic) GETSTRUCT(heaptupleStats);
+	CDouble dWidth = CDouble(fpsStats->stawidth);
+
+	gpdb::FreeHeapTuple(heaptupleStats);
+
+	// the buckets are shared with the cache
+	CUtils::AddRefAppend(pdrgpdxlbucket, pcsentry->Pdrgpdxlbucket());
+
+	// create col stats object
+	pmdidColStats->AddRef();
+	CDXLColStats *pdxlcolstats = GPOS_NEW(pmp) CDXLColStats
+											(
+											pmp,
+											pmdidColStats,
+											pmdnameCol,
+											dWidth,
+											pcsentry->DNullFreq(),
+											pcsentry->DDistinctRemain(),
+											pcsentry->DFreqRemain(),
+											pdrgpdxlbucket,
+											false /* fColStatsMissing */
+											);
+
+	return pdxlcolstats;
+}
+
+//---------------------------------------------------------------------------
+//	@function:
+//		CTranslatorRelcacheToDXL::PcsentryTransformStats
+//
+//	@doc:
+//		Transform the MCVs and histogram of a pg_statistic row to buckets,
+//		allocated in the given memory pool. If ulMaxBuckets is not zero,
+//		only the ulMaxBuckets most common values are kept, and the
+//		histogram is coarsened to at most ulMaxBuckets buckets
+//
+//---------------------------------------------------------------------------
+CColStatsCacheEntry *
+CTranslatorRelcacheToDXL::PcsentryTransformStats
+	(
+	IMemoryPool *pmp,
+	const IMDRelation *pmdrel,
+	const IMDColumn *pmdcol,
+	OID oidAttType,
+	CDouble dRows,
+	HeapTuple heaptupleStats,
+	ULONG ulMaxBuckets
+	)
+{
 	Datum	   *pdrgdatumMCVValues = NULL;
 	int			iNumMCVValues = 0;
 	float4	   *pdrgfMCVFrequencies = NULL;
@@ -2351,6 +2433,15 @@ CTranslatorRelcacheToDXL::PimdobjColStats
 				pmdcol->Mdname().Pstr()->Wsz(), pmdrel->Mdname().Pstr()->Wsz());
 	}
 
+	// ANALYZE stores the MCVs by decreasing frequency, so dropping the
+	// tail keeps the most common ones. The frequency of the dropped values
+	// goes to the histogram.
+	ULONG ulMCVs = ULONG(iNumMCVValues);
+	if (0 < ulMaxBuckets && ulMCVs > ulMaxBuckets)
+	{
+		ulMCVs = ulMaxBuckets;
+	}
+
 	Form_pg_statistic fpsStats = (Form_pg_statistic) GETSTRUCT(heaptupleStats);
 
 	// null frequency and NDV
@@ -2363,10 +2454,7 @@ CTranslatorRelcacheToDXL::PimdobjColStats
 	}
 
 	// fix mcv and null frequencies (sometimes they can add up to more than 1.0)
-	NormalizeFrequencies(pdrgfMCVFrequencies, (ULONG) iNumMCVValues, &dNullFrequency);
-
-	// column width
-	CDouble dWidth = CDouble(fpsStats->stawidth);
+	NormalizeFrequencies(pdrgfMCVFrequencies, ulMCVs, &dNullFrequency);
 
 	// calculate total number of distinct values
 	CDouble dDistinct(1.0);
@@ -2381,13 +2469,6 @@ CTranslatorRelcacheToDXL::PimdobjColStats
 	}
 	dDistinct = dDistinct.FpCeil();
 
-	// total MCV frequency
-	CDouble dMCFSum = 0.0;
-	for (ULONG ul = 0; ul < iNumMCVValues; ul++)
-	{
-		dMCFSum = dMCFSum + CDouble(pdrgfMCVFrequencies[ul]);
-	}
-
 	// get histogram datums from pg_statistic entry
 	(void) gpdb::FGetAttrStatsSlot
 			(
@@ -2399,6 +2480,20 @@ CTranslatorRelcacheToDXL::PimdobjColStats
 					&pdrgdatumHistValues, &iNumHistValues,
 					NULL, NULL);
 
+	// the bounds of an equi-depth histogram are still the bounds of an
+	// equi-depth histogram when only every n-th of them is kept
+	Datum *pdrgdatumHistBounds = pdrgdatumHistValues;
+	ULONG ulHistBounds = ULONG(iNumHistValues);
+	if (0 < ulMaxBuckets && ulHistBounds > ulMaxBuckets + 1)
+	{
+		pdrgdatumHistBounds = GPOS_NEW_ARRAY(pmp, Datum, ulMaxBuckets + 1);
+		for (ULONG ul = 0; ul <= ulMaxBuckets; ul++)
+		{
+			pdrgdatumHistBounds[ul] = pdrgdatumHistValues[ul * (ulHistBounds - 1) / ulMaxBuckets];
+		}
+		ulHistBounds = ulMaxBuckets + 1;
+	}
+
 	// transform all the bits and pieces from pg_statistic
 	// to a single bucket structure
 	DrgPdxlbucket *pdrgpdxlbucketTransformed =
@@ -2410,9 +2505,9 @@ CTranslatorRelcacheToDXL::PimdobjColStats
 					dNullFrequency,
 					pdrgdatumMCVValues,
 					pdrgfMCVFrequencies,
-					ULONG(iNumMCVValues),
-					pdrgdatumHistValues,
-					ULONG(iNumHistValues)
+					ulMCVs,
+					pdrgdatumHistBounds,
+					ulHistBounds
 					);
 
 	GPOS_ASSERT(NULL != pdrgpdxlbucketTransformed);
@@ -2439,32 +2534,21 @@ CTranslatorRelcacheToDXL::PimdobjColStats
  		dFreqRemain = std::max(CDouble(0.0), (1 - dFreqBuckets - dNullFrequency));
 	}
 
-	CUtils::AddRefAppend(pdrgpdxlbucket, pdrgpdxlbucketTransformed);
-
 	// free up allocated datum and float4 arrays
+	if (pdrgdatumHistBounds != pdrgdatumHistValues)
+	{
+		GPOS_DELETE_ARRAY(pdrgdatumHistBounds);
+	}
 	gpdb::FreeAttrStatsSlot(oidAttType, pdrgdatumMCVValues, iNumMCVValues, pdrgfMCVFrequencies, iNumMCVFrequencies);
 	gpdb::FreeAttrStatsSlot(oidAttType, pdrgdatumHistValues, iNumHistValues, NULL, 0);
 
-	gpdb::FreeHeapTuple(heaptupleStats);
-
-	pdrgpdxlbucketTransformed->Release();
-
-	// create col stats object
-	pmdidColStats->AddRef();
-	CDXLColStats *pdxlcolstats = GPOS_NEW(pmp) CDXLColStats
-											(
-											pmp,
-											pmdidColStats,
-											pmdnameCol,
-											dWidth,
-											dNullFrequency,
-											dDistinctRemain,
-											dFreqRemain,
-											pdrgpdxlbucket,
-											false /* fColStatsMissing */
-											);
-
-	return pdxlcolstats;
+	return GPOS_NEW(pmp) CColStatsCacheEntry
+							(
+							pdrgpdxlbucketTransformed,
+							dNullFrequency,
+							dDistinctRemain,
+							dFreqRemain
+							);
 }
 
 
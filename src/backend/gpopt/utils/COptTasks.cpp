@@ -39,11 +39,13 @@
 
 #include "gpos/_api.h"
 #include "gpos/common/CAutoP.h"
+#include "gpos/common/CWallClock.h"
 #include "gpos/error/CErrorHandlerStandard.h"
 #include "gpos/error/CLoggerStream.h"
 #include "gpos/io/COstreamFile.h"
 #include "gpos/io/COstreamString.h"
 #include "gpos/memory/CAutoMemoryPool.h"
+#include "gpos/memory/CCacheAccessor.h"
 #include "gpos/task/CWorkerPoolManager.h"
 #include "gpos/task/CAutoTaskProxy.h"
 #include "gpos/task/CTaskContext.h"
@@ -61,6 +63,8 @@
 #include "gpopt/engine/CCTEConfig.h"
 #include "gpopt/mdcache/CAutoMDAccessor.h"
 #include "gpopt/mdcache/CMDCache.h"
+#include "gpopt/relcache/CColStatsCache.h"
+#include "gpopt/mdcache/CMDKey.h"
 #include "gpopt/minidump/CMiniDumperDXL.h"
 #include "gpopt/minidump/CMinidumperUtils.h"
 #include "gpopt/minidump/CSerializableStackTrace.h"
@@ -80,6 +84,7 @@
 
 #include "naucrates/md/IMDId.h"
 #include "naucrates/md/CMDRelationGPDB.h"
+#include "naucrates/md/IMDRelation.h"
 #include "naucrates/md/CMDIdRelStats.h"
 #include "naucrates/md/CMDIdColStats.h"
 
@@ -114,6 +119,9 @@ using namespace gpdbcost;
 // definition of default AutoMemoryPool
 #define AUTO_MEM_POOL(amp) CAutoMemoryPool amp(CAutoMemoryPool::ElcExc, CMemoryPoolManager::EatTracker, false /* fThreadSafe */)
 
+// accessor of the entries of the metadata cache
+typedef CCacheAccessor<IMDCacheObject*, CMDKey*> CMDCacheAccessor;
+
 // default id for the source system
 const CSystemId sysidDefault(IMDId::EmdidGPDB, GPOS_WSZ_STR_LENGTH("GPDB"));
 
@@ -142,6 +150,17 @@ const ULONG rgulExpectedDXLErrors[] =
 		gpdxl::ExmiQuery2DXLNotNullViolation,	// not null violation
 	};
 
+// elapsed time of the given clock in milliseconds
+static
+double DElapsedMS
+	(
+	CWallClock &clock
+	)
+{
+	return clock.UlElapsedUS() / 1000.0;
+}
+
+
 
 //---------------------------------------------------------------------------
 //	@function:
@@ -629,7 +648,8 @@ COptTasks::PvDXLFromQueryTask
 //		COptTasks::Pplstmt
 //
 //	@doc:
-//		Translate a DXL tree into a planned statement
+//		Translate a DXL tree into a planned statement, allocated in the
+//		current memory context
 //
 //---------------------------------------------------------------------------
 PlannedStmt *
@@ -712,6 +732,47 @@ COptTasks::PdrgPssLoad
 	return pdrgpss;
 }
 
+//---------------------------------------------------------------------------
+//	@function:
+//		COptTasks::PdrgPssBudget
+//
+//	@doc:
+//		Search strategy for a search with a time budget. The first stage
+//		finds a plan without enumerating join orders, which is cheap even
+//		for many-way joins; the second stage is the full search, and is
+//		cut short when the budget runs out, in which case the best plan
+//		found by then is used
+//
+//---------------------------------------------------------------------------
+DrgPss *
+COptTasks::PdrgPssBudget
+	(
+	IMemoryPool *pmp,
+	ULONG ulTimeBudget
+	)
+{
+	CXformSet *pxfsJoinOrder = GPOS_NEW(pmp) CXformSet(pmp);
+	(void) pxfsJoinOrder->FExchangeSet(CXform::ExfJoinCommutativity);
+	(void) pxfsJoinOrder->FExchangeSet(CXform::ExfJoinAssociativity);
+	(void) pxfsJoinOrder->FExchangeSet(CXform::ExfExpandNAryJoinDP);
+
+	CXformSet *pxfsFirst = GPOS_NEW(pmp) CXformSet(pmp);
+	pxfsFirst->Union(CXformFactory::Pxff()->PxfsExploration());
+	pxfsFirst->Union(CXformFactory::Pxff()->PxfsImplementation());
+	pxfsFirst->Difference(pxfsJoinOrder);
+	pxfsJoinOrder->Release();
+
+	CXformSet *pxfsFull = GPOS_NEW(pmp) CXformSet(pmp);
+	pxfsFull->Union(CXformFactory::Pxff()->PxfsExploration());
+	pxfsFull->Union(CXformFactory::Pxff()->PxfsImplementation());
+
+	DrgPss *pdrgpss = GPOS_NEW(pmp) DrgPss(pmp);
+	pdrgpss->Append(GPOS_NEW(pmp) CSearchStage(pxfsFirst));
+	pdrgpss->Append(GPOS_NEW(pmp) CSearchStage(pxfsFull, ulTimeBudget));
+
+	return pdrgpss;
+}
+
 //---------------------------------------------------------------------------
 //	@function:
 //		COptTasks::PoconfCreate
@@ -826,6 +887,55 @@ COptTasks::FErrorOut
 		FExceptionFound(exc, rgulExpectedDXLErrors, GPOS_ARRAY_SIZE(rgulExpectedDXLErrors));
 }
 
+//---------------------------------------------------------------------------
+//	@function:
+//		COptTasks::FDropMDCache
+//
+//	@doc:
+//		Check if given exception means that the metadata cache may no
+//		longer match the catalog, and has to be dropped
+//
+//---------------------------------------------------------------------------
+BOOL
+COptTasks::FDropMDCache
+	(
+	gpos::CException &exc
+	)
+{
+	// failures to look up or translate metadata, other than metadata
+	// objects the optimizer does not support
+	BOOL fMDFailure =
+		gpdxl::ExmaMD == exc.UlMajor() &&
+		!FExceptionFound(exc, rgulExpectedDXLFallback, GPOS_ARRAY_SIZE(rgulExpectedDXLFallback));
+
+	// failed assertions may be caused by a broken cache entry
+	BOOL fAssertFailure =
+		CException::ExmaSystem == exc.UlMajor() &&
+		CException::ExmiAssert == exc.UlMinor();
+
+	return fMDFailure || fAssertFailure;
+}
+
+//---------------------------------------------------------------------------
+//	@function:
+//		COptTasks::FMemoryBudgetExhausted
+//
+//	@doc:
+//		Check if given exception means that the optimizer ran out of the
+//		memory budget set by optimizer_search_memory_budget
+//
+//---------------------------------------------------------------------------
+BOOL
+COptTasks::FMemoryBudgetExhausted
+	(
+	gpos::CException &exc
+	)
+{
+	return 0 < optimizer_search_memory_budget &&
+		CException::ExmaSystem == exc.UlMajor() &&
+		CException::ExmiOOM == exc.UlMinor();
+}
+
 //---------------------------------------------------------------------------
 //		@function:
 //			COptTasks::SetCostModelParams
@@ -892,31 +1002,20 @@ COptTasks::Pcm
 
 //---------------------------------------------------------------------------
 //	@function:
-//		COptTasks::PvOptimizeTask
+//		COptTasks::FInitMDCache
 //
 //	@doc:
-//		task that does the optimizes query to physical DXL
+//		Initialize the metadata cache, or bring it up to date with the
+//		catalog changes since the last call, and apply the requested cache
+//		size. Returns true if the cache was initialized by this call
 //
 //---------------------------------------------------------------------------
-void*
-COptTasks::PvOptimizeTask
+BOOL
+COptTasks::FInitMDCache
 	(
-	void *pv
+	IMemoryPool *pmp
 	)
 {
-	GPOS_ASSERT(NULL != pv);
-	SOptContext *poctx = SOptContext::PoptctxtConvert(pv);
-
-	GPOS_ASSERT(NULL != poctx->m_pquery);
-	GPOS_ASSERT(NULL == poctx->m_szPlanDXL);
-	GPOS_ASSERT(NULL == poctx->m_pplstmt);
-
-	// initially assume no unexpected failure
-	poctx->m_fUnexpectedFailure = false;
-
-	AUTO_MEM_POOL(amp);
-	IMemoryPool *pmp = amp.Pmp();
-
 	// Does the metadatacache need to be reset?
 	//
 	// On the first call, before the cache has been initialized, we
@@ -924,26 +1023,222 @@ COptTasks::PvOptimizeTask
 	// we need to call it anyway, to give it a chance to initialize
 	// the invalidation mechanism.
 	bool reset_mdcache = gpdb::FMDCacheNeedsReset();
+	List *plInvalidatedRels = gpdb::PlMDCacheInvalidatedRels();
+
+	// cached column statistics were capped at the number of buckets in
+	// effect when they were translated
+	static int iHistogramMaxBuckets = 0;
+	if (iHistogramMaxBuckets != optimizer_histogram_max_buckets)
+	{
+		iHistogramMaxBuckets = optimizer_histogram_max_buckets;
+		reset_mdcache = true;
+	}
+
+	// cached plans go along with the metadata they were produced from, even
+	// if the metadata itself was not kept
+	if (reset_mdcache)
+	{
+		gpdb::OptPlanCacheReset();
+	}
+	else
+	{
+		gpdb::OptPlanCacheEvictRelations(plInvalidatedRels);
+	}
 
-	// initialize metadata cache, or purge if needed, or change size if requested
+	BOOL fInitialized = false;
 	if (!CMDCache::FInitialized())
 	{
+		CColStatsCache::Reset();
 		CMDCache::Init();
 		CMDCache::SetCacheQuota(optimizer_mdcache_size * 1024L);
+		fInitialized = true;
 	}
 	else if (reset_mdcache)
 	{
+		CColStatsCache::Reset();
 		CMDCache::Reset();
 		CMDCache::SetCacheQuota(optimizer_mdcache_size * 1024L);
 	}
-	else if (CMDCache::ULLGetCacheQuota() != optimizer_mdcache_size * 1024L)
+	else
 	{
-		CMDCache::SetCacheQuota(optimizer_mdcache_size * 1024L);
+		CColStatsCache::Trim();
+		EvictMDCacheRelations(pmp, plInvalidatedRels);
+		if (CMDCache::ULLGetCacheQuota() != optimizer_mdcache_size * 1024L)
+		{
+			CMDCache::SetCacheQuota(optimizer_mdcache_size * 1024L);
+		}
+	}
+
+	gpdb::FreeList(plInvalidatedRels);
+	return fInitialized;
+}
+
+
+//---------------------------------------------------------------------------
+//	@function:
+//		COptTasks::EvictMDCacheRelations
+//
+//	@doc:
+//		Evict the metadata cache entries of the given relations: the
+//		relation itself, its statistics, and its indexes, triggers and
+//		check constraints
+//
+//---------------------------------------------------------------------------
+void
+COptTasks::EvictMDCacheRelations
+	(
+	IMemoryPool *pmp,
+	List *plRelOids
+	)
+{
+	CMDAccessor::MDCache *pcache = CMDCache::Pcache();
+
+	ListCell *plc = NULL;
+	ForEach (plc, plRelOids)
+	{
+		CMDIdGPDB *pmdidRel = GPOS_NEW(pmp) CMDIdGPDB(lfirst_oid(plc));
+		DrgPmdid *pdrgpmdid = GPOS_NEW(pmp) DrgPmdid(pmp);
+
+		// collect the objects derived from the relation while it is still
+		// in the cache
+		{
+			CMDKey mdkey(pmdidRel);
+			CMDCacheAccessor mdcacc(pcache);
+			mdcacc.Lookup(&mdkey);
+			IMDCacheObject *pmdobj = mdcacc.PtVal();
+
+			if (NULL != pmdobj && IMDCacheObject::EmdtRel == pmdobj->Emdt())
+			{
+				IMDRelation *pmdrel = dynamic_cast<IMDRelation *>(pmdobj);
+
+				const ULONG ulColumns = pmdrel->UlColumns();
+				for (ULONG ul = 0; ul < ulColumns; ul++)
+				{
+					pmdidRel->AddRef();
+					pdrgpmdid->Append(GPOS_NEW(pmp) CMDIdColStats(pmdidRel, ul));
+				}
+
+				const ULONG ulIndices = pmdrel->UlIndices();
+				for (ULONG ul = 0; ul < ulIndices; ul++)
+				{
+					IMDId *pmdidIndex = pmdrel->PmdidIndex(ul);
+					pmdidIndex->AddRef();
+					pdrgpmdid->Append(pmdidIndex);
+				}
+
+				const ULONG ulTriggers = pmdrel->UlTriggers();
+				for (ULONG ul = 0; ul < ulTriggers; ul++)
+				{
+					IMDId *pmdidTrigger = pmdrel->PmdidTrigger(ul);
+					pmdidTrigger->AddRef();
+					pdrgpmdid->Append(pmdidTrigger);
+				}
+
+				const ULONG ulCheckConstraints = pmdrel->UlCheckConstraints();
+				for (ULONG ul = 0; ul < ulCheckConstraints; ul++)
+				{
+					IMDId *pmdidCheckConstraint = pmdrel->PmdidCheckConstraint(ul);
+					pmdidCheckConstraint->AddRef();
+					pdrgpmdid->Append(pmdidCheckConstraint);
+				}
+			}
+		}
+
+		pmdidRel->AddRef();
+		pdrgpmdid->Append(GPOS_NEW(pmp) CMDIdRelStats(pmdidRel));
+		pdrgpmdid->Append(pmdidRel);
+
+		const ULONG ulMDIds = pdrgpmdid->UlLength();
+		for (ULONG ul = 0; ul < ulMDIds; ul++)
+		{
+			CMDKey mdkey((*pdrgpmdid)[ul]);
+			CMDCacheAccessor mdcacc(pcache);
+			mdcacc.Lookup(&mdkey);
+			if (NULL != mdcacc.PtVal())
+			{
+				mdcacc.MarkForDeletion();
+			}
+		}
+
+		pdrgpmdid->Release();
 	}
+}
 
 
-	// load search strategy
+//---------------------------------------------------------------------------
+//	@function:
+//		COptTasks::PvOptimizeTask
+//
+//	@doc:
+//		task that does the optimizes query to physical DXL
+//
+//---------------------------------------------------------------------------
+void*
+COptTasks::PvOptimizeTask
+	(
+	void *pv
+	)
+{
+	GPOS_ASSERT(NULL != pv);
+	SOptContext *poctx = SOptContext::PoptctxtConvert(pv);
+
+	GPOS_ASSERT(NULL != poctx->m_pquery);
+	GPOS_ASSERT(NULL == poctx->m_szPlanDXL);
+	GPOS_ASSERT(NULL == poctx->m_pplstmt);
+
+	// initially assume no unexpected failure
+	poctx->m_fUnexpectedFailure = false;
+
+	// everything the optimizer allocates for the query counts against the
+	// memory budget, except for the metadata cache
+	ULLONG ullMemoryBudget = ULLONG_MAX;
+	if (0 < optimizer_search_memory_budget)
+	{
+		ullMemoryBudget = (ULLONG) optimizer_search_memory_budget * 1024;
+	}
+	CAutoMemoryPool amp(CAutoMemoryPool::ElcExc, CMemoryPoolManager::EatTracker, false /* fThreadSafe */, ullMemoryBudget);
+	IMemoryPool *pmp = amp.Pmp();
+
+	// initialize metadata cache, or bring it up to date with the catalog
+	(void) FInitMDCache(pmp);
+
+	// a plan cached for the same query is still valid, as the plans that
+	// depend on changed metadata were dropped along with it
+	CHAR *szPlanCacheKey = NULL;
+	if (poctx->m_fGeneratePlStmt && !poctx->m_fSerializePlanDXL && !optimizer_minidump)
+	{
+		szPlanCacheKey = gpdb::SzOptPlanCacheKey((Query*) poctx->m_pquery);
+		if (NULL != szPlanCacheKey)
+		{
+			CWallClock clockCopy;
+			poctx->m_pplstmt = gpdb::PplstmtOptPlanCacheLookup(szPlanCacheKey);
+			if (NULL != poctx->m_pplstmt)
+			{
+				OptimizerQueryStats.cachedPlans = 1;
+				OptimizerQueryStats.copyPlanTime = DElapsedMS(clockCopy);
+				gpdb::GPDBFree(szPlanCacheKey);
+				if (!optimizer_metadata_caching)
+				{
+					CMDCache::Shutdown();
+				}
+				return NULL;
+			}
+		}
+	}
+
+	// load search strategy, a strategy given in a file has time thresholds
+	// of its own
 	DrgPss *pdrgpss = PdrgPssLoad(pmp, optimizer_search_strategy_path);
+	DrgPss *pdrgpssBudget = NULL;
+	if (NULL == pdrgpss && 0 < optimizer_search_time_budget)
+	{
+		pdrgpss = PdrgPssBudget(pmp, (ULONG) optimizer_search_time_budget);
+
+		// the optimizer releases the stages when it is done; keep them to
+		// tell whether the timed stage was cut short
+		pdrgpss->AddRef();
+		pdrgpssBudget = pdrgpss;
+	}
 
 	CBitSet *pbsTraceFlags = NULL;
 	CBitSet *pbsEnabled = NULL;
@@ -980,6 +1275,7 @@ COptTasks::PvOptimizeTask
 				ulSegmentsForCosting = ulSegments;
 			}
 
+			CWallClock clockTranslateQuery;
 			CAutoP<CTranslatorQueryToDXL> ptrquerytodxl;
 			ptrquerytodxl = CTranslatorQueryToDXL::PtrquerytodxlInstance
 							(
@@ -1002,11 +1298,14 @@ COptTasks::PvOptimizeTask
 			DrgPdxln *pdrgpdxlnQueryOutput = ptrquerytodxl->PdrgpdxlnQueryOutput();
 			DrgPdxln *pdrgpdxlnCTE = ptrquerytodxl->PdrgpdxlnCTE();
 			GPOS_ASSERT(NULL != pdrgpdxlnQueryOutput);
+			OptimizerQueryStats.translateQueryTime = DElapsedMS(clockTranslateQuery);
+			RecordPeakMemory(pmp);
 
 			BOOL fMasterOnly = !optimizer_enable_motions ||
 						(!optimizer_enable_motions_masteronly_queries && !ptrquerytodxl->FHasDistributedTables());
 			CAutoTraceFlag atf(EopttraceDisableMotions, fMasterOnly);
 
+			CWallClock clockSearch;
 			pdxlnPlan = COptimizer::PdxlnOptimize
 									(
 									pmp,
@@ -1022,6 +1321,23 @@ COptTasks::PvOptimizeTask
 									pocconf
 									);
 
+			OptimizerQueryStats.searchTime = DElapsedMS(clockSearch);
+			RecordPeakMemory(pmp);
+
+			// only the last stage has a time threshold, a slow first stage
+			// does not cut the search short
+			if (NULL != pdrgpssBudget)
+			{
+				CSearchStage *pssTimed = (*pdrgpssBudget)[pdrgpssBudget->UlLength() - 1];
+				if (pssTimed->FTimedOut())
+				{
+					OptimizerQueryStats.budgetExhausted = 1;
+					elog(NOTICE, "optimizer search exceeded its time budget of %d ms, using the best plan found by then", optimizer_search_time_budget);
+				}
+				pdrgpssBudget->Release();
+				pdrgpssBudget = NULL;
+			}
+
 			if (poctx->m_fSerializePlanDXL)
 			{
 				// serialize DXL to xml
@@ -1033,7 +1349,18 @@ COptTasks::PvOptimizeTask
 			// translate DXL->PlStmt only when needed
 			if (poctx->m_fGeneratePlStmt)
 			{
-				poctx->m_pplstmt = (PlannedStmt *) gpdb::PvCopyObject(Pplstmt(pmp, &mda, pdxlnPlan));
+				// the translator allocates the plan in the memory context of
+				// the caller, so it can be handed out as is
+				CWallClock clockTranslatePlan;
+				poctx->m_pplstmt = Pplstmt(pmp, &mda, pdxlnPlan);
+				OptimizerQueryStats.translatePlanTime = DElapsedMS(clockTranslatePlan);
+				RecordPeakMemory(pmp);
+
+				if (NULL != szPlanCacheKey)
+				{
+					gpdb::OptPlanCacheStore(szPlanCacheKey, poctx->m_pplstmt);
+					gpdb::GPDBFree(szPlanCacheKey);
+				}
 			}
 
 			CStatisticsConfig *pstatsconf = pocconf->Pstatsconf();
@@ -1061,7 +1388,14 @@ COptTasks::PvOptimizeTask
 		CRefCount::SafeRelease(pbsDisabled);
 		CRefCount::SafeRelease(pbsTraceFlags);
 		CRefCount::SafeRelease(pdxlnPlan);
-		CMDCache::Shutdown();
+		CRefCount::SafeRelease(pdrgpssBudget);
+
+		// the MD accessor of the query is gone, so the cache entries it used
+		// are unpinned; keep the cache unless it may be broken
+		if (!optimizer_metadata_caching || FDropMDCache(ex))
+		{
+			CMDCache::Shutdown();
+		}
 
 		if (GPOS_MATCH_EX(ex, gpdxl::ExmaGPDB, gpdxl::ExmiGPDBError))
 		{
@@ -1072,6 +1406,12 @@ COptTasks::PvOptimizeTask
 			IErrorContext *perrctxt = CTask::PtskSelf()->Perrctxt();
 			poctx->m_szErrorMsg = SzFromWsz(perrctxt->WszMsg());
 		}
+		else if (FMemoryBudgetExhausted(ex))
+		{
+			// an expected fallback to the planner
+			OptimizerQueryStats.budgetExhausted = 1;
+			elog(NOTICE, "optimizer exceeded its memory budget of %d kB, falling back to the planner", optimizer_search_memory_budget);
+		}
 		else
 		{
 			poctx->m_fUnexpectedFailure = FUnexpectedFailure(ex);
@@ -1094,6 +1434,30 @@ COptTasks::PvOptimizeTask
 }
 
 
+//---------------------------------------------------------------------------
+//	@function:
+//		COptTasks::RecordPeakMemory
+//
+//	@doc:
+//		Record the memory in use by the optimizer, if it is the most so far.
+//		It is only sampled between the phases of the optimization, so memory
+//		freed within a phase does not show
+//
+//---------------------------------------------------------------------------
+void
+COptTasks::RecordPeakMemory
+	(
+	IMemoryPool *pmp
+	)
+{
+	int64 lMemory = (int64) pmp->UllTotalAllocatedSize();
+	if (lMemory > OptimizerQueryStats.peakMemory)
+	{
+		OptimizerQueryStats.peakMemory = lMemory;
+	}
+}
+
+
 //---------------------------------------------------------------------------
 //	@function:
 //		COptTasks::PrintMissingStatsWarning
@@ -1289,9 +1653,8 @@ COptTasks::PvPlstmtFromDXLTask
 		}
 
 		GPOS_ASSERT(NULL != pplstmt);
-		GPOS_ASSERT(NULL != CurrentMemoryContext);
 
-		poctx->m_pplstmt = (PlannedStmt *) gpdb::PvCopyObject(pplstmt);
+		poctx->m_pplstmt = pplstmt;
 	}
 
 	// cleanup
@@ -1486,32 +1849,9 @@ COptTasks::PvEvalExprFromDXLTask
 	GPOS_ASSERT(NULL != pdxlnInput);
 
 	CDXLNode *pdxlnResult = NULL;
-	BOOL fReleaseCache = false;
-
-	// Does the metadatacache need to be reset?
-	//
-	// On the first call, before the cache has been initialized, we
-	// don't care about the return value of FMDCacheNeedsReset(). But
-	// we need to call it anyway, to give it a chance to initialize
-	// the invalidation mechanism.
-	bool reset_mdcache = gpdb::FMDCacheNeedsReset();
 
-	// initialize metadata cache, or purge if needed, or change size if requested
-	if (!CMDCache::FInitialized())
-	{
-		CMDCache::Init();
-		CMDCache::SetCacheQuota(optimizer_mdcache_size * 1024L);
-		fReleaseCache = true;
-	}
-	else if (reset_mdcache)
-	{
-		CMDCache::Reset();
-		CMDCache::SetCacheQuota(optimizer_mdcache_size * 1024L);
-	}
-	else if (CMDCache::ULLGetCacheQuota() != optimizer_mdcache_size * 1024L)
-	{
-		CMDCache::SetCacheQuota(optimizer_mdcache_size * 1024L);
-	}
+	// initialize metadata cache, or bring it up to date with the catalog
+	BOOL fReleaseCache = FInitMDCache(pmp);
 
 	GPOS_TRY
 	{
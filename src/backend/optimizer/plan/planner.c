@@ -29,6 +29,7 @@
 #include "optimizer/pathnode.h"
 #include "optimizer/paths.h"
 #include "optimizer/planmain.h"
+#include "optimizer/optstats.h"
 #include "optimizer/planner.h"
 #include "optimizer/prep.h"
 #include "optimizer/subselect.h"
@@ -63,6 +64,10 @@ double cursor_tuple_fraction = DEFAULT_CURSOR_TUPLE_FRACTION;
 /* Hook for plugins to get control in planner() */
 planner_hook_type planner_hook = NULL;
 
+/* Time and memory spent by the new optimizer, see optstats.h */
+OptimizerStats OptimizerQueryStats;
+OptimizerStats OptimizerSessionStats;
+
 /* Expression kind codes for preprocess_expression */
 #define EXPRKIND_QUAL		0
 #define EXPRKIND_TARGET		1
@@ -126,6 +131,27 @@ static bool is_dummy_plan(Plan *plan);
 
 
 #ifdef USE_ORCA
+/**
+ * Add the statistics of the query optimized last to those of the session
+ */
+static void accumulate_optimizer_stats(void)
+{
+	OptimizerStats *query = &OptimizerQueryStats;
+	OptimizerStats *session = &OptimizerSessionStats;
+
+	session->queries += query->queries;
+	session->cachedPlans += query->cachedPlans;
+	session->budgetExhausted += query->budgetExhausted;
+	session->mdFetches += query->mdFetches;
+	session->mdSharedHits += query->mdSharedHits;
+	session->mdFetchTime += query->mdFetchTime;
+	session->translateQueryTime += query->translateQueryTime;
+	session->searchTime += query->searchTime;
+	session->translatePlanTime += query->translatePlanTime;
+	session->copyPlanTime += query->copyPlanTime;
+	session->peakMemory = Max(session->peakMemory, query->peakMemory);
+}
+
 /**
  * Logging of optimization outcome
  */
@@ -211,8 +237,13 @@ optimize_query(Query *parse, ParamListInfo boundParams)
 	/* perform pre-processing of query tree before calling optimizer */
 	pqueryCopy = preprocess_query_optimizer(pqueryCopy, boundParams);
 
+	MemSet(&OptimizerQueryStats, 0, sizeof(OptimizerQueryStats));
+	OptimizerQueryStats.queries = 1;
+
 	PlannedStmt *result = PplstmtOptimize(pqueryCopy, &fUnexpectedFailure);
 
+	accumulate_optimizer_stats();
+
 	if (result)
 	{
 		postprocess_plan(result);
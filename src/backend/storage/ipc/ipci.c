@@ -67,6 +67,7 @@
 #include "cdb/memquota.h"
 #include "executor/spi.h"
 #include "utils/workfile_mgr.h"
+#include "utils/mdsharedcache.h"
 #include "utils/session_state.h"
 
 shmem_startup_hook_type shmem_startup_hook = NULL;
@@ -137,6 +138,7 @@ CreateSharedMemoryAndSemaphores(bool makePrivate, int port)
 		size = add_size(size, BufferShmemSize());
 		size = add_size(size, LockShmemSize());
 		size = add_size(size, workfile_mgr_shmem_size());
+		size = add_size(size, MDSharedCacheShmemSize());
 		if (Gp_role == GP_ROLE_DISPATCH)
 		{
 			size = add_size(size, AppendOnlyWriterShmemSize());
@@ -409,6 +411,7 @@ CreateSharedMemoryAndSemaphores(bool makePrivate, int port)
 	 */
 	BTreeShmemInit();
 	workfile_mgr_cache_init();
+	MDSharedCacheShmemInit();
 
 #ifdef EXEC_BACKEND
 
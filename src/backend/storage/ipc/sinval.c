@@ -20,6 +20,7 @@
 #include "storage/ipc.h"
 #include "storage/sinvaladt.h"
 #include "utils/inval.h"
+#include "utils/mdsharedcache.h"
 
 #include "cdb/cdbtm.h"          /* DtxContext */
 
@@ -59,6 +60,9 @@ void
 SendSharedInvalidMessages(const SharedInvalidationMessage *msgs, int n)
 {
 	SIInsertDataEntries(msgs, n);
+
+	/* Objects of the optimizer shared cache they affect are now stale */
+	MDSharedCacheInvalidate(msgs, n);
 }
 
 /*
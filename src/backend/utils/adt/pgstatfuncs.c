@@ -18,6 +18,8 @@
 #include "miscadmin.h"
 #include "pgstat.h"
 #include "catalog/pg_type.h"
+#include "codegen/codegen_wrapper.h"
+#include "optimizer/optstats.h"
 #include "utils/builtins.h"
 #include "utils/fmgroids.h"
 #include "utils/guc.h"
@@ -69,6 +71,9 @@ extern Datum pg_stat_get_queue_num_wait(PG_FUNCTION_ARGS);
 extern Datum pg_stat_get_queue_elapsed_exec(PG_FUNCTION_ARGS);
 extern Datum pg_stat_get_queue_elapsed_wait(PG_FUNCTION_ARGS);
 
+extern Datum pg_stat_get_codegen_cache(PG_FUNCTION_ARGS);
+extern Datum pg_stat_get_optimizer(PG_FUNCTION_ARGS);
+
 extern Datum pg_renice_session(PG_FUNCTION_ARGS);
 
 extern Datum pg_stat_clear_snapshot(PG_FUNCTION_ARGS);
@@ -1060,6 +1065,71 @@ pg_stat_get_queue_elapsed_wait(PG_FUNCTION_ARGS)
 }
 
 
+/*
+ * Counters of the compiled generated function cache of the current backend.
+ * All zeros if the server was built without code generation.
+ */
+Datum
+pg_stat_get_codegen_cache(PG_FUNCTION_ARGS)
+{
+	TupleDesc	tupdesc;
+	Datum		values[4];
+	bool		nulls[4];
+	HeapTuple	tuple;
+	CodegenCacheStats stats;
+
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	GetCodegenCacheStats(&stats);
+
+	MemSet(nulls, false, sizeof(nulls));
+	values[0] = Int64GetDatum(stats.hits);
+	values[1] = Int64GetDatum(stats.misses);
+	values[2] = Int64GetDatum(stats.evictions);
+	values[3] = Int64GetDatum(stats.entries);
+
+	tuple = heap_form_tuple(BlessTupleDesc(tupdesc), values, nulls);
+
+	PG_RETURN_DATUM(HeapTupleGetDatum(tuple));
+}
+
+/*
+ * Time and memory the optimizer spent on the queries of the current backend,
+ * summed over the queries except for the peak memory. Times are in
+ * milliseconds. All zeros if the server was built without the optimizer.
+ */
+Datum
+pg_stat_get_optimizer(PG_FUNCTION_ARGS)
+{
+	TupleDesc	tupdesc;
+	Datum		values[11];
+	bool		nulls[11];
+	HeapTuple	tuple;
+	OptimizerStats *stats = &OptimizerSessionStats;
+
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	MemSet(nulls, false, sizeof(nulls));
+	values[0] = Int64GetDatum(stats->queries);
+	values[1] = Int64GetDatum(stats->cachedPlans);
+	values[2] = Int64GetDatum(stats->budgetExhausted);
+	values[3] = Int64GetDatum(stats->mdFetches);
+	values[4] = Int64GetDatum(stats->mdSharedHits);
+	values[5] = Float8GetDatum(stats->mdFetchTime);
+	values[6] = Float8GetDatum(stats->translateQueryTime);
+	values[7] = Float8GetDatum(stats->searchTime);
+	values[8] = Float8GetDatum(stats->translatePlanTime);
+	values[9] = Float8GetDatum(stats->copyPlanTime);
+	values[10] = Int64GetDatum(stats->peakMemory);
+
+	tuple = heap_form_tuple(BlessTupleDesc(tupdesc), values, nulls);
+
+	PG_RETURN_DATUM(HeapTupleGetDatum(tuple));
+}
+
+
 /*
  * This should probably be moved to it's own file, or at least some better place.
  * I put it here because it uses pgstat_fetch_stat_beentry
@@ -90,6 +90,7 @@
 #include "access/xact.h"
 #include "catalog/catalog.h"
 #include "catalog/gp_policy.h"
+#include "catalog/pg_statistic.h"
 #include "miscadmin.h"
 #include "storage/sinval.h"
 #include "storage/smgr.h"
@@ -686,6 +687,19 @@ PrepareForTupleInvalidation(Relation relation, HeapTuple tuple)
 		relationId = gptup->localoid;
 		databaseId = MyDatabaseId;
 	}
+	else if (tupleRelId == StatisticRelationId)
+	{
+		Form_pg_statistic statup = (Form_pg_statistic) GETSTRUCT(tuple);
+
+		/*
+		 * The statistics of a relation aren't part of its relcache entry, but
+		 * caches of derived data, like the metadata cache of the optimizer,
+		 * have to be told which relation's statistics changed. The syscache
+		 * callbacks don't say, so send a relcache inval for the relation.
+		 */
+		relationId = statup->starelid;
+		databaseId = MyDatabaseId;
+	}
 	else if (tupleRelId == IndexRelationId)
 	{
 		Form_pg_index indextup = (Form_pg_index) GETSTRUCT(tuple);
@@ -1065,6 +1079,30 @@ CommandEndInvalidationMessages(void)
 							   &transInvalInfo->CurrentCmdInvalidMsgs);
 }
 
+/*
+ * CacheInvalidationsPending
+ *		Has the current transaction, or any of its open subtransactions,
+ *		registered invalidation messages not sent to other backends yet?
+ *
+ * If so, the catalog entries seen by the current transaction may differ
+ * from those seen by other backends.
+ */
+bool
+CacheInvalidationsPending(void)
+{
+	TransInvalidationInfo *info;
+
+	for (info = transInvalInfo; info != NULL; info = info->parent)
+	{
+		if (info->CurrentCmdInvalidMsgs.cclist != NULL ||
+			info->CurrentCmdInvalidMsgs.rclist != NULL ||
+			info->PriorCmdInvalidMsgs.cclist != NULL ||
+			info->PriorCmdInvalidMsgs.rclist != NULL)
+			return true;
+	}
+	return false;
+}
+
 /*
  * CacheInvalidateHeapTuple
  *		Register the given tuple for invalidation at end of command
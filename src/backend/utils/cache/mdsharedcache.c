@@ -0,0 +1,372 @@
+/*-------------------------------------------------------------------------
+ *
+ * mdsharedcache.c
+ *	  Cache of optimizer metadata objects shared by all backends.
+ *
+ * The optimizer caches the metadata objects it translated from the catalogs
+ * in a cache local to the backend, so every new backend translates the same
+ * relations and statistics again for its first queries. This cache keeps the
+ * serialized DXL of those objects in shared memory, so that a backend can
+ * pick up the objects another backend already translated.
+ *
+ * Only objects that are derived entirely from the relcache entry of a single
+ * relation are cached: the relation itself and its statistics. Every change
+ * to such an object sends a relcache invalidation message for the relation,
+ * so each relation has a version that is bumped whenever such a message is
+ * sent, and objects are looked up by their metadata id and the version of
+ * their relation. Objects of older versions are never found again, and are
+ * eventually evicted by the replacement policy of the shared cache.
+ *
+ * The version is bumped after the message was sent, so a backend that reads
+ * the version and then accepts invalidation messages has a relcache that is
+ * at least as recent as the version. An object translated by a backend that
+ * read the version before a concurrent commit bumped it is stored under the
+ * older version, and so never found by backends that read the newer one.
+ *
+ * Copyright (c) 2016, Pivotal Software, Inc.
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "cdb/cdbvars.h"
+#include "miscadmin.h"
+#include "storage/shmem.h"
+#include "utils/gp_atomic.h"
+#include "utils/guc.h"
+#include "utils/mdsharedcache.h"
+#include "utils/sharedcache.h"
+#include "utils/syscache.h"
+
+/* Number of relation versions. Relations that map to the same one share it */
+#define MDSHAREDCACHE_VERSION_SLOTS 1024
+
+typedef struct MDSharedCacheKey
+{
+	Oid			dbid;
+	char		mdid[MDSHAREDCACHE_MAX_KEY_LEN];
+} MDSharedCacheKey;
+
+typedef struct MDSharedCacheEntry
+{
+	MDSharedCacheKey key;
+	uint64		version;
+	char		object[MDSHAREDCACHE_MAX_OBJECT_LEN];
+} MDSharedCacheEntry;
+
+/*
+ * Versions of the cached objects, in shared memory. The version of an object
+ * is the generation in the upper half, and the version of the slot of its
+ * relation in the lower half.
+ */
+typedef struct MDSharedCacheVersions
+{
+	/* Bumped by changes that may affect the objects of any relation */
+	volatile uint32 generation;
+	/* Bumped by relcache invalidations of the relations mapped to a slot */
+	volatile uint32 relversions[MDSHAREDCACHE_VERSION_SLOTS];
+} MDSharedCacheVersions;
+
+/* Information needed to populate a new entry */
+typedef struct MDSharedCacheEntryInfo
+{
+	const char *mdid;
+	uint64		version;
+	const char *object;
+} MDSharedCacheEntryInfo;
+
+static Cache *md_shared_cache = NULL;
+static MDSharedCacheVersions *md_shared_cache_versions = NULL;
+
+static bool md_shared_cache_equivalent(const void *virtual_resource,
+									   const void *physical_resource);
+static void md_shared_cache_populate_entry(const void *resource,
+										   const void *param);
+static void md_shared_cache_cleanup_entry(const void *resource);
+static CacheEntry *md_shared_cache_acquire(const char *mdid, uint64 version,
+										   const char *object);
+
+/*
+ * The cache is only used by the optimizer, which only runs on the master
+ */
+static bool
+md_shared_cache_configured(void)
+{
+	return optimizer_mdcache_shared_entries > 0 &&
+		Gp_role == GP_ROLE_DISPATCH;
+}
+
+static uint32
+md_shared_cache_slot(Oid dbid, Oid relid)
+{
+	return (dbid * 31 + relid) % MDSHAREDCACHE_VERSION_SLOTS;
+}
+
+/*
+ * Compute the size of shared memory for the optimizer metadata cache
+ */
+Size
+MDSharedCacheShmemSize(void)
+{
+	if (!md_shared_cache_configured())
+		return 0;
+
+	return add_size(Cache_SharedMemSize(optimizer_mdcache_shared_entries,
+										sizeof(MDSharedCacheEntry)),
+					MAXALIGN(sizeof(MDSharedCacheVersions)));
+}
+
+/*
+ * Initialize the cache in shared memory, or attach to an existing one
+ */
+void
+MDSharedCacheShmemInit(void)
+{
+	CacheCtl	cacheCtl;
+	bool		found;
+
+	if (!md_shared_cache_configured())
+		return;
+
+	md_shared_cache_versions = (MDSharedCacheVersions *)
+		ShmemInitStruct("Optimizer Metadata Shared Cache Versions",
+						sizeof(MDSharedCacheVersions), &found);
+	if (!found)
+		MemSet(md_shared_cache_versions, 0, sizeof(MDSharedCacheVersions));
+
+	MemSet(&cacheCtl, 0, sizeof(CacheCtl));
+
+	cacheCtl.maxSize = optimizer_mdcache_shared_entries;
+	cacheCtl.cacheName = "Optimizer Metadata Shared Cache";
+	cacheCtl.entrySize = sizeof(MDSharedCacheEntry);
+	cacheCtl.keySize = sizeof(MDSharedCacheKey);
+	cacheCtl.keyOffset = GPDB_OFFSET(MDSharedCacheEntry, key);
+
+	cacheCtl.hash = tag_hash;
+	cacheCtl.keyCopy = (HashCopyFunc) memcpy;
+	cacheCtl.match = (HashCompareFunc) memcmp;
+	cacheCtl.equivalentEntries = md_shared_cache_equivalent;
+	cacheCtl.cleanupEntry = md_shared_cache_cleanup_entry;
+	cacheCtl.populateEntry = md_shared_cache_populate_entry;
+
+	cacheCtl.baseLWLockId = FirstMDSharedCacheLock;
+	cacheCtl.numPartitions = NUM_MDSHAREDCACHE_PARTITIONS;
+
+	md_shared_cache = Cache_Create(&cacheCtl);
+	Assert(NULL != md_shared_cache);
+}
+
+bool
+MDSharedCacheIsEnabled(void)
+{
+	return NULL != md_shared_cache;
+}
+
+/*
+ * Returns the current version of the objects of a relation in the current
+ * database.
+ *
+ * The caller has to accept invalidation messages after reading the version,
+ * and before translating any object it stores under it.
+ */
+uint64
+MDSharedCacheGetVersion(Oid relid)
+{
+	uint32		generation;
+	uint32		relversion;
+
+	Assert(NULL != md_shared_cache_versions);
+
+	generation = md_shared_cache_versions->generation;
+	relversion = md_shared_cache_versions->relversions[md_shared_cache_slot(MyDatabaseId, relid)];
+
+	return ((uint64) generation << 32) | relversion;
+}
+
+/*
+ * Looks up the serialized object with the given metadata id and version.
+ *
+ * Returns a copy of it, palloc-ed in the current memory context, or NULL
+ * if it is not cached.
+ */
+char *
+MDSharedCacheLookup(const char *mdid, uint64 version)
+{
+	CacheEntry *localEntry;
+	MDSharedCacheEntry *localPayload;
+	CacheEntry *cachedEntry;
+	char	   *object = NULL;
+
+	Assert(NULL != md_shared_cache);
+
+	if (strlen(mdid) >= MDSHAREDCACHE_MAX_KEY_LEN)
+		return NULL;
+
+	/*
+	 * The entry to look up is built in local memory rather than acquired from
+	 * the cache, which would evict a live entry when the cache is full. Only
+	 * its key and version are looked at, the object is left out.
+	 */
+	localEntry = (CacheEntry *) palloc0(CACHE_ENTRY_HEADER_SIZE +
+										offsetof(MDSharedCacheEntry, object));
+	localPayload = (MDSharedCacheEntry *) CACHE_ENTRY_PAYLOAD(localEntry);
+	localPayload->key.dbid = MyDatabaseId;
+	strlcpy(localPayload->key.mdid, mdid, MDSHAREDCACHE_MAX_KEY_LEN);
+	localPayload->version = version;
+
+	cachedEntry = Cache_Lookup(md_shared_cache, localEntry);
+	pfree(localEntry);
+
+	if (NULL == cachedEntry)
+		return NULL;
+
+	PG_TRY();
+	{
+		object = pstrdup(((MDSharedCacheEntry *) CACHE_ENTRY_PAYLOAD(cachedEntry))->object);
+	}
+	PG_CATCH();
+	{
+		Cache_Release(md_shared_cache, cachedEntry);
+		PG_RE_THROW();
+	}
+	PG_END_TRY();
+
+	Cache_Release(md_shared_cache, cachedEntry);
+
+	return object;
+}
+
+/*
+ * Stores a serialized object under the given metadata id and version.
+ *
+ * Objects too large to fit in an entry are silently not cached.
+ */
+void
+MDSharedCacheStore(const char *mdid, uint64 version, const char *object)
+{
+	CacheEntry *newEntry;
+	CacheEntry *cachedEntry;
+
+	Assert(NULL != md_shared_cache);
+
+	if (strlen(mdid) >= MDSHAREDCACHE_MAX_KEY_LEN ||
+		strlen(object) >= MDSHAREDCACHE_MAX_OBJECT_LEN)
+		return;
+
+	newEntry = md_shared_cache_acquire(mdid, version, object);
+	if (NULL == newEntry)
+		return;
+
+	/* Another backend may have stored the same object in the meantime */
+	cachedEntry = Cache_Lookup(md_shared_cache, newEntry);
+	if (NULL != cachedEntry)
+	{
+		Cache_Release(md_shared_cache, cachedEntry);
+		Cache_Release(md_shared_cache, newEntry);
+		return;
+	}
+
+	Cache_Insert(md_shared_cache, newEntry);
+	Cache_Release(md_shared_cache, newEntry);
+}
+
+/*
+ * Bumps the versions of the objects affected by invalidation messages that
+ * are being sent. Called after the changes the messages describe became
+ * visible to other backends.
+ */
+void
+MDSharedCacheInvalidate(const SharedInvalidationMessage *msgs, int n)
+{
+	int			i;
+
+	if (NULL == md_shared_cache_versions)
+		return;
+
+	for (i = 0; i < n; i++)
+	{
+		const SharedInvalidationMessage *msg = &msgs[i];
+
+		if (SHAREDINVALRELCACHE_ID == msg->id)
+		{
+			uint32		slot = md_shared_cache_slot(msg->rc.dbId, msg->rc.relId);
+
+			pg_atomic_add_fetch_u32((pg_atomic_uint32 *) &md_shared_cache_versions->relversions[slot], 1);
+		}
+		else if (PARTOID == msg->id || PARTRULEOID == msg->id)
+		{
+			/*
+			 * Partitioning changes are not always accompanied by relcache
+			 * invalidations of all the relations involved.
+			 */
+			pg_atomic_add_fetch_u32((pg_atomic_uint32 *) &md_shared_cache_versions->generation, 1);
+		}
+	}
+}
+
+/*
+ * Acquires a new entry for the given object, evicting entries if the cache
+ * is full.
+ *
+ * Returns NULL if no entry could be freed.
+ */
+static CacheEntry *
+md_shared_cache_acquire(const char *mdid, uint64 version, const char *object)
+{
+	MDSharedCacheEntryInfo info;
+	CacheEntry *newEntry;
+
+	info.mdid = mdid;
+	info.version = version;
+	info.object = object;
+
+	newEntry = Cache_AcquireEntry(md_shared_cache, &info);
+	if (NULL == newEntry)
+	{
+		Cache_Evict(md_shared_cache, 1 /* evictRequestSize */);
+		newEntry = Cache_AcquireEntry(md_shared_cache, &info);
+	}
+
+	if (NULL != newEntry)
+		newEntry->size = 1;
+
+	return newEntry;
+}
+
+/*
+ * Two entries are equivalent if they are the same object of the same
+ * version.
+ */
+static bool
+md_shared_cache_equivalent(const void *virtual_resource,
+						   const void *physical_resource)
+{
+	const MDSharedCacheEntry *virtualEntry = (const MDSharedCacheEntry *) virtual_resource;
+	const MDSharedCacheEntry *physicalEntry = (const MDSharedCacheEntry *) physical_resource;
+
+	return virtualEntry->version == physicalEntry->version &&
+		0 == memcmp(&virtualEntry->key, &physicalEntry->key,
+					sizeof(MDSharedCacheKey));
+}
+
+static void
+md_shared_cache_populate_entry(const void *resource, const void *param)
+{
+	MDSharedCacheEntry *entry = (MDSharedCacheEntry *) resource;
+	const MDSharedCacheEntryInfo *info = (const MDSharedCacheEntryInfo *) param;
+
+	/* The key is hashed as a whole, so it must not contain garbage */
+	MemSet(&entry->key, 0, sizeof(MDSharedCacheKey));
+	entry->key.dbid = MyDatabaseId;
+	strlcpy(entry->key.mdid, info->mdid, MDSHAREDCACHE_MAX_KEY_LEN);
+
+	entry->version = info->version;
+
+	strlcpy(entry->object, info->object, MDSHAREDCACHE_MAX_OBJECT_LEN);
+}
+
+static void
+md_shared_cache_cleanup_entry(const void *resource)
+{
+	/* Nothing to clean up, the object lives in the entry */
+}
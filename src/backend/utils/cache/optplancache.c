@@ -0,0 +1,361 @@
+/*-------------------------------------------------------------------------
+ *
+ * optplancache.c
+ *	  Per-backend cache of plans produced by the optimizer.
+ *
+ * Reporting tools tend to send the same statements over and over, and most
+ * of the time spent on them can be the optimizer's search. This cache keeps
+ * the plans the optimizer produced, so that planning the same query again
+ * only costs a lookup and a copy of the plan.
+ *
+ * The optimizer's plans embed the constants of the query, which drive
+ * partition elimination and the cardinality estimates, so a plan is only
+ * reused for the very same query: the key is the text of the query after
+ * constant folding, which has the values and types of the bound parameters
+ * substituted, along with a hash of the settings of the session.
+ *
+ * Reusing a plan for queries that only differ in their literals would need
+ * a plan with parameters in place of the constants. The optimizer cannot
+ * produce one: bound parameters are folded into constants before it sees
+ * the query, and it does not translate external parameters. Nor can the
+ * constants of a cached plan be swapped for new ones, as the optimizer
+ * derives constants from one another and merges or drops predicates based
+ * on their values. So statements that repeat with different literals are
+ * planned every time, and only their metadata lookups are cached.
+ *
+ * A plan is only as current as the metadata it was produced from. Entries
+ * are dropped along with the optimizer's metadata cache: all of them on the
+ * catalog changes that reset it, and those of a relation when the relcache
+ * entry of the relation is invalidated (see COptTasks::FInitMDCache()).
+ *
+ * Copyright (c) 2016, Pivotal Software, Inc.
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "access/hash.h"
+#include "cdb/cdbpartition.h"
+#include "optimizer/prep.h"
+#include "utils/guc.h"
+#include "utils/guc_tables.h"
+#include "utils/hsearch.h"
+#include "utils/inval.h"
+#include "utils/memutils.h"
+#include "utils/optplancache.h"
+
+typedef struct OptPlanCacheEntry
+{
+	uint32		hash;			/* hash of the key, must be first */
+	char	   *key;			/* text of the query and the settings */
+	PlannedStmt *plan;			/* the cached plan */
+	List	   *relids;			/* relations the plan depends on */
+	uint64		lastUsed;		/* value of the clock when last used */
+	MemoryContext context;		/* holds everything above */
+} OptPlanCacheEntry;
+
+static HTAB *OptPlanCache = NULL;
+
+/* Ticks on every hit and store, for evicting the least recently used plan */
+static uint64 optPlanCacheClock = 0;
+
+static uint32 opt_plan_cache_settings_hash(void);
+static void opt_plan_cache_remove(OptPlanCacheEntry *entry);
+static void opt_plan_cache_trim(int maxEntries);
+
+/*
+ * Returns the key to look up and store the plan of the given query under,
+ * palloc-ed in the current memory context, or NULL if the plan of the query
+ * must not be cached.
+ *
+ * The query is expected to have gone through preprocess_query_optimizer().
+ */
+char *
+OptPlanCacheKey(Query *query)
+{
+	StringInfoData buf;
+	char	   *queryString;
+
+	if (optimizer_plan_cache_entries <= 0)
+	{
+		OptPlanCacheReset();
+		return NULL;
+	}
+
+	/*
+	 * Data modifying statements have their target chosen when they are
+	 * executed, and locking clauses record the relations to lock in the
+	 * plan. Only plain queries are worth the trouble.
+	 */
+	if (CMD_SELECT != query->commandType ||
+		NULL != query->utilityStmt ||
+		NULL != query->intoClause ||
+		NIL != query->rowMarks)
+		return NULL;
+
+	/*
+	 * The invalidations of catalog changes made by the current transaction
+	 * are only seen when it ends, so plans depending on them must be neither
+	 * stored nor found.
+	 */
+	if (CacheInvalidationsPending())
+		return NULL;
+
+	queryString = nodeToString(query);
+
+	initStringInfo(&buf);
+	appendStringInfo(&buf, "%08X ", opt_plan_cache_settings_hash());
+	appendStringInfoString(&buf, queryString);
+	pfree(queryString);
+
+	return buf.data;
+}
+
+/*
+ * Looks up the plan cached under the given key.
+ *
+ * Returns a copy of it, allocated in the current memory context, or NULL if
+ * no plan is cached under the key.
+ */
+PlannedStmt *
+OptPlanCacheLookup(const char *key)
+{
+	OptPlanCacheEntry *entry;
+	uint32		hash;
+
+	Assert(NULL != key);
+
+	if (NULL == OptPlanCache)
+		return NULL;
+
+	hash = DatumGetUInt32(hash_any((const unsigned char *) key, strlen(key)));
+	entry = (OptPlanCacheEntry *) hash_search(OptPlanCache, (void *) &hash,
+											  HASH_FIND, NULL);
+
+	/* different keys may have the same hash */
+	if (NULL == entry || 0 != strcmp(entry->key, key))
+		return NULL;
+
+	entry->lastUsed = ++optPlanCacheClock;
+
+	return (PlannedStmt *) copyObject(entry->plan);
+}
+
+/*
+ * Caches a copy of the given plan under the given key, evicting the least
+ * recently used plan if the cache is full.
+ */
+void
+OptPlanCacheStore(const char *key, PlannedStmt *plan)
+{
+	OptPlanCacheEntry *entry;
+	MemoryContext context;
+	MemoryContext oldContext;
+	List	   *relids = NIL;
+	ListCell   *lc;
+	uint32		hash;
+	bool		found;
+
+	Assert(NULL != key);
+	Assert(NULL != plan);
+
+	if (NULL == OptPlanCache)
+	{
+		HASHCTL		ctl;
+
+		MemSet(&ctl, 0, sizeof(ctl));
+		ctl.keysize = sizeof(uint32);
+		ctl.entrysize = sizeof(OptPlanCacheEntry);
+		ctl.hash = oid_hash;
+		ctl.hcxt = CacheMemoryContext;
+		OptPlanCache = hash_create("Optimizer Plan Cache", 64, &ctl,
+								   HASH_ELEM | HASH_FUNCTION | HASH_CONTEXT);
+	}
+
+	/*
+	 * The plan of a partitioned table depends on its parts too, whose
+	 * relcache invalidations don't reach the root.
+	 */
+	foreach(lc, plan->relationOids)
+	{
+		Oid			relid = lfirst_oid(lc);
+
+		if (rel_is_partitioned(relid))
+			relids = list_concat_unique_oid(relids, find_all_inheritors(relid));
+		else
+			relids = list_append_unique_oid(relids, relid);
+	}
+
+	/* make room for the new plan */
+	opt_plan_cache_trim(optimizer_plan_cache_entries - 1);
+
+	context = AllocSetContextCreate(CacheMemoryContext,
+									"Optimizer Plan Cache Entry",
+									ALLOCSET_SMALL_MINSIZE,
+									ALLOCSET_SMALL_INITSIZE,
+									ALLOCSET_DEFAULT_MAXSIZE);
+	oldContext = MemoryContextSwitchTo(context);
+	PG_TRY();
+	{
+		key = pstrdup(key);
+		plan = (PlannedStmt *) copyObject(plan);
+		relids = list_copy(relids);
+	}
+	PG_CATCH();
+	{
+		MemoryContextSwitchTo(oldContext);
+		MemoryContextDelete(context);
+		PG_RE_THROW();
+	}
+	PG_END_TRY();
+	MemoryContextSwitchTo(oldContext);
+
+	hash = DatumGetUInt32(hash_any((const unsigned char *) key, strlen(key)));
+	entry = (OptPlanCacheEntry *) hash_search(OptPlanCache, (void *) &hash,
+											  HASH_ENTER, &found);
+
+	/* a plan of another key with the same hash makes way for this one */
+	if (found)
+		MemoryContextDelete(entry->context);
+
+	entry->key = (char *) key;
+	entry->plan = plan;
+	entry->relids = relids;
+	entry->lastUsed = ++optPlanCacheClock;
+	entry->context = context;
+}
+
+/*
+ * Drops all cached plans
+ */
+void
+OptPlanCacheReset(void)
+{
+	HASH_SEQ_STATUS status;
+	OptPlanCacheEntry *entry;
+
+	if (NULL == OptPlanCache)
+		return;
+
+	hash_seq_init(&status, OptPlanCache);
+	while (NULL != (entry = (OptPlanCacheEntry *) hash_seq_search(&status)))
+		opt_plan_cache_remove(entry);
+}
+
+/*
+ * Drops the cached plans that depend on any of the given relations
+ */
+void
+OptPlanCacheEvictRelations(List *relids)
+{
+	HASH_SEQ_STATUS status;
+	OptPlanCacheEntry *entry;
+
+	if (NULL == OptPlanCache || NIL == relids)
+		return;
+
+	hash_seq_init(&status, OptPlanCache);
+	while (NULL != (entry = (OptPlanCacheEntry *) hash_seq_search(&status)))
+	{
+		ListCell   *lc;
+
+		foreach(lc, relids)
+		{
+			if (list_member_oid(entry->relids, lfirst_oid(lc)))
+			{
+				opt_plan_cache_remove(entry);
+				break;
+			}
+		}
+	}
+}
+
+/*
+ * Hash of the settings of the session. The plan may depend on any of them,
+ * so all are included, except for the internal ones that change on their
+ * own from one query to the next.
+ */
+static uint32
+opt_plan_cache_settings_hash(void)
+{
+	struct config_generic **gucs = get_guc_variables();
+	int			numGucs = get_num_guc_variables();
+	uint32		hash = 0;
+	int			i;
+
+	for (i = 0; i < numGucs; i++)
+	{
+		struct config_generic *conf = gucs[i];
+		uint32		valueHash = 0;
+
+		if (PGC_INTERNAL == conf->context)
+			continue;
+
+		switch (conf->vartype)
+		{
+			case PGC_BOOL:
+				valueHash = *((struct config_bool *) conf)->variable ? 1 : 0;
+				break;
+			case PGC_INT:
+				valueHash = (uint32) *((struct config_int *) conf)->variable;
+				break;
+			case PGC_REAL:
+				{
+					double		value = *((struct config_real *) conf)->variable;
+
+					valueHash = DatumGetUInt32(hash_any((const unsigned char *) &value,
+														sizeof(double)));
+				}
+				break;
+			case PGC_STRING:
+				{
+					const char *value = *((struct config_string *) conf)->variable;
+
+					if (NULL != value)
+						valueHash = DatumGetUInt32(hash_any((const unsigned char *) value,
+															strlen(value)));
+				}
+				break;
+		}
+
+		hash = DatumGetUInt32(hash_uint32(hash ^ valueHash));
+	}
+
+	return hash;
+}
+
+static void
+opt_plan_cache_remove(OptPlanCacheEntry *entry)
+{
+	MemoryContext context = entry->context;
+
+	hash_search(OptPlanCache, (void *) &entry->hash, HASH_REMOVE, NULL);
+	MemoryContextDelete(context);
+}
+
+/*
+ * Evicts the least recently used plans until at most the given number of
+ * plans is left
+ */
+static void
+opt_plan_cache_trim(int maxEntries)
+{
+	if (NULL == OptPlanCache)
+		return;
+
+	while (hash_get_num_entries(OptPlanCache) > maxEntries)
+	{
+		HASH_SEQ_STATUS status;
+		OptPlanCacheEntry *entry;
+		OptPlanCacheEntry *oldest = NULL;
+
+		hash_seq_init(&status, OptPlanCache);
+		while (NULL != (entry = (OptPlanCacheEntry *) hash_seq_search(&status)))
+		{
+			if (NULL == oldest || entry->lastUsed < oldest->lastUsed)
+				oldest = entry;
+		}
+
+		opt_plan_cache_remove(oldest);
+	}
+}
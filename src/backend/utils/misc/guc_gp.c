@@ -497,6 +497,8 @@ bool		optimizer_print_plan;
 bool		optimizer_print_xform;
 bool		optimizer_metadata_caching;
 int		optimizer_mdcache_size;
+int		optimizer_mdcache_shared_entries;
+int		optimizer_plan_cache_entries;
 bool		optimizer_disable_xform_result_printing;
 bool		optimizer_print_memo_after_exploration;
 bool		optimizer_print_memo_after_implementation;
@@ -551,6 +553,9 @@ double		optimizer_damping_factor_filter;
 double		optimizer_damping_factor_join;
 double		optimizer_damping_factor_groupby;
 int			optimizer_segments;
+int			optimizer_histogram_max_buckets;
+int			optimizer_search_time_budget;
+int			optimizer_search_memory_budget;
 int			optimizer_join_arity_for_associativity_commutativity;
 bool		optimizer_analyze_root_partition;
 bool		optimizer_analyze_midlevel_partition;
@@ -576,6 +581,12 @@ bool		optimizer_prefer_scalar_dqa_multistage_agg;
  **/
 bool		init_codegen;
 bool		codegen;
+bool		codegen_async_compile;
+int			codegen_cache_size;
+int			codegen_min_plan_rows;
+int			codegen_max_instructions;
+int			codegen_object_cache_size;
+char	   *codegen_object_cache_directory;
 
 /* Security */
 bool		gp_reject_internal_tcp_conn = true;
@@ -3419,6 +3430,16 @@ struct config_bool ConfigureNamesBool_gp[] =
 		false, NULL, NULL
 	},
 
+	{
+		{"codegen_async_compile", PGC_USERSET, DEVELOPER_OPTIONS,
+			gettext_noop("Compile generated code in the background while the query starts without it."),
+			NULL,
+			GUC_NO_SHOW_ALL | GUC_NOT_IN_SAMPLE
+		},
+		&codegen_async_compile,
+		false, NULL, NULL
+	},
+
 	/* End-of-list marker */
 	{
 		{NULL, 0, 0, NULL, NULL}, NULL, false, NULL, NULL
@@ -4724,6 +4745,36 @@ struct config_int ConfigureNamesInt_gp[] =
 		0, 0, INT_MAX, NULL, NULL
 	},
 
+	{
+		{"optimizer_histogram_max_buckets", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Maximum number of histogram buckets and most common values of a column considered by the optimizer, or 0 for no limit."),
+			gettext_noop("Fewer buckets make planning faster on wide tables analyzed with a high statistics target, at the cost of less accurate estimates."),
+			GUC_NOT_IN_SAMPLE
+		},
+		&optimizer_histogram_max_buckets,
+		0, 0, INT_MAX, NULL, NULL
+	},
+
+	{
+		{"optimizer_search_time_budget", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Sets the time after which the optimizer's search is cut short, using the best plan found by then."),
+			gettext_noop("Zero means no limit. Not used when optimizer_search_strategy_path is set."),
+			GUC_UNIT_MS | GUC_NOT_IN_SAMPLE
+		},
+		&optimizer_search_time_budget,
+		0, 0, INT_MAX, NULL, NULL
+	},
+
+	{
+		{"optimizer_search_memory_budget", PGC_USERSET, RESOURCES_MEM,
+			gettext_noop("Sets the memory the optimizer may use for a query before falling back to the planner."),
+			gettext_noop("Zero means no limit. The metadata cache does not count against it."),
+			GUC_UNIT_KB | GUC_NOT_IN_SAMPLE
+		},
+		&optimizer_search_memory_budget,
+		0, 0, INT_MAX, NULL, NULL
+	},
+
 	{
 		{"optimizer_join_arity_for_associativity_commutativity", PGC_USERSET, QUERY_TUNING_METHOD,
 			gettext_noop("Maximum number of children n-ary-join have without disabling commutativity and associativity transform"),
@@ -4744,6 +4795,26 @@ struct config_int ConfigureNamesInt_gp[] =
 		0, 0, INT_MAX, NULL, NULL
 	},
 
+	{
+		{"optimizer_mdcache_shared_entries", PGC_POSTMASTER, RESOURCES_MEM,
+			gettext_noop("Sets the number of metadata objects the optimizer caches in shared memory."),
+			gettext_noop("Each entry takes 32kB. Zero disables the shared cache."),
+			GUC_NOT_IN_SAMPLE
+		},
+		&optimizer_mdcache_shared_entries,
+		0, 0, 65536, NULL, NULL
+	},
+
+	{
+		{"optimizer_plan_cache_entries", PGC_USERSET, RESOURCES_MEM,
+			gettext_noop("Sets the number of plans produced by the optimizer each session caches."),
+			gettext_noop("A cached plan is only reused for the very same query. Zero disables the cache."),
+			GUC_NOT_IN_SAMPLE
+		},
+		&optimizer_plan_cache_entries,
+		0, 0, INT_MAX, NULL, NULL
+	},
+
 	{
 		{"memory_profiler_dataset_size", PGC_USERSET, DEVELOPER_OPTIONS,
 			gettext_noop("Set the size in GB"),
@@ -4804,6 +4875,46 @@ struct config_int ConfigureNamesInt_gp[] =
 		INDEX_CHECK_NONE, 0, INDEX_CHECK_ALL, NULL, NULL
 	},
 
+	{
+		{"codegen_cache_size", PGC_USERSET, DEVELOPER_OPTIONS,
+			gettext_noop("Sets the maximum number of compiled generated functions cached per backend."),
+			gettext_noop("Cached functions are reused by later executions of the same plan shapes. 0 disables the cache."),
+			GUC_NOT_IN_SAMPLE
+		},
+		&codegen_cache_size,
+		256, 0, INT_MAX, NULL, NULL
+	},
+
+	{
+		{"codegen_min_plan_rows", PGC_USERSET, DEVELOPER_OPTIONS,
+			gettext_noop("Sets the minimum number of rows a plan node is expected to process to generate code for it."),
+			gettext_noop("Nodes with lower row estimates run the regular functions, since compiling generated code would cost more than it saves."),
+			GUC_NOT_IN_SAMPLE
+		},
+		&codegen_min_plan_rows,
+		1000, 0, INT_MAX, NULL, NULL
+	},
+
+	{
+		{"codegen_max_instructions", PGC_USERSET, DEVELOPER_OPTIONS,
+			gettext_noop("Sets the maximum number of LLVM IR instructions generated per query."),
+			gettext_noop("Code generators whose code no longer fits run the regular functions. 0 means no limit."),
+			GUC_NOT_IN_SAMPLE
+		},
+		&codegen_max_instructions,
+		100000, 0, INT_MAX, NULL, NULL
+	},
+
+	{
+		{"codegen_object_cache_size", PGC_SUSET, DEVELOPER_OPTIONS,
+			gettext_noop("Sets the maximum total size of compiled object code cached on disk."),
+			gettext_noop("Backends that generate identical code reuse its machine code instead of compiling it. 0 disables the cache."),
+			GUC_UNIT_KB | GUC_NOT_IN_SAMPLE
+		},
+		&codegen_object_cache_size,
+		0, 0, INT_MAX, NULL, NULL
+	},
+
 	/* End-of-list marker */
 	{
 		{NULL, 0, 0, NULL, NULL}, NULL, 0, 0, 0, NULL, NULL
@@ -5577,6 +5688,16 @@ struct config_string ConfigureNamesString_gp[] =
 		"csv", assign_gp_log_format, NULL
 	},
 
+	{
+		{"codegen_object_cache_directory", PGC_SUSET, DEVELOPER_OPTIONS,
+			gettext_noop("Sets the directory of the on-disk cache of compiled object code."),
+			gettext_noop("Relative paths are relative to the data directory. Point the segments of a host at the same directory to share the cache between them."),
+			GUC_NOT_IN_SAMPLE
+		},
+		&codegen_object_cache_directory,
+		"pg_codegen_cache", NULL, NULL
+	},
+
 	/* End-of-list marker */
 	{
 		{NULL, 0, 0, NULL, NULL}, NULL, NULL, NULL, NULL
@@ -151,6 +151,10 @@
 
  CREATE FUNCTION pg_stat_get_wal_senders(OUT pid int4, OUT state text, OUT sent_location text, OUT write_location text, OUT flush_location text, OUT replay_location text, OUT sync_priority int4, OUT sync_state text) RETURNS SETOF pg_catalog.record LANGUAGE internal STABLE AS 'pg_stat_get_wal_senders' WITH (OID=3099, DESCRIPTION="statistics: information about currently active replication");
 
+ CREATE FUNCTION pg_stat_get_codegen_cache(OUT hits int8, OUT misses int8, OUT evictions int8, OUT entries int8) RETURNS pg_catalog.record LANGUAGE internal VOLATILE AS 'pg_stat_get_codegen_cache' WITH (OID=6110, DESCRIPTION="statistics: compiled generated function cache of the current backend");
+
+ CREATE FUNCTION pg_stat_get_optimizer(OUT queries int8, OUT cached_plans int8, OUT budget_exhausted int8, OUT md_fetches int8, OUT md_shared_hits int8, OUT md_fetch_time float8, OUT query_translation_time float8, OUT search_time float8, OUT plan_translation_time float8, OUT plan_copy_time float8, OUT peak_memory int8) RETURNS pg_catalog.record LANGUAGE internal VOLATILE AS 'pg_stat_get_optimizer' WITH (OID=6119, DESCRIPTION="statistics: optimizer time and memory of the current backend");
+
  CREATE FUNCTION pg_terminate_backend(int4) RETURNS bool LANGUAGE internal VOLATILE STRICT AS 'pg_terminate_backend' WITH (OID=6118, DESCRIPTION="terminate a server process");
 
  CREATE FUNCTION pg_resqueue_status() RETURNS SETOF record LANGUAGE internal VOLATILE STRICT AS 'pg_resqueue_status' WITH (OID=6030, DESCRIPTION="Return resource queue information");
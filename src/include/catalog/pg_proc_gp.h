@@ -22,7 +22,7 @@
 
    WARNING: DO NOT MODIFY THE FOLLOWING SECTION: 
    Generated by catullus.pl version 8
-   on Thu Apr 14 18:56:55 2016
+   on Sat Oct 17 03:44:25 2026
 
    Please make your changes in pg_proc.sql
 */
@@ -326,6 +326,14 @@ DESCR("statistics: information about currently active backends");
 DATA(insert OID = 3099 ( pg_stat_get_wal_senders  PGNSP PGUID 12 1 1000 0 f f f t s 0 0 2249 f "" "{23,25,25,25,25,25,23,25}" "{o,o,o,o,o,o,o,o}" "{pid,state,sent_location,write_location,flush_location,replay_location,sync_priority,sync_state}" _null_ pg_stat_get_wal_senders _null_ _null_ n ));
 DESCR("statistics: information about currently active replication");
 
+/* pg_stat_get_codegen_cache(OUT hits int8, OUT misses int8, OUT evictions int8, OUT entries int8) => pg_catalog.record */ 
+DATA(insert OID = 6110 ( pg_stat_get_codegen_cache  PGNSP PGUID 12 1 0 0 f f f f v 0 0 2249 f "" "{20,20,20,20}" "{o,o,o,o}" "{hits,misses,evictions,entries}" _null_ pg_stat_get_codegen_cache _null_ _null_ n ));
+DESCR("statistics: compiled generated function cache of the current backend");
+
+/* pg_stat_get_optimizer(OUT queries int8, OUT cached_plans int8, OUT budget_exhausted int8, OUT md_fetches int8, OUT md_shared_hits int8, OUT md_fetch_time float8, OUT query_translation_time float8, OUT search_time float8, OUT plan_translation_time float8, OUT plan_copy_time float8, OUT peak_memory int8) => pg_catalog.record */ 
+DATA(insert OID = 6119 ( pg_stat_get_optimizer  PGNSP PGUID 12 1 0 0 f f f f v 0 0 2249 f "" "{20,20,20,20,20,701,701,701,701,701,20}" "{o,o,o,o,o,o,o,o,o,o,o}" "{queries,cached_plans,budget_exhausted,md_fetches,md_shared_hits,md_fetch_time,query_translation_time,search_time,plan_translation_time,plan_copy_time,peak_memory}" _null_ pg_stat_get_optimizer _null_ _null_ n ));
+DESCR("statistics: optimizer time and memory of the current backend");
+
 /* pg_terminate_backend(int4) => bool */ 
 DATA(insert OID = 6118 ( pg_terminate_backend  PGNSP PGUID 12 1 0 0 f f t f v 1 0 16 f "23" _null_ _null_ _null_ _null_ pg_terminate_backend _null_ _null_ n ));
 DESCR("terminate a server process");
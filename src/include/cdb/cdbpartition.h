@@ -228,6 +228,7 @@ extern void RemovePartitionEncodingByRelidAttribute(Oid relid, AttrNumber attnum
 extern Datum *get_partition_encoding_attoptions(Relation rel, Oid paroid);
 
 extern LogicalIndexes * BuildLogicalIndexInfo(Oid relid);
+extern LogicalIndexes * GetLogicalIndexInfo(Oid relid);
 extern Oid getPhysicalIndexRelid(LogicalIndexInfo *iInfo, Oid partOid);
 
 extern LogicalIndexInfo *logicalIndexInfoForIndexOid(Oid rootOid, Oid indexOid);
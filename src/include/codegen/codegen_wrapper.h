@@ -28,9 +28,36 @@ struct TupleTableSlot;
 struct ProjectionInfo;
 struct List;
 struct ExprContext;
+struct AggState;
+struct AggStatePerGroupData;
+struct MemoryManagerContainer;
+struct HashState;
+struct HashJoinTableData;
+struct CdbHash;
 
 typedef void (*ExecVariableListFn) (struct ProjectionInfo *projInfo, Datum *values, bool *isnull);
 typedef bool (*ExecQualFn) (struct List *qual, struct ExprContext *econtext, bool resultForNull);
+typedef void (*SlotDeformTupleFn) (struct TupleTableSlot *slot, int natts);
+typedef void (*SlotDeformMemTupleFn) (struct TupleTableSlot *slot, int natts);
+typedef void (*AdvanceAggregatesFn) (struct AggState *aggstate, struct AggStatePerGroupData *pergroup,
+		struct MemoryManagerContainer *mem_manager);
+typedef bool (*ExecHashGetHashValueFn) (struct HashState *hashState, struct HashJoinTableData *hashtable,
+		struct ExprContext *econtext, struct List *hashkeys, bool outer_tuple, bool keep_nulls,
+		uint32 *hashvalue, bool *hashkeys_null);
+typedef uint32 (*CalcHashValueFn) (struct AggState *aggstate, struct TupleTableSlot *inputslot);
+typedef uint32 (*EvalHashKeyFn) (struct ExprContext *econtext, struct List *hashkeys, struct List *hashtypes,
+		struct CdbHash *h);
+
+/*
+ * Counters of the per-backend cache of compiled generated functions
+ */
+typedef struct CodegenCacheStats
+{
+	int64		hits;		/* lookups that found a compiled function */
+	int64		misses;		/* lookups that had to generate code */
+	int64		evictions;	/* functions evicted to stay within capacity */
+	int64		entries;	/* functions currently in the cache */
+} CodegenCacheStats;
 
 #ifndef USE_CODEGEN
 
@@ -40,8 +67,11 @@ typedef bool (*ExecQualFn) (struct List *qual, struct ExprContext *econtext, boo
 #define CodeGeneratorManagerPrepareGeneratedFunctions(manager) 1
 #define CodeGeneratorManagerNotifyParameterChange(manager) 1
 #define CodeGeneratorManagerDestroy(manager);
+#define CodeGeneratorManagerCancelAsyncCompilations();
+#define CodeGeneratorDetach(generator);
 #define GetActiveCodeGeneratorManager() NULL
 #define SetActiveCodeGeneratorManager(manager);
+#define GetCodegenCacheStats(stats) MemSet(stats, 0, sizeof(CodegenCacheStats))
 
 #define START_CODE_GENERATOR_MANAGER(newManager)
 #define END_CODE_GENERATOR_MANAGER()
@@ -53,6 +83,25 @@ typedef bool (*ExecQualFn) (struct List *qual, struct ExprContext *econtext, boo
 
 #define call_ExecQual(planstate, qual, econtext, resultForNull) ExecQual(qual, econtext, resultForNull)
 #define enroll_ExecQual_codegen(regular_func, ptr_to_chosen_func, planstate)
+
+#define call_slot_deform_tuple(slot, natts) slot_deform_tuple(slot, natts)
+#define enroll_slot_deform_tuple_codegen(regular_func, ptr_to_chosen_func, slot)
+
+#define call_slot_deform_memtuple(slot, natts) slot_deform_memtuple(slot, natts)
+#define enroll_slot_deform_memtuple_codegen(regular_func, ptr_to_chosen_func, slot)
+
+#define call_advance_aggregates(aggstate, pergroup, mem_manager) advance_aggregates(aggstate, pergroup, mem_manager)
+#define enroll_advance_aggregates_codegen(regular_func, ptr_to_chosen_func, aggstate)
+
+#define call_ExecHashGetHashValue(node, hashState, hashtable, econtext, hashkeys, outer_tuple, keep_nulls, hashvalue, hashkeys_null) \
+		ExecHashGetHashValue(hashState, hashtable, econtext, hashkeys, outer_tuple, keep_nulls, hashvalue, hashkeys_null)
+#define enroll_ExecHashGetHashValue_codegen(regular_func, ptr_to_chosen_func, node, hashkeys, hashoperators, outer_tuple)
+
+#define call_calc_hash_value(aggstate, inputslot) calc_hash_value(aggstate, inputslot)
+#define enroll_calc_hash_value_codegen(regular_func, ptr_to_chosen_func, aggstate)
+
+#define call_evalHashKey(node, econtext, hashkeys, hashtypes, h) evalHashKey(econtext, hashkeys, hashtypes, h)
+#define enroll_evalHashKey_codegen(regular_func, ptr_to_chosen_func, node, hashkeys, hashtypes)
 #else
 
 /*
@@ -83,6 +132,16 @@ extern "C" {
  */
 extern void ExecVariableList(struct ProjectionInfo *projInfo, Datum *values, bool *isnull);
 extern bool ExecQual(struct List *qual, struct ExprContext *econtext, bool resultForNull);
+extern void slot_deform_tuple(struct TupleTableSlot *slot, int natts);
+extern void slot_deform_memtuple(struct TupleTableSlot *slot, int natts);
+extern void advance_aggregates(struct AggState *aggstate, struct AggStatePerGroupData *pergroup,
+		struct MemoryManagerContainer *mem_manager);
+extern bool ExecHashGetHashValue(struct HashState *hashState, struct HashJoinTableData *hashtable,
+		struct ExprContext *econtext, struct List *hashkeys, bool outer_tuple, bool keep_nulls,
+		uint32 *hashvalue, bool *hashkeys_null);
+extern uint32 calc_hash_value(struct AggState *aggstate, struct TupleTableSlot *inputslot);
+extern uint32 evalHashKey(struct ExprContext *econtext, struct List *hashkeys, struct List *hashtypes,
+		struct CdbHash *h);
 
 /*
  * Do one-time global initialization of LLVM library. Returns 1
@@ -105,7 +164,9 @@ CodeGeneratorManagerGenerateCode(void* manager);
 
 /*
  * Compiles and prepares all the Codegen function pointers. Returns
- * number of successfully generated functions
+ * number of successfully generated functions. With codegen_async_compile,
+ * compilation continues in the background and generated functions are
+ * swapped in once they are compiled.
  */
 unsigned int
 CodeGeneratorManagerPrepareGeneratedFunctions(void* manager);
@@ -122,6 +183,20 @@ CodeGeneratorManagerNotifyParameterChange(void* manager);
 void
 CodeGeneratorManagerDestroy(void* manager);
 
+/*
+ * Stops background compilations from swapping in their functions, for
+ * transaction abort
+ */
+void
+CodeGeneratorManagerCancelAsyncCompilations();
+
+/*
+ * Stops background compilations from swapping in the function of one
+ * generator, for slots whose tuple descriptor changes
+ */
+void
+CodeGeneratorDetach(void* generator);
+
 /*
  * Get the active code generator manager
  */
@@ -134,6 +209,12 @@ GetActiveCodeGeneratorManager();
 void
 SetActiveCodeGeneratorManager(void* manager);
 
+/*
+ * Fill in the counters of the compiled function cache of this backend
+ */
+void
+GetCodegenCacheStats(CodegenCacheStats* stats);
+
 /*
  * returns the pointer to the ExecVariableList
  */
@@ -151,6 +232,57 @@ ExecQualCodegenEnroll(ExecQualFn regular_func_ptr,
                               ExecQualFn* ptr_to_regular_func_ptr,
                               struct PlanState *planstate);
 
+/*
+ * returns the pointer to the SlotDeformTupleCodegen
+ */
+void*
+SlotDeformTupleCodegenEnroll(SlotDeformTupleFn regular_func_ptr,
+                             SlotDeformTupleFn* ptr_to_regular_func_ptr,
+                             struct TupleTableSlot* slot);
+
+/*
+ * returns the pointer to the SlotDeformMemTupleCodegen
+ */
+void*
+SlotDeformMemTupleCodegenEnroll(SlotDeformMemTupleFn regular_func_ptr,
+                                SlotDeformMemTupleFn* ptr_to_regular_func_ptr,
+                                struct TupleTableSlot* slot);
+
+/*
+ * returns the pointer to the AdvanceAggregatesCodegen
+ */
+void*
+AdvanceAggregatesCodegenEnroll(AdvanceAggregatesFn regular_func_ptr,
+                               AdvanceAggregatesFn* ptr_to_regular_func_ptr,
+                               struct AggState* aggstate);
+
+/*
+ * returns the pointer to the ExecHashGetHashValueCodegen
+ */
+void*
+ExecHashGetHashValueCodegenEnroll(ExecHashGetHashValueFn regular_func_ptr,
+                                  ExecHashGetHashValueFn* ptr_to_regular_func_ptr,
+                                  struct List* hashkeys,
+                                  struct List* hashoperators,
+                                  bool outer_tuple);
+
+/*
+ * returns the pointer to the CalcHashValueCodegen
+ */
+void*
+CalcHashValueCodegenEnroll(CalcHashValueFn regular_func_ptr,
+                           CalcHashValueFn* ptr_to_regular_func_ptr,
+                           struct AggState* aggstate);
+
+/*
+ * returns the pointer to the EvalHashKeyCodegen
+ */
+void*
+EvalHashKeyCodegenEnroll(EvalHashKeyFn regular_func_ptr,
+                         EvalHashKeyFn* ptr_to_regular_func_ptr,
+                         struct List* hashkeys,
+                         struct List* hashtypes);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif
@@ -194,19 +326,69 @@ ExecQualCodegenEnroll(ExecQualFn regular_func_ptr,
 			} \
 		} \
 
+/*
+ * Load a function pointer that a background compilation may swap in, see
+ * CodeGeneratorManagerPrepareGeneratedFunctions()
+ */
+#define load_codegen_fn(fn) __atomic_load_n(&(fn), __ATOMIC_ACQUIRE)
+
 /*
  * Call ExecVariableList using function pointer ExecVariableList_fn.
  * Function pointer may point to regular version or generated function
  */
 #define call_ExecVariableList(projInfo, values, isnull) \
-		projInfo->ExecVariableList_gen_info.ExecVariableList_fn(projInfo, values, isnull)
+		load_codegen_fn(projInfo->ExecVariableList_gen_info.ExecVariableList_fn)(projInfo, values, isnull)
 
 /*
  * Call ExecQual using function pointer ExecQual_fn.
  * Function pointer may point to regular version or generated function
  */
 #define call_ExecQual(ps, qual, econtext, resultForNull) \
-     ps.ExecQual_gen_info.ExecQual_fn(qual, econtext, resultForNull)
+     load_codegen_fn(ps.ExecQual_gen_info.ExecQual_fn)(qual, econtext, resultForNull)
+
+/*
+ * Call slot_deform_tuple using function pointer slot_deform_tuple_fn.
+ * Function pointer may point to regular version or generated function
+ */
+#define call_slot_deform_tuple(slot, natts) \
+		load_codegen_fn(slot->slot_deform_tuple_gen_info.slot_deform_tuple_fn)(slot, natts)
+
+/*
+ * Call slot_deform_memtuple using function pointer slot_deform_memtuple_fn.
+ * Function pointer may point to regular version or generated function
+ */
+#define call_slot_deform_memtuple(slot, natts) \
+		load_codegen_fn(slot->slot_deform_memtuple_gen_info.slot_deform_memtuple_fn)(slot, natts)
+
+/*
+ * Call advance_aggregates using function pointer advance_aggregates_fn.
+ * Function pointer may point to regular version or generated function
+ */
+#define call_advance_aggregates(aggstate, pergroup, mem_manager) \
+		load_codegen_fn(aggstate->advance_aggregates_gen_info.advance_aggregates_fn)(aggstate, pergroup, mem_manager)
+
+/*
+ * Call ExecHashGetHashValue using function pointer ExecHashGetHashValue_fn of
+ * the node that the hash keys belong to.
+ * Function pointer may point to regular version or generated function
+ */
+#define call_ExecHashGetHashValue(node, hashState, hashtable, econtext, hashkeys, outer_tuple, keep_nulls, hashvalue, hashkeys_null) \
+		load_codegen_fn(node->ExecHashGetHashValue_gen_info.ExecHashGetHashValue_fn)(hashState, hashtable, econtext, \
+				hashkeys, outer_tuple, keep_nulls, hashvalue, hashkeys_null)
+
+/*
+ * Call calc_hash_value using function pointer calc_hash_value_fn.
+ * Function pointer may point to regular version or generated function
+ */
+#define call_calc_hash_value(aggstate, inputslot) \
+		load_codegen_fn(aggstate->calc_hash_value_gen_info.calc_hash_value_fn)(aggstate, inputslot)
+
+/*
+ * Call evalHashKey using function pointer evalHashKey_fn.
+ * Function pointer may point to regular version or generated function
+ */
+#define call_evalHashKey(node, econtext, hashkeys, hashtypes, h) \
+		load_codegen_fn(node->evalHashKey_gen_info.evalHashKey_fn)(econtext, hashkeys, hashtypes, h)
 
 /*
  * Enrollment macros
@@ -223,6 +405,36 @@ ExecQualCodegenEnroll(ExecQualFn regular_func_ptr,
         regular_func, ptr_to_regular_func_ptr, planstate); \
     Assert(planstate->ExecQual_gen_info.ExecQual_fn == regular_func); \
 
+#define enroll_slot_deform_tuple_codegen(regular_func, ptr_to_regular_func_ptr, slot) \
+		slot->slot_deform_tuple_gen_info.code_generator = SlotDeformTupleCodegenEnroll( \
+				regular_func, ptr_to_regular_func_ptr, slot); \
+		Assert(slot->slot_deform_tuple_gen_info.slot_deform_tuple_fn == regular_func); \
+
+#define enroll_slot_deform_memtuple_codegen(regular_func, ptr_to_regular_func_ptr, slot) \
+		slot->slot_deform_memtuple_gen_info.code_generator = SlotDeformMemTupleCodegenEnroll( \
+				regular_func, ptr_to_regular_func_ptr, slot); \
+		Assert(slot->slot_deform_memtuple_gen_info.slot_deform_memtuple_fn == regular_func); \
+
+#define enroll_advance_aggregates_codegen(regular_func, ptr_to_regular_func_ptr, aggstate) \
+		aggstate->advance_aggregates_gen_info.code_generator = AdvanceAggregatesCodegenEnroll( \
+				regular_func, ptr_to_regular_func_ptr, aggstate); \
+		Assert(aggstate->advance_aggregates_gen_info.advance_aggregates_fn == regular_func); \
+
+#define enroll_ExecHashGetHashValue_codegen(regular_func, ptr_to_regular_func_ptr, node, hashkeys, hashoperators, outer_tuple) \
+		node->ExecHashGetHashValue_gen_info.code_generator = ExecHashGetHashValueCodegenEnroll( \
+				regular_func, ptr_to_regular_func_ptr, hashkeys, hashoperators, outer_tuple); \
+		Assert(node->ExecHashGetHashValue_gen_info.ExecHashGetHashValue_fn == regular_func); \
+
+#define enroll_calc_hash_value_codegen(regular_func, ptr_to_regular_func_ptr, aggstate) \
+		aggstate->calc_hash_value_gen_info.code_generator = CalcHashValueCodegenEnroll( \
+				regular_func, ptr_to_regular_func_ptr, aggstate); \
+		Assert(aggstate->calc_hash_value_gen_info.calc_hash_value_fn == regular_func); \
+
+#define enroll_evalHashKey_codegen(regular_func, ptr_to_regular_func_ptr, node, hashkeys, hashtypes) \
+		node->evalHashKey_gen_info.code_generator = EvalHashKeyCodegenEnroll( \
+				regular_func, ptr_to_regular_func_ptr, hashkeys, hashtypes); \
+		Assert(node->evalHashKey_gen_info.evalHashKey_fn == regular_func); \
+
 #endif //USE_CODEGEN
 
 #endif  // CODEGEN_WRAPPER_H_
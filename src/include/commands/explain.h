@@ -14,6 +14,7 @@
 #define EXPLAIN_H
 
 #include "executor/executor.h"
+#include "optimizer/optstats.h"
 
 
 extern void ExplainQuery(ExplainStmt *stmt, const char *queryString,
@@ -28,6 +29,7 @@ extern void ExplainOneUtility(Node *utilityStmt, ExplainStmt *stmt,
 
 extern void ExplainOnePlan(PlannedStmt *plannedstmt, ExplainStmt *stmt,
 		   const char *queryString, ParamListInfo params,
+		   const OptimizerStats *optstats,
 		   TupOutputState *tstate);
 
 #endif   /* EXPLAIN_H */
@@ -414,6 +414,9 @@ extern void end_tup_output(TupOutputState *tstate);
 extern EState *CreateExecutorState(void);
 extern EState *CreateSubExecutorState(EState *parent_estate);
 extern void FreeExecutorState(EState *estate);
+extern void *CreateExecutorCodegenManager(const char *module_name);
+extern void DestroyExecutorCodegenManager(void *manager);
+extern void AtAbort_ExecutorCodegenManagers(SubTransactionId mySubid);
 extern void ClearPartitionState(EState *estate);
 extern ExprContext *CreateExprContext(EState *estate);
 extern ExprContext *CreateStandaloneExprContext(void);
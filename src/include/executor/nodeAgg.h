@@ -176,6 +176,9 @@ initialize_aggregates(AggState *aggstate,
 extern void 
 advance_aggregates(AggState *aggstate, AggStatePerGroup pergroup,
 				   MemoryManagerContainer *mem_manager);
+extern void
+advance_aggregate(AggState *aggstate, AggStatePerGroup pergroup, int aggno,
+				  MemoryManagerContainer *mem_manager);
 
 extern List *
 get_agg_hash_collist(AggState *aggstate);
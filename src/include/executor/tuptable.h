@@ -106,6 +106,24 @@
  *----------
  */
 
+#ifdef USE_CODEGEN
+typedef struct SlotDeformTupleCodegenInfo
+{
+	/* Pointer to store SlotDeformTupleCodegen from Codegen */
+	void* code_generator;
+	/* Function pointer that points to either regular or generated slot_deform_tuple */
+	SlotDeformTupleFn slot_deform_tuple_fn;
+} SlotDeformTupleCodegenInfo;
+
+typedef struct SlotDeformMemTupleCodegenInfo
+{
+	/* Pointer to store SlotDeformMemTupleCodegen from Codegen */
+	void* code_generator;
+	/* Function pointer that points to either regular or generated slot_deform_memtuple */
+	SlotDeformMemTupleFn slot_deform_memtuple_fn;
+} SlotDeformMemTupleCodegenInfo;
+#endif
+
 /* tts_flags */
 #define         TTS_ISEMPTY     1
 #define         TTS_SHOULDFREE 	2
@@ -141,6 +159,11 @@ typedef struct TupleTableSlot
 
     /* System attributes */
     Oid         tts_tableOid;
+
+#ifdef USE_CODEGEN
+	SlotDeformTupleCodegenInfo slot_deform_tuple_gen_info;
+	SlotDeformMemTupleCodegenInfo slot_deform_memtuple_gen_info;
+#endif
 } TupleTableSlot;
 
 static inline bool TupIsNull(TupleTableSlot *slot)
@@ -230,6 +253,7 @@ static inline bool *slot_get_isnull(TupleTableSlot *slot)
 }
 
 extern void _slot_getsomeattrs(TupleTableSlot *slot, int attnum);
+extern void slot_deform_memtuple(TupleTableSlot *slot, int natts);
 static inline void slot_getsomeattrs(TupleTableSlot *slot, int attnum)
 {
 
@@ -241,11 +265,7 @@ static inline void slot_getsomeattrs(TupleTableSlot *slot, int attnum)
 
 	if(TupHasMemTuple(slot))
 	{
-		int i; 
-		for(i=0; i<attnum; ++i)
-			slot->PRIVATE_tts_values[i] = memtuple_getattr(
-					slot->PRIVATE_tts_memtuple, slot->tts_mt_bind, 
-					i+1, &(slot->PRIVATE_tts_isnull[i]));
+		call_slot_deform_memtuple(slot, attnum);
 
 		TupSetVirtualTuple(slot);
 		slot->PRIVATE_tts_nvalid = attnum;
@@ -614,6 +614,44 @@ namespace gpdb {
 	// table has been changed?)
 	bool FMDCacheNeedsReset(void);
 
+	// Relations whose metadata cache entries need to be evicted (because
+	// their relcache entry has been invalidated)
+	List *PlMDCacheInvalidatedRels(void);
+
+	// Can the current transaction use the metadata cache shared by all
+	// backends? Accepts pending invalidation messages if it can.
+	bool FMDSharedCacheEnabled(void);
+
+	// Can the metadata objects of the given relation be shared by all
+	// backends?
+	bool FMDSharedCacheRelation(Oid relid);
+
+	// version of the shared metadata objects of the given relation
+	uint64 UllMDSharedCacheVersion(Oid relid);
+
+	// shared serialized metadata object with the given id and version,
+	// or NULL
+	char *SzMDSharedCacheLookup(const char *szMDId, uint64 ullVersion);
+
+	// share a serialized metadata object under the given id and version
+	void MDSharedCacheStore(const char *szMDId, uint64 ullVersion, const char *szObject);
+
+	// key to cache the plan of the given query under, or NULL if the plan
+	// must not be cached
+	char *SzOptPlanCacheKey(Query *pquery);
+
+	// copy of the plan cached under the given key, or NULL
+	PlannedStmt *PplstmtOptPlanCacheLookup(const char *szKey);
+
+	// cache a copy of the given plan under the given key
+	void OptPlanCacheStore(const char *szKey, PlannedStmt *pplstmt);
+
+	// drop all cached plans
+	void OptPlanCacheReset(void);
+
+	// drop the cached plans that depend on any of the given relations
+	void OptPlanCacheEvictRelations(List *plRelOids);
+
 } //namespace gpdb
 
 #define ForEach(cell, l)	\
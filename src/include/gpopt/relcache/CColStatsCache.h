@@ -0,0 +1,275 @@
+//---------------------------------------------------------------------------
+//	Greenplum Database
+//	Copyright (C) 2016 Pivotal Software, Inc.
+//
+//	@filename:
+//		CColStatsCache.h
+//
+//	@doc:
+//		Cache of column statistics transformed from pg_statistic, kept for
+//		the lifetime of the backend
+//
+//	@test:
+//
+//
+//---------------------------------------------------------------------------
+
+#ifndef GPDXL_CColStatsCache_H
+#define GPDXL_CColStatsCache_H
+
+#include "gpos/base.h"
+#include "gpos/common/CHashMap.h"
+#include "gpos/common/CRefCount.h"
+
+#include "naucrates/dxl/gpdb_types.h"
+#include "naucrates/md/CDXLBucket.h"
+
+namespace gpdxl
+{
+	using namespace gpos;
+	using namespace gpmd;
+
+	//---------------------------------------------------------------------------
+	//	@class:
+	//		CColStatsKey
+	//
+	//	@doc:
+	//		Identifies the version of the statistics of a column: the version
+	//		of its pg_statistic row, and everything else the transformed
+	//		statistics depend on
+	//
+	//---------------------------------------------------------------------------
+	class CColStatsKey
+	{
+		private:
+
+			// relation
+			OID m_oidRel;
+
+			// attribute number
+			INT m_iAttno;
+
+			// type of the attribute
+			OID m_oidAttType;
+
+			// xmin and location of the pg_statistic row
+			ULONG m_ulXmin;
+			ULONG m_ulBlock;
+			ULONG m_ulOffset;
+
+			// number of rows of the relation
+			CDouble m_dRows;
+
+			// maximum number of buckets the statistics were transformed to
+			ULONG m_ulMaxBuckets;
+
+		public:
+
+			// ctor
+			CColStatsKey
+				(
+				OID oidRel,
+				INT iAttno,
+				OID oidAttType,
+				ULONG ulXmin,
+				ULONG ulBlock,
+				ULONG ulOffset,
+				CDouble dRows,
+				ULONG ulMaxBuckets
+				)
+				:
+				m_oidRel(oidRel),
+				m_iAttno(iAttno),
+				m_oidAttType(oidAttType),
+				m_ulXmin(ulXmin),
+				m_ulBlock(ulBlock),
+				m_ulOffset(ulOffset),
+				m_dRows(dRows),
+				m_ulMaxBuckets(ulMaxBuckets)
+			{}
+
+			// equality check
+			BOOL FEquals(const CColStatsKey &cskey) const
+			{
+				return m_oidRel == cskey.m_oidRel
+						&& m_iAttno == cskey.m_iAttno
+						&& m_oidAttType == cskey.m_oidAttType
+						&& m_ulXmin == cskey.m_ulXmin
+						&& m_ulBlock == cskey.m_ulBlock
+						&& m_ulOffset == cskey.m_ulOffset
+						&& m_dRows == cskey.m_dRows
+						&& m_ulMaxBuckets == cskey.m_ulMaxBuckets;
+			}
+
+			// hash value
+			ULONG UlHash() const
+			{
+				return gpos::UlCombineHashes(
+						gpos::UlHash(&m_oidRel),
+						gpos::UlCombineHashes(gpos::UlHash(&m_iAttno),
+								gpos::UlHash(&m_ulXmin)));
+			}
+	};
+
+	// hash function
+	inline ULONG UlHashColStatsKey
+		(
+		const CColStatsKey *pcskey
+		)
+	{
+		GPOS_ASSERT(NULL != pcskey);
+		return pcskey->UlHash();
+	}
+
+	// equality function
+	inline BOOL FEqualColStatsKey
+		(
+		const CColStatsKey *pcskeyA,
+		const CColStatsKey *pcskeyB
+		)
+	{
+		GPOS_ASSERT(NULL != pcskeyA && NULL != pcskeyB);
+		return pcskeyA->FEquals(*pcskeyB);
+	}
+
+	//---------------------------------------------------------------------------
+	//	@class:
+	//		CColStatsCacheEntry
+	//
+	//	@doc:
+	//		Transformed statistics of a column
+	//
+	//---------------------------------------------------------------------------
+	class CColStatsCacheEntry : public CRefCount
+	{
+		private:
+
+			// buckets of the merged histogram, allocated in the cache
+			DrgPdxlbucket *m_pdrgpdxlbucket;
+
+			// frequency of NULLs, after normalizing the MCV frequencies
+			CDouble m_dNullFreq;
+
+			// distinct values and frequency not covered by the buckets
+			CDouble m_dDistinctRemain;
+			CDouble m_dFreqRemain;
+
+			// private copy ctor
+			CColStatsCacheEntry(const CColStatsCacheEntry &);
+
+		public:
+
+			// ctor
+			CColStatsCacheEntry
+				(
+				DrgPdxlbucket *pdrgpdxlbucket,
+				CDouble dNullFreq,
+				CDouble dDistinctRemain,
+				CDouble dFreqRemain
+				)
+				:
+				m_pdrgpdxlbucket(pdrgpdxlbucket),
+				m_dNullFreq(dNullFreq),
+				m_dDistinctRemain(dDistinctRemain),
+				m_dFreqRemain(dFreqRemain)
+			{
+				GPOS_ASSERT(NULL != pdrgpdxlbucket);
+			}
+
+			// dtor
+			virtual
+			~CColStatsCacheEntry()
+			{
+				m_pdrgpdxlbucket->Release();
+			}
+
+			// accessors
+			DrgPdxlbucket *Pdrgpdxlbucket() const
+			{
+				return m_pdrgpdxlbucket;
+			}
+
+			CDouble DNullFreq() const
+			{
+				return m_dNullFreq;
+			}
+
+			CDouble DDistinctRemain() const
+			{
+				return m_dDistinctRemain;
+			}
+
+			CDouble DFreqRemain() const
+			{
+				return m_dFreqRemain;
+			}
+	};
+
+	//---------------------------------------------------------------------------
+	//	@class:
+	//		CColStatsCache
+	//
+	//	@doc:
+	//		Cache of transformed column statistics, kept across queries in a
+	//		memory pool of its own. Unlike the metadata cache, which evicts
+	//		the statistics of all columns of a relation whenever its relcache
+	//		entry is invalidated, entries here are keyed by the version of the
+	//		statistics, so the columns that were not analyzed again are not
+	//		transformed again.
+	//
+	//		Buckets handed out by the cache must not be used after the next
+	//		call of Reset() or Trim(), which are only called between queries.
+	//
+	//---------------------------------------------------------------------------
+	class CColStatsCache
+	{
+		private:
+
+			// hash map of transformed statistics
+			typedef CHashMap<CColStatsKey, CColStatsCacheEntry, UlHashColStatsKey, FEqualColStatsKey,
+							CleanupDelete<CColStatsKey>, CleanupRelease<CColStatsCacheEntry> > HMColStats;
+
+			// maximum number of columns cached
+			static
+			const ULONG m_ulMaxEntries;
+
+			// memory pool of the cache
+			static
+			IMemoryPool *m_pmp;
+
+			// cached statistics
+			static
+			HMColStats *m_phmcolstats;
+
+			// number of cached columns
+			static
+			ULONG m_ulEntries;
+
+		public:
+
+			// memory pool to allocate the statistics to insert in
+			static
+			IMemoryPool *Pmp();
+
+			// cached statistics of the given version, or NULL
+			static
+			const CColStatsCacheEntry *Pcsentry(const CColStatsKey &cskey);
+
+			// cache the statistics of the given version, takes ownership of
+			// the entry and returns the cached one
+			static
+			const CColStatsCacheEntry *PcsentryInsert(const CColStatsKey &cskey, CColStatsCacheEntry *pcsentry);
+
+			// drop all cached statistics
+			static
+			void Reset();
+
+			// drop all cached statistics if the cache is full
+			static
+			void Trim();
+	};
+}
+
+#endif // !GPDXL_CColStatsCache_H
+
+// EOF
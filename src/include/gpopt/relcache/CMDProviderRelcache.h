@@ -53,6 +53,15 @@ namespace gpmd
 			// private copy ctor
 			CMDProviderRelcache(const CMDProviderRelcache&);
 
+			// relation whose version the given object is shared under,
+			// or InvalidOid if the object is never shared
+			static
+			OID OidSharedRelation(IMDId *pmdid);
+
+			// can the given translated object be shared by all backends?
+			static
+			BOOL FShareable(IMDCacheObject *pimdobj);
+
 		public:
 			// ctor/dtor
 			explicit
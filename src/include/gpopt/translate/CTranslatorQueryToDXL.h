@@ -368,6 +368,24 @@ namespace gpdxl
 				ULONG //ulCurrQueryLevel
 				);
 
+			// is the tuple of a value scan made of constants of the given types
+			BOOL FConstValues(List *plTuple, DrgPdxlcd *pdrgpdxlcd) const;
+
+			// column descriptors of a const table get producing a tuple of constants
+			DrgPdxlcd *PdrgpdxlcdConstValues(List *plTuple, List *plColnames);
+
+			// datums of a tuple of constants
+			DrgPdxldatum *PdrgpdxldatumConstValues(List *plTuple) const;
+
+			// const table get producing a run of tuples of constants
+			CDXLNode *PdxlnConstValues
+				(
+				DrgPdxlcd *pdrgpdxlcd,
+				DrgPdrgPdxldatum *pdrgpdrgpdxldatum,
+				DrgPdrgPul *pdrgpdrgulInputColIds
+				)
+				const;
+
 			// create a dxl node from a array of datums and project elements
 			CDXLNode *PdxlnFromTVF
 				(
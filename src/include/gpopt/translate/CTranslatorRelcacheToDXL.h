@@ -48,12 +48,17 @@ struct RelationData;
 typedef struct RelationData* Relation;
 struct LogicalIndexes;
 struct LogicalIndexInfo;
+struct HeapTupleData;
+typedef struct HeapTupleData *HeapTuple;
 
 namespace gpdxl
 {
 	using namespace gpos;
 	using namespace gpmd;
 
+	// fwd decl
+	class CColStatsCacheEntry;
+
 	//---------------------------------------------------------------------------
 	//	@class:
 	//		CTranslatorRelcacheToDXL
@@ -201,6 +206,20 @@ namespace gpdxl
 			static
 			IMDCacheObject *PimdobjColStats(IMemoryPool *pmp, CMDAccessor *pmda, IMDId *pmdid);
 
+			// transform a pg_statistic row to buckets, capped at the given
+			// number of buckets
+			static
+			CColStatsCacheEntry *PcsentryTransformStats
+								(
+								IMemoryPool *pmp,
+								const IMDRelation *pmdrel,
+								const IMDColumn *pmdcol,
+								OID oidAttType,
+								CDouble dRows,
+								HeapTuple heaptupleStats,
+								ULONG ulMaxBuckets
+								);
+
 			// retrieve cast object from the relcache
 			static
 			IMDCacheObject *PimdobjCast(IMemoryPool *pmp, IMDId *pmdid);
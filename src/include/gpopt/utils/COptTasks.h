@@ -195,6 +195,14 @@ class COptTasks
 		static
 		COptimizerConfig *PoconfCreate(IMemoryPool *pmp, ICostModel *pcm);
 
+		// initialize the metadata cache, or bring it up to date with the catalog
+		static
+		BOOL FInitMDCache(IMemoryPool *pmp);
+
+		// evict the metadata cache entries of the given relations
+		static
+		void EvictMDCacheRelations(IMemoryPool *pmp, List *plRelOids);
+
 		// optimize a query to a physical DXL
 		static
 		void* PvOptimizeTask(void *pv);
@@ -211,6 +219,11 @@ class COptTasks
 		static
 		DrgPss *PdrgPssLoad(IMemoryPool *pmp, char *szPath);
 
+		// search strategy that cuts the full search short after the given
+		// number of milliseconds
+		static
+		DrgPss *PdrgPssBudget(IMemoryPool *pmp, ULONG ulTimeBudget);
+
 		// allocate memory for string
 		static
 		CHAR *SzAllocate(IMemoryPool *pmp, ULONG ulSize);
@@ -231,6 +244,15 @@ class COptTasks
 		static
 		BOOL FErrorOut(gpos::CException &exc);
 
+		// check if given exception means that the metadata cache has to be dropped
+		static
+		BOOL FDropMDCache(gpos::CException &exc);
+
+		// check if given exception means that the optimizer ran out of its
+		// memory budget
+		static
+		BOOL FMemoryBudgetExhausted(gpos::CException &exc);
+
 		// set cost model parameters
 		static
 		void SetCostModelParams(ICostModel *pcm);
@@ -240,6 +262,10 @@ class COptTasks
 		ICostModel *Pcm(IMemoryPool *pmp, ULONG ulSegments);
 
 		// print warning messages for columns with missing statistics
+		// record the memory in use by the optimizer, if it is the most so far
+		static
+		void RecordPeakMemory(IMemoryPool *pmp);
+
 		static
 		void PrintMissingStatsWarning(IMemoryPool *pmp, CMDAccessor *pmda, DrgPmdid *pdrgmdidCol, HMMDIdMDId *phmmdidRel);
 
@@ -64,6 +64,9 @@ extern "C" {
 #include "parser/parse_coerce.h"
 #include "utils/selfuncs.h"
 #include "utils/faultinjector.h"
+#include "utils/mdsharedcache.h"
+#include "utils/optplancache.h"
+#include "optimizer/optstats.h"
 
 extern
 Query *preprocess_query_optimizer(Query *pquery, ParamListInfo boundParams);
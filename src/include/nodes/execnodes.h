@@ -665,6 +665,13 @@ typedef struct EState
 	 * Information relevant to dynamic table scans.
 	 */
 	DynamicTableScanInfo *dynamicTableScanInfo;
+
+	/*
+	 * The code generator manager for this query.  All plan nodes enroll
+	 * their generators into it during ExecInitNode, and it owns the single
+	 * LLVM module that is compiled once for the whole plan tree.
+	 */
+	void	   *CodegenManager;
 } EState;
 
 struct PlanState;
@@ -1377,9 +1384,6 @@ typedef struct PlanState
 	ExprContext *ps_ExprContext;	/* node's expression-evaluation context */
 	ProjectionInfo *ps_ProjInfo;	/* info for doing tuple projection */
 
-	/* The manager manages all the code generators and generation process */
-	void *CodegenManager;
-
 	/*
 	 * EXPLAIN ANALYZE statistics collection
 	 */
@@ -2186,6 +2190,14 @@ typedef struct MergeJoinState
 typedef struct HashJoinTupleData *HashJoinTuple;
 typedef struct HashJoinTableData *HashJoinTable;
 
+typedef struct ExecHashGetHashValueCodegenInfo
+{
+	/* Pointer to store ExecHashGetHashValueCodegen from Codegen */
+	void* code_generator;
+	/* Function pointer that points to either regular or generated ExecHashGetHashValue */
+	ExecHashGetHashValueFn ExecHashGetHashValue_fn;
+} ExecHashGetHashValueCodegenInfo;
+
 typedef struct HashJoinState
 {
 	JoinState	js;				/* its first field is NodeTag */
@@ -2211,6 +2223,11 @@ typedef struct HashJoinState
 
 	/* set if the operator created workfiles */
 	bool workfiles_created;
+
+#ifdef USE_CODEGEN
+	/* hashes hj_OuterHashKeys */
+	ExecHashGetHashValueCodegenInfo ExecHashGetHashValue_gen_info;
+#endif
 } HashJoinState;
 
 
@@ -2320,6 +2337,22 @@ typedef struct SortState
 typedef struct AggStatePerAggData *AggStatePerAgg;
 typedef struct AggStatePerGroupData *AggStatePerGroup;
 
+typedef struct AdvanceAggregatesCodegenInfo
+{
+	/* Pointer to store AdvanceAggregatesCodegen from Codegen */
+	void* code_generator;
+	/* Function pointer that points to either regular or generated advance_aggregates */
+	AdvanceAggregatesFn advance_aggregates_fn;
+} AdvanceAggregatesCodegenInfo;
+
+typedef struct CalcHashValueCodegenInfo
+{
+	/* Pointer to store CalcHashValueCodegen from Codegen */
+	void* code_generator;
+	/* Function pointer that points to either regular or generated calc_hash_value */
+	CalcHashValueFn calc_hash_value_fn;
+} CalcHashValueCodegenInfo;
+
 typedef struct AggState
 {
 	ScanState	ss;				/* its first field is NodeTag */
@@ -2364,6 +2397,10 @@ typedef struct AggState
 	/* set if the operator created workfiles */
 	bool		workfiles_created;
 
+#ifdef USE_CODEGEN
+	AdvanceAggregatesCodegenInfo advance_aggregates_gen_info;
+	CalcHashValueCodegenInfo calc_hash_value_gen_info;
+#endif
 } AggState;
 
 
@@ -2456,6 +2493,11 @@ typedef struct HashState
 	bool		hs_quit_if_hashkeys_null;	/* quit building hash table if hashkeys are all null */
 	bool		hs_hashkeys_null;	/* found an instance wherein hashkeys are all null */
 	/* hashkeys is same as parent's hj_InnerHashKeys */
+
+#ifdef USE_CODEGEN
+	/* hashes hashkeys, enrolled by the parent HashJoin */
+	ExecHashGetHashValueCodegenInfo ExecHashGetHashValue_gen_info;
+#endif
 } HashState;
 
 /* ----------------
@@ -2581,6 +2623,14 @@ typedef enum MotionStateType
 	MOTIONSTATE_RECV,			/* The motion is recver */
 } MotionStateType;
 
+typedef struct EvalHashKeyCodegenInfo
+{
+	/* Pointer to store EvalHashKeyCodegen from Codegen */
+	void* code_generator;
+	/* Function pointer that points to either regular or generated evalHashKey */
+	EvalHashKeyFn evalHashKey_fn;
+} EvalHashKeyCodegenInfo;
+
 /* ----------------
  *         MotionState information
  * ----------------
@@ -2622,6 +2672,10 @@ typedef struct MotionState
 	Oid		   *outputFunArray;	/* output functions for each column (debug only) */
 
 	int			numInputSegs;	/* the number of segments on the sending slice */
+
+#ifdef USE_CODEGEN
+	EvalHashKeyCodegenInfo evalHashKey_gen_info;
+#endif
 } MotionState;
 
 /*
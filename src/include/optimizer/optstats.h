@@ -0,0 +1,39 @@
+/*-------------------------------------------------------------------------
+ *
+ * optstats.h
+ *	  Time and memory spent by the new optimizer (ORCA), per phase.
+ *
+ * Copyright (c) 2016, Pivotal Software, Inc.
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef OPTSTATS_H
+#define OPTSTATS_H
+
+/*
+ * Times are in milliseconds. Fetching metadata happens during the phases,
+ * mostly while translating the query and searching, so its time is part of
+ * theirs.
+ */
+typedef struct OptimizerStats
+{
+	int64		queries;			/* queries handed to the optimizer */
+	int64		cachedPlans;		/* plans found in the plan cache */
+	int64		budgetExhausted;	/* optimizations that ran out of budget */
+	int64		mdFetches;			/* metadata objects not in the cache */
+	int64		mdSharedHits;		/* ... found in the shared cache */
+	double		mdFetchTime;		/* fetching and translating them */
+	double		translateQueryTime;	/* translating the query to DXL */
+	double		searchTime;			/* searching for the best plan */
+	double		translatePlanTime;	/* translating the plan from DXL */
+	double		copyPlanTime;		/* copying the plan out of the plan cache */
+	int64		peakMemory;			/* bytes, largest memory pool between phases */
+} OptimizerStats;
+
+/* Of the query optimized last */
+extern OptimizerStats OptimizerQueryStats;
+
+/* Of all queries of the session */
+extern OptimizerStats OptimizerSessionStats;
+
+#endif   /* OPTSTATS_H */
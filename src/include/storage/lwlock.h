@@ -34,6 +34,9 @@
 /* Number of partitions of the workfile query diskspace hashtable */
 #define NUM_WORKFILE_QUERYSPACE_PARTITIONS 128
 
+/* Number of partitions of the optimizer metadata shared cache */
+#define NUM_MDSHAREDCACHE_PARTITIONS 16
+
 /*
  * We have a number of predefined LWLocks, plus a bunch of LWLocks that are
  * dynamically assigned (e.g., for shared buffers).  The LWLock structures
@@ -97,9 +100,10 @@ typedef enum LWLockId
 	FirstBufMappingLock = FirstWorkfileQuerySpaceLock + NUM_WORKFILE_QUERYSPACE_PARTITIONS,
 	FirstLockMgrLock = FirstBufMappingLock + NUM_BUFFER_PARTITIONS,
 	SessionStateLock = FirstLockMgrLock + NUM_LOCK_PARTITIONS,
+	FirstMDSharedCacheLock,
 
 	/* must be last except for MaxDynamicLWLock: */
-	NumFixedLWLocks,
+	NumFixedLWLocks = FirstMDSharedCacheLock + NUM_MDSHAREDCACHE_PARTITIONS,
 
 	MaxDynamicLWLock = 1000000000
 } LWLockId;
@@ -377,6 +377,8 @@ extern bool optimizer_print_plan;
 extern bool optimizer_print_xform;
 extern bool optimizer_metadata_caching;
 extern int optimizer_mdcache_size;
+extern int optimizer_mdcache_shared_entries;
+extern int optimizer_plan_cache_entries;
 extern bool optimizer_disable_xform_result_printing;
 extern bool	optimizer_print_memo_after_exploration;
 extern bool	optimizer_print_memo_after_implementation;
@@ -429,6 +431,9 @@ extern double optimizer_damping_factor_filter;
 extern double optimizer_damping_factor_join;
 extern double optimizer_damping_factor_groupby;
 extern int optimizer_segments;
+extern int optimizer_histogram_max_buckets;
+extern int optimizer_search_time_budget;
+extern int optimizer_search_memory_budget;
 extern int optimizer_join_arity_for_associativity_commutativity;
 extern bool optimizer_analyze_root_partition;
 extern bool optimizer_analyze_midlevel_partition;
@@ -456,6 +461,12 @@ extern bool optimizer_prefer_scalar_dqa_multistage_agg;
  **/
 extern bool init_codegen;
 extern bool codegen;
+extern bool codegen_async_compile;
+extern int codegen_cache_size;
+extern int codegen_min_plan_rows;
+extern int codegen_max_instructions;
+extern int codegen_object_cache_size;
+extern char *codegen_object_cache_directory;
 
 /**
  * Enable logging of DPE match in optimizer.
@@ -0,0 +1,33 @@
+/*-------------------------------------------------------------------------
+ *
+ * mdsharedcache.h
+ *	  Interface for the cache of optimizer metadata objects shared by all
+ *	  backends.
+ *
+ * Copyright (c) 2016, Pivotal Software, Inc.
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef MDSHAREDCACHE_H
+#define MDSHAREDCACHE_H
+
+#include "storage/sinval.h"
+
+/* Longest metadata id that can be cached, including the terminator */
+#define MDSHAREDCACHE_MAX_KEY_LEN 64
+
+/* Longest serialized metadata object that can be cached */
+#define MDSHAREDCACHE_MAX_OBJECT_LEN (32 * 1024)
+
+extern Size MDSharedCacheShmemSize(void);
+extern void MDSharedCacheShmemInit(void);
+
+extern bool MDSharedCacheIsEnabled(void);
+extern uint64 MDSharedCacheGetVersion(Oid relid);
+extern char *MDSharedCacheLookup(const char *key, uint64 version);
+extern void MDSharedCacheStore(const char *key, uint64 version,
+							   const char *object);
+extern void MDSharedCacheInvalidate(const SharedInvalidationMessage *msgs,
+									int n);
+
+#endif   /* MDSHAREDCACHE_H */
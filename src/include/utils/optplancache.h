@@ -0,0 +1,22 @@
+/*-------------------------------------------------------------------------
+ *
+ * optplancache.h
+ *	  Interface for the per-backend cache of plans produced by the optimizer.
+ *
+ * Copyright (c) 2016, Pivotal Software, Inc.
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef OPTPLANCACHE_H
+#define OPTPLANCACHE_H
+
+#include "nodes/parsenodes.h"
+#include "nodes/plannodes.h"
+
+extern char *OptPlanCacheKey(Query *query);
+extern PlannedStmt *OptPlanCacheLookup(const char *key);
+extern void OptPlanCacheStore(const char *key, PlannedStmt *plan);
+extern void OptPlanCacheReset(void);
+extern void OptPlanCacheEvictRelations(List *relids);
+
+#endif   /* OPTPLANCACHE_H */
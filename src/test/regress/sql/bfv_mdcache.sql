@@ -0,0 +1,68 @@
+--
+-- Test that the metadata cache of the optimizer evicts only the relations
+-- whose catalog entries changed, rather than everything it has cached, and
+-- that it is kept when the optimizer gives up on a query.
+--
+-- The number of metadata objects the optimizer had to fetch for a query,
+-- rather than find in its cache, tells whether the cache was kept.
+--
+create or replace function mdcache_fetches(query text) returns bigint as
+$$
+declare
+	before bigint;
+	after bigint;
+begin
+	select md_fetches into before from pg_stat_optimizer;
+	execute query;
+	select md_fetches into after from pg_stat_optimizer;
+	return after - before;
+end;
+$$
+language plpgsql;
+
+set optimizer = on;
+-- plans found in the plan cache fetch nothing at all
+set optimizer_plan_cache_entries = 0;
+
+drop table if exists mdcache_foo;
+drop table if exists mdcache_bar;
+create table mdcache_foo (a int, b int) distributed by (a);
+create table mdcache_bar (a int, b int) distributed by (a);
+insert into mdcache_foo select i, i % 10 from generate_series(1, 100) i;
+insert into mdcache_bar select i, i % 10 from generate_series(1, 100) i;
+analyze mdcache_foo;
+analyze mdcache_bar;
+
+-- fill the cache
+select mdcache_fetches('select * from mdcache_foo where b > 5') > 0 as fetched;
+select mdcache_fetches('select * from mdcache_bar where b > 5') > 0 as fetched;
+select mdcache_fetches('select * from mdcache_foo where b > 5') = 0 as cached;
+select mdcache_fetches('select * from mdcache_bar where b > 5') = 0 as cached;
+
+-- ANALYZE of one table evicts only that table
+analyze mdcache_foo;
+select mdcache_fetches('select * from mdcache_bar where b > 5') = 0 as cached;
+select mdcache_fetches('select * from mdcache_foo where b > 5') > 0 as fetched;
+
+-- so does TRUNCATE
+truncate mdcache_bar;
+select mdcache_fetches('select * from mdcache_foo where b > 5') = 0 as cached;
+select mdcache_fetches('select * from mdcache_bar where b > 5') > 0 as fetched;
+
+-- and a change made to pg_statistic directly
+set allow_system_table_mods=DML;
+update pg_statistic set stanullfrac = 0.5 where starelid = 'mdcache_foo'::regclass and staattnum = 2;
+reset allow_system_table_mods;
+select mdcache_fetches('select * from mdcache_bar where b > 5') = 0 as cached;
+select mdcache_fetches('select * from mdcache_foo where b > 5') > 0 as fetched;
+
+-- a query the optimizer does not support falls back to the planner, and
+-- keeps the cache
+select count(*) from gp_dist_random('mdcache_foo');
+select mdcache_fetches('select * from mdcache_foo where b > 5') = 0 as cached;
+select mdcache_fetches('select * from mdcache_bar where b > 5') = 0 as cached;
+
+reset optimizer_plan_cache_entries;
+drop table mdcache_foo;
+drop table mdcache_bar;
+drop function mdcache_fetches(text);
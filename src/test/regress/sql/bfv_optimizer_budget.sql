@@ -0,0 +1,58 @@
+--
+-- Test the time and memory budgets of the optimizer search: a query whose
+-- search runs out of its budget still runs, and is counted in
+-- pg_stat_optimizer.
+--
+create or replace function optbudget_exhausted() returns bigint as
+$$
+	select budget_exhausted from pg_stat_optimizer;
+$$
+language sql;
+
+set optimizer = on;
+
+drop table if exists optbudget_foo;
+drop table if exists optbudget_bar;
+drop table if exists optbudget_baz;
+create table optbudget_foo (a int, b int) distributed by (a);
+create table optbudget_bar (a int, b int) distributed by (a);
+create table optbudget_baz (a int, b int) distributed by (a);
+insert into optbudget_foo select i, i % 10 from generate_series(1, 100) i;
+insert into optbudget_bar select i, i % 10 from generate_series(1, 100) i;
+insert into optbudget_baz select i, i % 10 from generate_series(1, 100) i;
+analyze optbudget_foo;
+analyze optbudget_bar;
+analyze optbudget_baz;
+
+create temp table optbudget_before as select optbudget_exhausted() as exhausted
+distributed randomly;
+
+-- a query that does not fit in the memory budget falls back to the planner
+set optimizer_search_memory_budget = 1;
+select count(*) from optbudget_foo, optbudget_bar where optbudget_foo.a = optbudget_bar.a;
+reset optimizer_search_memory_budget;
+
+select optbudget_exhausted() - exhausted as exhausted from optbudget_before;
+
+-- without a budget, the same query is not counted
+select count(*) from optbudget_foo, optbudget_bar where optbudget_foo.a = optbudget_bar.a;
+select optbudget_exhausted() - exhausted as exhausted from optbudget_before;
+
+-- a search that runs out of its time budget uses the best plan found by
+-- then; whether a 1 ms budget runs out depends on the speed of the machine,
+-- so only the results are checked
+set optimizer_search_time_budget = 1;
+set client_min_messages = warning;
+select count(*) from optbudget_foo, optbudget_bar, optbudget_baz
+where optbudget_foo.a = optbudget_bar.a and optbudget_bar.a = optbudget_baz.a
+and optbudget_foo.b = optbudget_baz.b;
+reset client_min_messages;
+reset optimizer_search_time_budget;
+
+select optbudget_exhausted() - exhausted between 1 and 2 as exhausted from optbudget_before;
+
+drop table optbudget_before;
+drop table optbudget_foo;
+drop table optbudget_bar;
+drop table optbudget_baz;
+drop function optbudget_exhausted();
@@ -0,0 +1,72 @@
+--
+-- Test the cache of the plans produced by the optimizer: a repeated query
+-- finds its plan, and the plan is planned again after the settings or the
+-- metadata it was produced from changed.
+--
+-- The number of plans found in the cache for a query tells whether it was
+-- planned again.
+--
+create or replace function optplan_cached(query text) returns bigint as
+$$
+declare
+	before bigint;
+	after bigint;
+begin
+	select cached_plans into before from pg_stat_optimizer;
+	execute query;
+	select cached_plans into after from pg_stat_optimizer;
+	return after - before;
+end;
+$$
+language plpgsql;
+
+set optimizer = on;
+set optimizer_plan_cache_entries = 100;
+
+drop table if exists optplan_foo;
+drop table if exists optplan_bar;
+drop table if exists optplan_part;
+create table optplan_foo (a int, b int) distributed by (a);
+create table optplan_bar (a int, b int) distributed by (a);
+create table optplan_part (a int, b int) distributed by (a)
+partition by range (b) (start (0) end (10) every (5));
+insert into optplan_foo select i, i % 10 from generate_series(1, 100) i;
+insert into optplan_bar select i, i % 10 from generate_series(1, 100) i;
+insert into optplan_part select i, i % 10 from generate_series(1, 100) i;
+analyze optplan_foo;
+analyze optplan_bar;
+analyze optplan_part;
+
+-- a repeated query finds its plan
+select optplan_cached('select * from optplan_foo where b > 5') = 0 as planned;
+select optplan_cached('select * from optplan_foo where b > 5') = 1 as cached;
+select optplan_cached('select * from optplan_bar where b > 5') = 0 as planned;
+select optplan_cached('select * from optplan_part where b > 5') = 0 as planned;
+select optplan_cached('select * from optplan_part where b > 5') = 1 as cached;
+
+-- but not under other settings
+set optimizer_segments = 3;
+select optplan_cached('select * from optplan_foo where b > 5') = 0 as planned;
+reset optimizer_segments;
+select optplan_cached('select * from optplan_foo where b > 5') = 1 as cached;
+
+-- ALTER of a table evicts only the plans that read it
+alter table optplan_foo alter column b set statistics 50;
+select optplan_cached('select * from optplan_bar where b > 5') = 1 as cached;
+select optplan_cached('select * from optplan_foo where b > 5') = 0 as planned;
+
+-- so does ANALYZE
+analyze optplan_bar;
+select optplan_cached('select * from optplan_foo where b > 5') = 1 as cached;
+select optplan_cached('select * from optplan_bar where b > 5') = 0 as planned;
+
+-- and ANALYZE of a part of a partitioned table
+analyze optplan_part_1_prt_1;
+select optplan_cached('select * from optplan_foo where b > 5') = 1 as cached;
+select optplan_cached('select * from optplan_part where b > 5') = 0 as planned;
+
+reset optimizer_plan_cache_entries;
+drop table optplan_foo;
+drop table optplan_bar;
+drop table optplan_part;
+drop function optplan_cached(text);
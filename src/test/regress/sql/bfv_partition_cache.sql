@@ -0,0 +1,61 @@
+--
+-- Test that the partition metadata the optimizer caches for a partitioned
+-- table, its logical indexes and the constraints of its parts, follows the
+-- changes to its indexes and partitions.
+--
+-- start_ignore
+create language plpythonu;
+-- end_ignore
+
+create or replace function count_operator(explain_query text, operator text) returns int as
+$$
+rv = plpy.execute(explain_query)
+search_text = operator
+result = 0
+for i in range(len(rv)):
+    cur_line = rv[i]['QUERY PLAN']
+    if search_text.lower() in cur_line.lower():
+        result = result+1
+return result
+$$
+language plpythonu;
+
+set optimizer = on;
+
+drop table if exists partcache_pt;
+create table partcache_pt (a int, b int, c int) distributed by (a)
+partition by range (b) (start (0) end (10) every (5));
+insert into partcache_pt select i, i % 10, i % 7 from generate_series(1, 100) i;
+analyze partcache_pt;
+
+-- logical indexes: without a table scan, only an index makes a plan
+-- start_ignore
+select disable_xform('CXformDynamicGet2DynamicTableScan');
+-- end_ignore
+
+select count_operator('explain select * from partcache_pt where c = 3;', 'Dynamic Index Scan');
+create index partcache_pt_c on partcache_pt (c);
+select count_operator('explain select * from partcache_pt where c = 3;', 'Dynamic Index Scan');
+select count(*) from partcache_pt where c = 3;
+drop index partcache_pt_c;
+select count_operator('explain select * from partcache_pt where c = 3;', 'Dynamic Index Scan');
+
+-- start_ignore
+select enable_xform('CXformDynamicGet2DynamicTableScan');
+-- end_ignore
+
+-- part constraints: partitions are selected by their constraints
+select count(*) from partcache_pt where b >= 5;
+alter table partcache_pt add partition p3 start (10) end (15);
+insert into partcache_pt select i, 10 + i % 5, i % 7 from generate_series(1, 20) i;
+select count(*) from partcache_pt where b >= 5;
+select count(*) from partcache_pt where b >= 10;
+alter table partcache_pt drop partition p3;
+select count(*) from partcache_pt where b >= 5;
+alter table partcache_pt drop partition for (0);
+select count(*) from partcache_pt where b < 5;
+select count(*) from partcache_pt;
+
+reset optimizer;
+drop table partcache_pt;
+drop function count_operator(text, text);
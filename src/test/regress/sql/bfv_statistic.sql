@@ -272,6 +272,45 @@ select most_common_vals from pg_stats where tablename = 'foo_numeric' and attnam
 
 reset gp_create_table_random_default_distribution;
 
+--
+-- Cardinality estimation with the statistics capped by
+-- optimizer_histogram_max_buckets, and after they changed
+--
+
+create or replace function row_count(query text) returns integer as
+$$
+output = plpy.execute(query)
+return int(output[0]['QUERY PLAN'].split('rows=')[1].split()[0])
+$$
+language plpythonu;
+
+set optimizer = on;
+drop table if exists foo4;
+create table foo4 (a int, b int) distributed by (a);
+insert into foo4 select i, 0 from generate_series(1, 500) i;
+insert into foo4 select i, 1 from generate_series(1, 200) i;
+insert into foo4 select i, 2 from generate_series(1, 100) i;
+insert into foo4 select i, i + 2 from generate_series(1, 200) i;
+analyze foo4;
+
+select check_row_count('explain select * from foo4 where b = 2;', 100);
+
+-- only the most common value is left
+set optimizer_histogram_max_buckets = 1;
+select check_row_count('explain select * from foo4 where b = 0;', 500);
+select row_count('explain select * from foo4 where b = 2;') < 100 as capped;
+reset optimizer_histogram_max_buckets;
+select check_row_count('explain select * from foo4 where b = 2;', 100);
+
+-- statistics are transformed again after ANALYZE changed them
+insert into foo4 select i, 2 from generate_series(1, 1000) i;
+analyze foo4;
+select check_row_count('explain select * from foo4 where b = 2;', 1100);
+
+drop table foo4;
+drop function row_count(text);
+reset optimizer;
+
 --
 -- Ensure that VACUUM ANALYZE does not result in incorrect statistics
 --
@@ -0,0 +1,26 @@
+--
+-- Test VALUES lists with the optimizer, which translates consecutive tuples
+-- of constants to a single operator.
+--
+set optimizer = on;
+
+-- tuples of constants, including NULLs
+select * from (values (42, 'x')) v(a, b);
+select * from (values (1, 'one', 1.5), (2, 'two', null), (3, null, 3.5)) v(a, b, c) order by a;
+select * from (values (1::int8, 'a'::varchar), (2, 'b'), (3, 'c')) v(a, b) order by a;
+
+-- a tuple that is not constant breaks a run of tuples of constants
+select * from (values (1, 'a'), (2, 'b'), (floor(random() * 0)::int + 3, 'c'), (4, 'd'), (5, 'e')) v(a, b) order by a;
+select * from (values (floor(random() * 0)::int + 1, 'a'), (2, 'b'), (3, 'c')) v(a, b) order by a;
+
+-- aggregates and joins over a VALUES list
+select count(*), sum(a), min(b), max(b) from (values (1, 'x'), (2, 'y'), (3, 'z'), (4, null)) v(a, b);
+
+drop table if exists values_foo;
+create table values_foo (a int, b text) distributed by (a);
+insert into values_foo values (1, 'one'), (2, 'two'), (3, 'three'), (4, null);
+select * from values_foo order by a;
+select f.a, f.b, v.c from values_foo f join (values (1, 10), (3, 30), (5, 50)) v(a, c) on f.a = v.a order by f.a;
+
+reset optimizer;
+drop table values_foo;
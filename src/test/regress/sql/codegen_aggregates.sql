@@ -0,0 +1,38 @@
+--
+-- Aggregates whose transition step is inlined in the generated
+-- advance_aggregates: count, sum of int4 and float8, and min and max of
+-- int4, int8 and float8. Their arguments have to be plain columns.
+--
+set codegen = on;
+set codegen_async_compile = off;
+set codegen_min_plan_rows = 0;
+
+drop table if exists codegen_agg;
+create table codegen_agg (g int, i4 int, i8 int8, f8 float8) distributed by (g);
+-- NULLs, negative values, and a group of NULLs only
+insert into codegen_agg
+select i % 3, x, x, x
+from (select i, case when i % 7 = 1 or i % 3 = 0 then null else i - 5000 end as x
+      from generate_series(1, 10000) i) t;
+analyze codegen_agg;
+
+select count(*), count(i4), sum(i4), min(i4), max(i4) from codegen_agg;
+select sum(f8), min(i8), max(i8), min(f8), max(f8) from codegen_agg;
+
+select g, count(*), count(i4), sum(i4), min(i4), max(i4) from codegen_agg
+group by g order by g;
+select g, sum(f8), min(i8), max(i8), min(f8), max(f8) from codegen_agg
+group by g order by g;
+
+-- sum(int4) adds up in int8, past the range of int4
+truncate codegen_agg;
+insert into codegen_agg select 1, 2147483647, 0, 1e308 from generate_series(1, 3);
+select sum(i4) from codegen_agg;
+
+-- overflow of float8 is left to the regular function to report
+select sum(f8) from codegen_agg;
+
+drop table codegen_agg;
+reset codegen_min_plan_rows;
+reset codegen_async_compile;
+reset codegen;
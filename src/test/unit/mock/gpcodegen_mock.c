@@ -50,6 +50,13 @@ CodeGeneratorManagerDestroy(void* manager)
 	elog(ERROR, "mock implementation of CodeGeneratorManager_Destroy called");
 }
 
+// cancels the background compilations of all managers
+void
+CodeGeneratorManagerCancelAsyncCompilations()
+{
+	elog(ERROR, "mock implementation of CodeGeneratorManagerCancelAsyncCompilations called");
+}
+
 // get the active code generator manager
 void*
 GetActiveCodeGeneratorManager()
@@ -65,6 +72,13 @@ SetActiveCodeGeneratorManager(void* manager)
 	elog(ERROR, "mock implementation of SetActiveCodeGeneratorManager called");
 }
 
+// fill in the counters of the compiled function cache
+void
+GetCodegenCacheStats(CodegenCacheStats* stats)
+{
+	elog(ERROR, "mock implementation of GetCodegenCacheStats called");
+}
+
 // returns the pointer to the SlotDeformTupleCodegen
 void*
 ExecVariableListCodegenEnroll(ExecVariableListFn regular_func_ptr,
@@ -77,3 +91,71 @@ ExecVariableListCodegenEnroll(ExecVariableListFn regular_func_ptr,
 	return NULL;
 }
 
+// returns the pointer to the SlotDeformTupleCodegen
+void*
+SlotDeformTupleCodegenEnroll(SlotDeformTupleFn regular_func_ptr,
+                             SlotDeformTupleFn* ptr_to_regular_func_ptr,
+                             struct TupleTableSlot* slot)
+{
+  *ptr_to_regular_func_ptr = regular_func_ptr;
+	elog(ERROR, "mock implementation of SlotDeformTupleCodegenEnroll called");
+	return NULL;
+}
+
+// returns the pointer to the SlotDeformMemTupleCodegen
+void*
+SlotDeformMemTupleCodegenEnroll(SlotDeformMemTupleFn regular_func_ptr,
+                                SlotDeformMemTupleFn* ptr_to_regular_func_ptr,
+                                struct TupleTableSlot* slot)
+{
+  *ptr_to_regular_func_ptr = regular_func_ptr;
+	elog(ERROR, "mock implementation of SlotDeformMemTupleCodegenEnroll called");
+	return NULL;
+}
+
+// returns the pointer to the AdvanceAggregatesCodegen
+void*
+AdvanceAggregatesCodegenEnroll(AdvanceAggregatesFn regular_func_ptr,
+                               AdvanceAggregatesFn* ptr_to_regular_func_ptr,
+                               struct AggState* aggstate)
+{
+  *ptr_to_regular_func_ptr = regular_func_ptr;
+	elog(ERROR, "mock implementation of AdvanceAggregatesCodegenEnroll called");
+	return NULL;
+}
+
+// returns the pointer to the ExecHashGetHashValueCodegen
+void*
+ExecHashGetHashValueCodegenEnroll(ExecHashGetHashValueFn regular_func_ptr,
+                                  ExecHashGetHashValueFn* ptr_to_regular_func_ptr,
+                                  struct List* hashkeys,
+                                  struct List* hashoperators,
+                                  bool outer_tuple)
+{
+  *ptr_to_regular_func_ptr = regular_func_ptr;
+	elog(ERROR, "mock implementation of ExecHashGetHashValueCodegenEnroll called");
+	return NULL;
+}
+
+// returns the pointer to the CalcHashValueCodegen
+void*
+CalcHashValueCodegenEnroll(CalcHashValueFn regular_func_ptr,
+                           CalcHashValueFn* ptr_to_regular_func_ptr,
+                           struct AggState* aggstate)
+{
+  *ptr_to_regular_func_ptr = regular_func_ptr;
+	elog(ERROR, "mock implementation of CalcHashValueCodegenEnroll called");
+	return NULL;
+}
+
+// returns the pointer to the EvalHashKeyCodegen
+void*
+EvalHashKeyCodegenEnroll(EvalHashKeyFn regular_func_ptr,
+                         EvalHashKeyFn* ptr_to_regular_func_ptr,
+                         struct List* hashkeys,
+                         struct List* hashtypes)
+{
+  *ptr_to_regular_func_ptr = regular_func_ptr;
+	elog(ERROR, "mock implementation of EvalHashKeyCodegenEnroll called");
+	return NULL;
+}